@@ -41,6 +41,34 @@ extern "C"
 #define JPMCDS_WEEKEND_NO_WEEKENDS 0x0000
 #define JPMCDS_WEEKEND_STANDARD    (JPMCDS_WEEKEND_SATURDAY | JPMCDS_WEEKEND_SUNDAY)
 
+/* number of days in each word of the bitmap of a THolidayIndex */
+#define JPMCDS_HOLIDAY_INDEX_BITS 32
+
+/*t
+***************************************************************************
+** Business days of a holiday list over a range of dates, as a bitmap with
+** the number of business days before each word of the bitmap. Lets the
+** business day functions test a date in constant time, and count or step
+** over business days without walking through the days in between.
+**
+** Made by JpmcdsHolidayListBuildIndex, and only used while the date list
+** and weekends of the holiday list are the ones it was made from.
+***************************************************************************
+*/
+typedef struct _THolidayIndex
+{
+    TDate          startDate;   /* first date in the bitmap */
+    TDate          endDate;     /* first date after the bitmap */
+    long           nbWords;     /* number of words in the bitmap */
+    unsigned long *bits;        /* [nbWords+1] bit i%32 of word i/32 is
+                                   set if startDate+i is a business day */
+    long          *ranks;       /* [nbWords+1] business days before
+                                   each word */
+    TDateList     *dateList;    /* date list of the holiday list */
+    long           numHolidays; /* number of dates in it */
+    long           weekends;    /* weekends of the holiday list */
+} THolidayIndex;
+
 /*t
 ***************************************************************************
 ** Contains holiday dates and a series of flags that indicate that
@@ -49,8 +77,9 @@ extern "C"
 */
 typedef struct _THolidayList
 {
-    TDateList  *dateList;     /* date list of holidays */
-    long        weekends;     /* weekends */
+    TDateList     *dateList;  /* date list of holidays */
+    long           weekends;  /* weekends */
+    THolidayIndex *index;     /* business days as a bitmap, or NULL */
 } THolidayList;
 
 
@@ -64,6 +93,18 @@ typedef struct _THolidayCache THolidayCache;
 #define JPMCDS_IS_WEEKEND(date, weekends) ((1 << ((date) % 7)) & (weekends))
 #define JPMCDS_IS_WEEKDAY(date, weekends) (!(JPMCDS_IS_WEEKEND((date),(weekends))))
 
+/*m
+***************************************************************************
+** Returns the business day index of a holiday list if it still matches
+** the dates and weekends of the list, and NULL otherwise.
+***************************************************************************
+*/
+#define JPMCDS_HOLIDAY_LIST_INDEX(hl)                                   \
+    ((hl)->index != NULL && (hl)->dateList != NULL &&                   \
+     (hl)->index->dateList == (hl)->dateList &&                         \
+     (hl)->index->numHolidays == (hl)->dateList->fNumItems &&           \
+     (hl)->index->weekends == (hl)->weekends ? (hl)->index : NULL)
+
 /*
 ***************************************************************************
 ** This file is broken into two types of functions.
@@ -91,8 +132,8 @@ typedef struct _THolidayCache THolidayCache;
 /*f
 ***************************************************************************
 ** The function first checks if the input name is really an encoded
-** pointer. If it is, the function decodes the pointer and returns
-** it. Otherwise, it checks whether the name is "NONE" or "NO_WEEKENDS".
+** pointer, as made by JpmcdsHolidayCalendarHandle. If it is, the function
+** decodes the pointer and returns it. Otherwise, it checks whether the name is "NONE" or "NO_WEEKENDS".
 ** If it is either of those, the function returns a pointer to an
 ** appropriate static data structure (for efficiency). If it is
 ** none of the above, then the function searches for the name in the
@@ -106,16 +147,40 @@ typedef struct _THolidayCache THolidayCache;
 ** This behaviour exactly duplicates the behaviour when using a holiday
 ** name as an input to any analytics function.
 **
+** Can be called from many threads at once, and takes no lock unless the
+** holidays have to be read from file. The returned list remains valid
+** until the cache is emptied, even if its entry is replaced.
+**
 ** Returns NULL on failure, a valid THolidayList pointer on success.
 ***************************************************************************
 */
 THolidayList * JpmcdsHolidayListFromCache
 (char *name);   /* (I) Name associated with the holidays */
 
+
+/*f
+***************************************************************************
+** Returns a handle for a calendar of the cache, reading the holidays from
+** file if necessary. The handle is a string which can be passed instead
+** of the calendar name to any function taking one, and leads straight to
+** the holiday list without the name being looked up.
+**
+** The handle follows the calendar: if the calendar is replaced in the
+** cache the handle leads to the new holiday list, and if the cache is
+** emptied the calendar is found again by its name. A calendar keeps the
+** same handle for good, and the string returned is never freed.
+**
+** Returns NULL on failure.
+***************************************************************************
+*/
+char* JpmcdsHolidayCalendarHandle
+(char *name);   /* (I) Name associated with the holidays */
+
 /*f
 ***************************************************************************
 ** Adds a holiday list to the holiday cache. If the entry already exists
-** in the cache, then the old version will be deleted.
+** in the cache, then the old version is replaced, though it is only
+** deleted when the cache is emptied.
 ***************************************************************************
 */
 int JpmcdsHolidayListAddToCache
@@ -126,12 +191,24 @@ int JpmcdsHolidayListAddToCache
 
 /*f
 ***************************************************************************
-** Empty holiday cache
+** Empty holiday cache. Deletes all the holiday lists of the cache, so must
+** not be called while other threads are using the cache or its lists.
 ***************************************************************************
 */
 void JpmcdsHolidayEmptyCache (void);
 
 
+/*f
+***************************************************************************
+** Returns the version of the holiday cache. This changes whenever a list
+** is added by JpmcdsHolidayListAddToCache or the cache is emptied, but not
+** when a list is first read from file, so anything found from the
+** calendars of the cache can be kept while the version is unchanged.
+***************************************************************************
+*/
+long JpmcdsHolidayCacheVersion (void);
+
+
 /*
 ***************************************************************************
 ** 2. Holiday list manipulation functions. These are functions that
@@ -165,6 +242,21 @@ void JpmcdsHolidayListDelete
 (THolidayList *hl);  /* (I) Holiday list to delete */
 
 
+/*f
+***************************************************************************
+** Makes the business day index of a holiday list, replacing any index it
+** already has. The index covers the years 1900 to 2199 and any holidays
+** outside them; dates outside the index are handled as before.
+**
+** Holiday lists get an index when they are added to the holiday cache,
+** unless they already have one. Other lists can be given one here, and must be given one again if their
+** dates are changed in place.
+***************************************************************************
+*/
+int JpmcdsHolidayListBuildIndex
+(THolidayList *hl);  /* (I/O) Holiday list */
+
+
 /*f
 ***************************************************************************
 ** Reads a holiday file into memory as a holiday list.
@@ -181,6 +273,9 @@ void JpmcdsHolidayListDelete
 **     # FRIDAY_ALWAYS_HOLIDAY        - sets "friday as always a holiday"
 **
 ** Dates must be in increasing order.
+**
+** Binary holiday files, as written by JpmcdsHolidayListWriteBinary, are
+** also accepted and read with JpmcdsHolidayListReadBinary.
 ***************************************************************************
 */
 THolidayList* JpmcdsHolidayListRead
@@ -114,6 +114,49 @@ TFeeLeg* JpmcdsCdsFeeLegMake(
     TBoolean        protectStart);
 
 
+/*f
+***************************************************************************
+** Makes the live part of a fixed fee leg for a vanilla CDS, which is the
+** leg made by JpmcdsCdsFeeLegMake without the fee payments whose accrual
+** ends before stepinDate (or on stepinDate, if protectStart=False). The
+** last payment is kept even if it has ended.
+**
+** The leg gives the same values as the whole leg for any step-in date on
+** or after stepinDate, so a seasoned trade is valued without going through
+** the coupons which have already been paid. It must not be used for an
+** earlier step-in date.
+***************************************************************************
+*/
+TFeeLeg* JpmcdsCdsFeeLegMakeLive(
+    /** Date when protection begins. Either at start or end of day (depends
+        on protectStart) */
+    TDate           startDate,
+    /** Date when protection ends (end of day) */
+    TDate           endDate,
+    /** Should accrued interest be paid on default. Usually set to TRUE */
+    TBoolean        payAccOnDefault,
+    /** Interval between coupon payments. Can be NULL when 3M is assumed */
+    TDateInterval  *couponInterval,
+    /** If the startDate and endDate are not on cycle, then this parameter
+        determines location of coupon dates. */
+    TStubMethod    *stubType,
+    /** Notional value protected */
+    double          notional, 
+    /** Fixed coupon rate (a.k.a. spread) for the fee leg */
+    double          couponRate,
+    /** Day count convention for coupon payment. Normal is ACT_360 */
+    long            paymentDcc,
+    /** Bad day convention for adjusting coupon payment dates. */
+    long            badDayConv,
+    /** Calendar used when adjusting coupon dates. Can be NULL which equals
+        a calendar with no holidays and including weekends. */
+    char           *calendar,
+    /** Should protection include the start date */
+    TBoolean        protectStart,
+    /** Earliest step-in date at which the leg will be valued */
+    TDate           stepinDate);
+
+
 /*f
 ***************************************************************************
 ** Computes the PV for a fixed fee leg for a vanilla CDS.
@@ -228,6 +271,175 @@ EXPORT int JpmcdsCdsPrice(
         (see also isPriceClean) */
     double         *price);
 
+
+/*f
+***************************************************************************
+** Computes the price for a vanilla CDS as JpmcdsCdsPrice, together with
+** its gradient with respect to the rate of every point of the discount
+** curve and of the spread curve.
+**
+** The gradient is found in reverse mode along the one walk of the legs
+** which values them, at a cost of a few pricings however many points the
+** curves have. The price agrees with JpmcdsCdsPrice to rounding. Use
+** JpmcdsCleanSpreadCurveAdjoint to carry the gradient with respect to
+** the spread curve back to the benchmark spreads.
+***************************************************************************
+*/
+EXPORT int JpmcdsCdsPriceAdjoint(
+    /** Risk starts at the end of today */
+    TDate           today,
+    /** Date for which the PV is calculated and cash settled */
+    TDate           valueDate,
+    /** Date when step-in becomes effective */
+    TDate           stepinDate,
+    /** Date when protection begins. Either at start or end of day (depends
+        on protectStart) */
+    TDate           startDate,
+    /** Date when protection ends (end of day) */
+    TDate           endDate,
+    /** Fixed coupon rate (a.k.a. spread) for the fee leg */
+    double          couponRate,
+    /** Should accrued interest be paid on default. Usually set to TRUE */
+    TBoolean        payAccOnDefault,
+    /** Interval between coupon payments. Can be NULL when 3M is assumed */
+    TDateInterval  *couponInterval,
+    /** If the startDate and endDate are not on cycle, then this parameter
+        determines location of coupon dates. */
+    TStubMethod    *stubType,
+    /** Day count convention for coupon payment. Normal is ACT_360 */
+    long            paymentDcc,
+    /** Bad day convention for adjusting coupon payment dates. */
+    long            badDayConv,
+    /** Calendar used when adjusting coupon dates. Can be NULL which equals
+        a calendar with no holidays and including weekends. */
+    char           *calendar,
+    /** Interest rate discount curve - assumes flat forward interpolation */
+    TCurve         *discCurve,
+    /** Credit clean spread curve */
+    TCurve         *spreadCurve,
+    /** Assumed recovery rate in case of default */
+    double          recoveryRate,
+    /** Is the price expressed as a clean price (removing accrued interest) */
+    TBoolean        isPriceClean,
+    /** Output - price (a.k.a. upfront charge) for the CDS */
+    double         *price,
+    /** Output - derivative of the price with respect to the rate of each
+        point of discCurve. Array of size discCurve->fNumItems */
+    double         *discGrad,
+    /** Output - derivative of the price with respect to the rate of each
+        point of spreadCurve. Array of size spreadCurve->fNumItems */
+    double         *spreadGrad);
+
+
+/*t
+***************************************************************************
+** Table of vanilla CDS trades for batch pricing, stored as one array per
+** field. Each array has nbTrades elements.
+**
+** Trades which point to the same discount curve and spread curve share
+** timelines and curve evaluations when priced as a batch, so the curves
+** should be shared by pointer rather than copied for each trade.
+***************************************************************************
+*/
+typedef struct _TCdsTradeTable
+{
+    /** Number of trades in the table */
+    long            nbTrades;
+    /** Date when protection begins for each trade */
+    TDate          *startDates;
+    /** Date when protection ends for each trade (end of day) */
+    TDate          *endDates;
+    /** Fixed coupon rate (a.k.a. spread) for each trade */
+    double         *couponRates;
+    /** Assumed recovery rate in case of default for each trade */
+    double         *recoveryRates;
+    /** Interest rate discount curve for each trade */
+    TCurve        **discCurves;
+    /** Credit clean spread curve for each trade */
+    TCurve        **spreadCurves;
+} TCdsTradeTable;
+
+
+/*f
+***************************************************************************
+** Computes the price (a.k.a. upfront charge) for a table of vanilla CDS
+** which share the same contract conventions.
+**
+** Each price is identical to the result of JpmcdsCdsPrice for the same
+** trade. Trades are grouped by discount curve and spread curve - within
+** a group the timeline of the curves is computed once, and discount and
+** survival factors are evaluated at most once per date. Trades with the
+** same start date and end date also share their fee leg schedule.
+**
+** See JpmcdsCdsPriceBatchVectorIntegrals for a faster version whose
+** prices differ from JpmcdsCdsPrice by rounding.
+***************************************************************************
+*/
+EXPORT int JpmcdsCdsPriceBatch(
+    /** Risk starts at the end of today */
+    TDate           today,
+    /** Date for which the PV is calculated and cash settled */
+    TDate           valueDate,
+    /** Date when step-in becomes effective */
+    TDate           stepinDate,
+    /** Trades to be priced */
+    TCdsTradeTable *trades,
+    /** Should accrued interest be paid on default. Usually set to TRUE */
+    TBoolean        payAccOnDefault,
+    /** Interval between coupon payments. Can be NULL when 3M is assumed */
+    TDateInterval  *couponInterval,
+    /** If the startDate and endDate are not on cycle, then this parameter
+        determines location of coupon dates. */
+    TStubMethod    *stubType,
+    /** Day count convention for coupon payment. Normal is ACT_360 */
+    long            paymentDcc,
+    /** Bad day convention for adjusting coupon payment dates. */
+    long            badDayConv,
+    /** Calendar used when adjusting coupon dates. Can be NULL which equals
+        a calendar with no holidays and including weekends. */
+    char           *calendar,
+    /** Is the price expressed as a clean price (removing accrued interest) */
+    TBoolean        isPriceClean,
+    /** Output - price for each trade. Array of size trades->nbTrades */
+    double         *prices);
+
+
+/*f
+***************************************************************************
+** Computes the price for a table of vanilla CDS as JpmcdsCdsPriceBatch,
+** but integrates the legs with the segment integrals of segint.h. These
+** are faster where the processor supports AVX2, and the prices then
+** differ from JpmcdsCdsPrice only by rounding.
+***************************************************************************
+*/
+EXPORT int JpmcdsCdsPriceBatchVectorIntegrals(
+    /** Risk starts at the end of today */
+    TDate           today,
+    /** Date for which the PV is calculated and cash settled */
+    TDate           valueDate,
+    /** Date when step-in becomes effective */
+    TDate           stepinDate,
+    /** Trades to be priced */
+    TCdsTradeTable *trades,
+    /** Should accrued interest be paid on default. Usually set to TRUE */
+    TBoolean        payAccOnDefault,
+    /** Interval between coupon payments. Can be NULL when 3M is assumed */
+    TDateInterval  *couponInterval,
+    /** If the startDate and endDate are not on cycle, then this parameter
+        determines location of coupon dates. */
+    TStubMethod    *stubType,
+    /** Day count convention for coupon payment. Normal is ACT_360 */
+    long            paymentDcc,
+    /** Bad day convention for adjusting coupon payment dates. */
+    long            badDayConv,
+    /** Calendar used when adjusting coupon dates. Can be NULL which equals
+        a calendar with no holidays and including weekends. */
+    char           *calendar,
+    /** Is the price expressed as a clean price (removing accrued interest) */
+    TBoolean        isPriceClean,
+    /** Output - price for each trade. Array of size trades->nbTrades */
+    double         *prices);
+
   
 /*f
 ***************************************************************************
@@ -281,6 +493,53 @@ EXPORT int JpmcdsCdsParSpreads(
     double         *parSpread);
 
 
+/*f
+***************************************************************************
+** Computes the benchmark par spreads as JpmcdsCdsParSpreads, but values
+** both legs of each benchmark in a single walk of their timeline, and
+** accumulates the legs of all the benchmarks along one schedule where
+** their schedules allow.
+**
+** This is faster, and the spreads differ from those of JpmcdsCdsParSpreads
+** only by rounding, since the integrals are split at different dates.
+***************************************************************************
+*/
+EXPORT int JpmcdsCdsParSpreadsOneWalk(
+    /** Risk starts at the end of today */
+    TDate           today,
+    /** Date when step-in becomes effective  */
+    TDate           stepinDate,
+    /** Date when protection begins. Either at start or end of day (depends
+        on protectStart) */
+    TDate           startDate,
+    /** Number of benchmark dates */
+    long            nbEndDates,
+    /** Date when protection ends (end of day), no bad day adjustment */
+    TDate          *endDates,
+    /** Should accrued interest be paid on default. Usually set to TRUE */
+    TBoolean        payAccOnDefault,
+    /** Interval between coupon payments. Can be NULL when 3M is assumed */
+    TDateInterval  *couponInterval,
+    /** If the startDate and endDate are not on cycle, then this parameter
+        determines location of coupon dates. */
+    TStubMethod    *stubType,
+    /** Day count convention for coupon payment. Normal is ACT_360 */
+    long            paymentDcc,
+    /** Bad day convention for adjusting coupon payment dates. */
+    long            badDayConv,
+    /** Calendar used when adjusting coupon dates. Can be NULL which equals
+        a calendar with no holidays and including weekends. */
+    char           *calendar,
+    /** Interest rate discount curve - assumes flat forward interpolation */
+    TCurve         *discCurve,
+    /** Credit clean spread curve */
+    TCurve         *spreadCurve,
+    /** Assumed recovery rate in case of default */
+    double          recoveryRate,
+    /** Output - par spreads for the CDS are returned (see also isPriceClean) */
+    double         *parSpread);
+
+
 /*f
 ***************************************************************************
 ** Computes the non-contingent cash flows for a fee leg. These are the
@@ -374,6 +633,263 @@ EXPORT TCurve* JpmcdsCleanSpreadCurve(
     char           *calendar
 );
 
+
+/*f
+***************************************************************************
+** Bootstraps a clean spread curve as JpmcdsCleanSpreadCurve with a choice
+** of root finder for each point of the curve.
+**
+** BOOTSTRAP_NEWTON uses the analytic derivatives of the contingent leg and
+** the fee leg (including accrual on default) with respect to the hazard
+** rate being solved. It typically needs about half as many evaluations
+** of the legs as BOOTSTRAP_BRENT, which is what JpmcdsCleanSpreadCurve
+** uses. If Newton's method does not converge for a point then that point
+** is solved with Brent's method. The two solvers agree to within the
+** tolerance of the root finders.
+***************************************************************************
+*/
+EXPORT TCurve* JpmcdsCleanSpreadCurveWithSolver(
+    /** Risk starts at the end of today */
+    TDate           today,
+    /** Interest rate discount curve - assumes flat forward interpolation */
+    TCurve         *discCurve,
+    /** Effective date of the benchmark CDS */
+    TDate           startDate,
+    /** Step in date of the benchmark CDS */
+    TDate           stepinDate,
+    /** Date when payment should be make */
+    TDate           cashSettleDate,
+    /** Number of benchmark dates */
+    long            nbDate,
+    /** Dates when protection ends for each benchmark (end of day).
+        Array of size nbDate */
+    TDate          *endDates,
+    /** Coupon rates for each benchmark instrument. Array of size nbDate */
+    double         *couponRates,
+    /** Flags to denote that we include particular benchmarks. Can be NULL
+        if all are included. Otherwise an array of size nbDate. */
+    TBoolean       *includes,
+    /** Recovery rate in case of default */
+    double          recoveryRate,
+    /** Should accrued interest be paid on default. Usually set to TRUE */
+    TBoolean        payAccOnDefault,
+    /** Interval between coupon payments. Can be NULL when 3M is assumed */
+    TDateInterval  *couponInterval,
+    /** Day count convention for coupon payment. Normal is ACT_360 */
+    long            paymentDcc,
+    /** If the startDate and endDate are not on cycle, then this parameter
+        determines location of coupon dates. */
+    TStubMethod    *stubType,
+    /** Bad day convention for adjusting coupon payment dates. */
+    long            badDayConv,
+    /** Calendar used when adjusting coupon dates. Can be NULL which equals
+        a calendar with no holidays and including weekends. */
+    char           *calendar,
+    /** Root finder for each point of the curve */
+    TBootstrapSolver solver
+);
+
+
+/*f
+***************************************************************************
+** Re-bootstraps a clean spread curve when only some benchmark spreads have
+** changed since prevCurve was built by JpmcdsCleanSpreadCurve.
+**
+** Each point of the curve depends only on the benchmarks up to its own
+** maturity. So the points before benchmark firstChanged are copied from
+** prevCurve unchanged, and only firstChanged and the later benchmarks are
+** solved again. The inputs other than couponRates must be those used to
+** build prevCurve.
+**
+** The result agrees with a full JpmcdsCleanSpreadCurve rebuild to within
+** the tolerance of the root solver.
+***************************************************************************
+*/
+EXPORT TCurve* JpmcdsCleanSpreadCurveUpdate(
+    /** Risk starts at the end of today */
+    TDate           today,
+    /** Interest rate discount curve - assumes flat forward interpolation */
+    TCurve         *discCurve,
+    /** Effective date of the benchmark CDS */
+    TDate           startDate,
+    /** Step in date of the benchmark CDS */
+    TDate           stepinDate,
+    /** Date when payment should be make */
+    TDate           cashSettleDate,
+    /** Number of benchmark dates */
+    long            nbDate,
+    /** Dates when protection ends for each benchmark (end of day).
+        Array of size nbDate */
+    TDate          *endDates,
+    /** Coupon rates for each benchmark instrument. Array of size nbDate */
+    double         *couponRates,
+    /** Flags to denote that we include particular benchmarks. Can be NULL
+        if all are included. Otherwise an array of size nbDate. */
+    TBoolean       *includes,
+    /** Recovery rate in case of default */
+    double          recoveryRate,
+    /** Should accrued interest be paid on default. Usually set to TRUE */
+    TBoolean        payAccOnDefault,
+    /** Interval between coupon payments. Can be NULL when 3M is assumed */
+    TDateInterval  *couponInterval,
+    /** Day count convention for coupon payment. Normal is ACT_360 */
+    long            paymentDcc,
+    /** If the startDate and endDate are not on cycle, then this parameter
+        determines location of coupon dates. */
+    TStubMethod    *stubType,
+    /** Bad day convention for adjusting coupon payment dates. */
+    long            badDayConv,
+    /** Calendar used when adjusting coupon dates. Can be NULL which equals
+        a calendar with no holidays and including weekends. */
+    char           *calendar,
+    /** Curve previously built by JpmcdsCleanSpreadCurve from the same
+        benchmarks */
+    TCurve         *prevCurve,
+    /** Index of the first benchmark whose coupon rate has changed. Index
+        into endDates, couponRates and includes */
+    long            firstChanged
+);
+
+
+/*f
+***************************************************************************
+** Carries the gradient of a value with respect to the rates of a clean
+** spread curve back through its bootstrap, to give the gradient with
+** respect to the benchmark coupon rates.
+**
+** Each point of the curve is solved so that the PV of its benchmark is
+** zero, and that PV depends on the point and the points before it. The
+** gradient with respect to the benchmarks is found by solving the
+** transposed triangular system of the derivatives of the benchmark PVs,
+** which are themselves found by JpmcdsFeeAndContingentLegPVAdjoint.
+**
+** The value also depends on the discount curve through the spread curve.
+** That dependence is added to discGrad, which then holds the gradient
+** with respect to the discount curve rates with the benchmark spreads
+** held fixed.
+**
+** The inputs other than spreadCurve, spreadGrad, discGrad and couponGrad
+** must be those used to build spreadCurve with JpmcdsCleanSpreadCurve.
+***************************************************************************
+*/
+EXPORT int JpmcdsCleanSpreadCurveAdjoint(
+    /** Risk starts at the end of today */
+    TDate           today,
+    /** Interest rate discount curve - assumes flat forward interpolation */
+    TCurve         *discCurve,
+    /** Effective date of the benchmark CDS */
+    TDate           startDate,
+    /** Step in date of the benchmark CDS */
+    TDate           stepinDate,
+    /** Date when payment should be make */
+    TDate           cashSettleDate,
+    /** Number of benchmark dates */
+    long            nbDate,
+    /** Dates when protection ends for each benchmark (end of day).
+        Array of size nbDate */
+    TDate          *endDates,
+    /** Coupon rates for each benchmark instrument. Array of size nbDate */
+    double         *couponRates,
+    /** Flags to denote that we include particular benchmarks. Can be NULL
+        if all are included. Otherwise an array of size nbDate. */
+    TBoolean       *includes,
+    /** Recovery rate in case of default */
+    double          recoveryRate,
+    /** Should accrued interest be paid on default. Usually set to TRUE */
+    TBoolean        payAccOnDefault,
+    /** Interval between coupon payments. Can be NULL when 3M is assumed */
+    TDateInterval  *couponInterval,
+    /** Day count convention for coupon payment. Normal is ACT_360 */
+    long            paymentDcc,
+    /** If the startDate and endDate are not on cycle, then this parameter
+        determines location of coupon dates. */
+    TStubMethod    *stubType,
+    /** Bad day convention for adjusting coupon payment dates. */
+    long            badDayConv,
+    /** Calendar used when adjusting coupon dates. Can be NULL which equals
+        a calendar with no holidays and including weekends. */
+    char           *calendar,
+    /** Curve built by JpmcdsCleanSpreadCurve from the benchmarks */
+    TCurve         *spreadCurve,
+    /** Gradient of the value with respect to the rates of spreadCurve.
+        Array of size spreadCurve->fNumItems */
+    double         *spreadGrad,
+    /** Gradient of the value with respect to the rates of discCurve, to
+        which the dependence through spreadCurve is added. Array of size
+        discCurve->fNumItems. Can be NULL */
+    double         *discGrad,
+    /** Output - gradient of the value with respect to couponRates. Array
+        of size nbDate */
+    double         *couponGrad
+);
+
+
+/*f
+***************************************************************************
+** Bootstraps clean spread curves for many issuers against one discount
+** curve. The curves are independent and are built in parallel on a pool
+** of worker threads.
+**
+** Each curve is built exactly as by JpmcdsCleanSpreadCurve with the same
+** benchmark dates, using row k of couponRates and includes and element k
+** of recoveryRates.
+**
+** A failure to build one curve does not stop the others. On return
+** statuses[k] is SUCCESS and curves[k] is the curve, or statuses[k] is
+** FAILURE and curves[k] is NULL. The function itself only fails if the
+** inputs are invalid.
+***************************************************************************
+*/
+EXPORT int JpmcdsCleanSpreadCurves(
+    /** Risk starts at the end of today */
+    TDate           today,
+    /** Interest rate discount curve - assumes flat forward interpolation */
+    TCurve         *discCurve,
+    /** Effective date of the benchmark CDS */
+    TDate           startDate,
+    /** Step in date of the benchmark CDS */
+    TDate           stepinDate,
+    /** Date when payment should be make */
+    TDate           cashSettleDate,
+    /** Number of curves to bootstrap */
+    long            nbCurve,
+    /** Number of benchmark dates */
+    long            nbDate,
+    /** Dates when protection ends for each benchmark (end of day).
+        Array of size nbDate */
+    TDate          *endDates,
+    /** Coupon rates for each curve and benchmark instrument. Array of size
+        nbCurve*nbDate, with the rates for curve k starting at k*nbDate */
+    double         *couponRates,
+    /** Flags to denote that we include particular benchmarks for each
+        curve. Can be NULL if all are included. Otherwise an array of size
+        nbCurve*nbDate laid out as couponRates. */
+    TBoolean       *includes,
+    /** Recovery rate in case of default for each curve. Array of size
+        nbCurve */
+    double         *recoveryRates,
+    /** Should accrued interest be paid on default. Usually set to TRUE */
+    TBoolean        payAccOnDefault,
+    /** Interval between coupon payments. Can be NULL when 3M is assumed */
+    TDateInterval  *couponInterval,
+    /** Day count convention for coupon payment. Normal is ACT_360 */
+    long            paymentDcc,
+    /** If the startDate and endDate are not on cycle, then this parameter
+        determines location of coupon dates. */
+    TStubMethod    *stubType,
+    /** Bad day convention for adjusting coupon payment dates. */
+    long            badDayConv,
+    /** Calendar used when adjusting coupon dates. Can be NULL which equals
+        a calendar with no holidays and including weekends. */
+    char           *calendar,
+    /** Number of worker threads. Zero or less means one per processor */
+    int             nbThreads,
+    /** Output curves. Array of size nbCurve */
+    TCurve        **curves,
+    /** Output status of each curve. Array of size nbCurve */
+    int            *statuses
+);
+
 #ifdef __cplusplus
 }
 #endif
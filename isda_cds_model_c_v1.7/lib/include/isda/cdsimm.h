@@ -0,0 +1,96 @@
+/*
+ * ISDA CDS Standard Model
+ *
+ * Copyright (C) 2009 International Swaps and Derivatives Association, Inc.
+ * Developed and supported in collaboration with Markit
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the ISDA CDS Standard Model Public License.
+ */
+
+#ifndef CDSIMM_H
+#define CDSIMM_H
+
+#include "cdate.h"
+#include "buscache.h"
+#include "stub.h"
+#include "schedcache.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/* years covered by the table of CDS IMM dates */
+#define JPMCDS_IMM_FIRST_YEAR 1900
+#define JPMCDS_IMM_LAST_YEAR  2199
+
+
+/*f
+***************************************************************************
+** Returns TRUE if a date is a CDS IMM date, that is the 20th of March,
+** June, September or December, within the years of the table of IMM
+** dates.
+***************************************************************************
+*/
+TBoolean JpmcdsIsImmDate
+(TDate          date);          /* (I) Date to test */
+
+
+/*f
+***************************************************************************
+** Returns the first CDS IMM date strictly after a date. Fails if it is
+** not within the years of the table of IMM dates.
+***************************************************************************
+*/
+int JpmcdsImmDateNext
+(TDate          date,           /* (I) Date */
+ TDate         *immDate);       /* (O) Next IMM date */
+
+
+/*f
+***************************************************************************
+** Returns TRUE if JpmcdsCdsImmScheduleMake can make the fee leg schedule
+** with the given terms. That is the case for quarterly payments with a
+** front stub, ending on an IMM date after the start date, with both
+** dates within the years of the table of IMM dates.
+***************************************************************************
+*/
+TBoolean JpmcdsCdsImmScheduleValid
+(TDate          startDate,      /* (I) Start of the first period       */
+ TDate          endDate,        /* (I) End of protection               */
+ TDateInterval *dateInterval,   /* (I) Interval between payments       */
+ TStubMethod   *stubType);      /* (I) Location and length of the stub */
+
+
+/*f
+***************************************************************************
+** Makes the fee leg schedule of a standard quarterly IMM CDS in one pass
+** over the table of IMM dates, adjusting the dates with a holiday list
+** which has already been found. The schedule is the same as the one made
+** by JpmcdsCdsFeeLegMake with the same terms.
+**
+** The terms must be accepted by JpmcdsCdsImmScheduleValid. The holiday
+** list is not used, and can be NULL, when badDayConv is
+** JPMCDS_BAD_DAY_NONE.
+**
+** The three arrays of the schedule share one allocation, which is freed
+** with FREE(schedule->accStartDates).
+***************************************************************************
+*/
+int JpmcdsCdsImmScheduleMake
+(TDate            startDate,    /* (I) Start of the first period       */
+ TDate            endDate,      /* (I) End of protection               */
+ TDateInterval   *dateInterval, /* (I) Interval between payments       */
+ TStubMethod     *stubType,     /* (I) Location and length of the stub */
+ long             badDayConv,   /* (I) Adjustment of payment dates     */
+ THolidayList    *hl,           /* (I) Holidays for the adjustment     */
+ TBoolean         protectStart, /* (I) Protection from start of day    */
+ TFeeLegSchedule *schedule);    /* (O) Schedule made                   */
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
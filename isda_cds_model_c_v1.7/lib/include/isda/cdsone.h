@@ -72,6 +72,80 @@ EXPORT int JpmcdsCdsoneSpread
  TBoolean        payAccruedAtStart,
  double         *oneSpread);
 
+
+/*f
+***************************************************************************
+** Computes the upfront charges for many flat spread quotes at once.
+**
+** Quote k is converted as by JpmcdsCdsoneUpfrontCharge with endDates[k],
+** couponRates[k], oneSpreads[k] and recoveryRates[k]. The quotes are
+** grouped by end date, and the quotes of one group share their fee leg
+** schedules, discount factors and timelines. Each flat hazard rate is
+** found by Newton's method with analytic derivatives.
+**
+** The results agree with JpmcdsCdsoneUpfrontCharge to the accuracy of
+** its root finder. A quote which cannot be converted is marked FAILURE
+** in statuses and does not stop the others.
+***************************************************************************
+*/
+EXPORT int JpmcdsCdsoneUpfrontCharges
+(TDate           today,
+ TDate           valueDate,
+ TDate           benchmarkStartDate,  /* start date of benchmark CDS for
+                                      ** internal clean spread bootstrapping */
+ TDate           stepinDate,
+ TDate           startDate,           /* CDS start date, can be in the past */
+ long            nbQuote,
+ TDate          *endDates,            /* [nbQuote] */
+ double         *couponRates,         /* [nbQuote] */
+ TBoolean        payAccruedOnDefault,
+ TDateInterval  *dateInterval,
+ TStubMethod    *stubType,
+ long            accrueDCC,
+ long            badDayConv,
+ char           *calendar,
+ TCurve         *discCurve,
+ double         *oneSpreads,          /* [nbQuote] */
+ double         *recoveryRates,       /* [nbQuote] */
+ TBoolean        payAccruedAtStart,
+ double         *upfrontCharges,      /* (O) [nbQuote] */
+ int            *statuses);           /* (O) [nbQuote] SUCCESS or FAILURE */
+
+
+/*f
+***************************************************************************
+** Computes the flat spreads for many upfront charges at once.
+**
+** Quote k is converted as by JpmcdsCdsoneSpread with endDates[k],
+** couponRates[k], upfrontCharges[k] and recoveryRates[k], and shares
+** its schedules and discount factors as in JpmcdsCdsoneUpfrontCharges.
+** The flat hazard rate which matches the upfront charge is solved for
+** directly, so there is no nested root search.
+***************************************************************************
+*/
+EXPORT int JpmcdsCdsoneSpreads
+(TDate           today,
+ TDate           valueDate,
+ TDate           benchmarkStartDate,  /* start date of benchmark CDS for
+                                      ** internal clean spread bootstrapping */
+ TDate           stepinDate,
+ TDate           startDate,           /* CDS start date, can be in the past */
+ long            nbQuote,
+ TDate          *endDates,            /* [nbQuote] */
+ double         *couponRates,         /* [nbQuote] */
+ TBoolean        payAccruedOnDefault,
+ TDateInterval  *dateInterval,
+ TStubMethod    *stubType,
+ long            accrueDCC,
+ long            badDayConv,
+ char           *calendar,
+ TCurve         *discCurve,
+ double         *upfrontCharges,      /* [nbQuote] */
+ double         *recoveryRates,       /* [nbQuote] */
+ TBoolean        payAccruedAtStart,
+ double         *oneSpreads,          /* (O) [nbQuote] */
+ int            *statuses);           /* (O) [nbQuote] SUCCESS or FAILURE */
+
 #ifdef __cplusplus
 }
 #endif
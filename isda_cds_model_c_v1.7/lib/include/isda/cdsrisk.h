@@ -0,0 +1,130 @@
+/*
+ * ISDA CDS Standard Model
+ *
+ * Copyright (C) 2009 International Swaps and Derivatives Association, Inc.
+ * Developed and supported in collaboration with Markit
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the ISDA CDS Standard Model Public License.
+ */
+
+#ifndef CDSRISK_H
+#define CDSRISK_H
+
+#include "cx.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+
+/*f
+***************************************************************************
+** Computes the bucketed credit spread and interest rate sensitivities of
+** a set of vanilla CDS trades which share one discount curve and one
+** clean spread curve.
+**
+** The discount curve is built as by JpmcdsBuildIRZeroCurve and the clean
+** spread curve as by JpmcdsCleanSpreadCurve. Each benchmark spread and
+** each rate is then bumped in turn by csBump and irBump. For each bump
+** only the points of the curves at and after the bumped quote are
+** bootstrapped again, and each trade only values the parts of its legs
+** which observe the curves where they have changed.
+**
+** The trades have a notional of one and are priced as by JpmcdsCdsPrice
+** with the same conventions as the benchmarks. For trade k, cs01 holds
+** at k*nbDate+j the change in price when benchmark j is bumped, and ir01
+** holds at k*nbRate+r the change in price when rate r is bumped. Benchmarks
+** which are not included have no sensitivity.
+***************************************************************************
+*/
+EXPORT int JpmcdsCdsBucketedRisk(
+    /** Risk starts at the end of today */
+    TDate           today,
+    /** Date for which the PV is calculated and cash settled */
+    TDate           valueDate,
+    /** Date when step-in becomes effective */
+    TDate           stepinDate,
+    /** Value date of the discount curve */
+    TDate           discValueDate,
+    /** Number of rate instruments */
+    long            nbRate,
+    /** Type of each rate instrument, 'M' or 'S'. Array of size nbRate */
+    char           *rateTypes,
+    /** Maturity of each rate instrument. Array of size nbRate */
+    TDate          *rateDates,
+    /** Rate of each instrument. Array of size nbRate */
+    double         *rates,
+    /** Day count convention of money market instruments */
+    long            mmDcc,
+    /** Fixed leg frequency of swaps */
+    long            fixedSwapFreq,
+    /** Floating leg frequency of swaps */
+    long            floatSwapFreq,
+    /** Day count convention of the fixed leg of swaps */
+    long            fixedSwapDcc,
+    /** Day count convention of the floating leg of swaps */
+    long            floatSwapDcc,
+    /** Bad day convention of swaps */
+    long            swapBadDayConv,
+    /** Holiday file of swaps */
+    char           *swapHolidays,
+    /** Effective date of the benchmark CDS */
+    TDate           benchmarkStartDate,
+    /** Number of benchmark dates */
+    long            nbDate,
+    /** Dates when protection ends for each benchmark (end of day).
+        Array of size nbDate */
+    TDate          *endDates,
+    /** Coupon rates for each benchmark instrument. Array of size nbDate */
+    double         *couponRates,
+    /** Flags to denote that we include particular benchmarks. Can be NULL
+        if all are included. Otherwise an array of size nbDate. */
+    TBoolean       *includes,
+    /** Recovery rate in case of default */
+    double          recoveryRate,
+    /** Should accrued interest be paid on default. Usually set to TRUE */
+    TBoolean        payAccOnDefault,
+    /** Interval between coupon payments. Can be NULL when 3M is assumed */
+    TDateInterval  *couponInterval,
+    /** Day count convention for coupon payment. Normal is ACT_360 */
+    long            paymentDcc,
+    /** If the startDate and endDate are not on cycle, then this parameter
+        determines location of coupon dates. */
+    TStubMethod    *stubType,
+    /** Bad day convention for adjusting coupon payment dates. */
+    long            badDayConv,
+    /** Calendar used when adjusting coupon dates. Can be NULL which equals
+        a calendar with no holidays and including weekends. */
+    char           *calendar,
+    /** Number of trades */
+    long            nbTrade,
+    /** Date when protection begins for each trade. Array of size nbTrade */
+    TDate          *tradeStartDates,
+    /** Date when protection ends for each trade (end of day). Array of
+        size nbTrade */
+    TDate          *tradeEndDates,
+    /** Fixed coupon rate for each trade. Array of size nbTrade */
+    double         *tradeCouponRates,
+    /** Is the price expressed as a clean price (removing accrued interest) */
+    TBoolean        isPriceClean,
+    /** Bump added to each benchmark coupon rate */
+    double          csBump,
+    /** Bump added to each rate */
+    double          irBump,
+    /** Output - price of each trade. Array of size nbTrade */
+    double         *prices,
+    /** Output - credit spread sensitivities. Array of size nbTrade*nbDate.
+        Can be NULL */
+    double         *cs01,
+    /** Output - interest rate sensitivities. Array of size nbTrade*nbRate.
+        Can be NULL */
+    double         *ir01);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
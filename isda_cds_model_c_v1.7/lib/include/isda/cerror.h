@@ -124,6 +124,9 @@ EXPORT int JpmcdsErrMsgFileName(
 ***************************************************************************
 ** Returns pointer to privately held error log file name which was set by 
 ** JpmcdsErrMsgFileName.
+**
+** The name is a copy held separately for each thread, which stays valid
+** until the same thread calls JpmcdsErrMsgGetFileName again.
 ***************************************************************************
 */
 EXPORT char* JpmcdsErrMsgGetFileName(void);
@@ -131,7 +134,8 @@ EXPORT char* JpmcdsErrMsgGetFileName(void);
 
 /*f
 ***************************************************************************
-** Turns on the error message record facility.
+** Returns the error messages recorded by the calling thread, oldest
+** first. Each thread has its own record.
 ***************************************************************************
 */
 EXPORT char** JpmcdsErrGetMsgRecord(void);
@@ -139,7 +143,11 @@ EXPORT char** JpmcdsErrGetMsgRecord(void);
 
 /*f
 ***************************************************************************
-** Turns on the error message record facility.
+** Turns on the error message record facility for the calling thread.
+**
+** Messages are recorded separately for each thread which enables the
+** record. A thread should call JpmcdsErrMsgDisableRecord before it exits
+** to release its record.
 ***************************************************************************
 */
 EXPORT int JpmcdsErrMsgEnableRecord(
@@ -149,7 +157,7 @@ EXPORT int JpmcdsErrMsgEnableRecord(
 
 /*f
 ***************************************************************************
-** Turns off the error message record facility.
+** Turns off the error message record facility for the calling thread.
 ***************************************************************************
 */
 EXPORT int JpmcdsErrMsgDisableRecord(void);
@@ -38,6 +38,71 @@ void* JpmcdsMallocSafe(size_t theSize);
 void JpmcdsFreeSafe(void *x);     /* (I) */
 
 
+/*t
+***************************************************************************
+** Arena for short-lived allocations.
+**
+** JpmcdsArenaAlloc takes memory from an arena by moving a pointer along
+** its latest block. The memory is never freed on its own: all of it is
+** released at once by JpmcdsArenaReset, and must not be used after that.
+**
+** Only the routines which are given an arena use it - NEW and FREE always
+** use the heap. An arena must not be used by two threads at once.
+***************************************************************************
+*/
+typedef struct _TArenaBlock
+{
+    struct _TArenaBlock *next;          /* older block */
+    size_t               size;          /* bytes available in the block */
+    size_t               used;          /* bytes handed out */
+} TArenaBlock;
+
+typedef struct _TArena
+{
+    TArenaBlock         *blocks;        /* latest block first */
+    size_t               blockSize;     /* minimum size of a new block */
+} TArena;
+
+/* block size used by JpmcdsArenaMake if none is given */
+#define JPMCDS_ARENA_BLOCK_SIZE 65536
+
+
+/*f
+***************************************************************************
+** Makes an empty arena. New blocks are at least blockSize bytes, or
+** JPMCDS_ARENA_BLOCK_SIZE if blockSize is 0.
+***************************************************************************
+*/
+TArena* JpmcdsArenaMake(size_t blockSize);
+
+
+/*f
+***************************************************************************
+** Returns cleared memory from an arena, aligned for any type, or NULL if
+** no memory left.
+***************************************************************************
+*/
+void* JpmcdsArenaAlloc(TArena *arena, size_t theSize);
+
+
+/*f
+***************************************************************************
+** Releases all the memory handed out by an arena so it can be used
+** again. If the arena grew beyond one block, its blocks are replaced by a
+** single block of their total size.
+***************************************************************************
+*/
+void JpmcdsArenaReset(TArena *arena);
+
+
+/*f
+***************************************************************************
+** Frees an arena and all the memory it handed out.
+***************************************************************************
+*/
+void JpmcdsArenaFree(TArena *arena);
+
+
 #ifdef __cplusplus
 }
 #endif
@@ -12,6 +12,7 @@
 #define CONTINGENT_LEG_H
 
 #include "cx.h"
+#include "curvecache.h"
 
 #ifdef __cplusplus
 extern "C"
@@ -38,6 +39,48 @@ int JpmcdsContingentLegPV
  double          recoveryRate,     /* (I) Recovery rate                   */
  double         *pv);              /* (O) Present value of contingent leg */
 
+
+/*f
+***************************************************************************
+** Computes the PV of a contingent leg as a whole, taking the discount and
+** survival factors from a curve pair cache.
+**
+** The result is identical to JpmcdsContingentLegPV with the curves of the
+** cache. When the cache has critical dates, no timeline is built for the
+** curves.
+***************************************************************************
+*/
+int JpmcdsContingentLegPVWithCache
+(TContingentLeg  *cl,              /* (I) Contingent leg                  */
+ TDate            today,           /* (I) No observations before today    */
+ TDate            valueDate,       /* (I) Value date for discounting      */
+ TDate            stepinDate,      /* (I) Step-in date                    */
+ TCurvePairCache *curves,          /* (I/O) Risk-free and spread curves   */
+ double           recoveryRate,    /* (I) Recovery rate                   */
+ double          *pv);             /* (O) Present value of contingent leg */
+
+
+/*f
+***************************************************************************
+** Computes the PV of a contingent leg as JpmcdsContingentLegPVWithCache,
+** and also its derivative with respect to the rate of point spreadNode of
+** the spread curve in the cache. The spread curve must be continuously
+** compounded ACT/365F.
+**
+** The pv is identical to that of JpmcdsContingentLegPVWithCache unless
+** curves->vectorIntegrals is set.
+***************************************************************************
+*/
+int JpmcdsContingentLegPVWithDeriv
+(TContingentLeg  *cl,              /* (I) Contingent leg                  */
+ TDate            today,           /* (I) No observations before today    */
+ TDate            valueDate,       /* (I) Value date for discounting      */
+ TDate            stepinDate,      /* (I) Step-in date                    */
+ TCurvePairCache *curves,          /* (I/O) Risk-free and spread curves   */
+ double           recoveryRate,    /* (I) Recovery rate                   */
+ double          *pv,              /* (O) Present value of contingent leg */
+ double          *dpv);            /* (O) Derivative of pv - can be NULL  */
+
 #ifdef __cplusplus
 }
 #endif
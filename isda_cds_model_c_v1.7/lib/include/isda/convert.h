@@ -22,25 +22,56 @@ extern "C"
 
 
 
+/* Size of buffer needed by JpmcdsFormatDateToBuffer and
+   JpmcdsFormatDateIntervalToBuffer, including the terminating null. */
+#define JPMCDS_FORMAT_DATE_LEN 16
+
+
 /*f
 ***************************************************************************
 ** Formats a TDate for printing. The print format is YYYYMMDD. 
 ** Can be called eight times from the same print statement, but not more.
+**
+** The buffers are kept separately for each thread.
 ***************************************************************************
 */
 char* JpmcdsFormatDate(TDate date);
 
 
+/*f
+***************************************************************************
+** Formats a TDate for printing into a buffer provided by the caller.
+** The print format is YYYYMMDD. Returns the buffer.
+***************************************************************************
+*/
+char* JpmcdsFormatDateToBuffer
+    (TDate date,                /* (I) */
+     char *buffer);             /* (O) [JPMCDS_FORMAT_DATE_LEN] */
+
+
 /*f
 ***************************************************************************
 ** Formats a TDateInterval.
 ** Can be called twice from the same print statement, but not more.
+**
+** The buffers are kept separately for each thread.
 ***************************************************************************
 */
 char* JpmcdsFormatDateInterval
     (TDateInterval *interval);  /* (I) */
 
 
+/*f
+***************************************************************************
+** Formats a TDateInterval into a buffer provided by the caller.
+** Returns the buffer.
+***************************************************************************
+*/
+char* JpmcdsFormatDateIntervalToBuffer
+    (TDateInterval *interval,   /* (I) */
+     char          *buffer);    /* (O) [JPMCDS_FORMAT_DATE_LEN] */
+
+
 /*f
 ***************************************************************************
 ** Converts a date in string format to a TDate.
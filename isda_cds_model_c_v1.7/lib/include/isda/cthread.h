@@ -0,0 +1,188 @@
+/*
+ * ISDA CDS Standard Model
+ *
+ * Copyright (C) 2009 International Swaps and Derivatives Association, Inc.
+ * Developed and supported in collaboration with Markit
+ * 
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the ISDA CDS Standard Model Public License.
+ */
+
+#ifndef CTHREAD_H
+#define CTHREAD_H
+
+#include "cgeneral.h"
+
+#if defined(WIN32) || defined(_WIN32)
+#include <windows.h>
+#else
+#include <pthread.h>
+#endif
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/*
+***************************************************************************
+** Portable wrappers for the small number of threading primitives used by
+** the library. On Windows these map onto slim reader/writer locks, and
+** elsewhere onto POSIX threads.
+**
+** Locks are intended to be defined statically using the initialisers
+** below, so that no initialisation call is needed before the library is
+** first used.
+***************************************************************************
+*/
+
+/*m
+***************************************************************************
+** Storage class for variables which have a separate instance in each
+** thread.
+***************************************************************************
+*/
+#if defined(_MSC_VER)
+#define JPMCDS_THREAD_LOCAL __declspec(thread)
+#elif defined(__GNUC__) || defined(__SUNPRO_C) || defined(__IBMC__)
+#define JPMCDS_THREAD_LOCAL __thread
+#else
+#define JPMCDS_THREAD_LOCAL _Thread_local
+#endif
+
+/*m
+***************************************************************************
+** JPMCDS_ATOMIC_LOAD_PTR and JPMCDS_ATOMIC_STORE_PTR read and write a
+** pointer shared between threads without a lock. A thread which loads a
+** pointer also sees everything written before the pointer was stored.
+**
+** JPMCDS_ATOMIC_LOAD_INT and JPMCDS_ATOMIC_STORE_INT do the same for an
+** int, such as a TBoolean flag.
+***************************************************************************
+*/
+
+#if defined(WIN32) || defined(_WIN32)
+
+typedef SRWLOCK TMutex;
+typedef SRWLOCK TRWLock;
+
+#define JPMCDS_MUTEX_INIT   SRWLOCK_INIT
+#define JPMCDS_RWLOCK_INIT  SRWLOCK_INIT
+
+#define JPMCDS_ATOMIC_LOAD_PTR(p) \
+    InterlockedCompareExchangePointer((PVOID volatile *)(p), NULL, NULL)
+#define JPMCDS_ATOMIC_STORE_PTR(p, v) \
+    ((void)InterlockedExchangePointer((PVOID volatile *)(p), (PVOID)(v)))
+#define JPMCDS_ATOMIC_LOAD_INT(p) \
+    ((int)InterlockedCompareExchange((LONG volatile *)(p), 0, 0))
+#define JPMCDS_ATOMIC_STORE_INT(p, v) \
+    ((void)InterlockedExchange((LONG volatile *)(p), (LONG)(v)))
+
+#else
+
+typedef pthread_mutex_t  TMutex;
+typedef pthread_rwlock_t TRWLock;
+
+#define JPMCDS_MUTEX_INIT   PTHREAD_MUTEX_INITIALIZER
+#define JPMCDS_RWLOCK_INIT  PTHREAD_RWLOCK_INITIALIZER
+
+#define JPMCDS_ATOMIC_LOAD_PTR(p)     __atomic_load_n((p), __ATOMIC_ACQUIRE)
+#define JPMCDS_ATOMIC_STORE_PTR(p, v) __atomic_store_n((p), (v), __ATOMIC_RELEASE)
+#define JPMCDS_ATOMIC_LOAD_INT(p)     __atomic_load_n((p), __ATOMIC_ACQUIRE)
+#define JPMCDS_ATOMIC_STORE_INT(p, v) __atomic_store_n((p), (v), __ATOMIC_RELEASE)
+
+#endif
+
+
+/*f
+***************************************************************************
+** Acquires a mutex. Mutexes are not recursive.
+***************************************************************************
+*/
+void JpmcdsMutexLock(TMutex *mutex);
+
+
+/*f
+***************************************************************************
+** Releases a mutex acquired by JpmcdsMutexLock.
+***************************************************************************
+*/
+void JpmcdsMutexUnlock(TMutex *mutex);
+
+
+/*f
+***************************************************************************
+** Acquires a reader/writer lock for reading. Many threads can hold the
+** lock for reading at the same time.
+***************************************************************************
+*/
+void JpmcdsRWLockRead(TRWLock *lock);
+
+
+/*f
+***************************************************************************
+** Releases a reader/writer lock acquired by JpmcdsRWLockRead.
+***************************************************************************
+*/
+void JpmcdsRWLockReadUnlock(TRWLock *lock);
+
+
+/*f
+***************************************************************************
+** Acquires a reader/writer lock for writing. This excludes all readers
+** and all other writers.
+***************************************************************************
+*/
+void JpmcdsRWLockWrite(TRWLock *lock);
+
+
+/*f
+***************************************************************************
+** Releases a reader/writer lock acquired by JpmcdsRWLockWrite.
+***************************************************************************
+*/
+void JpmcdsRWLockWriteUnlock(TRWLock *lock);
+
+
+/*t
+***************************************************************************
+** Task called by JpmcdsParallelFor for each index i in [0,n).
+***************************************************************************
+*/
+typedef void (*TParallelFunc)(void *data, long i);
+
+
+/*f
+***************************************************************************
+** Returns the number of processors available to the process, and at
+** least one.
+***************************************************************************
+*/
+int JpmcdsNumProcessors(void);
+
+
+/*f
+***************************************************************************
+** Calls func(data, i) for each i in [0,n) on a pool of worker threads.
+** Indices are handed out one at a time, so tasks of uneven cost are
+** spread evenly. Returns when all tasks have completed.
+**
+** The calling thread is one of the workers. If nbThreads <= 0 then one
+** worker is used per processor. If a worker thread cannot be started,
+** its share of the tasks is done by the remaining workers.
+**
+** Tasks must not share mutable data unless they synchronise access
+** themselves.
+***************************************************************************
+*/
+int JpmcdsParallelFor
+(long           n,              /* (I) Number of tasks                 */
+ int            nbThreads,      /* (I) Number of workers. <= 0 => all  */
+ TParallelFunc  func,           /* (I) Task                            */
+ void          *data);          /* (I) Passed to each task             */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif    /* CTHREAD_H */
@@ -0,0 +1,226 @@
+/*
+ * ISDA CDS Standard Model
+ *
+ * Copyright (C) 2009 International Swaps and Derivatives Association, Inc.
+ * Developed and supported in collaboration with Markit
+ * 
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the ISDA CDS Standard Model Public License.
+ */
+
+#ifndef CURVECACHE_H
+#define CURVECACHE_H
+
+#include "cx.h"
+#include "cmemory.h"
+#include "prepcurve.h"
+#include "timeline.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/*t
+***************************************************************************
+** Discount and survival factors for a pair of curves, observed from
+** today, together with the critical dates of both curves.
+**
+** Valuations which share a discount curve and a spread curve can share
+** one of these. Factors are evaluated on first use and remembered for
+** dates in [firstDate, firstDate+numDates). Outside that range (or when
+** numDates=0) they are evaluated directly from the curves.
+**
+** Routines which compute derivatives do so with respect to the rate of
+** point spreadNode of the spread curve.
+**
+** When the curves have been prepared, factors which are not remembered
+** are evaluated from the prepared curves instead.
+**
+** If vectorIntegrals is set, the legs integrate over their timelines with
+** the segment integrals of segint.h, which may differ by rounding from
+** the integrals of the legs themselves. It is not set by default - see
+** JpmcdsCurvePairCacheSetVectorIntegrals.
+**
+** If arena is given, the legs take the scratch memory of each valuation
+** from it instead of the heap - see JpmcdsCurvePairCacheSetArena.
+***************************************************************************
+*/
+typedef struct _TCurvePairCache
+{
+    TDate       today;          /* factors are forward from today */
+    TCurve     *discCurve;      /* risk-free curve */
+    TCurve     *spreadCurve;    /* clean spread curve */
+    TDateList  *criticalDates;  /* dates of both curves - can be NULL */
+    TDate       firstDate;      /* first date of remembered factors */
+    long        numDates;       /* number of remembered dates */
+    double     *discount;       /* [numDates] 0 => not yet evaluated */
+    double     *survival;       /* [numDates] 0 => not yet evaluated */
+    long        spreadNode;     /* spread curve point for derivatives */
+    TPreparedCurve *discPrepared;   /* prepared discCurve - can be NULL */
+    TPreparedCurve *spreadPrepared; /* prepared spreadCurve - can be NULL */
+    TBoolean    vectorIntegrals; /* use the integrals of segint.h */
+    TArena     *arena;          /* scratch for the legs - can be NULL */
+} TCurvePairCache;
+
+
+/*f
+***************************************************************************
+** Initialises a cache which remembers nothing and has no critical dates.
+** Does not allocate memory, so this can be used on the stack to pass a
+** pair of curves to routines which take a TCurvePairCache.
+***************************************************************************
+*/
+void JpmcdsCurvePairCacheInit
+(TCurvePairCache *cache,        /* (O) Cache to initialise             */
+ TDate            today,        /* (I) Factors are forward from today  */
+ TCurve          *discCurve,    /* (I) Risk-free curve                 */
+ TCurve          *spreadCurve); /* (I) Clean spread curve              */
+
+
+/*f
+***************************************************************************
+** Prepares both curves of a cache. Factors are identical with or without
+** the prepared curves, but are faster to evaluate with them.
+**
+** A curve which JpmcdsPreparedCurveMake cannot prepare, such as one with
+** repeated dates, is left unprepared rather than failing.
+**
+** A cache initialised on the stack must then be released with
+** JpmcdsCurvePairCacheClear.
+***************************************************************************
+*/
+int JpmcdsCurvePairCachePrepare
+(TCurvePairCache *cache);       /* (I/O) Cache                         */
+
+
+/*f
+***************************************************************************
+** Chooses whether the legs valued with a cache integrate with the segment
+** integrals of segint.h. These process four segments at a time where the
+** processor supports AVX2 and FMA, and the leg values then differ from
+** the default integrals only by rounding. Derivatives are always computed
+** with the default integrals.
+***************************************************************************
+*/
+void JpmcdsCurvePairCacheSetVectorIntegrals
+(TCurvePairCache *cache,        /* (I/O) Cache                         */
+ TBoolean         vectorIntegrals); /* (I) Use the segment integrals   */
+
+
+/*f
+***************************************************************************
+** Gives a cache an arena from which the legs valued with it take their
+** scratch memory, or takes it away if arena is NULL. The arena is not
+** owned by the cache.
+**
+** Nothing taken from the arena outlives the valuation, so the caller can
+** reset it after each valuation. Otherwise it grows with every valuation.
+***************************************************************************
+*/
+void JpmcdsCurvePairCacheSetArena
+(TCurvePairCache *cache,        /* (I/O) Cache                         */
+ TArena          *arena);       /* (I) Arena - can be NULL             */
+
+
+/*f
+***************************************************************************
+** Frees the memory held by a cache, but not the cache itself.
+***************************************************************************
+*/
+void JpmcdsCurvePairCacheClear
+(TCurvePairCache *cache);       /* (I/O) Cache                         */
+
+
+/*f
+***************************************************************************
+** Makes a cache which remembers factors for dates in [firstDate,lastDate]
+** and holds the critical dates and prepared versions of both curves.
+**
+** The curves are not copied and must not change while the cache is used.
+***************************************************************************
+*/
+TCurvePairCache* JpmcdsCurvePairCacheMake
+(TDate            today,        /* (I) Factors are forward from today  */
+ TDate            firstDate,    /* (I) First date to remember          */
+ TDate            lastDate,     /* (I) Last date to remember           */
+ TCurve          *discCurve,    /* (I) Risk-free curve                 */
+ TCurve          *spreadCurve); /* (I) Clean spread curve              */
+
+
+/*f
+***************************************************************************
+** Frees a cache made by JpmcdsCurvePairCacheMake.
+***************************************************************************
+*/
+void JpmcdsCurvePairCacheFree(TCurvePairCache *cache);
+
+
+/*f
+***************************************************************************
+** Returns the discount factor from today to the given date. The result
+** is identical to JpmcdsForwardZeroPrice(discCurve, today, date).
+***************************************************************************
+*/
+double JpmcdsCurvePairCacheDiscount
+(TCurvePairCache *cache,        /* (I/O) Cache                         */
+ TDate            date);        /* (I) Date                            */
+
+
+/*f
+***************************************************************************
+** Returns the survival probability from today to the given date. The
+** result is identical to JpmcdsForwardZeroPrice(spreadCurve, today, date).
+***************************************************************************
+*/
+double JpmcdsCurvePairCacheSurvival
+(TCurvePairCache *cache,        /* (I/O) Cache                         */
+ TDate            date);        /* (I) Date                            */
+
+
+/*f
+***************************************************************************
+** Returns the survival probability and the discount factor from today to
+** each of an array of dates. Discount factors for dates before today are
+** those for today.
+***************************************************************************
+*/
+void JpmcdsCurvePairCacheFactors
+(TCurvePairCache *cache,        /* (I/O) Cache                         */
+ long             numDates,     /* (I) Number of dates                 */
+ TDate           *dates,        /* (I) [numDates] Dates                */
+ double          *survival,     /* (O) [numDates] Survival             */
+ double          *discount);    /* (O) [numDates] Discount factors     */
+
+
+/*f
+***************************************************************************
+** Returns the survival probability and the discount factor from today to
+** each date of a timeline view, as JpmcdsCurvePairCacheFactors does for
+** an array of the same dates.
+***************************************************************************
+*/
+void JpmcdsCurvePairCacheViewFactors
+(TCurvePairCache *cache,        /* (I/O) Cache                         */
+ TTimeLineView   *view,         /* (I) Timeline                        */
+ double          *survival,     /* (O) [view size] Survival            */
+ double          *discount);    /* (O) [view size] Discount factors    */
+
+
+/*f
+***************************************************************************
+** Returns the derivative of the log of the survival probability from
+** today to the given date with respect to the rate of point spreadNode
+** of the spread curve. The spread curve must be continuously compounded
+** ACT/365F.
+***************************************************************************
+*/
+double JpmcdsCurvePairCacheSurvivalLogDeriv
+(TCurvePairCache *cache,        /* (I) Cache                           */
+ TDate            date);        /* (I) Date                            */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
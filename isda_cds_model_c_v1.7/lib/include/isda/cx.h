@@ -39,6 +39,16 @@ typedef enum
     ACCRUAL_PAY_ALL                       /* All */
 } TAccrualPayConv;
 
+/** Root finder used to bootstrap each point of a credit curve. */
+typedef enum
+{
+/** Brent's method, using only values of the objective function. */
+    BOOTSTRAP_BRENT,                      /* Brent */
+/** Newton's method using analytic derivatives of the legs. Falls back to
+    Brent's method if Newton's method does not converge. */
+    BOOTSTRAP_NEWTON                      /* Newton */
+} TBootstrapSolver;
+
 
 /** Contingent leg (a.k.a. protection leg). Defines notional amount and
     protection start and end dates. */
@@ -41,6 +41,28 @@ double JpmcdsForwardZeroPrice
  TDate   maturityDate);
 
 
+/*f
+***************************************************************************
+** Calculates the zero prices for an array of dates in ascending order.
+** Each price is identical to JpmcdsZeroPrice for its date.
+**
+** The dates are matched with the points of the curve in one merge, so
+** the cost is linear in the number of dates plus the number of points.
+**
+** If fwdRates is not NULL, it receives for each pair of consecutive dates
+** the continuously compounded ACT/365F forward rate between them,
+**     fwdRates[i] = log(prices[i]/prices[i+1]) / ((dates[i+1]-dates[i])/365)
+** or zero where the two dates are the same.
+***************************************************************************
+*/
+int JpmcdsZeroPrices
+(TCurve* zeroCurve,             /* (I) Zero curve                      */
+ long    numDates,              /* (I) Number of dates                 */
+ TDate  *dates,                 /* (I) [numDates] Ascending dates      */
+ double *prices,                /* (O) [numDates] Zero prices          */
+ double *fwdRates);             /* (O) [numDates-1] Can be NULL        */
+
+
 /*f
 ***************************************************************************
 ** Calculates the zero rate for a given date using ACT/365F and continously
@@ -52,6 +74,36 @@ double JpmcdsZeroRate
  TDate   date);
 
 
+/*f
+***************************************************************************
+** Calculates the derivative of log(JpmcdsZeroPrice(zeroCurve, date)) with
+** respect to the rate of point idx of the curve. The curve must be
+** continuously compounded ACT/365F. Returns NaN for errors.
+***************************************************************************
+*/
+double JpmcdsLogZeroPriceDeriv
+(TCurve* zeroCurve,
+ TDate   date,
+ long    idx);
+
+
+/*f
+***************************************************************************
+** Adds adjoint times the derivative of log(JpmcdsZeroPrice(zeroCurve,
+** date)) with respect to the rate of each point of the curve to grad.
+**
+** Unlike JpmcdsLogZeroPriceDeriv the curve can have any basis and day
+** count convention that JpmcdsZeroRate accepts. The derivatives are with
+** respect to the rates as they are stored in the curve.
+***************************************************************************
+*/
+int JpmcdsLogZeroPriceAdjoint
+(TCurve* zeroCurve,             /* (I) Zero curve                      */
+ TDate   date,                  /* (I) Date of the zero price          */
+ double  adjoint,               /* (I) Adjoint of the log zero price   */
+ double *grad);                 /* (I/O) [fNumItems] Rate gradient     */
+
+
 /*f
 ***************************************************************************
 ** Converts a compound rate from one frequency to another.
@@ -12,6 +12,7 @@
 #define FEE_LEG_H
 
 #include "cx.h"
+#include "curvecache.h"
 
 #ifdef __cplusplus
 extern "C"
@@ -35,6 +36,288 @@ int JpmcdsFeeLegPV
  double        *pv);
 
 
+/*f
+***************************************************************************
+** Calculates the PV of a fee leg with fixed fee payments, taking the
+** discount and survival factors from a curve pair cache.
+**
+** The result is identical to JpmcdsFeeLegPV with the curves of the cache.
+** When the cache has critical dates, no timeline is built for the leg.
+***************************************************************************
+*/
+int JpmcdsFeeLegPVWithCache
+(TFeeLeg         *fl,
+ TDate            today,
+ TDate            stepinDate,
+ TDate            valueDate,
+ TCurvePairCache *curves,
+ TBoolean         payAccruedAtStart,
+ double          *pv);
+
+
+/*f
+***************************************************************************
+** Calculates the PV of a fee leg as JpmcdsFeeLegPVWithCache, and also its
+** derivative with respect to the rate of point spreadNode of the spread
+** curve in the cache. The spread curve must be continuously compounded
+** ACT/365F.
+**
+** The pv is identical to that of JpmcdsFeeLegPVWithCache unless
+** curves->vectorIntegrals is set.
+***************************************************************************
+*/
+int JpmcdsFeeLegPVWithDeriv
+(TFeeLeg         *fl,
+ TDate            today,
+ TDate            stepinDate,
+ TDate            valueDate,
+ TCurvePairCache *curves,
+ TBoolean         payAccruedAtStart,
+ double          *pv,
+ double          *dpv);            /* (O) Derivative of pv - can be NULL */
+
+
+/*t
+***************************************************************************
+** Values of a fee leg and a contingent leg found together.
+**
+** Fee leg values are for a coupon of one, so a fee leg with coupon c has
+** dirty PV c*rpv01 and clean PV c*(rpv01 - accruedInterest).
+***************************************************************************
+*/
+typedef struct _TCdsLegsPV
+{
+    double      contingentPV;       /* PV of the contingent leg */
+    double      rpv01;              /* risky annuity, including accrual
+                                       on default */
+    double      accrualOnDefaultPV; /* part of rpv01 paid on default */
+    double      accruedInterest;    /* accrued interest at stepinDate */
+} TCdsLegsPV;
+
+
+/*f
+***************************************************************************
+** Values a fee leg and a contingent leg in one walk along their shared
+** timeline, so that each survival probability and discount factor is
+** evaluated once for both legs.
+**
+** The contingent leg can be NULL, and must otherwise pay on default. The
+** values agree with JpmcdsFeeLegPVWithCache and
+** JpmcdsContingentLegPVWithCache to rounding, since the integrals are
+** exact under flat forwards however the timeline is divided.
+***************************************************************************
+*/
+int JpmcdsFeeAndContingentLegPV
+(TFeeLeg         *fl,               /* (I) Fee leg                         */
+ TContingentLeg  *cl,               /* (I) Contingent leg - can be NULL    */
+ TDate            today,            /* (I) No observations before today    */
+ TDate            stepinDate,       /* (I) Stepin date                     */
+ TDate            valueDate,        /* (I) Value date for discounting      */
+ TCurvePairCache *curves,           /* (I/O) Risk-free and spread curves   */
+ double           recoveryRate,     /* (I) Recovery rate                   */
+ TCdsLegsPV      *legs);            /* (O) Values of the legs              */
+
+
+/*t
+***************************************************************************
+** Partial sums of the walk of JpmcdsFeeAndContingentLegPV after each
+** period of the fee leg.
+**
+** Step i holds the sums as at today up to the end of period i, and the
+** latest date at which the curves were observed to find them.
+***************************************************************************
+*/
+typedef struct _TCdsLegsSteps
+{
+    long        maxSteps;       /* size of the arrays */
+    long        nbSteps;        /* number of steps recorded */
+    TDate      *lastDates;      /* [maxSteps] latest date observed */
+    TDate      *protDone;       /* [maxSteps] protection integrated to */
+    double     *paymentsPv;     /* [maxSteps] fee payments */
+    double     *accrualPv;      /* [maxSteps] accrual on default */
+    double     *contingentPv;   /* [maxSteps] protection per unit loss */
+} TCdsLegsSteps;
+
+
+/*f
+***************************************************************************
+** Makes an empty record of the steps of a walk over a fee leg with up
+** to maxSteps periods.
+***************************************************************************
+*/
+TCdsLegsSteps* JpmcdsCdsLegsStepsMake
+(long             maxSteps);        /* (I) Number of fee leg periods       */
+
+
+/*f
+***************************************************************************
+** Frees a record of steps.
+***************************************************************************
+*/
+void JpmcdsCdsLegsStepsFree
+(TCdsLegsSteps   *steps);
+
+
+/*f
+***************************************************************************
+** Values a fee leg and a contingent leg as JpmcdsFeeAndContingentLegPV,
+** resuming the walk of an earlier valuation of the same legs.
+**
+** The steps in from which observed the curves only up to unchangedDate
+** are taken as they are, and the walk continues after them. So when the
+** curves have changed only after unchangedDate, only the periods which
+** see the change are valued again. The values are identical to those of
+** JpmcdsFeeAndContingentLegPV with the current curves.
+**
+** If record is not NULL the steps of this walk are recorded in it, and
+** it must not be the same as from.
+***************************************************************************
+*/
+int JpmcdsFeeAndContingentLegPVSteps
+(TFeeLeg         *fl,               /* (I) Fee leg                         */
+ TContingentLeg  *cl,               /* (I) Contingent leg - can be NULL    */
+ TDate            today,            /* (I) No observations before today    */
+ TDate            stepinDate,       /* (I) Stepin date                     */
+ TDate            valueDate,        /* (I) Value date for discounting      */
+ TCurvePairCache *curves,           /* (I/O) Risk-free and spread curves   */
+ double           recoveryRate,     /* (I) Recovery rate                   */
+ TCdsLegsSteps   *from,             /* (I) Earlier walk - can be NULL      */
+ TDate            unchangedDate,    /* (I) Curves are as for from up to
+                                           and including this date         */
+ TCdsLegsSteps   *record,           /* (O) Steps of this walk - can be NULL */
+ TCdsLegsPV      *legs);            /* (O) Values of the legs              */
+
+
+/*t
+***************************************************************************
+** Weights of the values of a fee leg and a contingent leg, and the
+** gradients of their weighted sum
+**
+**     contingentWeight * contingentPV + feeWeight * rpv01
+**
+** with respect to the rates of the discount curve and the spread curve.
+** For the price of a CDS with coupon c the weights are 1 and -c.
+***************************************************************************
+*/
+typedef struct _TCdsLegsAdjoint
+{
+    double      contingentWeight;   /* (I) weight of contingentPV */
+    double      feeWeight;          /* (I) weight of rpv01 */
+    double     *discGrad;           /* (I/O) [discCurve->fNumItems] */
+    double     *spreadGrad;         /* (I/O) [spreadCurve->fNumItems] */
+} TCdsLegsAdjoint;
+
+
+/*f
+***************************************************************************
+** Values a fee leg and a contingent leg as JpmcdsFeeAndContingentLegPV,
+** and adds the gradient of their weighted sum with respect to the rates
+** of both curves to the gradients of adjoint.
+**
+** The gradient is found by reverse accumulation along the same walk, so
+** its cost is a small multiple of that of the values, whatever the number
+** of points on the curves. The values are identical to those of
+** JpmcdsFeeAndContingentLegPV.
+***************************************************************************
+*/
+int JpmcdsFeeAndContingentLegPVAdjoint
+(TFeeLeg         *fl,               /* (I) Fee leg                         */
+ TContingentLeg  *cl,               /* (I) Contingent leg - can be NULL    */
+ TDate            today,            /* (I) No observations before today    */
+ TDate            stepinDate,       /* (I) Stepin date                     */
+ TDate            valueDate,        /* (I) Value date for discounting      */
+ TCurvePairCache *curves,           /* (I/O) Risk-free and spread curves   */
+ double           recoveryRate,     /* (I) Recovery rate                   */
+ TCdsLegsAdjoint *adjoint,          /* (I/O) Weights and gradients         */
+ TCdsLegsPV      *legs);            /* (O) Values of the legs              */
+
+
+/*t
+***************************************************************************
+** The contributions to the values of a fee leg and a contingent leg from
+** each segment of their timeline and each fee payment, with the discount
+** factors already applied.
+**
+** When the hazard rate is flat, the survival probability to a date which
+** is T years after today is exp(-hazardRate * T), and the legs can be
+** valued from these alone for any hazard rate and recovery rate without
+** walking the timeline again.
+***************************************************************************
+*/
+typedef struct _TCdsLegsFlat
+{
+    long        maxSegments;        /* size of the segment arrays */
+    long        nbSegments;         /* number of segments recorded */
+    double     *startTimes;         /* [maxSegments] years from today */
+    double     *endTimes;           /* [maxSegments] years from today */
+    double     *startDiscounts;     /* [maxSegments] from today */
+    double     *endDiscounts;       /* [maxSegments] from today */
+    double     *fwdRates;           /* [maxSegments] flat forward rate */
+    TBoolean   *protects;           /* [maxSegments] segment is protected */
+    double     *accRates;           /* [maxSegments] accrual per year or 0 */
+    double     *accStartTimes;      /* [maxSegments] accrual time at start */
+    double     *accEndTimes;        /* [maxSegments] accrual time at end */
+    long        maxPayments;        /* size of the payment arrays */
+    long        nbPayments;         /* number of payments recorded */
+    double     *paymentTimes;       /* [maxPayments] years from today to
+                                       the observation of survival */
+    double     *paymentPvs;         /* [maxPayments] amount discounted to
+                                       today from the pay date */
+    long       *paymentSegments;    /* [maxPayments] segment which ends at
+                                       the observation, or -1 */
+    double      notional;           /* notional of the contingent leg, or
+                                       0 if there is none */
+    double      valueDatePv;        /* discount factor to valueDate */
+    double      accruedInterest;    /* accrued interest at stepinDate */
+} TCdsLegsFlat;
+
+
+/*f
+***************************************************************************
+** Makes a record of the contributions to the values of a fee leg and a
+** contingent leg from the walk of JpmcdsFeeAndContingentLegPV.
+**
+** Only the discount curve of the cache is used for values. The dates of
+** the spread curve still divide the timeline, which does not change the
+** values under a flat hazard rate.
+***************************************************************************
+*/
+TCdsLegsFlat* JpmcdsCdsLegsFlatMake
+(TFeeLeg         *fl,               /* (I) Fee leg                         */
+ TContingentLeg  *cl,               /* (I) Contingent leg - can be NULL    */
+ TDate            today,            /* (I) No observations before today    */
+ TDate            stepinDate,       /* (I) Stepin date                     */
+ TDate            valueDate,        /* (I) Value date for discounting      */
+ TCurvePairCache *curves);          /* (I/O) Risk-free and spread curves   */
+
+
+/*f
+***************************************************************************
+** Frees a record made by JpmcdsCdsLegsFlatMake.
+***************************************************************************
+*/
+void JpmcdsCdsLegsFlatFree
+(TCdsLegsFlat    *flat);
+
+
+/*f
+***************************************************************************
+** Values the legs of a record for a flat hazard rate, and optionally
+** finds the derivatives of the values with respect to the hazard rate.
+**
+** The values agree with JpmcdsFeeAndContingentLegPV for a one point
+** continuously compounded ACT/365F spread curve with base date today to
+** rounding. The derivative of the accrued interest is zero.
+***************************************************************************
+*/
+int JpmcdsCdsLegsFlatPV
+(TCdsLegsFlat    *flat,             /* (I) Record of the legs              */
+ double           hazardRate,       /* (I) Flat hazard rate                */
+ double           recoveryRate,     /* (I) Recovery rate                   */
+ TCdsLegsPV      *legs,             /* (O) Values of the legs              */
+ TCdsLegsPV      *dlegs);           /* (O) Derivatives - can be NULL       */
+
+
 /*f
 ***************************************************************************
 ** Calculates the PV of the accruals which occur on default with delay.
@@ -55,6 +55,26 @@ TCurve* JpmcdsZCSwaps(
  char            *holidayFile);      /* (I) See JpmcdsBusinessDay              */
 
 
+/*f
+***************************************************************************
+** Check input arguments for adding swaps to a given zero curve.
+***************************************************************************
+*/
+int JpmcdsZCSwapsCheckInputs(
+        TCurve     *zeroCurve,       /* (I) Zero curve to add swap points to*/
+        TCurve     *discZC,          /* (I) Zero curve used for discounting */
+        TDate      *dates,           /* (I) Unadjusted swap maturity dates  */
+        double     *rates,           /* (I) Swap par fixed rates (0.06=6%)  */
+        int        numSwaps,         /* (I) Len of dates,rates              */
+        int        fixedSwapFreq,    /* (I) Fixed leg coupon frequency      */
+        int        floatSwapFreq,    /* (I) Floating leg coupon frequency   */
+        long       fixDayCountConv,  /* (I) See JpmcdsDayCountConvention       */
+        long       floatDayCountConv,/* (I) See JpmcdsDayCountConvention       */
+        char       fwdLength,        /* (I) For fwd smoothing, length of fwds*/
+        long       badDayConv,       /* (I) Bad day convention              */
+        char       *holidayFile);    /* (I) See JpmcdsBusinessDay              */
+
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,113 @@
+/*
+ * ISDA CDS Standard Model
+ *
+ * Copyright (C) 2009 International Swaps and Derivatives Association, Inc.
+ * Developed and supported in collaboration with Markit
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the ISDA CDS Standard Model Public License.
+ */
+
+#ifndef HOLFILE_H
+#define HOLFILE_H
+
+#include "cgeneral.h"
+#include "buscache.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/*
+***************************************************************************
+** Binary holiday files.
+**
+** A binary holiday file holds the same information as a text holiday file
+** read by JpmcdsHolidayListRead, laid out so that it can be mapped into
+** memory and used without being parsed. All the fields are 32 bit
+** integers in the byte order of the machine which wrote the file:
+**
+**     header    "JHOL", byte order mark 0x01020304, format version,
+**               weekends flags, number of holidays, first date of the
+**               index, number of words of the index, zero
+**     holidays  [number of holidays] dates in increasing order
+**     index     [words+1] bitmap of business days, then [words+1] counts
+**               of business days before each word, as in THolidayIndex;
+**               absent if the number of words is zero
+**
+** JpmcdsHolidayListRead recognises binary files, so they can be used
+** wherever holiday files are named.
+***************************************************************************
+*/
+
+/* extension of the binary holiday files loaded from a directory */
+#define JPMCDS_HOLIDAY_FILE_EXT ".hol"
+
+
+/*f
+***************************************************************************
+** Writes a holiday list to a binary holiday file. If withIndex is TRUE
+** the file also holds the business day index of the list, which is made
+** if the list does not have one.
+***************************************************************************
+*/
+int JpmcdsHolidayListWriteBinary
+(THolidayList *hl,          /* (I/O) Holiday list */
+ char         *fileName,    /* (I) File to write */
+ TBoolean      withIndex);  /* (I) Include the business day index */
+
+
+/*f
+***************************************************************************
+** Reads a holiday list from a binary holiday file. The list has the index
+** held in the file, if any.
+**
+** Returns NULL on failure.
+***************************************************************************
+*/
+THolidayList* JpmcdsHolidayListReadBinary
+(char         *fileName);   /* (I) File to read */
+
+
+/*f
+***************************************************************************
+** Returns TRUE if a file is a binary holiday file, and FALSE if it is not
+** or cannot be read.
+***************************************************************************
+*/
+TBoolean JpmcdsHolidayFileIsBinary
+(char         *fileName);   /* (I) File to test */
+
+
+/*f
+***************************************************************************
+** Converts a text holiday file to a binary holiday file.
+***************************************************************************
+*/
+int JpmcdsHolidayFileConvert
+(char         *textFileName,   /* (I) Text holiday file to read */
+ char         *binaryFileName, /* (I) Binary holiday file to write */
+ TBoolean      withIndex);     /* (I) Include the business day index */
+
+
+/*f
+***************************************************************************
+** Adds every binary holiday file of a directory to the holiday cache,
+** under the file name without its extension. Only files ending with the
+** extension are loaded; JPMCDS_HOLIDAY_FILE_EXT is used if it is NULL.
+**
+** Stops at the first file which cannot be loaded.
+***************************************************************************
+*/
+int JpmcdsHolidayLoadDirectory
+(char         *directory,   /* (I) Directory to load */
+ char         *extension,   /* (I) Extension of the files, or NULL */
+ long         *numLoaded);  /* (O) Number of calendars loaded, or NULL */
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,147 @@
+/*
+ * ISDA CDS Standard Model
+ *
+ * Copyright (C) 2009 International Swaps and Derivatives Association, Inc.
+ * Developed and supported in collaboration with Markit
+ * 
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the ISDA CDS Standard Model Public License.
+ */
+
+#ifndef PREPCURVE_H
+#define PREPCURVE_H
+
+#include "cgeneral.h"
+#include "bastypes.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/*t
+***************************************************************************
+** A zero curve prepared for repeated evaluation of zero prices.
+**
+** The rates of the curve are converted once to continuously compounded
+** ACT/365F rates, and the products of rate and time which are linearly
+** interpolated under flat forwards are stored with their differences for
+** each segment. Zero prices are then found without any rate conversion.
+**
+** Segment i runs from point i-1 to point i. Values for segment 0 are not
+** used.
+**
+** The dates are held apart from the rates, so that a search for a date
+** reads only the dates array.
+***************************************************************************
+*/
+typedef struct _TPreparedCurve
+{
+    TDate       baseDate;       /* base date of the curve */
+    long        numItems;       /* number of points */
+    TDate      *dates;          /* [numItems] dates of the points */
+    long       *days;           /* [numItems] days from baseDate */
+    double     *rates;          /* [numItems] continuously compounded */
+    double     *rateDays;       /* [numItems] rates * days = -log(Z) * 365 */
+    double     *segRateDays;    /* [numItems] rateDays[i] - rateDays[i-1] */
+    double     *segDays;        /* [numItems] days[i] - days[i-1] */
+} TPreparedCurve;
+
+
+/*f
+***************************************************************************
+** Returns TRUE if JpmcdsPreparedCurveMake can prepare a zero curve, that
+** is if it has points and their dates are strictly increasing.
+***************************************************************************
+*/
+TBoolean JpmcdsPreparedCurveValid
+(TCurve         *curve);        /* (I) Zero curve                      */
+
+
+/*f
+***************************************************************************
+** Prepares a zero curve for fast evaluation of zero prices. The curve
+** dates must be strictly increasing.
+***************************************************************************
+*/
+TPreparedCurve* JpmcdsPreparedCurveMake
+(TCurve         *curve);        /* (I) Zero curve                      */
+
+
+/*f
+***************************************************************************
+** Frees a prepared curve.
+***************************************************************************
+*/
+void JpmcdsPreparedCurveFree
+(TPreparedCurve *pc);           /* (I) Prepared curve                  */
+
+
+/*f
+***************************************************************************
+** Changes the rate of point idx of a prepared curve. The rate is in the
+** basis and day count convention of the original curve, so the result is
+** the same as preparing the original curve after changing its rate.
+**
+** The rate of the original curve is changed too. If pc is NULL, then only
+** the original curve is changed.
+***************************************************************************
+*/
+int JpmcdsPreparedCurveSetRate
+(TPreparedCurve *pc,            /* (I/O) Prepared curve - can be NULL  */
+ TCurve         *curve,         /* (I/O) Curve which pc was made from  */
+ long            idx,           /* (I) Index of point                  */
+ double          rate);         /* (I) New rate of the point           */
+
+
+/*f
+***************************************************************************
+** Makes a TCurve from a prepared curve. The rates are continuously
+** compounded ACT/365F, so the zero prices of the curve are those of the
+** curve which was prepared.
+***************************************************************************
+*/
+TCurve* JpmcdsPreparedCurveToTCurve
+(TPreparedCurve *pc);           /* (I) Prepared curve                  */
+
+
+/*f
+***************************************************************************
+** Returns the index of the first point of a prepared curve on or after a
+** date, or numItems if there is none. The search takes the same steps for
+** every date, so it does not depend on branch prediction.
+***************************************************************************
+*/
+long JpmcdsPreparedCurveSearch
+(TPreparedCurve *pc,            /* (I) Prepared curve                  */
+ TDate           date);         /* (I) Date                            */
+
+
+/*f
+***************************************************************************
+** Calculates the zero price for a given date. The result is identical to
+** JpmcdsZeroPrice on the original curve.
+***************************************************************************
+*/
+double JpmcdsPreparedZeroPrice
+(TPreparedCurve *pc,            /* (I) Prepared curve                  */
+ TDate           date);         /* (I) Date                            */
+
+
+/*f
+***************************************************************************
+** Calculates the zero price for a given start date and maturity date.
+** The result is identical to JpmcdsForwardZeroPrice on the original
+** curve.
+***************************************************************************
+*/
+double JpmcdsPreparedForwardZeroPrice
+(TPreparedCurve *pc,            /* (I) Prepared curve                  */
+ TDate           startDate,     /* (I) Start date                      */
+ TDate           maturityDate); /* (I) Maturity date                   */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,55 @@
+/*
+ * ISDA CDS Standard Model
+ *
+ * Copyright (C) 2009 International Swaps and Derivatives Association, Inc.
+ * Developed and supported in collaboration with Markit
+ * 
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the ISDA CDS Standard Model Public License.
+ */
+
+#ifndef RTNEWTON_H
+#define RTNEWTON_H
+
+#include "cgeneral.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+
+typedef int (*TObjectDerivFunc) (double x, void * para, double *f, double *df);
+
+
+/*f
+***************************************************************************
+** Finds the root of f(x) = 0 using Newton's method with the derivative
+** supplied by the objective function.
+**
+** Newton's method is fast but not safe. The routine gives up, setting
+** foundIt to FALSE, if the derivative vanishes, if the iteration leaves
+** [boundLo, boundHi], or if numIterations is reached. The caller can then
+** fall back to a bracketing method such as JpmcdsRootFindBrent.
+**
+** Only returns FAILURE if the objective function returns FAILURE.
+***************************************************************************
+*/
+int JpmcdsRootFindNewton(
+   TObjectDerivFunc funcd,         /* (I) function to be solved */
+   void        *data,              /* (I) data to pass into funcd */
+   double      boundLo,            /* (I) lower bound on legal X */
+   double      boundHi,            /* (I) upper bound on legal X */
+   int         numIterations,      /* (I) Maximum number of iterations */
+   double      guess,              /* (I) Initial guess */
+   double      xacc,               /* (I) X accuracy tolerance */
+   double      facc,               /* (I) function accuracy tolerance */
+   TBoolean    *foundIt,           /* (O) If the root was found */
+   double      *solution);         /* (O) root found */
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif    /* RTNEWTON_H */
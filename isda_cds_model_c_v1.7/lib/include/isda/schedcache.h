@@ -0,0 +1,114 @@
+/*
+ * ISDA CDS Standard Model
+ *
+ * Copyright (C) 2009 International Swaps and Derivatives Association, Inc.
+ * Developed and supported in collaboration with Markit
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the ISDA CDS Standard Model Public License.
+ */
+
+#ifndef SCHEDCACHE_H
+#define SCHEDCACHE_H
+
+#include "cx.h"
+#include "stub.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/* number of schedules kept by the cache unless changed */
+#define JPMCDS_FEE_SCHEDULE_CACHE_SIZE 4096
+
+
+/*t
+***************************************************************************
+** The dates of the fee leg of a vanilla CDS, as made by
+** JpmcdsCdsFeeLegMake.
+**
+** Schedules are shared between all the fee legs with the same contract
+** terms and must not be changed. Each holder has a reference which it
+** gives up with JpmcdsFeeLegScheduleRelease.
+***************************************************************************
+*/
+typedef struct _TFeeLegSchedule
+{
+    int             nbDates;        /* number of fee payments */
+    TDate          *accStartDates;  /* [nbDates] accrual start dates */
+    TDate          *accEndDates;    /* [nbDates] accrual end dates */
+    TDate          *payDates;       /* [nbDates] payment dates */
+} TFeeLegSchedule;
+
+
+/*f
+***************************************************************************
+** Returns the schedule of a vanilla CDS fee leg with the given terms,
+** taking it from the schedule cache if it is there and adding it if not.
+** The caller has a reference to the schedule.
+**
+** The calendar is ignored when badDayConv is JPMCDS_BAD_DAY_NONE, and is
+** otherwise matched without regard to case. Schedules found from a
+** calendar which has since been replaced in the holiday cache are made
+** again.
+**
+** Can be called from many threads at once. Returns NULL on failure.
+***************************************************************************
+*/
+TFeeLegSchedule* JpmcdsFeeLegScheduleGet
+(TDate           startDate,     /* (I) Start of the first period       */
+ TDate           endDate,       /* (I) End of protection               */
+ TDateInterval  *dateInterval,  /* (I) Interval between payments       */
+ TStubMethod    *stubType,      /* (I) Location and length of the stub */
+ long            badDayConv,    /* (I) Adjustment of payment dates     */
+ char           *calendar,      /* (I) Holiday calendar                */
+ TBoolean        protectStart); /* (I) Protection from start of day    */
+
+
+/*f
+***************************************************************************
+** Gives up a reference to a schedule. The schedule is freed when it has
+** no references and is no longer in the cache.
+***************************************************************************
+*/
+void JpmcdsFeeLegScheduleRelease
+(TFeeLegSchedule *schedule);    /* (I) Can be NULL                     */
+
+
+/*f
+***************************************************************************
+** Sets the number of schedules which the cache keeps, removing the least
+** recently used schedules beyond it. Zero stops schedules being kept.
+***************************************************************************
+*/
+void JpmcdsFeeLegScheduleCacheSetMaxSize
+(long            maxEntries);   /* (I) Number of schedules kept        */
+
+
+/*f
+***************************************************************************
+** Returns the number of schedules found in the cache and made since the
+** cache was last emptied, and the number of schedules it now holds. Any
+** of the outputs can be NULL.
+***************************************************************************
+*/
+void JpmcdsFeeLegScheduleCacheStats
+(long           *hits,          /* (O) Schedules found in the cache    */
+ long           *misses,        /* (O) Schedules made                  */
+ long           *numEntries);   /* (O) Schedules held                  */
+
+
+/*f
+***************************************************************************
+** Removes all the schedules from the cache and resets its counts.
+***************************************************************************
+*/
+void JpmcdsFeeLegScheduleCacheEmpty(void);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,84 @@
+/*
+ * ISDA CDS Standard Model
+ *
+ * Copyright (C) 2009 International Swaps and Derivatives Association, Inc.
+ * Developed and supported in collaboration with Markit
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the ISDA CDS Standard Model Public License.
+ */
+
+#ifndef SEGINT_H
+#define SEGINT_H
+
+#include "cgeneral.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/*
+***************************************************************************
+** Integrals over the segments of a timeline, on which both the hazard
+** rate and the forward rate are flat.
+**
+** The integrals take arrays of survival probabilities s[] and discount
+** factors df[] at the n+1 points of a timeline, and sum over the n
+** segments between them.
+**
+** Where the processor supports AVX2 and FMA, four segments are integrated
+** at a time. The results then differ from the scalar integrals only by
+** rounding. Otherwise, and on compilers other than gcc and clang for x86,
+** the scalar integrals are used, and give results identical to those of
+** the contingent leg and fee leg. Define JPMCDS_NO_SIMD to always use the
+** scalar integrals.
+***************************************************************************
+*/
+
+
+/*f
+***************************************************************************
+** Returns the protection integral over n segments of a timeline,
+**
+**     sum of loss * lambda/(lambda+f) * (1-exp(-(lambda+f)t)) * s0 * df0
+**
+** where segment i has length t = dt[i] in years.
+***************************************************************************
+*/
+double JpmcdsProtectionSegmentsPV
+(long          n,               /* (I) Number of segments              */
+ double        loss,            /* (I) Loss given default              */
+ const double *s,               /* (I) [n+1] Survival probabilities    */
+ const double *df,              /* (I) [n+1] Discount factors          */
+ const double *dt);             /* (I) [n] Segment lengths in years    */
+
+
+/*f
+***************************************************************************
+** Returns the accrual on default integral over n segments of a timeline,
+** where accrual runs at accRate per year and t[] are the accrual times at
+** the points of the timeline.
+***************************************************************************
+*/
+double JpmcdsAccrualSegmentsPV
+(long          n,               /* (I) Number of segments              */
+ double        accRate,         /* (I) Accrual per year                */
+ const double *s,               /* (I) [n+1] Survival probabilities    */
+ const double *df,              /* (I) [n+1] Discount factors          */
+ const double *t);              /* (I) [n+1] Accrual times in years    */
+
+
+/*f
+***************************************************************************
+** Returns TRUE if the segment integrals process four segments at a time
+** on this processor.
+***************************************************************************
+*/
+TBoolean JpmcdsSegmentsVectorized(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -18,6 +18,40 @@ extern "C"
 {
 #endif
 
+/* size of the timeline buffers which the integrators keep on the stack */
+#define JPMCDS_TIMELINE_BUFFER_SIZE 256
+
+/*t
+***************************************************************************
+** A view of the timeline of a period, which reads the dates strictly
+** inside the period from a longer timeline instead of copying them.
+**
+** The dates of the view are startDate, dates[begin] to dates[end-1], and
+** endDate.
+***************************************************************************
+*/
+typedef struct
+{
+    TDate       startDate;  /* First date of the view */
+    TDate       endDate;    /* Last date of the view */
+    TDate      *dates;      /* Dates read by the view */
+    long        begin;      /* Index of the first date read */
+    long        end;        /* Index after the last date read */
+} TTimeLineView;
+
+/*m
+** Number of dates in a timeline view.
+*/
+#define JPMCDS_TIMELINE_VIEW_SIZE(v) ((v)->end - (v)->begin + 2)
+
+/*m
+** Date k of a timeline view, for k from 0 to JPMCDS_TIMELINE_VIEW_SIZE-1.
+*/
+#define JPMCDS_TIMELINE_VIEW_DATE(v, k)                           \
+    ((k) == 0 ? (v)->startDate :                                  \
+     (k) > (v)->end - (v)->begin ? (v)->endDate :                 \
+     (v)->dates[(v)->begin + (k) - 1])
+
 /*f
 ***************************************************************************
 ** Returns a timeline for use with risky integrations assuming flat
@@ -56,6 +90,69 @@ TDateList* JpmcdsTruncateTimeLine
  TDate      startDate,
  TDate      endDate);
 
+
+/*f
+***************************************************************************
+** Returns the critical dates for risky integrations assuming flat
+** forward curves, i.e. all the points in the discount curve and all the
+** points in the risky curve.
+**
+** Truncating this with JpmcdsTruncateTimeLine gives the same timeline as
+** JpmcdsRiskyTimeLine for any startDate and endDate.
+***************************************************************************
+*/
+TDateList* JpmcdsRiskyCriticalDates
+(TCurve           *discCurve,
+ TCurve           *riskyCurve);
+
+
+/*f
+***************************************************************************
+** Writes a timeline for risky integrations into a buffer supplied by the
+** caller without allocating any memory.
+**
+** The dates are those of JpmcdsTruncateTimeLine for criticalDates if it
+** is given, and otherwise those of JpmcdsRiskyTimeLine for the curves.
+** They are merged in one pass from the sorted dates of the inputs.
+**
+** numDates is set to the number of dates in the timeline. If this is
+** more than maxDates then only the first maxDates are written, and the
+** call can be repeated with a buffer of size numDates.
+***************************************************************************
+*/
+int JpmcdsRiskyTimeLineToBuffer
+(TDate             startDate,     /* (I) First date of timeline          */
+ TDate             endDate,       /* (I) Last date of timeline           */
+ TCurve           *discCurve,     /* (I) Used if criticalDates is NULL   */
+ TCurve           *riskyCurve,    /* (I) Used if criticalDates is NULL   */
+ TDateList        *criticalDates, /* (I) Can be NULL                     */
+ long              maxDates,      /* (I) Size of buffer                  */
+ TDate            *dates,         /* (O) [maxDates] Timeline             */
+ long             *numDates);     /* (O) Number of dates in timeline     */
+
+
+/*f
+***************************************************************************
+** Makes a view of the timeline for risky integrations over a period,
+** with the dates of JpmcdsRiskyTimeLineToBuffer.
+**
+** If criticalDates is given the view reads its dates in place, and the
+** buffer is not used. Otherwise the dates of the curves are merged into
+** the buffer; if there are more than maxDates then view->dates is NULL,
+** and the call can be repeated with a buffer of JPMCDS_TIMELINE_VIEW_SIZE
+** dates.
+***************************************************************************
+*/
+int JpmcdsRiskyTimeLineView
+(TDate             startDate,     /* (I) First date of timeline          */
+ TDate             endDate,       /* (I) Last date of timeline           */
+ TCurve           *discCurve,     /* (I) Used if criticalDates is NULL   */
+ TCurve           *riskyCurve,    /* (I) Used if criticalDates is NULL   */
+ TDateList        *criticalDates, /* (I) Can be NULL                     */
+ long              maxDates,      /* (I) Size of buffer                  */
+ TDate            *dates,         /* (I) [maxDates] Buffer               */
+ TTimeLineView    *view);         /* (O) Timeline                        */
+
 #ifdef __cplusplus
 }
 #endif
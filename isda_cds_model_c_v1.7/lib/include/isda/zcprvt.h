@@ -31,6 +31,8 @@ typedef struct {                       /* stores curve of zero rates */
    int             numAlloc;           /* number of items allowed in arrays */
    long            basis;              /* compounding basis: usually annual */
    long            dayCountConv;       /* day counting convention */
+   TBoolean        newtonSolve;        /* flat fwds: solve new points with
+                                        * Newton - see JpmcdsZCAddCashFlowList */
 } ZCurve;
 
 
@@ -206,6 +208,68 @@ int JpmcdsZCAddSwaps(
  char            *holidayFile);     /* (I) See JpmcdsBusinessDay      */
 
 
+/*t
+***************************************************************************
+** A strip of swaps with the floating side at par, whose maturity dates and
+** fixed coupon schedules are made once, so that the strip can be added to
+** zero curves for many sets of rates.
+***************************************************************************
+*/
+typedef struct _TZCSwapStrip
+{
+    struct _swapDates *swapDates;       /* Maturity dates (see zcswdate.h) */
+    TCashFlowList    **fractions;       /* [numSwaps] coupon year fractions*/
+    TCashFlowList    **cfls;            /* [numSwaps] flows at last rates  */
+    TCashFlowList     *zeroRateCfl;     /* flow of a swap with rate 0      */
+    int                numSwaps;        /* Number of swaps in strip        */
+    long               fixDayCountConv; /* Convention for fixed leg        */
+} TZCSwapStrip;
+
+
+/*f
+***************************************************************************
+** Makes a strip of swaps with the floating side at par, whose dates and
+** fixed coupon schedules are kept for JpmcdsZCSwapStripAdd.
+**
+** The dates are un-adjusted and there is no bad day list, as in the
+** swaps added by JpmcdsZCSwaps.
+***************************************************************************
+*/
+TZCSwapStrip* JpmcdsZCSwapStripNew(
+ TDate            valueDate,        /* (I) Value date of zero curves */
+ TDate           *inDates,          /* (I) Unadjusted maturity dates */
+ int              numSwaps,         /* (I) # instruments in strip  */
+ int              fixedSwapFreq,    /* (I) Fixed leg freq          */
+ long             fixDayCountConv,  /* (I) Convention for fixed leg*/
+ TBadDayAndStubPos badDayAndStubPos,/* (I) See JpmcdsBusinessDay      */
+ char            *holidayFile);     /* (I) See JpmcdsBusinessDay      */
+
+
+/*f
+***************************************************************************
+** Adds swap i of a strip to a ZCurve. Adding swaps 0 to numSwaps-1 in
+** turn, with oneAlreadyAdded initially FALSE, gives the same ZCurve as
+** JpmcdsZCAddSwaps with the dates of the strip and no discount curve.
+***************************************************************************
+*/
+int JpmcdsZCSwapStripAdd(
+ ZCurve          *zc,               /* (M) ZCurve to add to        */
+ TZCSwapStrip    *strip,            /* (I) Strip of swaps          */
+ double          *rates,            /* (I) Fixed rates of the strip*/
+ int              i,                /* (I) Swap to add             */
+ TBoolean        *oneAlreadyAdded,  /* (M) If a swap was already added */
+ long             interpType,       /* (I) Zero interpolation method */
+ TInterpData     *interpData);      /* (I) Zero interpolation data */
+
+
+/*f
+***************************************************************************
+** Frees a strip of swaps.
+***************************************************************************
+*/
+void JpmcdsZCSwapStripFree(TZCSwapStrip *strip);
+
+
 /*f
 ***************************************************************************
 ** Makes a date list for all coupons associated w/ a swap instrument.
@@ -247,6 +311,39 @@ TCashFlowList* JpmcdsZCGetSwapCFL
    char           *holidayFile);        /* (I) Name of holiday file        */
 
 
+/*f
+***************************************************************************
+** Makes a cash flow list with the coupon dates of a swap instrument, and
+** the year fraction of each coupon as its amount.
+**
+** Returns the list, NULL if an error found.
+***************************************************************************
+*/
+TCashFlowList* JpmcdsZCGetSwapFractions
+  (TDate           valueDate,           /* (I) Value date                  */
+   TDate           matDate,             /* (I) Unadjusted maturity date    */
+   TBoolean        stubAtEnd,           /* (I) If matDate on-cycle         */
+   TDateInterval  *interval,            /* (I) Coupon payment interval     */
+   long            dayCountConv,        /* (I) Day count convention        */
+   TBadDayList    *badDayList,          /* (I) Bad day adjustment list     */
+   long            badDayConv,          /* (I) Bad day convention for rate */
+   char           *holidayFile);        /* (I) Name of holiday file        */
+
+
+/*f
+***************************************************************************
+** Sets the cash flows of a swap instrument with a non-zero coupon rate
+** from the year fractions made by JpmcdsZCGetSwapFractions, so that they
+** are the same as those made by JpmcdsZCGetSwapCFL. The two lists can be
+** the same.
+***************************************************************************
+*/
+void JpmcdsZCSwapCFLFromFractions
+  (TCashFlowList  *fractions,           /* (I) Coupon dates and fractions  */
+   double          rate,                /* (I) Coupon rate                 */
+   TCashFlowList  *cfl);                /* (O) Cash flows, same length     */
+
+
 /*f
 ***************************************************************************
 ** Adds simple-interest money market bond to ZCurve
@@ -299,6 +396,11 @@ int JpmcdsZCAddCFLPoints(
 ** Notes: date may be set for non-linear-forward interpolation methods to a 
 ** date to be added to the zero curve.  This allows production of a curve 
 ** with "nice" dates.
+**
+** If zc->newtonSolve is set and the curve has flat forwards, a single new
+** point is solved for by Newton's method, falling back to Brent. Newton
+** runs to a tighter tolerance, so the points differ slightly from those
+** found by Brent. It is not set by default.
 ***************************************************************************
 */
 int JpmcdsZCAddCashFlowList(
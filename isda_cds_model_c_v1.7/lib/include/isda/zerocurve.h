@@ -40,6 +40,75 @@ EXPORT TCurve* JpmcdsBuildIRZeroCurve(
     char      *holidayFile);   /* (I) Holiday file                     */
 
 
+/*t
+***************************************************************************
+** Builds zero curves from money market and swap instruments whose dates
+** and conventions are fixed, as their rates change.
+**
+** The swap schedules are made once, and the curve is kept as it was
+** before each swap was added, so that an update only re-solves the curve
+** from the first swap whose rate has changed. A change in any money
+** market rate re-solves the whole curve.
+***************************************************************************
+*/
+typedef struct _TIRCurveBuilder TIRCurveBuilder;
+
+
+/*f
+***************************************************************************
+** Makes a builder of zero curves from the given instruments, with the
+** same arguments as JpmcdsBuildIRZeroCurve apart from the rates. No curve
+** is built until the first call of JpmcdsIRCurveBuilderUpdate.
+***************************************************************************
+*/
+EXPORT TIRCurveBuilder* JpmcdsIRCurveBuilderNew(
+    TDate      valueDate,      /* (I) Value date                       */
+    char      *instrNames,     /* (I) Array of 'M' or 'S'              */
+    TDate     *dates,          /* (I) Array of swaps dates             */
+    long       nInstr,         /* (I) Number of benchmark instruments  */
+    long       mmDCC,          /* (I) DCC of MM instruments            */
+    long       fixedSwapFreq,  /* (I) Fixed leg freqency               */
+    long       floatSwapFreq,  /* (I) Floating leg freqency            */
+    long       fixedSwapDCC,   /* (I) DCC of fixed leg                 */
+    long       floatSwapDCC,   /* (I) DCC of floating leg              */
+    long       badDayConv,     /* (I) Bad day convention               */
+    char      *holidayFile);   /* (I) Holiday file                     */
+
+
+/*f
+***************************************************************************
+** Builds the zero curve for new rates of the instruments of a builder.
+** The curve is the same as the one built by JpmcdsBuildIRZeroCurve, unless
+** the builder solves by Newton's method, and belongs to the caller.
+***************************************************************************
+*/
+EXPORT TCurve* JpmcdsIRCurveBuilderUpdate(
+    TIRCurveBuilder *builder,  /* (I/O) Builder                        */
+    double    *rates);         /* (I) Array of rates of instruments    */
+
+
+/*f
+***************************************************************************
+** Chooses whether a builder solves for the swap points by Newton's method,
+** which is faster than the Brent search of JpmcdsBuildIRZeroCurve. Newton
+** runs to a tighter tolerance, so the curves then differ slightly from
+** those of JpmcdsBuildIRZeroCurve. The default is FALSE.
+***************************************************************************
+*/
+EXPORT void JpmcdsIRCurveBuilderSetNewton(
+    TIRCurveBuilder *builder,  /* (I/O) Builder                        */
+    TBoolean   newtonSolve);   /* (I) Solve by Newton's method         */
+
+
+/*f
+***************************************************************************
+** Frees a builder made by JpmcdsIRCurveBuilderNew.
+***************************************************************************
+*/
+EXPORT void JpmcdsIRCurveBuilderFree(
+    TIRCurveBuilder *builder); /* (I) Builder                          */
+
+
 #ifdef __cplusplus
 }
 #endif
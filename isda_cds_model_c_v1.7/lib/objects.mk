@@ -23,13 +23,17 @@ busday.$(OBJ)\
 cashflow.$(OBJ)\
 cds.$(OBJ)\
 cdsbootstrap.$(OBJ)\
+cdsimm.$(OBJ)\
 cdsone.$(OBJ)\
+cdsrisk.$(OBJ)\
 cerror.$(OBJ)\
 cfileio.$(OBJ)\
 cfinanci.$(OBJ)\
 cmemory.$(OBJ)\
 contingentleg.$(OBJ)\
 convert.$(OBJ)\
+cthread.$(OBJ)\
+curvecache.$(OBJ)\
 cx.$(OBJ)\
 cxbsearch.$(OBJ)\
 cxdatelist.$(OBJ)\
@@ -42,14 +46,19 @@ dtlist.$(OBJ)\
 feeleg.$(OBJ)\
 fltrate.$(OBJ)\
 gtozc.$(OBJ)\
+holfile.$(OBJ)\
 interpc.$(OBJ)\
 ldate.$(OBJ)\
 linterpc.$(OBJ)\
 lintrp1.$(OBJ)\
 lprintf.$(OBJ)\
 lscanf.$(OBJ)\
+prepcurve.$(OBJ)\
 rtbrent.$(OBJ)\
+rtnewton.$(OBJ)\
+schedcache.$(OBJ)\
 schedule.$(OBJ)\
+segint.$(OBJ)\
 streamcf.$(OBJ)\
 strutil.$(OBJ)\
 stub.$(OBJ)\
@@ -12,11 +12,14 @@
 #include "cgeneral.h"
 #include "cerror.h"
 #include "bsearch.h"
+#include "cthread.h"
 
 #define STR(x) # x
 #define STRING(x) STR(x)
 
-static TBoolean bSearchCheckOrder_g = TRUE;
+/* kept for each thread, since callers switch it off and on again around
+   searches of arrays which they know to be sorted */
+static JPMCDS_THREAD_LOCAL TBoolean bSearchCheckOrder_g = TRUE;
 
 
 /*
@@ -17,6 +17,8 @@
 #include "dateconv.h"
 #include "macros.h"
 #include "strutil.h"
+#include "cthread.h"
+#include "holfile.h"
 #include <limits.h>
 
 #if defined(LINUX) || defined(MACOSX)
@@ -48,19 +50,75 @@ if (pSrc != NULL && pTarget != NULL)\
 }
 
 
+/* First character of the name of a calendar handle. */
+#define HOLIDAY_HANDLE_MARK          '\001'
+
+/* Number of letters in a handle after the mark, each giving four bits of
+   its number, and so the number of handles which can be given out. */
+#define HOLIDAY_HANDLE_LETTERS       3
+#define HOLIDAY_MAX_HANDLES          (1 << (4 * HOLIDAY_HANDLE_LETTERS))
+
+/* Smallest number of slots in a table of the cache. */
+#define HOLIDAY_TABLE_MIN_SIZE       16
+
+
 /*t
  * Holiday cache information
  * */
 typedef struct _THoliday
 {
-    char         *name;   /* Upper case name associated with this entry */
+    char         *name;   /* Name associated with this entry */
     THolidayList *hl;     /* Holiday list */
     void         *next;
+    long          handle; /* Number of its handle, or -1 */
 } THoliday;
 
+/*t
+ * Hash table of the entries of the cache, looked up without a lock. A table
+ * is never changed once published; adding an entry publishes a new one.
+ * */
+typedef struct _THolidayTable
+{
+    long                   version; /* Version of the cache */
+    long                   size;    /* Number of slots, a power of two */
+    THoliday             **slots;   /* Entries by hash of name, or NULL */
+    struct _THolidayTable *older;   /* Table which this one replaced */
+} THolidayTable;
 
+
+/* Entries of the cache, changed only under the cache mutex. */
 THoliday *cache = NULL;
 
+/* Entries which have been replaced, kept until the cache is emptied since
+   other threads may still be looking at them. */
+static THoliday *retired = NULL;
+
+/* Latest table of the cache. Tables which it replaced are kept until the
+   cache is emptied for the same reason. */
+static THolidayTable *cacheTable = NULL;
+
+/* Entries by the number in their handles. Only set under the mutex, and
+   read without a lock. An entry is NULL if the cache has been emptied
+   since the handle was made. */
+static THoliday *handles[HOLIDAY_MAX_HANDLES];
+
+/* Calendar names and handles by number. A calendar keeps its number for
+   good, so these are set once under the mutex and never freed: a handle
+   given out stays valid after the cache is emptied. */
+static char     *handleCalendars[HOLIDAY_MAX_HANDLES];
+static char      handleNames[HOLIDAY_MAX_HANDLES][HOLIDAY_HANDLE_LETTERS + 2];
+static long      numHandles = 0;
+
+/* Taken by all threads changing the cache; readers use the table. */
+static TMutex cacheMutex = JPMCDS_MUTEX_INIT;
+
+/* Changed under the mutex whenever a list may have been replaced. */
+static long cacheVersion = 0;
+
+/* Years always covered by the index of a holiday list. */
+#define HOLIDAY_INDEX_FIRST_YEAR 1900
+#define HOLIDAY_INDEX_LAST_YEAR  2199
+
 
 /*
 ***************************************************************************
@@ -74,12 +132,33 @@ static int verifyHolidayList
 /* Finds an entry associated with a name in the cache. */
 static THoliday *holidayFind(char *name);
 
-/* Delete holiday calendar from cache. */
-static void holidayDelete(THoliday *hol);
+/* Finds an entry from a name or handle, loading the file if necessary. */
+static THoliday *holidayLookup(char *name);
+
+/* Finds the entry for a handle again after the cache has been emptied. */
+static THoliday *holidayHandleReload(long number);
+
+/* Publishes a table of the entries of the cache - caller holds the mutex. */
+static int holidayPublish(void);
+
+/* Removes an entry from the list of the cache. */
+static void holidayUnlink(THoliday *hol);
+
+/* Hashes a name without regard to case. */
+static unsigned long holidayHash(char *name);
+
+/* Ensures that the built-in calendars are in the cache. */
+static int holidayInitCache(void);
+
+/* Adds holiday calendar to cache - caller holds the write lock. */
+static int holidayAdd(char *name, THolidayList *hl);
 
 /* Create holiday calendar. */
 static THoliday* JpmcdsNewHoliday(THolidayList *hl, char *name);
 
+/* Free the business day index of a holiday list. */
+static void holidayIndexFree(THolidayIndex *index);
+
 /* Free memory used by holiday calendar. */
 void JpmcdsFreeHoliday(THoliday *holiday);
 
@@ -123,48 +202,195 @@ THolidayList* JpmcdsHolidayListFromCache
 (char *name)    /* (I) Name associated with the holidays */
 {
     static char   routine[] = "JpmcdsHolidayListFromCache";
-    int           status    = FAILURE;
 
-    THolidayList  *hl = NULL; /* To be returned */
     THoliday      *hol;
 
+    hol = holidayLookup (name);
+    if (hol == NULL)
+    {
+        JpmcdsErrMsg ("%s: Failed.\n", routine);
+        return NULL;
+    }
+
+    return hol->hl;
+}
+
+
+/*
+***************************************************************************
+** Returns a handle for a calendar, which can be used in place of its name.
+***************************************************************************
+*/
+char* JpmcdsHolidayCalendarHandle
+(char *name)    /* (I) Name associated with the holidays */
+{
+    static char   routine[] = "JpmcdsHolidayCalendarHandle";
+
+    THoliday      *hol;
+    char          *handle = NULL;
+    char          *calendar;
+    long           number;
+    long           bits;
+    int            i;
+
+    hol = holidayLookup (name);
+    if (hol == NULL)
+        goto done;
+
+    JpmcdsMutexLock (&cacheMutex);
+    if (hol->handle < 0)
+    {
+        /* a calendar which had a handle before the cache was emptied
+           gets the same one back */
+        for (number = 0; number < numHandles; ++number)
+        {
+            if (stricmp (handleCalendars[number], hol->name) == 0)
+                break;
+        }
+
+        if (number == numHandles && numHandles < HOLIDAY_MAX_HANDLES)
+        {
+            calendar = JpmcdsStringDuplicate (hol->name);
+            if (calendar != NULL)
+            {
+                /* the number is written four bits to a letter from A to P,
+                   so that the handle is unchanged by upper casing */
+                bits = number;
+                handleNames[number][0] = HOLIDAY_HANDLE_MARK;
+                for (i = HOLIDAY_HANDLE_LETTERS; i > 0; --i)
+                {
+                    handleNames[number][i] = (char)('A' + (bits & 15));
+                    bits >>= 4;
+                }
+                handleNames[number][HOLIDAY_HANDLE_LETTERS + 1] = '\0';
+                JPMCDS_ATOMIC_STORE_PTR (&handleCalendars[number], calendar);
+                ++numHandles;
+            }
+        }
+        else if (number == numHandles)
+        {
+            JpmcdsErrMsg ("%s: No more than %d handles can be made.\n", routine, HOLIDAY_MAX_HANDLES);
+        }
+
+        if (number < numHandles)
+        {
+            hol->handle = number;
+            JPMCDS_ATOMIC_STORE_PTR (&handles[number], hol);
+        }
+    }
+    if (hol->handle >= 0)
+        handle = handleNames[hol->handle];
+    JpmcdsMutexUnlock (&cacheMutex);
+
+done:
+
+    if (handle == NULL)
+        JpmcdsErrMsg ("%s: Failed.\n", routine);
+
+    return handle;
+}
+
+
+/*
+***************************************************************************
+** Finds the entry of the cache for a name or handle, reading the holidays
+** from file if they are not yet in the cache.
+***************************************************************************
+*/
+static THoliday *holidayLookup
+(char *name)    /* (I) Name or handle */
+{
+    static char   routine[] = "holidayLookup";
+
+    THoliday      *hol = NULL;
+
     /* Must have a name. */
     if (name == NULL)
     {
         JpmcdsErrMsg ("%s: NULL inputs.\n", routine);
-        goto done;
+        return NULL;
     }
 
-    /* Use holidayFind to find in the cache. Note that NONE and NO_WEEKENDS are always in the cache. */
-    hol = holidayFind (name);
-    if (hol != NULL)
+    /* A handle holds the number of its entry, four bits to a letter. */
+    if (name[0] == HOLIDAY_HANDLE_MARK)
     {
-        hl = hol->hl;
+        long  number = 0;
+        char *p;
+
+        for (p = name + 1; *p >= 'A' && *p <= 'P'; ++p)
+            number = (number << 4) | (long)(*p - 'A');
+        if (*p == '\0' && p == name + 1 + HOLIDAY_HANDLE_LETTERS)
+        {
+            hol = (THoliday*)JPMCDS_ATOMIC_LOAD_PTR (&handles[number]);
+            if (hol == NULL)
+                hol = holidayHandleReload (number);
+        }
+        if (hol == NULL)
+            JpmcdsErrMsg ("%s: Invalid calendar handle.\n", routine);
+        return hol;
     }
-    else
+
+    /* Use holidayFind to find in the cache. Most calls end here, without
+       taking any lock. */
+    hol = holidayFind (name);
+
+    if (hol == NULL)
     {
-        /* Not in the cache, so use JpmcdsHolidayListRead to read from file. */
-        hl = JpmcdsHolidayListRead (name);
-        if (hl == NULL)
-            goto done;
+        /* Look again under the mutex, since another thread may have
+           loaded the file in the meantime. Note that NONE and NO_WEEKENDS
+           are always in the cache once it is initialised. */
+        THolidayList *hl;
 
-        /* Now add hl to the cache. This takes a shallow copy, but is
-           guaranteed to be destructive if the operation fails. */
-        if (JpmcdsHolidayListAddToCache (name, hl) != SUCCESS)
-            goto done;
+        JpmcdsMutexLock (&cacheMutex);
+        if (holidayInitCache () == SUCCESS)
+        {
+            hol = holidayFind (name);
+            if (hol == NULL)
+            {
+                /* Not in the cache, so use JpmcdsHolidayListRead to read from file. */
+                hl = JpmcdsHolidayListRead (name);
+
+                /* Now add hl to the cache. This takes a shallow copy, but is
+                   guaranteed to be destructive if the operation fails. */
+                if (hl != NULL && holidayAdd (name, hl) == SUCCESS)
+                    hol = holidayFind (name);
+            }
+        }
+        JpmcdsMutexUnlock (&cacheMutex);
     }
 
-    status = SUCCESS;
+    return hol;
+}
 
-done:
 
-    if (status != SUCCESS)
-    {
-        JpmcdsErrMsg ("%s: Failed.\n", routine);
+/*
+***************************************************************************
+** Finds the entry for a handle whose entry was dropped when the cache was
+** emptied, by the name of its calendar, and gives the entry the handle.
+***************************************************************************
+*/
+static THoliday *holidayHandleReload
+(long number)   /* (I) Number of the handle */
+{
+    THoliday *hol = NULL;
+    char     *calendar;
+
+    calendar = (char*)JPMCDS_ATOMIC_LOAD_PTR (&handleCalendars[number]);
+    if (calendar == NULL || holidayLookup (calendar) == NULL)
         return NULL;
+
+    /* the entry is found again under the mutex, since it may have been
+       replaced in the meantime */
+    JpmcdsMutexLock (&cacheMutex);
+    hol = holidayFind (calendar);
+    if (hol != NULL && hol->handle < 0)
+    {
+        hol->handle = number;
+        JPMCDS_ATOMIC_STORE_PTR (&handles[number], hol);
     }
+    JpmcdsMutexUnlock (&cacheMutex);
 
-    return hl;
+    return hol;
 }
 
 /*
@@ -177,6 +403,32 @@ int JpmcdsHolidayListAddToCache
 (char         *name,   /* (I) Name to associate holidays with */
  THolidayList *hl      /* (I) Adds shallow copy */
 )
+{
+    int status;
+
+    JpmcdsMutexLock (&cacheMutex);
+    ++cacheVersion;
+    status = holidayInitCache ();
+    if (status == SUCCESS)
+        status = holidayAdd (name, hl);
+    else
+        JpmcdsHolidayListDelete (hl);
+    JpmcdsMutexUnlock (&cacheMutex);
+
+    return status;
+}
+
+
+/*
+***************************************************************************
+** Adds a holiday list to the holiday cache. The caller must hold the
+** cache mutex.
+***************************************************************************
+*/
+static int holidayAdd
+(char         *name,   /* (I) Name to associate holidays with */
+ THolidayList *hl      /* (I) Adds shallow copy */
+)
 {
     static char routine[] = "JpmcdsHolidayListAddToCache";
     int         status    = FAILURE;
@@ -185,7 +437,7 @@ int JpmcdsHolidayListAddToCache
     THoliday   *oldHol;
 
     /* JpmcdsNewHoliday creates a holiday structure with the holiday list
-       as a shallow copy, but a deep copy of the capitalized name.
+       as a shallow copy, but a deep copy of the name.
        This shallow copy is for efficiency. We do this call first so
        that we can be sure that either hl is owned by hol or hl is
        deleted. */
@@ -193,8 +445,7 @@ int JpmcdsHolidayListAddToCache
     if (hol == NULL)
         goto done;
 
-    /* If necessary get rid of the old entry with the same name. 
-       Use hol->name since this has been capitalized. */
+    /* If necessary get rid of the old entry with the same name. */
     oldHol = holidayFind(hol->name);
     if (oldHol != NULL)
     {
@@ -202,22 +453,42 @@ int JpmcdsHolidayListAddToCache
         ** Cannot delete NONE or NO_WEEKENDS at this point. This is a sign
         ** that somebody is trying to overwrite these standard names.
         */
-        if (hol->name[0] == 'N')
+        if (stricmp(hol->name, "NONE") == 0 || stricmp (hol->name, "NO_WEEKENDS") == 0)
         {
-            if (strcmp(hol->name, "NONE") == 0 || strcmp (hol->name, "NO_WEEKENDS") == 0)
-            {
-                JpmcdsErrMsg ("%s: Attempt to over-write standard holiday %s\n", routine, hol->name);
-                goto done;
-            }
+            JpmcdsErrMsg ("%s: Attempt to over-write standard holiday %s\n", routine, hol->name);
+            goto done;
         }
 
-        holidayDelete(oldHol);
+        holidayUnlink(oldHol);
     }
 
-    /* Insert into cache */
+    /* Insert into cache, and publish a table with the new entry. */
     hol->next = cache;
     cache = hol;
+    if (holidayPublish() != SUCCESS)
+    {
+        holidayUnlink(hol);
+        if (oldHol != NULL)
+        {
+            oldHol->next = cache;
+            cache = oldHol;
+        }
+        goto done;
+    }
+    /* The handle of the old entry leads to the new one. */
+    if (oldHol != NULL && oldHol->handle >= 0)
+    {
+        hol->handle = oldHol->handle;
+        JPMCDS_ATOMIC_STORE_PTR (&handles[hol->handle], hol);
+    }
     hol = NULL; /* Now owned by cache */
+
+    /* Other threads may still be looking at the old entry. */
+    if (oldHol != NULL)
+    {
+        oldHol->next = retired;
+        retired = oldHol;
+    }
     status = SUCCESS;
 
 done:
@@ -237,65 +508,130 @@ done:
 */
 void JpmcdsHolidayEmptyCache (void)
 {
-    THoliday *node;
-    THoliday *next;
+    THoliday      *node;
+    THoliday      *next;
+    THolidayTable *table;
+    long           i;
 
-    if(cache != NULL)
+    JpmcdsMutexLock (&cacheMutex);
+    for (node = cache; node != NULL; node = next)
     {
-        node = cache;
         next = node->next;
-        while (node)
-        {
-            JpmcdsFreeHoliday(node);
-            node = next;
-            if(node) next = node->next;
-        }
-        cache = NULL;
+        JpmcdsFreeHoliday(node);
+    }
+    for (node = retired; node != NULL; node = next)
+    {
+        next = node->next;
+        JpmcdsFreeHoliday(node);
     }
+    cache   = NULL;
+    retired = NULL;
+
+    /* The handles given out stay valid, and find their calendars again
+       by name. */
+    for (i = 0; i < numHandles; ++i)
+        JPMCDS_ATOMIC_STORE_PTR (&handles[i], (THoliday*)NULL);
+
+    table = cacheTable;
+    JPMCDS_ATOMIC_STORE_PTR (&cacheTable, (THolidayTable*)NULL);
+    while (table != NULL)
+    {
+        THolidayTable *older = table->older;
+        FREE(table->slots);
+        FREE(table);
+        table = older;
+    }
+    ++cacheVersion;
+    JpmcdsMutexUnlock (&cacheMutex);
 }
 
 
 /*
 ***************************************************************************
-** Finds an entry associated with a name in the cache.
-** Converts the name to upper case before searching in the hash table.
+** Returns the version of the holiday cache.
 ***************************************************************************
 */
-static THoliday *holidayFind(char *name)
+long JpmcdsHolidayCacheVersion (void)
 {
-    THoliday *hol = NULL;
+    THolidayTable *table;
+    long           version;
+
+    table = (THolidayTable*)JPMCDS_ATOMIC_LOAD_PTR (&cacheTable);
+    if (table != NULL)
+        return table->version;
 
-    /* ensure that built-in calendars are present in the cache */
+    /* the cache is empty */
+    JpmcdsMutexLock (&cacheMutex);
+    version = cacheVersion;
+    JpmcdsMutexUnlock (&cacheMutex);
+
+    return version;
+}
+
+
+/*
+***************************************************************************
+** Ensures that the built-in calendars are present in the cache.
+** The caller must hold the cache mutex.
+***************************************************************************
+*/
+static int holidayInitCache(void)
+{
     if (cache == NULL)
     {
         THoliday *h;
 
         h = JpmcdsNewHoliday(JpmcdsHolidayListNewGeneral(NULL, JPMCDS_WEEKEND_SATURDAY | JPMCDS_WEEKEND_SUNDAY), "NONE");
         if (h == NULL)
-            return NULL;
+            return FAILURE;
 
         cache = h;
         
         h = JpmcdsNewHoliday(JpmcdsHolidayListNewGeneral(NULL, JPMCDS_WEEKEND_NO_WEEKENDS), "NO_WEEKENDS");
         if (h == NULL)
-            return NULL;
+            return FAILURE;
         
         cache->next = h;
         h->next = NULL;
-    }
-    
-    hol = cache;
-    if (name != NULL)
-    {
-        while (hol)
+
+        if (holidayPublish() != SUCCESS)
         {
-            if (stricmp(name, hol->name) == 0)
-                return hol;
-            
-            hol = hol->next;
+            JpmcdsFreeHoliday(cache->next);
+            JpmcdsFreeHoliday(cache);
+            cache = NULL;
+            return FAILURE;
         }
     }
 
+    return SUCCESS;
+}
+
+
+/*
+***************************************************************************
+** Finds an entry associated with a name in the cache.
+** Searches the latest table of the cache without regard to case. Needs no
+** lock.
+***************************************************************************
+*/
+static THoliday *holidayFind(char *name)
+{
+    THolidayTable *table;
+    THoliday      *hol;
+    unsigned long  mask;
+    unsigned long  i;
+
+    table = (THolidayTable*)JPMCDS_ATOMIC_LOAD_PTR (&cacheTable);
+    if (table == NULL || name == NULL)
+        return NULL;
+
+    mask = (unsigned long)table->size - 1;
+    for (i = holidayHash(name) & mask; (hol = table->slots[i]) != NULL; i = (i + 1) & mask)
+    {
+        if (stricmp(name, hol->name) == 0)
+            return hol;
+    }
+
     /* not necessarily an error */
     return NULL;
 }
@@ -303,42 +639,104 @@ static THoliday *holidayFind(char *name)
 
 /*
 ***************************************************************************
-** Deletes an entry in the holiday cache.
+** Publishes a new table of the entries of the cache, keeping the table it
+** replaces. The caller must hold the cache mutex.
 ***************************************************************************
 */
-static void holidayDelete(THoliday *hol)
+static int holidayPublish(void)
 {
-    THoliday *node;
-    
-    /* remove node from cache list */
-    if (cache == hol)
-        cache = hol->next;
-    else
+    static char    routine[] = "holidayPublish";
+
+    THolidayTable *table = NULL;
+    THoliday      *hol;
+    long           count = 0;
+    unsigned long  mask;
+    unsigned long  i;
+
+    for (hol = cache; hol != NULL; hol = hol->next)
+        ++count;
+
+    table = NEW(THolidayTable);
+    if (table == NULL)
+        goto fail;
+
+    /* at most half full, so that searches are short and always end */
+    table->size = HOLIDAY_TABLE_MIN_SIZE;
+    while (table->size < 2 * count)
+        table->size *= 2;
+    table->slots = NEW_ARRAY(THoliday*, table->size);
+    if (table->slots == NULL)
+        goto fail;
+
+    mask = (unsigned long)table->size - 1;
+    for (i = 0; i <= mask; ++i)
+        table->slots[i] = NULL;
+    for (hol = cache; hol != NULL; hol = hol->next)
     {
-        node = cache;
-        while (node)
-        {
-            if (node->next == hol)
-                node->next = hol->next;
-            else
-                node = node->next;
-        }
+        for (i = holidayHash(hol->name) & mask; table->slots[i] != NULL; i = (i + 1) & mask)
+            ;
+        table->slots[i] = hol;
     }
 
-    /* Free memory. */
-    JpmcdsFreeHoliday(hol);
+    table->version = cacheVersion;
+    table->older   = cacheTable;
+    JPMCDS_ATOMIC_STORE_PTR (&cacheTable, table);
+
+    return SUCCESS;
+
+fail:
+    if (table != NULL)
+        FREE(table->slots);
+    FREE(table);
+    JpmcdsErrMsg ("%s: Failed.\n", routine);
+    return FAILURE;
+}
+
+
+/*
+***************************************************************************
+** Removes an entry from the list of the cache without freeing it.
+***************************************************************************
+*/
+static void holidayUnlink(THoliday *hol)
+{
+    THoliday **link = &cache;
+
+    while (*link != NULL && *link != hol)
+        link = (THoliday**)&(*link)->next;
+    if (*link != NULL)
+        *link = hol->next;
+    hol->next = NULL;
+}
+
+
+/*
+***************************************************************************
+** Hashes a name without regard to case.
+***************************************************************************
+*/
+static unsigned long holidayHash(char *name)
+{
+    unsigned long hash = 5381;
+
+    while (*name != '\0')
+    {
+        hash = hash * 33 + (unsigned long)toupper((int)(unsigned char)*name);
+        ++name;
+    }
+    return hash;
 }
 
 
 /*
 ***************************************************************************
 ** Creates a new THoliday pointer. Takes shallow copy of the holiday list,
-** takes a deep capitalized copy of the name.
+** takes a deep copy of the name.
 ***************************************************************************
 */
 static THoliday* JpmcdsNewHoliday
 (THolidayList *hl,   /* (I) Holiday list - takes shallow copy */
- char         *name  /* (I) Name - takes deep capitalized copy */
+ char         *name  /* (I) Name - takes deep copy */
 )
 {
     static char routine[] = "JpmcdsNewHoliday";
@@ -362,6 +760,15 @@ static THoliday* JpmcdsNewHoliday
     if (hol->name == NULL)
         goto done;
 
+    /* given a handle when one is asked for */
+    hol->handle = -1;
+
+    /* lists in the cache are not changed, so can always use an index,
+       keeping any which came with the list */
+    if (JPMCDS_HOLIDAY_LIST_INDEX (hol->hl) == NULL &&
+        JpmcdsHolidayListBuildIndex (hol->hl) != SUCCESS)
+        goto done;
+
     hol->next = NULL;
     status = SUCCESS;
 
@@ -450,6 +857,7 @@ THolidayList* JpmcdsHolidayListNewGeneral
     /* fill in holiday list */
     hl->dateList     = dl;
     hl->weekends     = weekends;
+    hl->index        = NULL;
     dl               = NULL; /* Now owned by hl */
 
     if (verifyHolidayList (hl) != SUCCESS)
@@ -483,11 +891,129 @@ void JpmcdsHolidayListDelete
     if (hl != NULL)
     {
         JpmcdsFreeDateList (hl->dateList);
+        holidayIndexFree (hl->index);
         FREE(hl);
     }
 }
 
 
+/*
+***************************************************************************
+** Makes the business day index of a holiday list.
+***************************************************************************
+*/
+int JpmcdsHolidayListBuildIndex
+(THolidayList *hl)  /* (I/O) Holiday list */
+{
+    static char routine[] = "JpmcdsHolidayListBuildIndex";
+    int         status    = FAILURE;
+
+    THolidayIndex *index = NULL;
+    TDate         *hols;
+    long           numHols;
+    long           holIdx;
+    long           count;
+    long           numDays;
+    long           i;
+
+    if (hl == NULL || hl->dateList == NULL)
+    {
+        JpmcdsErrMsg ("%s: NULL inputs.\n", routine);
+        goto done;
+    }
+
+    hols    = hl->dateList->fArray;
+    numHols = hl->dateList->fNumItems;
+
+    index = NEW(THolidayIndex);
+    if (index == NULL)
+        goto done;
+
+    index->startDate = JpmcdsDate (HOLIDAY_INDEX_FIRST_YEAR, 1, 1);
+    index->endDate   = JpmcdsDate (HOLIDAY_INDEX_LAST_YEAR + 1, 1, 1);
+    if (numHols > 0)
+    {
+        if (hols[0] < index->startDate)
+            index->startDate = hols[0];
+        if (hols[numHols-1] >= index->endDate)
+            index->endDate = hols[numHols-1] + 1;
+    }
+
+    /* the bitmap is made of whole words, with one more word at the end
+       so that the days before endDate can be counted from its word */
+    numDays = index->endDate - index->startDate;
+    index->nbWords = (numDays + JPMCDS_HOLIDAY_INDEX_BITS - 1) / JPMCDS_HOLIDAY_INDEX_BITS;
+    index->endDate = index->startDate + index->nbWords * JPMCDS_HOLIDAY_INDEX_BITS;
+
+    index->bits  = NEW_ARRAY(unsigned long, index->nbWords + 1);
+    index->ranks = NEW_ARRAY(long, index->nbWords + 1);
+    if (index->bits == NULL || index->ranks == NULL)
+        goto done;
+
+    holIdx = 0;
+    count  = 0;
+    for (i = 0; i < index->nbWords * JPMCDS_HOLIDAY_INDEX_BITS; ++i)
+    {
+        TDate date = index->startDate + i;
+        long  word = i / JPMCDS_HOLIDAY_INDEX_BITS;
+
+        if (i % JPMCDS_HOLIDAY_INDEX_BITS == 0)
+        {
+            index->bits[word]  = 0;
+            index->ranks[word] = count;
+        }
+
+        while (holIdx < numHols && hols[holIdx] < date)
+            ++holIdx;
+
+        if (JPMCDS_IS_WEEKDAY (date, hl->weekends) &&
+            (holIdx == numHols || hols[holIdx] != date))
+        {
+            index->bits[word] |= 1UL << (i % JPMCDS_HOLIDAY_INDEX_BITS);
+            ++count;
+        }
+    }
+    index->bits[index->nbWords]  = 0;
+    index->ranks[index->nbWords] = count;
+
+    index->dateList    = hl->dateList;
+    index->numHolidays = numHols;
+    index->weekends    = hl->weekends;
+
+    holidayIndexFree (hl->index);
+    hl->index = index;
+    index     = NULL;
+
+    status = SUCCESS;
+
+done:
+
+    holidayIndexFree (index);
+
+    if (status != SUCCESS)
+        JpmcdsErrMsg ("%s: Failed.\n", routine);
+
+    return status;
+}
+
+
+/*
+***************************************************************************
+** Frees the business day index of a holiday list.
+***************************************************************************
+*/
+static void holidayIndexFree
+(THolidayIndex *index)
+{
+    if (index != NULL)
+    {
+        FREE(index->bits);
+        FREE(index->ranks);
+        FREE(index);
+    }
+}
+
+
 /*
 ***************************************************************************
 ** Reads a holiday file into memory as a holiday list.
@@ -504,6 +1030,9 @@ void JpmcdsHolidayListDelete
 **     # FRIDAY_ALWAYS_HOLIDAY        - sets "friday as always a holiday"
 **
 ** Dates must be in increasing order.
+**
+** Binary holiday files are recognised and read by
+** JpmcdsHolidayListReadBinary.
 ***************************************************************************
 */
 THolidayList* JpmcdsHolidayListRead
@@ -522,6 +1051,9 @@ THolidayList* JpmcdsHolidayListRead
     TDateList *dl = NULL;          /* date list read in */
     long       weekends;
 
+    if (JpmcdsHolidayFileIsBinary (fileName))
+        return JpmcdsHolidayListReadBinary (fileName);
+
     fp = JpmcdsFopen (fileName, JPMCDS_FREAD);
     if (fp == NULL)
     {
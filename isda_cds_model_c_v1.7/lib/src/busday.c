@@ -120,6 +120,29 @@ static int stringToDate(
     long  *date                 /* (O) date              */
 );
 
+static THolidayIndex* holidayIndex (
+    THolidayList  * hl            /* (I) holiday list */
+);
+
+static long  indexBitCount (
+    unsigned long   bits          /* (I) word of the bitmap */
+);
+
+static long  indexRank (
+    THolidayIndex * index,        /* (I) business day index */
+    TDate           date          /* (I) in [startDate, endDate] */
+);
+
+static TDate indexSelect (
+    THolidayIndex * index,        /* (I) business day index */
+    long            rank          /* (I) business days before result */
+);
+
+static TBoolean indexIsBusinessDay (
+    THolidayIndex * index,        /* (I) business day index */
+    TDate           date          /* (I) in [startDate, endDate) */
+);
+
 /*---------------------------------------------------------------------------
  *                              Static Data.
  *---------------------------------------------------------------------------
@@ -427,6 +450,7 @@ int  JpmcdsHolidayListIsBusinessDay
 {
     static char     routine[] = "JpmcdsHolidayListIsBusinessDay";
     TBoolean        aHoliday = FALSE;
+    THolidayIndex  *index;
 
     /* Must have a holiday list */
     if (hl == NULL)
@@ -435,6 +459,13 @@ int  JpmcdsHolidayListIsBusinessDay
         return FAILURE;
     }
 
+    index = holidayIndex (hl);
+    if (index != NULL && date >= index->startDate && date < index->endDate)
+    {
+        *isBusinessDay = indexIsBusinessDay (index, date);
+        return SUCCESS;
+    }
+
     /* First check for week-ends */
     if (JPMCDS_IS_WEEKEND (date, hl->weekends))
     {
@@ -637,6 +668,10 @@ int  JpmcdsMultiHolidayListBusinessDay
             != SUCCESS)
             goto done;
 
+        /* a business day stays in its month */
+        if (nextDate == date)
+            break;
+
         if (JpmcdsDateToMDY (nextDate, &mdy1) != SUCCESS)
             goto done;
 
@@ -754,6 +789,35 @@ static int getNextBusDate
     long                   numHols = hl->dateList->fNumItems;
     TDate                * holArray = hl->dateList->fArray;
     TDate                  curDate = startDate;
+    THolidayIndex        * index = holidayIndex (hl);
+
+    /*
+    ** With an index, a business day is returned at once, and otherwise
+    ** the next business day is the one with as many business days before
+    ** it as there are before the start date.
+    */
+    if (index != NULL && startDate >= index->startDate && startDate < index->endDate)
+    {
+        long rank;
+
+        if (indexIsBusinessDay (index, startDate))
+        {
+            *nextDate = startDate;
+            return SUCCESS;
+        }
+
+        rank = indexRank (index, startDate);
+        if (direction > 0 && rank < index->ranks[index->nbWords])
+        {
+            *nextDate = indexSelect (index, rank);
+            return SUCCESS;
+        }
+        if (direction < 0 && rank > 0)
+        {
+            *nextDate = indexSelect (index, rank - 1);
+            return SUCCESS;
+        }
+    }
 
     if (IS_EMPTY_DATELIST(hl->dateList))
     {
@@ -840,6 +904,7 @@ int  JpmcdsHolidayListBusinessDaysDiff
     int                   signum = 1;  /* assume going forward by default */
     long                  numHolidays = 0L;
     TDate                 curDate = fromDate;
+    THolidayIndex        *index;
 
 /*
  * The following tables are used to calculate the number of business days
@@ -892,6 +957,27 @@ int  JpmcdsHolidayListBusinessDaysDiff
     if (fromDate == toDate)
         return SUCCESS;
 
+    /*
+    ** With an index, count the business days in [fromDate+1, toDate] or
+    ** [toDate, fromDate-1] as the difference of two ranks.
+    */
+    index = holidayIndex (hl);
+    if (index != NULL)
+    {
+        if (fromDate < toDate &&
+            fromDate + 1 >= index->startDate && toDate + 1 <= index->endDate)
+        {
+            *result = indexRank (index, toDate + 1) - indexRank (index, fromDate + 1);
+            return SUCCESS;
+        }
+        if (fromDate > toDate &&
+            toDate >= index->startDate && fromDate <= index->endDate)
+        {
+            *result = indexRank (index, toDate) - indexRank (index, fromDate);
+            return SUCCESS;
+        }
+    }
+
     /* Set the direction. */
     if (toDate < fromDate)
     {
@@ -1005,6 +1091,7 @@ int  JpmcdsHolidayListAddBusinessDays
     long               intervalSign   = SIGN( numBusDays );
     long               numBusDaysLeft = ABS( numBusDays );
     long               busDaysPerWeek = -1;
+    THolidayIndex     *index;
 
     if (hl == NULL)
     {
@@ -1012,6 +1099,34 @@ int  JpmcdsHolidayListAddBusinessDays
         goto done;
     }
 
+    /*
+    ** With an index, the result is the business day with the right number
+    ** of business days before it.
+    */
+    index = holidayIndex (hl);
+    if (index != NULL && numBusDays != 0)
+    {
+        long rank = -1;
+
+        if (numBusDays > 0 &&
+            fromDate + 1 >= index->startDate && fromDate + 1 <= index->endDate)
+        {
+            rank = indexRank (index, fromDate + 1) + numBusDays - 1;
+        }
+        else if (numBusDays < 0 &&
+                 fromDate >= index->startDate && fromDate <= index->endDate)
+        {
+            rank = indexRank (index, fromDate) + numBusDays;
+        }
+
+        if (rank >= 0 && rank < index->ranks[index->nbWords])
+        {
+            *resultDate = indexSelect (index, rank);
+            status = SUCCESS;
+            goto done;
+        }
+    }
+
     /*
     ** Get the number of business days per week. In-line for speed.
     */
@@ -1488,6 +1603,139 @@ static long calcNumWeekdayHolidays (
  */
 
 
+/*---------------------------------------------------------------------------
+ * Start of private functions using the business day index of a holiday list.
+ *---------------------------------------------------------------------------
+ */
+
+/*
+***************************************************************************
+** Returns the index of a holiday list if it was made from the current
+** dates and weekends of the list, and NULL otherwise.
+***************************************************************************
+*/
+static THolidayIndex* holidayIndex (
+    THolidayList  * hl            /* (I) holiday list */
+)
+{
+    return JPMCDS_HOLIDAY_LIST_INDEX (hl);
+}
+
+
+/*
+***************************************************************************
+** Returns the number of bits set in a word of the bitmap.
+***************************************************************************
+*/
+static long  indexBitCount (
+    unsigned long   bits          /* (I) word of the bitmap */
+)
+{
+    bits = bits - ((bits >> 1) & 0x55555555UL);
+    bits = (bits & 0x33333333UL) + ((bits >> 2) & 0x33333333UL);
+    bits = (bits + (bits >> 4)) & 0x0F0F0F0FUL;
+    return (long)(((bits * 0x01010101UL) & 0xFFFFFFFFUL) >> 24);
+}
+
+
+/*
+***************************************************************************
+** Returns the number of business days in [startDate, date) of the index.
+***************************************************************************
+*/
+static long  indexRank (
+    THolidayIndex * index,        /* (I) business day index */
+    TDate           date          /* (I) in [startDate, endDate] */
+)
+{
+    long offset = date - index->startDate;
+    long word   = offset / JPMCDS_HOLIDAY_INDEX_BITS;
+    long bit    = offset % JPMCDS_HOLIDAY_INDEX_BITS;
+
+    return index->ranks[word] +
+        indexBitCount (index->bits[word] & ((1UL << bit) - 1UL));
+}
+
+
+/*
+***************************************************************************
+** Returns the business day of the index with rank business days before
+** it, where rank is less than the number of business days in the index.
+**
+** The word is first guessed from the average number of business days per
+** word, which is out by no more than a word or two for any calendar.
+***************************************************************************
+*/
+static TDate indexSelect (
+    THolidayIndex * index,        /* (I) business day index */
+    long            rank          /* (I) business days before result */
+)
+{
+    long          *ranks = index->ranks;
+    long           word;
+    long           offset;
+    unsigned long  bits;
+
+    word = (long)((double)rank * index->nbWords / ranks[index->nbWords]);
+    if (word >= index->nbWords)
+        word = index->nbWords - 1;
+    while (ranks[word] > rank)
+        --word;
+    while (ranks[word+1] <= rank)
+        ++word;
+
+    /* step over whole bytes of the word, then over single days */
+    rank  -= ranks[word];
+    bits   = index->bits[word];
+    offset = 0;
+    for (;;)
+    {
+        long count = indexBitCount (bits & 0xFFUL);
+        if (count > rank)
+            break;
+        rank   -= count;
+        bits  >>= 8;
+        offset += 8;
+    }
+    for (;;)
+    {
+        if (bits & 1UL)
+        {
+            if (rank == 0)
+                break;
+            --rank;
+        }
+        bits >>= 1;
+        ++offset;
+    }
+
+    return index->startDate + word * JPMCDS_HOLIDAY_INDEX_BITS + offset;
+}
+
+
+/*
+***************************************************************************
+** Returns TRUE if a date of the index is a business day.
+***************************************************************************
+*/
+static TBoolean indexIsBusinessDay (
+    THolidayIndex * index,        /* (I) business day index */
+    TDate           date          /* (I) in [startDate, endDate) */
+)
+{
+    long offset = date - index->startDate;
+
+    return (TBoolean)((index->bits[offset / JPMCDS_HOLIDAY_INDEX_BITS] >>
+                       (offset % JPMCDS_HOLIDAY_INDEX_BITS)) & 1UL);
+}
+
+
+/*---------------------------------------------------------------------------
+ * End of private functions using the business day index of a holiday list.
+ *---------------------------------------------------------------------------
+ */
+
+
 /*
 ***************************************************************************
 ** Computes the last business day of the month.
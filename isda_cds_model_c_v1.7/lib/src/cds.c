@@ -17,6 +17,126 @@
 #include "busday.h"
 #include "dtlist.h"
 #include "cerror.h"
+#include "curvecache.h"
+#include "timeline.h"
+#include "dateconv.h"
+#include "cxbsearch.h"
+#include "schedcache.h"
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+
+
+/*
+** Number of days beyond the last end date of a group of trades for which
+** factors are remembered in batch pricing. Allows for the adjustment of
+** the last payment date.
+*/
+#define BATCH_CACHE_EXTRA_DAYS 14
+
+
+/*
+***************************************************************************
+** Sort key for grouping the trades of a batch.
+***************************************************************************
+*/
+typedef struct
+{
+    TCurve     *discCurve;
+    TCurve     *spreadCurve;
+    TDate       startDate;
+    TDate       endDate;
+    long        idx;
+} TBatchKey;
+
+
+/*
+***************************************************************************
+** Orders batch keys by curves, then by start date and end date, then by
+** position in the trade table.
+***************************************************************************
+*/
+static int batchKeyCompare(const void *a, const void *b);
+
+
+/*
+***************************************************************************
+** Computes the price for a table of vanilla CDS, with or without the
+** segment integrals of segint.h.
+***************************************************************************
+*/
+static int CdsPriceBatch
+(TDate             today,
+ TDate             settleDate,
+ TDate             stepinDate,
+ TCdsTradeTable   *trades,
+ TBoolean          payAccOnDefault,
+ TDateInterval    *dateInterval,
+ TStubMethod      *stubType,
+ long              paymentDcc,
+ long              badDayConv,
+ char             *calendar,
+ TBoolean          isPriceClean,
+ TBoolean          vectorIntegrals,
+ double           *prices);
+
+
+/*
+***************************************************************************
+** Finds the node of a schedule at which each of a sorted set of end dates
+** falls, if the schedule for each end date is a prefix of the schedule.
+***************************************************************************
+*/
+static TBoolean parSpreadsShareSchedule
+(TDateList     *dl,
+ long           nbKeys,
+ TBatchKey     *keys,
+ TDateInterval *interval,
+ TStubMethod   *stubType,
+ long          *nodes);
+
+
+/*
+***************************************************************************
+** Computes par spreads for sorted end dates in one pass along a shared
+** schedule.
+***************************************************************************
+*/
+static int parSpreadsAlongSchedule
+(TDate            today,
+ TDate            stepinDate,
+ TDate            startDate,
+ TFeeLeg         *fl,
+ long             nbKeys,
+ TBatchKey       *keys,
+ long            *nodes,
+ TCurvePairCache *curves,
+ double           recoveryRate,
+ double          *parSpread);
+
+
+/*
+***************************************************************************
+** Computes par spreads, valuing the legs apart or in one walk.
+***************************************************************************
+*/
+static int CdsParSpreads
+(TDate           today,
+ TDate           stepinDate,
+ TDate           startDate,
+ long            nbEndDates,
+ TDate          *endDates,
+ TBoolean        payAccOnDefault,
+ TDateInterval  *couponInterval,
+ TStubMethod    *stubType,
+ long            paymentDcc,
+ long            badDayConv,
+ char           *calendar,
+ TCurve         *discCurve,
+ TCurve         *spreadCurve,
+ double          recoveryRate,
+ TBoolean        oneWalk,
+ double         *parSpread);
 
 
 /*
@@ -112,6 +232,9 @@ int JpmcdsCdsContingentLegPV
 ***************************************************************************
 ** Makes a fixed fee leg for a vanilla CDS.
 ** Note that you are protected on both startDate and endDate.
+**
+** The dates come from the schedule cache, so a fee leg with the same
+** terms as an earlier one is made without generating its dates again.
 ***************************************************************************
 */
 TFeeLeg* JpmcdsCdsFeeLegMake
@@ -128,15 +251,56 @@ TFeeLeg* JpmcdsCdsFeeLegMake
  TBoolean        protectStart)
 {
     static char routine[] = "JpmcdsCdsFeeLegMake";
-    int         status    = FAILURE;
 
-    TDateList    *dl = NULL;
-    TFeeLeg      *fl = NULL;
-    TDateInterval ivl3M;
-    TDate         prevDate;
-    TDate         prevDateAdj;
+    TFeeLeg *fl;
+
+    /* no payment ends on or before the earliest date */
+    fl = JpmcdsCdsFeeLegMakeLive (startDate, endDate, payAccOnDefault,
+                                  dateInterval, stubType, notional,
+                                  couponRate, paymentDcc, badDayConv,
+                                  calendar, protectStart, 0);
+    if (fl == NULL)
+        JpmcdsErrMsgFailure (routine);
+
+    return fl;
+}
 
-    int i;
+
+/*
+***************************************************************************
+** Makes the live part of a fixed fee leg for a vanilla CDS.
+**
+** The schedule is the whole one from the schedule cache, and the payments
+** copied from it start at the first whose accrual ends after stepinDate is
+** observed. The accrual on default of the first payment copied is then
+** observed after its start date, so the start date does not add a point
+** to the timeline which the whole leg would not have.
+***************************************************************************
+*/
+TFeeLeg* JpmcdsCdsFeeLegMakeLive
+(TDate           startDate,
+ TDate           endDate,
+ TBoolean        payAccOnDefault,
+ TDateInterval  *dateInterval,
+ TStubMethod    *stubType,
+ double          notional,
+ double          couponRate,
+ long            paymentDcc,
+ long            badDayConv,
+ char           *calendar,
+ TBoolean        protectStart,
+ TDate           stepinDate)
+{
+    static char routine[] = "JpmcdsCdsFeeLegMakeLive";
+    int         status    = FAILURE;
+
+    TFeeLegSchedule *schedule = NULL;
+    TFeeLeg         *fl       = NULL;
+    TDateInterval    ivl3M;
+    TDate            obsStepinDate;
+    long             exact;
+    long             lo;
+    long             first;
 
     SET_TDATE_INTERVAL(ivl3M,3,'M');
     if (dateInterval == NULL)
@@ -147,26 +311,29 @@ TFeeLeg* JpmcdsCdsFeeLegMake
     else
         REQUIRE (endDate > startDate);
 
-    if(protectStart && endDate == startDate)
-    {
-        TDate dates[2];
-        dates[0] = startDate;
-        dates[1] = endDate;
-        dl = JpmcdsNewDateListFromDates(dates, 2);
-    } else
-    {
-        dl = JpmcdsDateListMakeRegular (startDate, endDate, dateInterval, stubType);
-    }
-    if (dl == NULL)
+    schedule = JpmcdsFeeLegScheduleGet (startDate, endDate, dateInterval, stubType,
+                                        badDayConv, calendar, protectStart);
+    if (schedule == NULL)
         goto done;
 
-    /* the datelist includes both start date and end date */
-    /* therefore it has one more element than the fee leg requires */
+    /* the first payment whose accrual ends after stepinDate is observed,
+       or the last */
+    obsStepinDate = protectStart ? stepinDate - 1 : stepinDate;
+    if (JpmcdsBinarySearchLong (obsStepinDate, schedule->accEndDates,
+                                sizeof(TDate), schedule->nbDates,
+                                &exact, &lo, &first) != SUCCESS)
+        goto done;
+    if (first > schedule->nbDates - 1)
+        first = schedule->nbDates - 1;
 
-    fl = JpmcdsFeeLegMakeEmpty (dl->fNumItems-1);
+    fl = JpmcdsFeeLegMakeEmpty (schedule->nbDates - first);
     if (fl == NULL)
         goto done;
 
+    memcpy (fl->accStartDates, schedule->accStartDates + first, fl->nbDates * sizeof(TDate));
+    memcpy (fl->accEndDates, schedule->accEndDates + first, fl->nbDates * sizeof(TDate));
+    memcpy (fl->payDates, schedule->payDates + first, fl->nbDates * sizeof(TDate));
+
     if (payAccOnDefault)
     {
         fl->accrualPayConv = ACCRUAL_PAY_ALL;
@@ -178,40 +345,10 @@ TFeeLeg* JpmcdsCdsFeeLegMake
     }
     fl->dcc = paymentDcc;
 
-    prevDate = dl->fArray[0];
-    prevDateAdj = prevDate; /* first date is not bad day adjusted */
-
-    for (i = 0; i < fl->nbDates; ++i)
-    {
-        TDate nextDate = dl->fArray[i+1];
-        TDate nextDateAdj;
-
-        if (JpmcdsBusinessDay (nextDate, badDayConv, calendar, &nextDateAdj) != SUCCESS)
-            goto done;
-
-        fl->accStartDates[i] = prevDateAdj;
-        fl->accEndDates[i]   = nextDateAdj;
-        fl->payDates[i]      = nextDateAdj;
-
-        prevDate    = nextDate;
-        prevDateAdj = nextDateAdj;
-    }
+    fl->notional      = notional;
+    fl->couponRate    = couponRate;
+    fl->obsStartOfDay = protectStart ? TRUE : FALSE;
 
-    fl->notional    = notional;
-    fl->couponRate  = couponRate;
-
-    /* the last accrual date is not adjusted */
-    /* also we may have one extra day of accrued interest */
-    if (protectStart)
-    {
-        fl->accEndDates[fl->nbDates-1] = prevDate+1;
-        fl->obsStartOfDay              = TRUE;
-    }
-    else
-    {
-        fl->accEndDates[fl->nbDates-1] = prevDate;
-        fl->obsStartOfDay              = FALSE;
-    }
     status = SUCCESS;
 
  done:
@@ -223,7 +360,7 @@ TFeeLeg* JpmcdsCdsFeeLegMake
         fl = NULL;
     }
 
-    JpmcdsFreeDateList (dl);
+    JpmcdsFeeLegScheduleRelease (schedule);
 
     return fl;
 }
@@ -260,10 +397,10 @@ int JpmcdsCdsFeeLegPV
 
     TFeeLeg *fl = NULL;
 
-    fl = JpmcdsCdsFeeLegMake (startDate, endDate, payAccOnDefault,
-                              dateInterval, stubType, notional,
-                              couponRate, paymentDcc, badDayConv,
-                              calendar, protectStart);
+    fl = JpmcdsCdsFeeLegMakeLive (startDate, endDate, payAccOnDefault,
+                                  dateInterval, stubType, notional,
+                                  couponRate, paymentDcc, badDayConv,
+                                  calendar, protectStart, stepinDate);
     if (fl == NULL)
         goto done;
 
@@ -370,9 +507,594 @@ EXPORT int JpmcdsCdsPrice
 }
 
 
+/*
+***************************************************************************
+** Computes the price for a vanilla CDS and its gradient with respect to
+** the rates of both curves.
+**
+** The legs are made as by JpmcdsCdsPrice and valued together, with the
+** price as the weighted sum of the legs whose gradient is accumulated.
+***************************************************************************
+*/
+EXPORT int JpmcdsCdsPriceAdjoint
+(TDate             today,
+ TDate             settleDate,
+ TDate             stepinDate,
+ TDate             startDate,
+ TDate             endDate,
+ double            couponRate,
+ TBoolean          payAccOnDefault,
+ TDateInterval    *dateInterval,
+ TStubMethod      *stubType,
+ long              paymentDcc,
+ long              badDayConv,
+ char             *calendar,
+ TCurve           *discCurve,
+ TCurve           *spreadCurve,
+ double            recoveryRate,
+ TBoolean          isPriceClean,
+ double           *price,
+ double           *discGrad,
+ double           *spreadGrad)
+{
+    static char routine[] = "JpmcdsCdsPriceAdjoint";
+    int         status    = FAILURE;
+
+    TFeeLeg         *fl = NULL;
+    TContingentLeg  *cl = NULL;
+    TCurvePairCache  curves;
+    TCdsLegsAdjoint  adjoint;
+    TCdsLegsPV       legs;
+    TDate            protStartDate = MAX(stepinDate, startDate);
+    TBoolean         protectStart = TRUE;
+    long             i;
+
+    REQUIRE(price != NULL);
+    REQUIRE(discGrad != NULL);
+    REQUIRE(spreadGrad != NULL);
+    REQUIRE(discCurve != NULL);
+    REQUIRE(spreadCurve != NULL);
+    REQUIRE(stepinDate >= today);
+
+    fl = JpmcdsCdsFeeLegMakeLive(startDate,
+                                 endDate,
+                                 payAccOnDefault,
+                                 dateInterval,
+                                 stubType,
+                                 1.0, /* notional */
+                                 couponRate,
+                                 paymentDcc,
+                                 badDayConv,
+                                 calendar,
+                                 protectStart,
+                                 stepinDate);
+    if (fl == NULL)
+        goto done;
+
+    if (protStartDate <= endDate)
+    {
+        cl = JpmcdsCdsContingentLegMake(protStartDate,
+                                        endDate,
+                                        1.0, /* notional */
+                                        protectStart);
+        if (cl == NULL)
+            goto done;
+    }
+
+    for (i = 0; i < discCurve->fNumItems; ++i)
+        discGrad[i] = 0.0;
+    for (i = 0; i < spreadCurve->fNumItems; ++i)
+        spreadGrad[i] = 0.0;
+
+    adjoint.contingentWeight = 1.0;
+    adjoint.feeWeight        = -couponRate;
+    adjoint.discGrad         = discGrad;
+    adjoint.spreadGrad       = spreadGrad;
+
+    JpmcdsCurvePairCacheInit(&curves, today, discCurve, spreadCurve);
+
+    if (JpmcdsFeeAndContingentLegPVAdjoint(fl,
+                                           cl,
+                                           today,
+                                           stepinDate,
+                                           settleDate,
+                                           &curves,
+                                           recoveryRate,
+                                           &adjoint,
+                                           &legs) != SUCCESS)
+        goto done;
+
+    *price = legs.contingentPV - couponRate *
+        (legs.rpv01 - (isPriceClean ? legs.accruedInterest : 0.0));
+    status = SUCCESS;
+
+ done:
+
+    if (status != SUCCESS)
+        JpmcdsErrMsgFailure (routine);
+
+    JpmcdsFeeLegFree(fl);
+    FREE(cl);
+
+    return status;
+}
+
+
+/*
+***************************************************************************
+** Computes the price for a table of vanilla CDS.
+**
+** The trades are sorted by their curves so that all the trades of one
+** pair of curves are priced against one curve pair cache. Within a pair
+** of curves the trades are sorted by start date and end date so that
+** consecutive trades with the same dates can use the same legs.
+**
+** The scratch memory of each trade comes from an arena given to the curve
+** pair cache, which is reset after each trade.
+***************************************************************************
+*/
+EXPORT int JpmcdsCdsPriceBatch
+(TDate             today,
+ TDate             settleDate,
+ TDate             stepinDate,
+ TCdsTradeTable   *trades,
+ TBoolean          payAccOnDefault,
+ TDateInterval    *dateInterval,
+ TStubMethod      *stubType,
+ long              paymentDcc,
+ long              badDayConv,
+ char             *calendar,
+ TBoolean          isPriceClean,
+ double           *prices)
+{
+    return CdsPriceBatch (today, settleDate, stepinDate, trades,
+                          payAccOnDefault, dateInterval, stubType,
+                          paymentDcc, badDayConv, calendar, isPriceClean,
+                          FALSE, prices);
+}
+
+
+/*
+***************************************************************************
+** Computes the price for a table of vanilla CDS with the segment
+** integrals of segint.h.
+***************************************************************************
+*/
+EXPORT int JpmcdsCdsPriceBatchVectorIntegrals
+(TDate             today,
+ TDate             settleDate,
+ TDate             stepinDate,
+ TCdsTradeTable   *trades,
+ TBoolean          payAccOnDefault,
+ TDateInterval    *dateInterval,
+ TStubMethod      *stubType,
+ long              paymentDcc,
+ long              badDayConv,
+ char             *calendar,
+ TBoolean          isPriceClean,
+ double           *prices)
+{
+    return CdsPriceBatch (today, settleDate, stepinDate, trades,
+                          payAccOnDefault, dateInterval, stubType,
+                          paymentDcc, badDayConv, calendar, isPriceClean,
+                          TRUE, prices);
+}
+
+
+/*
+***************************************************************************
+** Computes the price for a table of vanilla CDS, with or without the
+** segment integrals of segint.h.
+***************************************************************************
+*/
+static int CdsPriceBatch
+(TDate             today,
+ TDate             settleDate,
+ TDate             stepinDate,
+ TCdsTradeTable   *trades,
+ TBoolean          payAccOnDefault,
+ TDateInterval    *dateInterval,
+ TStubMethod      *stubType,
+ long              paymentDcc,
+ long              badDayConv,
+ char             *calendar,
+ TBoolean          isPriceClean,
+ TBoolean          vectorIntegrals,
+ double           *prices)
+{
+    static char routine[] = "CdsPriceBatch";
+    int         status    = FAILURE;
+
+    TBatchKey       *keys   = NULL;
+    TCurvePairCache *curves = NULL;
+    TFeeLeg         *fl     = NULL;
+    TContingentLeg  *cl     = NULL;
+    TArena          *arena  = NULL;
+    TDate            valueDate;
+    TDate            legStartDate = 0;
+    TDate            legEndDate   = 0;
+    TBoolean         protectStart = TRUE;
+    long             i;
+    long             j;
+
+    REQUIRE(trades != NULL);
+    REQUIRE(prices != NULL);
+    REQUIRE(trades->nbTrades >= 0);
+    REQUIRE(stepinDate >= today);
+
+    if (trades->nbTrades == 0)
+    {
+        status = SUCCESS;
+        goto done;
+    }
+
+    REQUIRE(trades->startDates != NULL);
+    REQUIRE(trades->endDates != NULL);
+    REQUIRE(trades->couponRates != NULL);
+    REQUIRE(trades->recoveryRates != NULL);
+    REQUIRE(trades->discCurves != NULL);
+    REQUIRE(trades->spreadCurves != NULL);
+
+    valueDate = settleDate;
+
+    keys = NEW_ARRAY(TBatchKey, trades->nbTrades);
+    if (keys == NULL)
+        goto done;
+
+    arena = JpmcdsArenaMake(0);
+    if (arena == NULL)
+        goto done;
+
+    for (i = 0; i < trades->nbTrades; ++i)
+    {
+        if (trades->discCurves[i] == NULL || trades->spreadCurves[i] == NULL)
+        {
+            JpmcdsErrMsg("%s: Missing curve for trade %ld.\n", routine, i);
+            goto done;
+        }
+        keys[i].discCurve   = trades->discCurves[i];
+        keys[i].spreadCurve = trades->spreadCurves[i];
+        keys[i].startDate   = trades->startDates[i];
+        keys[i].endDate     = trades->endDates[i];
+        keys[i].idx         = i;
+    }
+
+    qsort(keys, trades->nbTrades, sizeof(TBatchKey), batchKeyCompare);
+
+    i = 0;
+    while (i < trades->nbTrades)
+    {
+        long  groupEnd;
+        TDate lastDate = MAX(keys[i].endDate, valueDate);
+
+        for (groupEnd = i+1; groupEnd < trades->nbTrades; ++groupEnd)
+        {
+            if (keys[groupEnd].discCurve != keys[i].discCurve ||
+                keys[groupEnd].spreadCurve != keys[i].spreadCurve)
+                break;
+            lastDate = MAX(lastDate, keys[groupEnd].endDate);
+        }
+
+        /* nothing is observed before the start of today */
+        curves = JpmcdsCurvePairCacheMake(today,
+                                          today - 1,
+                                          MAX(lastDate, today) + BATCH_CACHE_EXTRA_DAYS,
+                                          keys[i].discCurve,
+                                          keys[i].spreadCurve);
+        if (curves == NULL)
+            goto done;
+        JpmcdsCurvePairCacheSetVectorIntegrals(curves, vectorIntegrals);
+        JpmcdsCurvePairCacheSetArena(curves, arena);
+
+        for (j = i; j < groupEnd; ++j)
+        {
+            long   idx = keys[j].idx;
+            TDate  protStartDate = MAX(stepinDate, keys[j].startDate);
+            double feeLegPV = 0;
+            double contingentLegPV = 0;
+
+            if (fl == NULL ||
+                keys[j].startDate != legStartDate ||
+                keys[j].endDate != legEndDate)
+            {
+                JpmcdsFeeLegFree(fl);
+                FREE(cl);
+                fl = NULL;
+                cl = NULL;
+
+                legStartDate = keys[j].startDate;
+                legEndDate   = keys[j].endDate;
+
+                fl = JpmcdsCdsFeeLegMakeLive(legStartDate,
+                                             legEndDate,
+                                             payAccOnDefault,
+                                             dateInterval,
+                                             stubType,
+                                             1.0, /* notional */
+                                             0.0, /* couponRate set below */
+                                             paymentDcc,
+                                             badDayConv,
+                                             calendar,
+                                             protectStart,
+                                             stepinDate);
+                if (fl != NULL && protStartDate <= legEndDate)
+                {
+                    cl = JpmcdsCdsContingentLegMake(protStartDate,
+                                                    legEndDate,
+                                                    1.0, /* notional */
+                                                    protectStart);
+                }
+
+                if (fl == NULL)
+                {
+                    JpmcdsErrMsg("%s: Fee leg failed for trade %ld.\n", routine, idx);
+                    goto done;
+                }
+
+                if (cl == NULL && protStartDate <= legEndDate)
+                {
+                    JpmcdsErrMsg("%s: Contingent leg failed for trade %ld.\n",
+                                 routine, idx);
+                    goto done;
+                }
+            }
+
+            fl->couponRate = trades->couponRates[idx];
+
+            if (JpmcdsFeeLegPVWithCache(fl,
+                                        today,
+                                        stepinDate,
+                                        valueDate,
+                                        curves,
+                                        isPriceClean,
+                                        &feeLegPV) != SUCCESS)
+            {
+                JpmcdsErrMsg("%s: Fee leg PV failed for trade %ld.\n", routine, idx);
+                goto done;
+            }
+
+            if (cl != NULL)
+            {
+                if (JpmcdsContingentLegPVWithCache(cl,
+                                                   today,
+                                                   valueDate,
+                                                   protStartDate,
+                                                   curves,
+                                                   trades->recoveryRates[idx],
+                                                   &contingentLegPV) != SUCCESS)
+                {
+                    JpmcdsErrMsg("%s: Contingent leg PV failed for trade %ld.\n",
+                                 routine, idx);
+                    goto done;
+                }
+            }
+
+            prices[idx] = contingentLegPV - feeLegPV;
+
+            /* the scratch memory of the trade is no longer needed */
+            JpmcdsArenaReset(arena);
+        }
+
+        JpmcdsCurvePairCacheFree(curves);
+        curves = NULL;
+        i = groupEnd;
+    }
+
+    status = SUCCESS;
+
+ done:
+
+    if (status != SUCCESS)
+        JpmcdsErrMsgFailure (routine);
+
+    JpmcdsCurvePairCacheFree(curves);
+    JpmcdsArenaFree(arena);
+    JpmcdsFeeLegFree(fl);
+    FREE(cl);
+    FREE(keys);
+
+    return status;
+}
+
+
+/*
+***************************************************************************
+** Orders batch keys by curves, then by start date and end date, then by
+** position in the trade table.
+***************************************************************************
+*/
+static int batchKeyCompare(const void *a, const void *b)
+{
+    const TBatchKey *ka = (const TBatchKey*)a;
+    const TBatchKey *kb = (const TBatchKey*)b;
+
+    if ((size_t)ka->discCurve != (size_t)kb->discCurve)
+        return (size_t)ka->discCurve < (size_t)kb->discCurve ? -1 : 1;
+    if ((size_t)ka->spreadCurve != (size_t)kb->spreadCurve)
+        return (size_t)ka->spreadCurve < (size_t)kb->spreadCurve ? -1 : 1;
+    if (ka->startDate != kb->startDate)
+        return ka->startDate < kb->startDate ? -1 : 1;
+    if (ka->endDate != kb->endDate)
+        return ka->endDate < kb->endDate ? -1 : 1;
+    if (ka->idx != kb->idx)
+        return ka->idx < kb->idx ? -1 : 1;
+    return 0;
+}
+
+
+/*
+***************************************************************************
+** Finds the node of a schedule at which each of a sorted set of end dates
+** falls, if the schedule for each end date is a prefix of the schedule.
+**
+** Schedules with a back stub are generated forwards from the start date,
+** so any end date on the schedule gives a prefix. Schedules with a front
+** stub are generated backwards from the end date, and give the same
+** dates from an earlier end date on the schedule only when no date needs
+** to be moved to the end of a month.
+***************************************************************************
+*/
+static TBoolean parSpreadsShareSchedule
+(TDateList     *dl,
+ long           nbKeys,
+ TBatchKey     *keys,
+ TDateInterval *interval,
+ TStubMethod   *stubType,
+ long          *nodes)
+{
+    long k;
+
+    if (!stubType->stubAtEnd)
+    {
+        switch (toupper(interval->prd_typ))
+        {
+        case 'D':
+        case 'W':
+            break;
+        case 'M':
+        case 'A':
+        case 'Y':
+        case 'S':
+        case 'Q':
+        {
+            TMonthDayYear mdy;
+            if (JpmcdsDateToMDY (dl->fArray[dl->fNumItems-1], &mdy) != SUCCESS ||
+                mdy.day > 28)
+                return FALSE;
+            break;
+        }
+        default:
+            return FALSE;
+        }
+    }
+
+    for (k = 0; k < nbKeys; ++k)
+    {
+        long exact;
+
+        if (JpmcdsBinarySearchLong (keys[k].endDate, dl->fArray, sizeof(TDate),
+                                    dl->fNumItems, &exact, NULL, NULL) != SUCCESS ||
+            exact < 1)
+            return FALSE;
+
+        nodes[k] = exact;
+    }
+
+    return TRUE;
+}
+
+
+/*
+***************************************************************************
+** Computes par spreads for sorted end dates in one pass along a shared
+** schedule.
+**
+** The fee leg fl is that of the last end date. The leg of the end date at
+** node m of the schedule has the first m-1 periods of fl and a final
+** period which ends one day after the node. Fee and protection PVs are
+** accumulated from one end date to the next, and only the final period
+** is valued for each end date.
+***************************************************************************
+*/
+static int parSpreadsAlongSchedule
+(TDate            today,
+ TDate            stepinDate,
+ TDate            startDate,
+ TFeeLeg         *fl,
+ long             nbKeys,
+ TBatchKey       *keys,
+ long            *nodes,
+ TCurvePairCache *curves,
+ double           recoveryRate,
+ double          *parSpread)
+{
+    static char routine[] = "parSpreadsAlongSchedule";
+    int         status    = FAILURE;
+
+    double      feePV = 0.0;
+    double      contingentPV = 0.0;
+    double      ai = 0.0;
+    TDate       protDate;
+    long        k;
+
+    /* as JpmcdsCdsContingentLegMake for each end date separately */
+    protDate = MAX(stepinDate, startDate) - 1;
+
+    for (k = 0; k < nbKeys; ++k)
+    {
+        TCdsLegsPV     legs;
+        TFeeLeg        lastFl;
+        TContingentLeg cl;
+        TDate          accStartDate = fl->accStartDates[nodes[k]-1];
+        TDate          accEndDate   = keys[k].endDate + 1;
+        TDate          payDate      = fl->payDates[nodes[k]-1];
+        long           lo = k == 0 ? 0 : nodes[k-1] - 1;
+        long           hi = nodes[k] - 1;
+
+        if (hi > lo)
+        {
+            /* periods which are not final for this end date */
+            TFeeLeg periods = *fl;
+
+            periods.nbDates       = hi - lo;
+            periods.accStartDates = fl->accStartDates + lo;
+            periods.accEndDates   = fl->accEndDates + lo;
+            periods.payDates      = fl->payDates + lo;
+
+            if (JpmcdsFeeAndContingentLegPV (&periods, NULL, today,
+                                             stepinDate, stepinDate,
+                                             curves, recoveryRate,
+                                             &legs) != SUCCESS)
+                goto done;
+
+            feePV += legs.rpv01;
+            ai    += legs.accruedInterest;
+        }
+
+        lastFl = *fl;
+        lastFl.nbDates       = 1;
+        lastFl.accStartDates = &accStartDate;
+        lastFl.accEndDates   = &accEndDate;
+        lastFl.payDates      = &payDate;
+
+        /* protection since the previous end date */
+        cl.startDate    = k == 0 ? protDate : MAX(protDate, keys[k-1].endDate);
+        cl.endDate      = keys[k].endDate;
+        cl.notional     = 1.0;
+        cl.payType      = PROT_PAY_DEF;
+        cl.protectStart = TRUE;
+
+        if (JpmcdsFeeAndContingentLegPV (&lastFl,
+                                         cl.endDate > cl.startDate ? &cl : NULL,
+                                         today, stepinDate, stepinDate,
+                                         curves, recoveryRate,
+                                         &legs) != SUCCESS)
+            goto done;
+
+        contingentPV += legs.contingentPV;
+
+        parSpread[keys[k].idx] = contingentPV /
+            (feePV + legs.rpv01 -
+             (stepinDate > accStartDate ? legs.accruedInterest : ai));
+    }
+
+    status = SUCCESS;
+
+ done:
+
+    if (status != SUCCESS)
+        JpmcdsErrMsgFailure (routine);
+
+    return status;
+}
+
+
 /*
 ***************************************************************************
 ** Computes the par spread for a vanilla CDS which produces a zero price.
+**
+** The legs of each benchmark are valued apart, with the curves prepared
+** once for all benchmarks.
 ***************************************************************************
 */
 EXPORT int JpmcdsCdsParSpreads(
@@ -392,55 +1114,234 @@ EXPORT int JpmcdsCdsParSpreads(
     double          recoveryRate,
     double         *parSpread)
 {
-    static char routine[] = "JpmcdsCdsParSpread";
+    return CdsParSpreads (today, stepinDate, startDate, nbEndDates, endDates,
+                          payAccOnDefault, couponInterval, stubType,
+                          paymentDcc, badDayConv, calendar, discCurve,
+                          spreadCurve, recoveryRate, FALSE, parSpread);
+}
+
+
+/*
+***************************************************************************
+** Computes the par spread for a vanilla CDS which produces a zero price,
+** valuing both legs of each benchmark in a single walk of their timeline.
+**
+** When the schedule of each benchmark is a prefix of the schedule of the
+** last benchmark, that schedule is made once and the PVs are accumulated
+** along it, so that the cost is linear in the last end date.
+***************************************************************************
+*/
+EXPORT int JpmcdsCdsParSpreadsOneWalk(
+    TDate           today,
+    TDate           stepinDate,
+    TDate           startDate,
+    long            nbEndDates,
+    TDate          *endDates,
+    TBoolean        payAccOnDefault,
+    TDateInterval  *couponInterval,
+    TStubMethod    *stubType,
+    long            paymentDcc,
+    long            badDayConv,
+    char           *calendar,
+    TCurve         *discCurve,
+    TCurve         *spreadCurve,
+    double          recoveryRate,
+    double         *parSpread)
+{
+    return CdsParSpreads (today, stepinDate, startDate, nbEndDates, endDates,
+                          payAccOnDefault, couponInterval, stubType,
+                          paymentDcc, badDayConv, calendar, discCurve,
+                          spreadCurve, recoveryRate, TRUE, parSpread);
+}
+
+
+/*
+***************************************************************************
+** Computes par spreads, valuing the legs apart or in one walk.
+***************************************************************************
+*/
+static int CdsParSpreads
+(TDate           today,
+ TDate           stepinDate,
+ TDate           startDate,
+ long            nbEndDates,
+ TDate          *endDates,
+ TBoolean        payAccOnDefault,
+ TDateInterval  *couponInterval,
+ TStubMethod    *stubType,
+ long            paymentDcc,
+ long            badDayConv,
+ char           *calendar,
+ TCurve         *discCurve,
+ TCurve         *spreadCurve,
+ double          recoveryRate,
+ TBoolean        oneWalk,
+ double         *parSpread)
+{
+    static char routine[] = "CdsParSpreads";
     int         status    = FAILURE;
 
-    double      feeLegPV;
-    double      contingentLegPV;
-    long        i;
-    TBoolean    isPriceClean = 1;
-    TBoolean    protectStart = TRUE;
+    TCurvePairCache curves;
+    TCdsLegsPV      legs;
+    TFeeLeg        *fl = NULL;
+    TContingentLeg *cl = NULL;
+    TBatchKey      *keys = NULL;
+    long           *nodes = NULL;
+    TDateList      *dl = NULL;
+    TDateInterval   ivl3M;
+    long            i;
+    TBoolean        protectStart = TRUE;
+    TBoolean        legsApart;
+
+    JpmcdsCurvePairCacheInit (&curves, today, discCurve, spreadCurve);
 
     REQUIRE(parSpread != NULL);
     REQUIRE(nbEndDates >= 1);
     REQUIRE(stepinDate >= today);
+    REQUIRE(discCurve != NULL);
+    REQUIRE(spreadCurve != NULL);
     /* all other requirements can be handled by the routines we call */
 
-    for(i = 0; i < nbEndDates; ++i)
+    curves.criticalDates = JpmcdsRiskyCriticalDates (discCurve, spreadCurve);
+    if (curves.criticalDates == NULL)
+        goto done;
+
+    if (JpmcdsCurvePairCachePrepare (&curves) != SUCCESS)
+        goto done;
+
+    SET_TDATE_INTERVAL(ivl3M,3,'M');
+    if (couponInterval == NULL)
+        couponInterval = &ivl3M;
+
+    /* Walking both legs at once, or along a shared schedule, splits the
+       integrals at dates where valuing the legs apart does not, which
+       changes the spreads by rounding. The split changes the integral
+       itself where a curve jumps, as a curve with repeated dates does,
+       and such a curve is left unprepared. */
+    legsApart = !oneWalk ||
+        curves.discPrepared == NULL || curves.spreadPrepared == NULL;
+
+    if (!legsApart)
     {
-        if (JpmcdsCdsFeeLegPV(today,
-                              stepinDate, /* valueDate */
-                              stepinDate,
-                              startDate,
-                              endDates[i],
-                              payAccOnDefault,
-                              couponInterval,
-                              stubType,
-                              1.0, /* notional */
-                              1.0, /* couponRate */
-                              paymentDcc,
-                              badDayConv,
-                              calendar,
-                              discCurve,
-                              spreadCurve,
-                              protectStart,
-                              isPriceClean,
-                              &feeLegPV) != SUCCESS)
+        keys  = NEW_ARRAY(TBatchKey, nbEndDates);
+        nodes = NEW_ARRAY(long, nbEndDates);
+        if (keys == NULL || nodes == NULL)
             goto done;
 
-        if (JpmcdsCdsContingentLegPV(today,
-                                     stepinDate,
-                                     MAX(stepinDate, startDate),
+        for (i = 0; i < nbEndDates; ++i)
+        {
+            keys[i].discCurve   = discCurve;
+            keys[i].spreadCurve = spreadCurve;
+            keys[i].startDate   = startDate;
+            keys[i].endDate     = endDates[i];
+            keys[i].idx         = i;
+        }
+        qsort(keys, nbEndDates, sizeof(TBatchKey), batchKeyCompare);
+    }
+
+    /* the legs of each end date would fail otherwise */
+    if (!legsApart && keys[0].endDate > MAX(stepinDate, startDate))
+    {
+        dl = JpmcdsDateListMakeRegular (startDate, keys[nbEndDates-1].endDate,
+                                        couponInterval, stubType);
+        if (dl == NULL)
+            goto done;
+
+        if (parSpreadsShareSchedule (dl, nbEndDates, keys, couponInterval,
+                                     stubType, nodes))
+        {
+            fl = JpmcdsCdsFeeLegMake(startDate,
+                                     keys[nbEndDates-1].endDate,
+                                     payAccOnDefault,
+                                     couponInterval,
+                                     stubType,
+                                     1.0, /* notional */
+                                     1.0, /* couponRate */
+                                     paymentDcc,
+                                     badDayConv,
+                                     calendar,
+                                     protectStart);
+            if (fl == NULL)
+                goto done;
+
+            if (parSpreadsAlongSchedule (today, stepinDate, startDate, fl,
+                                         nbEndDates, keys, nodes, &curves,
+                                         recoveryRate, parSpread) != SUCCESS)
+                goto done;
+
+            status = SUCCESS;
+            goto done;
+        }
+    }
+
+    for(i = 0; i < nbEndDates; ++i)
+    {
+        fl = JpmcdsCdsFeeLegMakeLive(startDate,
                                      endDates[i],
+                                     payAccOnDefault,
+                                     couponInterval,
+                                     stubType,
                                      1.0, /* notional */
-                                     discCurve,
-                                     spreadCurve,
-                                     recoveryRate,
+                                     1.0, /* couponRate */
+                                     paymentDcc,
+                                     badDayConv,
+                                     calendar,
                                      protectStart,
-                                     &contingentLegPV) != SUCCESS)
+                                     stepinDate);
+        if (fl == NULL)
+            goto done;
+
+        cl = JpmcdsCdsContingentLegMake(MAX(stepinDate, startDate),
+                                        endDates[i],
+                                        1.0, /* notional */
+                                        protectStart);
+        if (cl == NULL)
             goto done;
-        
-        parSpread[i] = contingentLegPV / feeLegPV;
+
+        if (legsApart)
+        {
+            double feeLegPV;
+            double contingentLegPV;
+
+            if (JpmcdsFeeLegPVWithCache(fl,
+                                        today,
+                                        stepinDate,
+                                        stepinDate, /* valueDate */
+                                        &curves,
+                                        TRUE, /* isPriceClean */
+                                        &feeLegPV) != SUCCESS)
+                goto done;
+
+            if (JpmcdsContingentLegPVWithCache(cl,
+                                               today,
+                                               stepinDate, /* valueDate */
+                                               stepinDate,
+                                               &curves,
+                                               recoveryRate,
+                                               &contingentLegPV) != SUCCESS)
+                goto done;
+
+            parSpread[i] = contingentLegPV / feeLegPV;
+        }
+        else
+        {
+            if (JpmcdsFeeAndContingentLegPV(fl,
+                                            cl,
+                                            today,
+                                            stepinDate,
+                                            stepinDate, /* valueDate */
+                                            &curves,
+                                            recoveryRate,
+                                            &legs) != SUCCESS)
+                goto done;
+
+            parSpread[i] = legs.contingentPV / (legs.rpv01 - legs.accruedInterest);
+        }
+
+        JpmcdsFeeLegFree (fl);
+        FREE (cl);
+        fl = NULL;
+        cl = NULL;
     }
 
     status = SUCCESS;
@@ -450,6 +1351,12 @@ EXPORT int JpmcdsCdsParSpreads(
     if (status != SUCCESS)
         JpmcdsErrMsgFailure (routine);
 
+    JpmcdsFeeLegFree (fl);
+    FREE (cl);
+    FREE (keys);
+    FREE (nodes);
+    JpmcdsFreeDateList (dl);
+    JpmcdsCurvePairCacheClear (&curves);
     return status;
 }
 
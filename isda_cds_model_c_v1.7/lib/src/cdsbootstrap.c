@@ -14,11 +14,14 @@
 #include "cxzerocurve.h"
 #include "cxdatelist.h"
 #include "rtbrent.h"
+#include "rtnewton.h"
+#include "curvecache.h"
 #include "convert.h"
 #include "tcurve.h"
 #include "ldate.h"
 #include "macros.h"
 #include "cerror.h"
+#include "cthread.h"
 
 
 typedef struct
@@ -31,9 +34,34 @@ typedef struct
     double          recoveryRate;
     TContingentLeg *cl;
     TFeeLeg        *fl;
+    TCurvePairCache curves;     /* prepared discountCurve and cdsCurve */
 } CDS_BOOTSTRAP_CONTEXT;
 
 
+/* inputs and outputs of JpmcdsCleanSpreadCurves shared by the workers */
+typedef struct
+{
+    TDate           today;
+    TCurve         *discountCurve;
+    TDate           startDate;
+    TDate           stepinDate;
+    TDate           cashSettleDate;
+    long            nbDate;
+    TDate          *endDates;
+    double         *couponRates;
+    TBoolean       *includes;
+    double         *recoveryRates;
+    TBoolean        payAccOnDefault;
+    TDateInterval  *couponInterval;
+    long            paymentDCC;
+    TStubMethod    *stubType;
+    long            badDayConv;
+    char           *calendar;
+    TCurve        **curves;
+    int            *statuses;
+} CDS_MULTI_BOOTSTRAP_CONTEXT;
+
+
 /* static function declarations */
 static int cdsBootstrapPointFunction
 (double   cleanSpread,
@@ -41,6 +69,18 @@ static int cdsBootstrapPointFunction
  double  *pv);
 
 
+static int cdsBootstrapPointFunctionDeriv
+(double   cleanSpread,
+ void    *data,
+ double  *pv,
+ double  *dpv);
+
+
+static void cdsMultiBootstrapCurve
+(void    *data,
+ long     k);
+
+
 static TCurve* CdsBootstrap
 (TDate           today,           /* (I) Used as credit curve base date     */
  TCurve         *discountCurve,   /* (I) Risk-free discount curve           */
@@ -56,7 +96,32 @@ static TCurve* CdsBootstrap
  long            paymentDCC,      /* (I) DCC for fee payments and accrual   */
  TStubMethod    *stubType,        /* (I) Stub type for fee leg              */
  long            badDayConv,
- char           *calendar);
+ char           *calendar,
+ TCurve         *prevCurve,       /* (I) Solved curve - can be NULL         */
+ long            firstIndex,      /* (I) First point to solve               */
+ TBootstrapSolver solver);        /* (I) Root finder                        */
+
+
+static TCurve* CleanSpreadCurve
+(TDate           today,
+ TCurve         *discountCurve,
+ TDate           startDate,
+ TDate           stepinDate,
+ TDate           cashSettleDate,
+ long            nbDate,
+ TDate          *endDates,
+ double         *couponRates,
+ TBoolean       *includes,
+ double          recoveryRate,
+ TBoolean        payAccOnDefault,
+ TDateInterval  *couponInterval,
+ long            paymentDCC,
+ TStubMethod    *stubType,
+ long            badDayConv,
+ char           *calendar,
+ TCurve         *prevCurve,
+ long            firstChanged,
+ TBootstrapSolver solver);
 
 /**
 ***************************************************************************
@@ -94,6 +159,384 @@ EXPORT TCurve* JpmcdsCleanSpreadCurve
 )
 {
     static char routine[] = "JpmcdsCleanSpreadCurve";
+    TCurve *out;
+
+    out = CleanSpreadCurve (today,
+                            discountCurve,
+                            startDate,
+                            stepinDate,
+                            cashSettleDate,
+                            nbDate,
+                            endDates,
+                            couponRates,
+                            includes,
+                            recoveryRate,
+                            payAccOnDefault,
+                            couponInterval,
+                            paymentDCC,
+                            stubType,
+                            badDayConv,
+                            calendar,
+                            NULL,
+                            0,
+                            BOOTSTRAP_BRENT);
+    if (out == NULL)
+        JpmcdsErrMsgFailure (routine);
+
+    return out;
+}
+
+
+/*
+***************************************************************************
+** The main bootstrap routine with a choice of root finder.
+***************************************************************************
+*/
+EXPORT TCurve* JpmcdsCleanSpreadCurveWithSolver
+(TDate              today,           /* (I) Used as credit curve base date       */
+ TCurve            *discountCurve,   /* (I) Risk-free discount curve             */
+ TDate              startDate,       /* (I) Start of CDS for accrual and risk    */
+ TDate              stepinDate,      /* (I) Stepin date                          */
+ TDate              cashSettleDate,  /* (I) Pay date                             */
+ long               nbDate,          /* (I) Number of benchmark dates            */
+ TDate             *endDates,        /* (I) Maturity dates of CDS to bootstrap   */
+ double            *couponRates,     /* (I) CouponRates (e.g. 0.05 = 5% = 500bp) */ 
+ TBoolean          *includes,        /* (I) Include this date. Can be NULL if    
+                                        all are included.                        */
+ double             recoveryRate,    /* (I) Recovery rate                        */
+ TBoolean           payAccOnDefault, /* (I) Pay accrued on default               */
+ TDateInterval     *couponInterval,  /* (I) Interval between fee payments        */
+ long               paymentDCC,      /* (I) DCC for fee payments and accrual     */
+ TStubMethod       *stubType,        /* (I) Stub type for fee leg                */
+ long               badDayConv,
+ char              *calendar,
+ TBootstrapSolver   solver           /* (I) Root finder                          */
+)
+{
+    static char routine[] = "JpmcdsCleanSpreadCurveWithSolver";
+    TCurve *out = NULL;
+
+    REQUIRE (solver == BOOTSTRAP_BRENT || solver == BOOTSTRAP_NEWTON);
+
+    out = CleanSpreadCurve (today,
+                            discountCurve,
+                            startDate,
+                            stepinDate,
+                            cashSettleDate,
+                            nbDate,
+                            endDates,
+                            couponRates,
+                            includes,
+                            recoveryRate,
+                            payAccOnDefault,
+                            couponInterval,
+                            paymentDCC,
+                            stubType,
+                            badDayConv,
+                            calendar,
+                            NULL,
+                            0,
+                            solver);
+
+ done:
+    if (out == NULL)
+        JpmcdsErrMsgFailure (routine);
+
+    return out;
+}
+
+
+/*
+***************************************************************************
+** Re-bootstraps a clean spread curve after the benchmark spreads from
+** index firstChanged onwards have changed.
+***************************************************************************
+*/
+EXPORT TCurve* JpmcdsCleanSpreadCurveUpdate
+(TDate              today,           /* (I) Used as credit curve base date       */
+ TCurve            *discountCurve,   /* (I) Risk-free discount curve             */
+ TDate              startDate,       /* (I) Start of CDS for accrual and risk    */
+ TDate              stepinDate,      /* (I) Stepin date                          */
+ TDate              cashSettleDate,  /* (I) Pay date                             */
+ long               nbDate,          /* (I) Number of benchmark dates            */
+ TDate             *endDates,        /* (I) Maturity dates of CDS to bootstrap   */
+ double            *couponRates,     /* (I) CouponRates (e.g. 0.05 = 5% = 500bp) */ 
+ TBoolean          *includes,        /* (I) Include this date. Can be NULL if    
+                                        all are included.                        */
+ double             recoveryRate,    /* (I) Recovery rate                        */
+ TBoolean           payAccOnDefault, /* (I) Pay accrued on default               */
+ TDateInterval     *couponInterval,  /* (I) Interval between fee payments        */
+ long               paymentDCC,      /* (I) DCC for fee payments and accrual     */
+ TStubMethod       *stubType,        /* (I) Stub type for fee leg                */
+ long               badDayConv,
+ char              *calendar,
+ TCurve            *prevCurve,       /* (I) Curve built from previous quotes     */
+ long               firstChanged     /* (I) Index of first changed benchmark     */
+)
+{
+    static char routine[] = "JpmcdsCleanSpreadCurveUpdate";
+    TCurve *out = NULL;
+
+    REQUIRE (prevCurve != NULL);
+    REQUIRE (firstChanged >= 0 && firstChanged < nbDate);
+
+    out = CleanSpreadCurve (today,
+                            discountCurve,
+                            startDate,
+                            stepinDate,
+                            cashSettleDate,
+                            nbDate,
+                            endDates,
+                            couponRates,
+                            includes,
+                            recoveryRate,
+                            payAccOnDefault,
+                            couponInterval,
+                            paymentDCC,
+                            stubType,
+                            badDayConv,
+                            calendar,
+                            prevCurve,
+                            firstChanged,
+                            BOOTSTRAP_BRENT);
+
+ done:
+    if (out == NULL)
+        JpmcdsErrMsgFailure (routine);
+
+    return out;
+}
+
+
+/*
+***************************************************************************
+** Carries a gradient with respect to a clean spread curve back to the
+** benchmark coupon rates.
+**
+** With F the benchmark PVs, which are zero on the solved curve, and g the
+** gradient with respect to the curve, the gradient with respect to the
+** coupon rates is -lambda' dF/dq where (dF/dh)' lambda = g. The jacobian
+** dF/dh is lower triangular, so lambda is found by back substitution.
+***************************************************************************
+*/
+EXPORT int JpmcdsCleanSpreadCurveAdjoint
+(TDate              today,           /* (I) Used as credit curve base date       */
+ TCurve            *discountCurve,   /* (I) Risk-free discount curve             */
+ TDate              startDate,       /* (I) Start of CDS for accrual and risk    */
+ TDate              stepinDate,      /* (I) Stepin date                          */
+ TDate              cashSettleDate,  /* (I) Pay date                             */
+ long               nbDate,          /* (I) Number of benchmark dates            */
+ TDate             *endDates,        /* (I) Maturity dates of CDS to bootstrap   */
+ double            *couponRates,     /* (I) CouponRates (e.g. 0.05 = 5% = 500bp) */ 
+ TBoolean          *includes,        /* (I) Include this date. Can be NULL if    
+                                        all are included.                        */
+ double             recoveryRate,    /* (I) Recovery rate                        */
+ TBoolean           payAccOnDefault, /* (I) Pay accrued on default               */
+ TDateInterval     *couponInterval,  /* (I) Interval between fee payments        */
+ long               paymentDCC,      /* (I) DCC for fee payments and accrual     */
+ TStubMethod       *stubType,        /* (I) Stub type for fee leg                */
+ long               badDayConv,
+ char              *calendar,
+ TCurve            *spreadCurve,     /* (I) Curve built from the benchmarks      */
+ double            *spreadGrad,      /* (I) Gradient w.r.t. spreadCurve rates    */
+ double            *discGrad,        /* (I/O) Gradient w.r.t. discountCurve rates */
+ double            *couponGrad       /* (O) Gradient w.r.t. couponRates          */
+)
+{
+    static char routine[] = "JpmcdsCleanSpreadCurveAdjoint";
+    int         status    = FAILURE;
+
+    TContingentLeg  *cl = NULL;
+    TFeeLeg         *fl = NULL;
+    TCurvePairCache  curves;
+    long            *points     = NULL; /* benchmark of each point */
+    double          *jacobian   = NULL; /* [k*nbPoint+l] dF_k/dh_l */
+    double          *discJac    = NULL; /* [k*nbDisc+i] dF_k/dr_i */
+    double          *couponDeriv = NULL; /* dF_k/dq */
+    double          *lambda     = NULL;
+    long             nbPoint;
+    long             nbDisc;
+    long             i;
+    long             j;
+    long             k;
+    long             l;
+    TBoolean         protectStart = TRUE;
+    TDateInterval    ivl3M;
+
+    SET_TDATE_INTERVAL(ivl3M,3,'M');
+    if (couponInterval == NULL)
+        couponInterval = &ivl3M;
+
+    REQUIRE (discountCurve != NULL);
+    REQUIRE (spreadCurve != NULL);
+    REQUIRE (nbDate > 0);
+    REQUIRE (endDates != NULL);
+    REQUIRE (couponRates != NULL);
+    REQUIRE (spreadGrad != NULL);
+    REQUIRE (couponGrad != NULL);
+
+    nbPoint = spreadCurve->fNumItems;
+    nbDisc  = discountCurve->fNumItems;
+
+    points      = NEW_ARRAY(long, nbPoint);
+    jacobian    = NEW_ARRAY(double, nbPoint * nbPoint);
+    discJac     = NEW_ARRAY(double, nbPoint * nbDisc);
+    couponDeriv = NEW_ARRAY(double, nbPoint);
+    lambda      = NEW_ARRAY(double, nbPoint);
+    if (points == NULL || jacobian == NULL || discJac == NULL ||
+        couponDeriv == NULL || lambda == NULL)
+        goto done;
+
+    /* the points of the curve are the included benchmarks */
+    k = 0;
+    for (j = 0; j < nbDate; ++j)
+    {
+        couponGrad[j] = 0.0;
+        if (includes != NULL && !includes[j])
+            continue;
+        REQUIRE (k < nbPoint);
+        REQUIRE (spreadCurve->fArray[k].fDate == endDates[j]);
+        points[k++] = j;
+    }
+    REQUIRE (k == nbPoint);
+
+    JpmcdsCurvePairCacheInit (&curves, today, discountCurve, spreadCurve);
+
+    for (k = 0; k < nbPoint; ++k)
+    {
+        TCdsLegsAdjoint adjoint;
+        TCdsLegsPV      legs;
+
+        j = points[k];
+
+        /* as in CdsBootstrap */
+        cl = JpmcdsCdsContingentLegMake (MAX(today, startDate),
+                                         endDates[j],
+                                         1.0,
+                                         protectStart);
+        if (cl == NULL)
+            goto done;
+
+        fl = JpmcdsCdsFeeLegMake(startDate,
+                                 endDates[j],
+                                 payAccOnDefault,
+                                 couponInterval,
+                                 stubType,
+                                 1.0,
+                                 couponRates[j],
+                                 paymentDCC,
+                                 badDayConv,
+                                 calendar,
+                                 protectStart);
+        if (fl == NULL)
+            goto done;
+
+        for (l = 0; l < nbPoint; ++l)
+            jacobian[k*nbPoint + l] = 0.0;
+        for (i = 0; i < nbDisc; ++i)
+            discJac[k*nbDisc + i] = 0.0;
+
+        adjoint.contingentWeight = 1.0;
+        adjoint.feeWeight        = -couponRates[j];
+        adjoint.discGrad         = discJac + k*nbDisc;
+        adjoint.spreadGrad       = jacobian + k*nbPoint;
+
+        if (JpmcdsFeeAndContingentLegPVAdjoint (fl,
+                                                cl,
+                                                today,
+                                                stepinDate,
+                                                cashSettleDate,
+                                                &curves,
+                                                recoveryRate,
+                                                &adjoint,
+                                                &legs) != SUCCESS)
+            goto done;
+
+        /* the PV is that of the clean price */
+        couponDeriv[k] = -(legs.rpv01 - legs.accruedInterest);
+
+        FREE(cl);
+        JpmcdsFeeLegFree (fl);
+        cl = NULL;
+        fl = NULL;
+    }
+
+    for (k = nbPoint - 1; k >= 0; --k)
+    {
+        double sum = spreadGrad[k];
+
+        for (l = k + 1; l < nbPoint; ++l)
+            sum -= jacobian[l*nbPoint + k] * lambda[l];
+
+        if (jacobian[k*nbPoint + k] == 0.0)
+        {
+            JpmcdsErrMsg ("%s: Benchmark PV does not depend on maturity %s\n",
+                          routine, JpmcdsFormatDate(spreadCurve->fArray[k].fDate));
+            goto done;
+        }
+        lambda[k] = sum / jacobian[k*nbPoint + k];
+    }
+
+    for (k = 0; k < nbPoint; ++k)
+    {
+        couponGrad[points[k]] = -lambda[k] * couponDeriv[k];
+
+        if (discGrad != NULL)
+        {
+            for (i = 0; i < nbDisc; ++i)
+                discGrad[i] -= lambda[k] * discJac[k*nbDisc + i];
+        }
+    }
+
+    status = SUCCESS;
+
+ done:
+
+    if (status != SUCCESS)
+        JpmcdsErrMsgFailure (routine);
+
+    FREE(cl);
+    JpmcdsFeeLegFree (fl);
+    FREE(points);
+    FREE(jacobian);
+    FREE(discJac);
+    FREE(couponDeriv);
+    FREE(lambda);
+
+    return status;
+}
+
+
+/*
+***************************************************************************
+** Selects the included benchmarks and bootstraps them. If prevCurve is
+** given then benchmarks before firstChanged are taken from it.
+***************************************************************************
+*/
+static TCurve* CleanSpreadCurve
+(TDate              today,           /* (I) Used as credit curve base date       */
+ TCurve            *discountCurve,   /* (I) Risk-free discount curve             */
+ TDate              startDate,       /* (I) Start of CDS for accrual and risk    */
+ TDate              stepinDate,      /* (I) Stepin date                          */
+ TDate              cashSettleDate,  /* (I) Pay date                             */
+ long               nbDate,          /* (I) Number of benchmark dates            */
+ TDate             *endDates,        /* (I) Maturity dates of CDS to bootstrap   */
+ double            *couponRates,     /* (I) CouponRates (e.g. 0.05 = 5% = 500bp) */ 
+ TBoolean          *includes,        /* (I) Include this date. Can be NULL if    
+                                        all are included.                        */
+ double             recoveryRate,    /* (I) Recovery rate                        */
+ TBoolean           payAccOnDefault, /* (I) Pay accrued on default               */
+ TDateInterval     *couponInterval,  /* (I) Interval between fee payments        */
+ long               paymentDCC,      /* (I) DCC for fee payments and accrual     */
+ TStubMethod       *stubType,        /* (I) Stub type for fee leg                */
+ long               badDayConv,
+ char              *calendar,
+ TCurve            *prevCurve,       /* (I) Solved curve - can be NULL           */
+ long               firstChanged,    /* (I) Index of first changed benchmark     */
+ TBootstrapSolver   solver           /* (I) Root finder                          */
+)
+{
+    static char routine[] = "CleanSpreadCurve";
     TCurve *out = NULL;
 
     TDate           *includeEndDates = NULL;
@@ -119,6 +562,7 @@ EXPORT TCurve* JpmcdsCleanSpreadCurve
         long j;
         for (i = 0; i < nbDate; ++i) 
         {
+            if (i == firstChanged) firstChanged = nbInclude;
             if (includes[i]) ++nbInclude;
         }
         REQUIRE (nbInclude > 0);
@@ -157,18 +601,153 @@ EXPORT TCurve* JpmcdsCleanSpreadCurve
                         paymentDCC,
                         stubType,
                         badDayConv,
-                        calendar);
+                        calendar,
+                        prevCurve,
+                        firstChanged,
+                        solver);
 
  done:
     FREE(includeEndDates);
     FREE(includeCouponRates);
-    if (out == NULL)
-        JpmcdsErrMsgFailure (routine);
 
     return out;
 }
 
 
+/*
+***************************************************************************
+** Bootstraps clean spread curves for many issuers at once on a pool of
+** worker threads.
+***************************************************************************
+*/
+EXPORT int JpmcdsCleanSpreadCurves
+(TDate              today,           /* (I) Used as credit curve base date       */
+ TCurve            *discountCurve,   /* (I) Risk-free discount curve             */
+ TDate              startDate,       /* (I) Start of CDS for accrual and risk    */
+ TDate              stepinDate,      /* (I) Stepin date                          */
+ TDate              cashSettleDate,  /* (I) Pay date                             */
+ long               nbCurve,         /* (I) Number of curves to bootstrap        */
+ long               nbDate,          /* (I) Number of benchmark dates            */
+ TDate             *endDates,        /* (I) Maturity dates of CDS to bootstrap   */
+ double            *couponRates,     /* (I) [nbCurve*nbDate] row per curve       */
+ TBoolean          *includes,        /* (I) [nbCurve*nbDate] row per curve. Can
+                                        be NULL if all are included.             */
+ double            *recoveryRates,   /* (I) [nbCurve] Recovery rates             */
+ TBoolean           payAccOnDefault, /* (I) Pay accrued on default               */
+ TDateInterval     *couponInterval,  /* (I) Interval between fee payments        */
+ long               paymentDCC,      /* (I) DCC for fee payments and accrual     */
+ TStubMethod       *stubType,        /* (I) Stub type for fee leg                */
+ long               badDayConv,
+ char              *calendar,
+ int                nbThreads,       /* (I) Number of threads. <= 0 => all       */
+ TCurve           **curves,          /* (O) [nbCurve] NULL on failure            */
+ int               *statuses         /* (O) [nbCurve] SUCCESS or FAILURE         */
+)
+{
+    static char routine[] = "JpmcdsCleanSpreadCurves";
+    int         status    = FAILURE;
+
+    CDS_MULTI_BOOTSTRAP_CONTEXT context;
+    long k;
+
+    REQUIRE (nbCurve >= 0);
+    REQUIRE (curves != NULL);
+    REQUIRE (statuses != NULL);
+
+    /* outputs are defined for every curve even when inputs are bad */
+    for (k = 0; k < nbCurve; ++k)
+    {
+        curves[k]   = NULL;
+        statuses[k] = FAILURE;
+    }
+
+    REQUIRE (discountCurve != NULL);
+    REQUIRE (nbDate > 0);
+    REQUIRE (endDates != NULL);
+    REQUIRE (couponRates != NULL);
+    REQUIRE (recoveryRates != NULL);
+
+    context.today           = today;
+    context.discountCurve   = discountCurve;
+    context.startDate       = startDate;
+    context.stepinDate      = stepinDate;
+    context.cashSettleDate  = cashSettleDate;
+    context.nbDate          = nbDate;
+    context.endDates        = endDates;
+    context.couponRates     = couponRates;
+    context.includes        = includes;
+    context.recoveryRates   = recoveryRates;
+    context.payAccOnDefault = payAccOnDefault;
+    context.couponInterval  = couponInterval;
+    context.paymentDCC      = paymentDCC;
+    context.stubType        = stubType;
+    context.badDayConv      = badDayConv;
+    context.calendar        = calendar;
+    context.curves          = curves;
+    context.statuses        = statuses;
+
+    if (JpmcdsParallelFor (nbCurve,
+                           nbThreads,
+                           cdsMultiBootstrapCurve,
+                           (void*) &context) != SUCCESS)
+        goto done;
+
+    status = SUCCESS;
+
+ done:
+
+    if (status != SUCCESS)
+        JpmcdsErrMsgFailure (routine);
+
+    return status;
+}
+
+
+/*
+***************************************************************************
+** Bootstraps curve k of JpmcdsCleanSpreadCurves. Runs on a worker thread.
+***************************************************************************
+*/
+static void cdsMultiBootstrapCurve
+(void    *data,
+ long     k)
+{
+    static char routine[] = "JpmcdsCleanSpreadCurves";
+
+    CDS_MULTI_BOOTSTRAP_CONTEXT *context = (CDS_MULTI_BOOTSTRAP_CONTEXT*)data;
+
+    long offset = k * context->nbDate;
+
+    context->curves[k] = JpmcdsCleanSpreadCurve (
+        context->today,
+        context->discountCurve,
+        context->startDate,
+        context->stepinDate,
+        context->cashSettleDate,
+        context->nbDate,
+        context->endDates,
+        context->couponRates + offset,
+        context->includes == NULL ? NULL : context->includes + offset,
+        context->recoveryRates[k],
+        context->payAccOnDefault,
+        context->couponInterval,
+        context->paymentDCC,
+        context->stubType,
+        context->badDayConv,
+        context->calendar);
+
+    if (context->curves[k] != NULL)
+    {
+        context->statuses[k] = SUCCESS;
+    }
+    else
+    {
+        context->statuses[k] = FAILURE;
+        JpmcdsErrMsg ("%s: Failed to bootstrap curve %ld.\n", routine, k);
+    }
+}
+
+
 /*
 ***************************************************************************
 ** This is the CDS bootstrap routine.
@@ -178,6 +757,10 @@ EXPORT TCurve* JpmcdsCleanSpreadCurve
 ** for each benchmark instrument while it changes the CDS zero rate at the
 ** maturity date of the benchmark instrument.
 **
+** Each point depends only on the points before it. So if prevCurve is
+** given, the points before firstIndex are copied from it unchanged and
+** only the remaining points are solved.
+**
 ***************************************************************************
 */
 static TCurve* CdsBootstrap
@@ -195,7 +778,10 @@ static TCurve* CdsBootstrap
  long              paymentDCC,      /* (I) DCC for fee payments and accrual   */
  TStubMethod      *stubType,        /* (I) Stub type for fee leg              */
  long              badDayConv,
- char             *calendar)
+ char             *calendar,
+ TCurve           *prevCurve,       /* (I) Solved curve - can be NULL         */
+ long              firstIndex,      /* (I) First point to solve               */
+ TBootstrapSolver  solver)          /* (I) Root finder                        */
 {
     static char routine[] = "CdsBootstrap";
     int         status    = FAILURE;
@@ -206,30 +792,76 @@ static TCurve* CdsBootstrap
     CDS_BOOTSTRAP_CONTEXT context;
     TContingentLeg *cl = NULL;
     TFeeLeg        *fl = NULL;
+    TArena         *arena = NULL;
     double          settleDiscount = 0.0;
     TBoolean        protectStart = TRUE;
 
-    /* we work with a continuously compounded curve since that is faster -
-       but we will convert to annual compounded since that is traditional */
-    cdsCurve = JpmcdsMakeTCurve (today,
-                                 endDates,
-                                 couponRates,
-                                 nbDate,
-                                 JPMCDS_CONTINUOUS_BASIS,
-                                 JPMCDS_ACT_365F);
-    if (cdsCurve == NULL)
+    JpmcdsCurvePairCacheInit (&context.curves, today, discountCurve, NULL);
+
+    /* scratch memory of the objective functions, reset after each point */
+    arena = JpmcdsArenaMake (0);
+    if (arena == NULL)
         goto done;
+    JpmcdsCurvePairCacheSetArena (&context.curves, arena);
+
+    if (prevCurve == NULL)
+    {
+        firstIndex = 0;
+
+        /* we work with a continuously compounded curve since that is faster -
+           but we will convert to annual compounded since that is traditional */
+        cdsCurve = JpmcdsMakeTCurve (today,
+                                     endDates,
+                                     couponRates,
+                                     nbDate,
+                                     JPMCDS_CONTINUOUS_BASIS,
+                                     JPMCDS_ACT_365F);
+        if (cdsCurve == NULL)
+            goto done;
+    }
+    else
+    {
+        /* the solved points must be for the same benchmarks */
+        REQUIRE (prevCurve->fBaseDate == today);
+        REQUIRE (prevCurve->fNumItems == nbDate);
+        REQUIRE (prevCurve->fDayCountConv == JPMCDS_ACT_365F);
+        REQUIRE (IS_EQUAL(prevCurve->fBasis, JPMCDS_ANNUAL_BASIS));
+        REQUIRE (firstIndex >= 0 && firstIndex <= nbDate);
+        for (i = 0; i < nbDate; ++i)
+        {
+            REQUIRE (prevCurve->fArray[i].fDate == endDates[i]);
+        }
+
+        cdsCurve = JpmcdsCopyCurve (prevCurve);
+        if (cdsCurve == NULL)
+            goto done;
+
+        if (CreditCurveConvertRateType (cdsCurve, JPMCDS_CONTINUOUS_BASIS) != SUCCESS)
+            goto done;
+
+        /* points which are to be solved start from the benchmark spread */
+        for (i = firstIndex; i < nbDate; ++i)
+            cdsCurve->fArray[i].fRate = couponRates[i];
+    }
 
     context.discountCurve = discountCurve;
     context.cdsCurve      = cdsCurve;
     context.recoveryRate  = recoveryRate;
     context.stepinDate    = stepinDate;
     context.cashSettleDate = cashSettleDate;
+
+    /* the rate of the point being solved is kept up to date in the
+       prepared cdsCurve by the objective functions */
+    context.curves.spreadCurve = cdsCurve;
+    if (JpmcdsCurvePairCachePrepare (&context.curves) != SUCCESS)
+        goto done;
     
-    for (i = 0; i < nbDate; ++i)
+    for (i = firstIndex; i < nbDate; ++i)
     {
-        double guess;
-        double spread;
+        double   guess;
+        double   spread;
+        TBoolean foundIt;
+        int      rootStatus;
 
         guess = couponRates[i] / (1.0 - recoveryRate);
 
@@ -258,17 +890,41 @@ static TCurve* CdsBootstrap
         context.cl = cl;
         context.fl = fl;
 
-        if (JpmcdsRootFindBrent ((TObjectFunc)cdsBootstrapPointFunction,
-                                 (void*) &context,
-                                 0.0,    /* boundLo */
-                                 1e10,   /* boundHi */
-                                 100,    /* numIterations */
-                                 guess,
-                                 0.0005, /* initialXstep */
-                                 0,      /* initialFDeriv */
-                                 1e-10,  /* xacc */
-                                 1e-10,  /* facc */
-                                 &spread) != SUCCESS)
+        foundIt    = FALSE;
+        rootStatus = SUCCESS;
+
+        if (solver == BOOTSTRAP_NEWTON)
+        {
+            rootStatus = JpmcdsRootFindNewton (
+                (TObjectDerivFunc)cdsBootstrapPointFunctionDeriv,
+                (void*) &context,
+                0.0,    /* boundLo */
+                1e10,   /* boundHi */
+                20,     /* numIterations */
+                guess,
+                1e-10,  /* xacc */
+                1e-10,  /* facc */
+                &foundIt,
+                &spread);
+        }
+
+        /* Brent is always used when Newton gives up */
+        if (rootStatus == SUCCESS && !foundIt)
+        {
+            rootStatus = JpmcdsRootFindBrent ((TObjectFunc)cdsBootstrapPointFunction,
+                                              (void*) &context,
+                                              0.0,    /* boundLo */
+                                              1e10,   /* boundHi */
+                                              100,    /* numIterations */
+                                              guess,
+                                              0.0005, /* initialXstep */
+                                              0,      /* initialFDeriv */
+                                              1e-10,  /* xacc */
+                                              1e-10,  /* facc */
+                                              &spread);
+        }
+
+        if (rootStatus != SUCCESS)
         {
             JpmcdsErrMsg ("%s: Could not add CDS maturity %s spread %.2fbp\n",
                           routine,
@@ -276,12 +932,17 @@ static TCurve* CdsBootstrap
                           1e4 * couponRates[i]);
             goto done;
         }
-        cdsCurve->fArray[i].fRate = spread;
+        if (JpmcdsPreparedCurveSetRate (context.curves.spreadPrepared,
+                                        cdsCurve,
+                                        i,
+                                        spread) != SUCCESS)
+            goto done;
 
         FREE(cl);
         JpmcdsFeeLegFree (fl);
         cl = NULL;
         fl = NULL;
+        JpmcdsArenaReset (arena);
 
         /** check if forward hazard rate is negative */
         if(i > 0)
@@ -305,6 +966,10 @@ static TCurve* CdsBootstrap
     if (CreditCurveConvertRateType (cdsCurve, JPMCDS_ANNUAL_BASIS) != SUCCESS)
         goto done;
 
+    /* avoid round trip differences in the basis conversion */
+    for (i = 0; i < firstIndex; ++i)
+        cdsCurve->fArray[i].fRate = prevCurve->fArray[i].fRate;
+
     status = SUCCESS;
 
  done:
@@ -318,6 +983,8 @@ static TCurve* CdsBootstrap
 
     FREE(cl);
     JpmcdsFeeLegFree (fl);
+    JpmcdsCurvePairCacheClear (&context.curves);
+    JpmcdsArenaFree (arena);
         
     return cdsCurve;
 }
@@ -340,7 +1007,6 @@ static int cdsBootstrapPointFunction
     CDS_BOOTSTRAP_CONTEXT *context = (CDS_BOOTSTRAP_CONTEXT*)data;
 
     int             i             = context->i;
-    TCurve         *discountCurve = context->discountCurve;
     TCurve         *cdsCurve      = context->cdsCurve;
     double          recoveryRate  = context->recoveryRate;
     TContingentLeg *cl            = context->cl;
@@ -353,26 +1019,28 @@ static int cdsBootstrapPointFunction
     double          pvC; /* PV of contingent leg */
     double          pvF; /* PV of fee leg */
 
-    cdsCurve->fArray[i].fRate = cleanSpread;
+    if (JpmcdsPreparedCurveSetRate (context->curves.spreadPrepared,
+                                    cdsCurve,
+                                    i,
+                                    cleanSpread) != SUCCESS)
+        goto done;
 
-    if (JpmcdsContingentLegPV (cl,
-                               cdsBaseDate,
-                               cashSettleDate,
-                               stepinDate,
-                               discountCurve,
-                               cdsCurve,
-                               recoveryRate,
-                               &pvC) != SUCCESS)
+    if (JpmcdsContingentLegPVWithCache (cl,
+                                        cdsBaseDate,
+                                        cashSettleDate,
+                                        stepinDate,
+                                        &context->curves,
+                                        recoveryRate,
+                                        &pvC) != SUCCESS)
         goto done;
                               
-    if (JpmcdsFeeLegPV(fl,
-                       cdsBaseDate,
-                       stepinDate,
-                       cashSettleDate,
-                       discountCurve,
-                       cdsCurve,
-                       isPriceClean,
-                       &pvF) != SUCCESS)
+    if (JpmcdsFeeLegPVWithCache (fl,
+                                 cdsBaseDate,
+                                 stepinDate,
+                                 cashSettleDate,
+                                 &context->curves,
+                                 isPriceClean,
+                                 &pvF) != SUCCESS)
         goto done;
 
     /* Note: price is discounted to cdsBaseDate */
@@ -388,6 +1056,75 @@ static int cdsBootstrapPointFunction
 }
 
 
+/*
+***************************************************************************
+** Objective function for root-solver with its derivative with respect to
+** the clean spread (the continuously compounded rate of point i).
+** Returns the same PV as cdsBootstrapPointFunction.
+***************************************************************************
+*/
+static int cdsBootstrapPointFunctionDeriv
+(double   cleanSpread,
+ void    *data,
+ double  *pv,
+ double  *dpv)
+{
+    static char routine[] = "cdsBootstrapPointFunctionDeriv";
+    int         status    = FAILURE;
+
+    CDS_BOOTSTRAP_CONTEXT *context = (CDS_BOOTSTRAP_CONTEXT*)data;
+
+    TCurve         *cdsCurve      = context->cdsCurve;
+    TDate           cdsBaseDate   = cdsCurve->fBaseDate;
+    TBoolean        isPriceClean  = 1;
+
+    TCurvePairCache *curves       = &context->curves;
+    double          pvC; /* PV of contingent leg */
+    double          pvF; /* PV of fee leg */
+    double          dpvC;
+    double          dpvF;
+
+    if (JpmcdsPreparedCurveSetRate (curves->spreadPrepared,
+                                    cdsCurve,
+                                    context->i,
+                                    cleanSpread) != SUCCESS)
+        goto done;
+
+    curves->spreadNode = context->i;
+
+    if (JpmcdsContingentLegPVWithDeriv (context->cl,
+                                        cdsBaseDate,
+                                        context->cashSettleDate,
+                                        context->stepinDate,
+                                        curves,
+                                        context->recoveryRate,
+                                        &pvC,
+                                        &dpvC) != SUCCESS)
+        goto done;
+
+    if (JpmcdsFeeLegPVWithDeriv (context->fl,
+                                 cdsBaseDate,
+                                 context->stepinDate,
+                                 context->cashSettleDate,
+                                 curves,
+                                 isPriceClean,
+                                 &pvF,
+                                 &dpvF) != SUCCESS)
+        goto done;
+
+    *pv  = pvC - pvF;
+    *dpv = dpvC - dpvF;
+    status = SUCCESS;
+
+ done:
+
+    if (status != SUCCESS)
+        JpmcdsErrMsgFailure (routine);
+
+    return status;
+}
+
+
 /*
 ***************************************************************************
 ** Routine for converting the compounding basis of a credit curve.
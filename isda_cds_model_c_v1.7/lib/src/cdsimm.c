@@ -0,0 +1,281 @@
+/*
+ * ISDA CDS Standard Model
+ *
+ * Copyright (C) 2009 International Swaps and Derivatives Association, Inc.
+ * Developed and supported in collaboration with Markit
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the ISDA CDS Standard Model Public License.
+ */
+
+#include "cdsimm.h"
+#include <ctype.h>
+#include "busday.h"
+#include "cmemory.h"
+#include "convert.h"
+#include "cthread.h"
+#include "dateconv.h"
+#include "macros.h"
+#include "cerror.h"
+
+
+/* four IMM dates a year */
+#define IMM_TABLE_SIZE (4 * (JPMCDS_IMM_LAST_YEAR - JPMCDS_IMM_FIRST_YEAR + 1))
+
+
+/* The IMM dates in increasing order, filled on first use. */
+static TDate   immTable[IMM_TABLE_SIZE];
+
+/* Points to immTable once it is filled, and is read without the lock. */
+static TDate  *immTableReady = NULL;
+
+static TMutex  immMutex = JPMCDS_MUTEX_INIT;
+
+
+static TDate* immTableGet(void);
+
+static long immIndexAfter
+(TDate *table,
+ TDate  date);
+
+
+/*
+***************************************************************************
+** Returns TRUE if a date is a CDS IMM date.
+***************************************************************************
+*/
+TBoolean JpmcdsIsImmDate
+(TDate          date)           /* (I) Date to test */
+{
+    TDate *table = immTableGet();
+    long   idx   = immIndexAfter (table, date);
+
+    return idx > 0 && table[idx-1] == date;
+}
+
+
+/*
+***************************************************************************
+** Returns the first CDS IMM date strictly after a date.
+***************************************************************************
+*/
+int JpmcdsImmDateNext
+(TDate          date,           /* (I) Date */
+ TDate         *immDate)        /* (O) Next IMM date */
+{
+    static char routine[] = "JpmcdsImmDateNext";
+
+    TDate *table = immTableGet();
+    long   idx   = immIndexAfter (table, date);
+
+    /* the table starts with the first IMM date after 20 December of the
+       year before, and has no date after the last one */
+    if (idx == IMM_TABLE_SIZE ||
+        (idx == 0 && date < JpmcdsDate (JPMCDS_IMM_FIRST_YEAR - 1, 12, 20)))
+    {
+        JpmcdsErrMsg ("%s: %s is outside the table of IMM dates.\n",
+                      routine, JpmcdsFormatDate(date));
+        return FAILURE;
+    }
+
+    *immDate = table[idx];
+    return SUCCESS;
+}
+
+
+/*
+***************************************************************************
+** Returns TRUE if JpmcdsCdsImmScheduleMake can make a fee leg schedule.
+***************************************************************************
+*/
+TBoolean JpmcdsCdsImmScheduleValid
+(TDate          startDate,      /* (I) Start of the first period       */
+ TDate          endDate,        /* (I) End of protection               */
+ TDateInterval *dateInterval,   /* (I) Interval between payments       */
+ TStubMethod   *stubType)       /* (I) Location and length of the stub */
+{
+    TDate *table;
+    char   prdType;
+
+    if (dateInterval == NULL || stubType == NULL || stubType->stubAtEnd)
+        return FALSE;
+
+    prdType = (char)toupper((int)dateInterval->prd_typ);
+    if (!(prdType == 'M' && dateInterval->prd == JPMCDS_MONTHS_PER_QUARTER) &&
+        !(prdType == 'Q' && dateInterval->prd == 1))
+        return FALSE;
+
+    table = immTableGet();
+    return endDate > startDate && startDate >= table[0] &&
+           JpmcdsIsImmDate (endDate);
+}
+
+
+/*
+***************************************************************************
+** Makes the fee leg schedule of a standard quarterly IMM CDS.
+**
+** Rolling back quarterly from an IMM date on the 20th only ever lands on
+** IMM dates, so the dates of JpmcdsDateListMakeRegular are the IMM dates
+** after the start date, and the table gives them without date arithmetic.
+***************************************************************************
+*/
+int JpmcdsCdsImmScheduleMake
+(TDate            startDate,    /* (I) Start of the first period       */
+ TDate            endDate,      /* (I) End of protection               */
+ TDateInterval   *dateInterval, /* (I) Interval between payments       */
+ TStubMethod     *stubType,     /* (I) Location and length of the stub */
+ long             badDayConv,   /* (I) Adjustment of payment dates     */
+ THolidayList    *hl,           /* (I) Holidays for the adjustment     */
+ TBoolean         protectStart, /* (I) Protection from start of day    */
+ TFeeLegSchedule *schedule)     /* (O) Schedule made                   */
+{
+    static char routine[] = "JpmcdsCdsImmScheduleMake";
+    int         status    = FAILURE;
+
+    TDate      *table;
+    TDate      *dates = NULL;
+    TDate       prevDateAdj;
+    long        first;
+    long        last;
+    long        n;
+    long        i;
+
+    if (schedule == NULL)
+    {
+        JpmcdsErrMsg ("%s: NULL inputs.\n", routine);
+        goto done;
+    }
+
+    if (!JpmcdsCdsImmScheduleValid (startDate, endDate, dateInterval, stubType))
+    {
+        JpmcdsErrMsg ("%s: Not a quarterly IMM schedule with a front stub.\n",
+                      routine);
+        goto done;
+    }
+
+    if (hl == NULL && badDayConv != JPMCDS_BAD_DAY_NONE)
+    {
+        JpmcdsErrMsg ("%s: Holidays must be given to adjust dates.\n", routine);
+        goto done;
+    }
+
+    /* the payments fall on table[first] to table[last] = endDate */
+    table = immTableGet();
+    first = immIndexAfter (table, startDate);
+    last  = immIndexAfter (table, endDate) - 1;
+
+    /* a long stub takes in the first regular period, unless the start
+       date is itself a roll date or there is only one period */
+    if (stubType->longStub && table[first-1] != startDate && first < last)
+        ++first;
+
+    n = last - first + 1;
+
+    /* the three arrays share one allocation */
+    dates = NEW_ARRAY(TDate, 3 * n);
+    if (dates == NULL)
+        goto done;
+
+    prevDateAdj = startDate; /* first date is not bad day adjusted */
+
+    for (i = 0; i < n; ++i)
+    {
+        TDate nextDate = table[first + i];
+        TDate nextDateAdj;
+
+        if (badDayConv == JPMCDS_BAD_DAY_NONE)
+            nextDateAdj = nextDate;
+        else if (JpmcdsHolidayListBusinessDay (nextDate, badDayConv, hl,
+                                               &nextDateAdj) != SUCCESS)
+            goto done;
+
+        dates[i]         = prevDateAdj;
+        dates[n + i]     = nextDateAdj;
+        dates[2 * n + i] = nextDateAdj;
+
+        prevDateAdj = nextDateAdj;
+    }
+
+    /* the last accrual date is not adjusted */
+    /* also we may have one extra day of accrued interest */
+    dates[2 * n - 1] = protectStart ? endDate + 1 : endDate;
+
+    schedule->nbDates       = (int)n;
+    schedule->accStartDates = dates;
+    schedule->accEndDates   = dates + n;
+    schedule->payDates      = dates + 2 * n;
+    dates = NULL; /* Now owned by schedule */
+
+    status = SUCCESS;
+
+ done:
+
+    FREE(dates);
+
+    if (status != SUCCESS)
+        JpmcdsErrMsgFailure (routine);
+
+    return status;
+}
+
+
+/*
+***************************************************************************
+** Returns the table of IMM dates, filling it on first use.
+***************************************************************************
+*/
+static TDate* immTableGet(void)
+{
+    TDate *table;
+    long   i;
+
+    table = (TDate*)JPMCDS_ATOMIC_LOAD_PTR (&immTableReady);
+    if (table != NULL)
+        return table;
+
+    JpmcdsMutexLock (&immMutex);
+    table = immTableReady;
+    if (table == NULL)
+    {
+        for (i = 0; i < IMM_TABLE_SIZE; ++i)
+        {
+            immTable[i] = JpmcdsDate (JPMCDS_IMM_FIRST_YEAR + i / 4,
+                                      JPMCDS_MONTHS_PER_QUARTER * (i % 4 + 1),
+                                      20);
+        }
+        table = immTable;
+        JPMCDS_ATOMIC_STORE_PTR (&immTableReady, table);
+    }
+    JpmcdsMutexUnlock (&immMutex);
+
+    return table;
+}
+
+
+/*
+***************************************************************************
+** Returns the index of the first IMM date strictly after a date, which is
+** IMM_TABLE_SIZE if there is none in the table.
+***************************************************************************
+*/
+static long immIndexAfter
+(TDate *table,
+ TDate  date)
+{
+    long idx;
+
+    /* a quarter is 1461/16 days on average, so this is close */
+    if (date < table[0])
+        return 0;
+    idx = (long)((date - table[0]) * 16 / 1461);
+    if (idx > IMM_TABLE_SIZE)
+        idx = IMM_TABLE_SIZE;
+
+    while (idx > 0 && table[idx-1] > date)
+        --idx;
+    while (idx < IMM_TABLE_SIZE && table[idx] <= date)
+        ++idx;
+
+    return idx;
+}
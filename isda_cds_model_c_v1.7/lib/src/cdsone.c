@@ -12,7 +12,22 @@
 #include "cds.h"
 #include "cerror.h"
 #include "rtbrent.h"
+#include "rtnewton.h"
 #include "tcurve.h"
+#include "feeleg.h"
+#include "curvecache.h"
+#include "macros.h"
+#include "ldate.h"
+#include "convert.h"
+#include <stdlib.h>
+
+
+/*
+** Number of days beyond the last end date of a batch of quotes for which
+** discount factors are remembered. Allows for the adjustment of the last
+** payment date.
+*/
+#define CDSONE_CACHE_EXTRA_DAYS 14
 
 
 typedef struct
@@ -38,6 +53,45 @@ typedef struct
 } CDSONE_SPREAD_CONTEXT;
 
 
+/* inputs of a batch of quotes shared by all of them */
+typedef struct
+{
+    TDate           today;
+    TDate           valueDate;
+    TDate           benchmarkStartDate;
+    TDate           stepinDate;
+    TDate           startDate;
+    TBoolean        payAccruedOnDefault;
+    TDateInterval  *dateInterval;
+    TStubMethod    *stubType;
+    long            accrueDCC;
+    long            badDayConv;
+    char           *calendar;
+    TBoolean        payAccruedAtStart;
+    TBoolean        toUpfront;      /* quotes are spreads, else upfronts */
+    TCurvePairCache *curves;        /* shared discount factors */
+} CDSONE_BATCH_CONTEXT;
+
+
+/* price of a CDS as a function of a flat hazard rate */
+typedef struct
+{
+    TCdsLegsFlat   *flat;
+    double          couponRate;
+    double          recoveryRate;
+    TBoolean        isPriceClean;
+    double          price;          /* target price */
+} CDSONE_FLAT_CONTEXT;
+
+
+/* sort key for grouping the quotes of a batch by end date */
+typedef struct
+{
+    TDate           endDate;
+    long            idx;
+} CDSONE_QUOTE_KEY;
+
+
 /* static function declarations */
 static int cdsoneSpreadSolverFunction
 (double               bbgSpread,
@@ -45,6 +99,53 @@ static int cdsoneSpreadSolverFunction
  double              *diff);
 
 
+static int cdsoneQuoteKeyCompare(const void *a, const void *b);
+
+
+static int cdsoneBatch
+(CDSONE_BATCH_CONTEXT *context,
+ long                  nbQuote,
+ TDate                *endDates,
+ double               *couponRates,
+ TCurve               *discCurve,
+ double               *quotes,
+ double               *recoveryRates,
+ double               *results,
+ int                  *statuses);
+
+
+static int cdsoneBatchGroup
+(CDSONE_BATCH_CONTEXT *context,
+ TDate                 endDate,
+ long                  nbKey,
+ CDSONE_QUOTE_KEY     *keys,
+ double               *couponRates,
+ double               *quotes,
+ double               *recoveryRates,
+ double               *results,
+ int                  *statuses);
+
+
+static int cdsoneFlatSolve
+(CDSONE_FLAT_CONTEXT  *context,
+ double                guess,
+ TBoolean             *foundIt,
+ double               *hazardRate);
+
+
+static int cdsoneFlatPrice
+(double               hazardRate,
+ void                *data,
+ double              *diff);
+
+
+static int cdsoneFlatPriceDeriv
+(double               hazardRate,
+ void                *data,
+ double              *diff,
+ double              *ddiff);
+
+
 /*
 ***************************************************************************
 ** Computes the upfront charge for a flat spread par curve.
@@ -232,3 +333,587 @@ static int cdsoneSpreadSolverFunction
     *diff = upfrontCharge - context->upfrontCharge;
     return SUCCESS;
 }
+
+
+/*
+***************************************************************************
+** Computes the upfront charges for many flat spread quotes at once.
+***************************************************************************
+*/
+EXPORT int JpmcdsCdsoneUpfrontCharges
+(TDate           today,
+ TDate           valueDate,
+ TDate           benchmarkStartDate,  /* start date of benchmark CDS for
+                                      ** internal clean spread bootstrapping */
+ TDate           stepinDate,
+ TDate           startDate,
+ long            nbQuote,
+ TDate          *endDates,
+ double         *couponRates,
+ TBoolean        payAccruedOnDefault,
+ TDateInterval  *dateInterval,
+ TStubMethod    *stubType,
+ long            accrueDCC,
+ long            badDayConv,
+ char           *calendar,
+ TCurve         *discCurve,
+ double         *oneSpreads,
+ double         *recoveryRates,
+ TBoolean        payAccruedAtStart,
+ double         *upfrontCharges,
+ int            *statuses)
+{
+    static char routine[] = "JpmcdsCdsoneUpfrontCharges";
+    int         status    = FAILURE;
+
+    CDSONE_BATCH_CONTEXT context;
+
+    context.today               = today;
+    context.valueDate           = valueDate;
+    context.benchmarkStartDate  = benchmarkStartDate;
+    context.stepinDate          = stepinDate;
+    context.startDate           = startDate;
+    context.payAccruedOnDefault = payAccruedOnDefault;
+    context.dateInterval        = dateInterval;
+    context.stubType            = stubType;
+    context.accrueDCC           = accrueDCC;
+    context.badDayConv          = badDayConv;
+    context.calendar            = calendar;
+    context.payAccruedAtStart   = payAccruedAtStart;
+    context.toUpfront           = TRUE;
+    context.curves              = NULL;
+
+    if (cdsoneBatch (&context,
+                     nbQuote,
+                     endDates,
+                     couponRates,
+                     discCurve,
+                     oneSpreads,
+                     recoveryRates,
+                     upfrontCharges,
+                     statuses) != SUCCESS)
+        goto done;
+
+    status = SUCCESS;
+
+ done:
+
+    if (status != SUCCESS)
+        JpmcdsErrMsgFailure (routine);
+
+    return status;
+}
+
+
+/*
+***************************************************************************
+** Computes the flat spreads for many upfront charges at once.
+***************************************************************************
+*/
+EXPORT int JpmcdsCdsoneSpreads
+(TDate           today,
+ TDate           valueDate,
+ TDate           benchmarkStartDate,  /* start date of benchmark CDS for
+                                      ** internal clean spread bootstrapping */
+ TDate           stepinDate,
+ TDate           startDate,
+ long            nbQuote,
+ TDate          *endDates,
+ double         *couponRates,
+ TBoolean        payAccruedOnDefault,
+ TDateInterval  *dateInterval,
+ TStubMethod    *stubType,
+ long            accrueDCC,
+ long            badDayConv,
+ char           *calendar,
+ TCurve         *discCurve,
+ double         *upfrontCharges,
+ double         *recoveryRates,
+ TBoolean        payAccruedAtStart,
+ double         *oneSpreads,
+ int            *statuses)
+{
+    static char routine[] = "JpmcdsCdsoneSpreads";
+    int         status    = FAILURE;
+
+    CDSONE_BATCH_CONTEXT context;
+
+    context.today               = today;
+    context.valueDate           = valueDate;
+    context.benchmarkStartDate  = benchmarkStartDate;
+    context.stepinDate          = stepinDate;
+    context.startDate           = startDate;
+    context.payAccruedOnDefault = payAccruedOnDefault;
+    context.dateInterval        = dateInterval;
+    context.stubType            = stubType;
+    context.accrueDCC           = accrueDCC;
+    context.badDayConv          = badDayConv;
+    context.calendar            = calendar;
+    context.payAccruedAtStart   = payAccruedAtStart;
+    context.toUpfront           = FALSE;
+    context.curves              = NULL;
+
+    if (cdsoneBatch (&context,
+                     nbQuote,
+                     endDates,
+                     couponRates,
+                     discCurve,
+                     upfrontCharges,
+                     recoveryRates,
+                     oneSpreads,
+                     statuses) != SUCCESS)
+        goto done;
+
+    status = SUCCESS;
+
+ done:
+
+    if (status != SUCCESS)
+        JpmcdsErrMsgFailure (routine);
+
+    return status;
+}
+
+
+/*
+***************************************************************************
+** Orders quote keys by end date, then by position in the batch.
+***************************************************************************
+*/
+static int cdsoneQuoteKeyCompare(const void *a, const void *b)
+{
+    const CDSONE_QUOTE_KEY *ka = (const CDSONE_QUOTE_KEY*)a;
+    const CDSONE_QUOTE_KEY *kb = (const CDSONE_QUOTE_KEY*)b;
+
+    if (ka->endDate != kb->endDate)
+        return ka->endDate < kb->endDate ? -1 : 1;
+    if (ka->idx != kb->idx)
+        return ka->idx < kb->idx ? -1 : 1;
+    return 0;
+}
+
+
+/*
+***************************************************************************
+** Converts a batch of quotes, one group of end dates at a time.
+**
+** All groups share one cache of discount factors. Its spread curve is a
+** single point at the last end date which is never used for values.
+***************************************************************************
+*/
+static int cdsoneBatch
+(CDSONE_BATCH_CONTEXT *context,
+ long                  nbQuote,
+ TDate                *endDates,
+ double               *couponRates,
+ TCurve               *discCurve,
+ double               *quotes,
+ double               *recoveryRates,
+ double               *results,
+ int                  *statuses)
+{
+    static char routine[] = "cdsoneBatch";
+    int         status    = FAILURE;
+
+    CDSONE_QUOTE_KEY *keys      = NULL;
+    TCurve           *flatCurve = NULL;
+    TDate             lastDate;
+    double            zeroRate  = 0.0;
+    long              i;
+    long              groupEnd;
+
+    REQUIRE (nbQuote >= 0);
+    REQUIRE (statuses != NULL);
+
+    /* outputs are defined for every quote even when inputs are bad */
+    for (i = 0; i < nbQuote; ++i)
+        statuses[i] = FAILURE;
+
+    if (nbQuote == 0)
+    {
+        status = SUCCESS;
+        goto done;
+    }
+
+    REQUIRE (endDates != NULL);
+    REQUIRE (couponRates != NULL);
+    REQUIRE (quotes != NULL);
+    REQUIRE (recoveryRates != NULL);
+    REQUIRE (results != NULL);
+    REQUIRE (discCurve != NULL);
+    REQUIRE (context->stepinDate >= context->today);
+    REQUIRE (context->valueDate >= context->today);
+
+    keys = NEW_ARRAY(CDSONE_QUOTE_KEY, nbQuote);
+    if (keys == NULL)
+        goto done;
+
+    lastDate = context->valueDate;
+    for (i = 0; i < nbQuote; ++i)
+    {
+        keys[i].endDate = endDates[i];
+        keys[i].idx     = i;
+        lastDate = MAX(lastDate, endDates[i]);
+    }
+
+    qsort (keys, nbQuote, sizeof(CDSONE_QUOTE_KEY), cdsoneQuoteKeyCompare);
+
+    flatCurve = JpmcdsMakeTCurve (context->today,
+                                  &lastDate,
+                                  &zeroRate,
+                                  1,
+                                  JPMCDS_CONTINUOUS_BASIS,
+                                  JPMCDS_ACT_365F);
+    if (flatCurve == NULL)
+        goto done;
+
+    /* nothing is observed before the start of today */
+    context->curves = JpmcdsCurvePairCacheMake (context->today,
+                                                context->today - 1,
+                                                lastDate + CDSONE_CACHE_EXTRA_DAYS,
+                                                discCurve,
+                                                flatCurve);
+    if (context->curves == NULL)
+        goto done;
+
+    for (i = 0; i < nbQuote; i = groupEnd)
+    {
+        for (groupEnd = i+1; groupEnd < nbQuote; ++groupEnd)
+        {
+            if (keys[groupEnd].endDate != keys[i].endDate)
+                break;
+        }
+
+        /* a group which cannot be set up leaves its quotes as FAILURE */
+        if (cdsoneBatchGroup (context,
+                              keys[i].endDate,
+                              groupEnd - i,
+                              keys + i,
+                              couponRates,
+                              quotes,
+                              recoveryRates,
+                              results,
+                              statuses) != SUCCESS)
+        {
+            JpmcdsErrMsg ("%s: Failed to convert quotes with end date %s.\n",
+                          routine,
+                          JpmcdsFormatDate(keys[i].endDate));
+        }
+    }
+
+    status = SUCCESS;
+
+ done:
+
+    if (status != SUCCESS)
+        JpmcdsErrMsgFailure (routine);
+
+    JpmcdsCurvePairCacheFree (context->curves);
+    context->curves = NULL;
+    JpmcdsFreeTCurve (flatCurve);
+    FREE (keys);
+
+    return status;
+}
+
+
+/*
+***************************************************************************
+** Converts the quotes of one end date.
+**
+** The benchmark and the CDS are made as by JpmcdsCleanSpreadCurve and
+** JpmcdsCdsPrice, and their legs are recorded once for the group. The
+** benchmark is clean and has zero price at its flat spread. So a spread
+** gives the hazard rate at which the benchmark has zero price, and an
+** upfront charge gives the hazard rate at which the CDS has that price.
+***************************************************************************
+*/
+static int cdsoneBatchGroup
+(CDSONE_BATCH_CONTEXT *context,
+ TDate                 endDate,
+ long                  nbKey,
+ CDSONE_QUOTE_KEY     *keys,
+ double               *couponRates,
+ double               *quotes,
+ double               *recoveryRates,
+ double               *results,
+ int                  *statuses)
+{
+    static char routine[] = "cdsoneBatchGroup";
+    int         status    = FAILURE;
+
+    TFeeLeg        *benchmarkFl   = NULL;
+    TContingentLeg *benchmarkCl   = NULL;
+    TFeeLeg        *fl            = NULL;
+    TContingentLeg *cl            = NULL;
+    TCdsLegsFlat   *benchmarkFlat = NULL;
+    TCdsLegsFlat   *flat          = NULL;
+    TDate           protStartDate = MAX(context->stepinDate, context->startDate);
+    TBoolean        protectStart  = TRUE;
+    long            j;
+
+    benchmarkFl = JpmcdsCdsFeeLegMake (context->benchmarkStartDate,
+                                       endDate,
+                                       context->payAccruedOnDefault,
+                                       context->dateInterval,
+                                       context->stubType,
+                                       1.0,    /* notional */
+                                       1.0,    /* couponRate */
+                                       context->accrueDCC,
+                                       context->badDayConv,
+                                       context->calendar,
+                                       protectStart);
+    if (benchmarkFl == NULL)
+        goto done;
+
+    benchmarkCl = JpmcdsCdsContingentLegMake (MAX(context->today,
+                                                  context->benchmarkStartDate),
+                                              endDate,
+                                              1.0,    /* notional */
+                                              protectStart);
+    if (benchmarkCl == NULL)
+        goto done;
+
+    fl = JpmcdsCdsFeeLegMake (context->startDate,
+                              endDate,
+                              context->payAccruedOnDefault,
+                              context->dateInterval,
+                              context->stubType,
+                              1.0,    /* notional */
+                              1.0,    /* couponRate */
+                              context->accrueDCC,
+                              context->badDayConv,
+                              context->calendar,
+                              protectStart);
+    if (fl == NULL)
+        goto done;
+
+    if (protStartDate <= endDate)
+    {
+        cl = JpmcdsCdsContingentLegMake (protStartDate,
+                                         endDate,
+                                         1.0,    /* notional */
+                                         protectStart);
+        if (cl == NULL)
+            goto done;
+    }
+
+    benchmarkFlat = JpmcdsCdsLegsFlatMake (benchmarkFl,
+                                           benchmarkCl,
+                                           context->today,
+                                           context->stepinDate,
+                                           context->valueDate,
+                                           context->curves);
+    if (benchmarkFlat == NULL)
+        goto done;
+
+    flat = JpmcdsCdsLegsFlatMake (fl,
+                                  cl,
+                                  context->today,
+                                  context->stepinDate,
+                                  context->valueDate,
+                                  context->curves);
+    if (flat == NULL)
+        goto done;
+
+    for (j = 0; j < nbKey; ++j)
+    {
+        long                 idx          = keys[j].idx;
+        double               recoveryRate = recoveryRates[idx];
+        double               hazardRate;
+        double               guess;
+        TBoolean             foundIt;
+        CDSONE_FLAT_CONTEXT  solve;
+        CDSONE_FLAT_CONTEXT  value;
+        TCdsLegsPV           legs;
+
+        if (context->toUpfront)
+        {
+            solve.flat         = benchmarkFlat;
+            solve.couponRate   = quotes[idx];
+            solve.isPriceClean = TRUE;
+            solve.price        = 0.0;
+            value.flat         = flat;
+            value.couponRate   = couponRates[idx];
+            value.isPriceClean = context->payAccruedAtStart;
+            value.price        = 0.0;
+        }
+        else
+        {
+            solve.flat         = flat;
+            solve.couponRate   = couponRates[idx];
+            solve.isPriceClean = context->payAccruedAtStart;
+            solve.price        = quotes[idx];
+            value.flat         = benchmarkFlat;
+            value.couponRate   = 0.0;
+            value.isPriceClean = TRUE;
+            value.price        = 0.0;
+        }
+        solve.recoveryRate = recoveryRate;
+        value.recoveryRate = recoveryRate;
+
+        /* as in CdsBootstrap */
+        guess = solve.couponRate;
+        if (recoveryRate < 1.0)
+            guess /= 1.0 - recoveryRate;
+
+        if (cdsoneFlatSolve (&solve, guess, &foundIt, &hazardRate) != SUCCESS)
+            goto done;
+
+        if (!foundIt)
+        {
+            JpmcdsErrMsg ("%s: Could not convert quote %ld.\n", routine, idx);
+            continue;
+        }
+
+        if (context->toUpfront)
+        {
+            if (cdsoneFlatPrice (hazardRate, &value, &results[idx]) != SUCCESS)
+                goto done;
+        }
+        else
+        {
+            /* the spread at which the benchmark has zero clean price */
+            if (JpmcdsCdsLegsFlatPV (benchmarkFlat, hazardRate, recoveryRate,
+                                     &legs, NULL) != SUCCESS)
+                goto done;
+
+            if (!(legs.rpv01 - legs.accruedInterest > 0.0))
+            {
+                JpmcdsErrMsg ("%s: Could not convert quote %ld.\n", routine, idx);
+                continue;
+            }
+            results[idx] = legs.contingentPV / (legs.rpv01 - legs.accruedInterest);
+        }
+
+        statuses[idx] = SUCCESS;
+    }
+
+    status = SUCCESS;
+
+ done:
+
+    if (status != SUCCESS)
+        JpmcdsErrMsgFailure (routine);
+
+    JpmcdsFeeLegFree (benchmarkFl);
+    FREE (benchmarkCl);
+    JpmcdsFeeLegFree (fl);
+    FREE (cl);
+    JpmcdsCdsLegsFlatFree (benchmarkFlat);
+    JpmcdsCdsLegsFlatFree (flat);
+
+    return status;
+}
+
+
+/*
+***************************************************************************
+** Solves for the flat hazard rate at which a CDS has its target price,
+** with the bounds of CdsBootstrap. Brent is used when Newton gives up.
+** Returns SUCCESS with foundIt FALSE if there is no root.
+**
+** Newton converges quadratically, so the tolerances are tighter than
+** those of CdsBootstrap at the cost of about one more iteration.
+***************************************************************************
+*/
+static int cdsoneFlatSolve
+(CDSONE_FLAT_CONTEXT  *context,
+ double                guess,
+ TBoolean             *foundIt,
+ double               *hazardRate)
+{
+    static char routine[] = "cdsoneFlatSolve";
+    int         status    = FAILURE;
+
+    *foundIt = FALSE;
+
+    if (JpmcdsRootFindNewton ((TObjectDerivFunc)cdsoneFlatPriceDeriv,
+                              (void*) context,
+                              0.0,    /* boundLo */
+                              1e10,   /* boundHi */
+                              20,     /* numIterations */
+                              guess,
+                              1e-12,  /* xacc */
+                              1e-12,  /* facc */
+                              foundIt,
+                              hazardRate) != SUCCESS)
+        goto done;
+
+    if (!*foundIt)
+    {
+        /* a bracketing failure only means there is no root */
+        *foundIt = JpmcdsRootFindBrent ((TObjectFunc)cdsoneFlatPrice,
+                                        (void*) context,
+                                        0.0,    /* boundLo */
+                                        1e10,   /* boundHi */
+                                        100,    /* numIterations */
+                                        guess,
+                                        0.0005, /* initialXstep */
+                                        0,      /* initialFDeriv */
+                                        1e-10,  /* xacc */
+                                        1e-10,  /* facc */
+                                        hazardRate) == SUCCESS;
+    }
+
+    status = SUCCESS;
+
+ done:
+
+    if (status != SUCCESS)
+        JpmcdsErrMsgFailure (routine);
+
+    return status;
+}
+
+
+/*
+***************************************************************************
+** Price of a CDS for a flat hazard rate less its target price.
+***************************************************************************
+*/
+static int cdsoneFlatPrice
+(double               hazardRate,
+ void                *data,
+ double              *diff)
+{
+    CDSONE_FLAT_CONTEXT *context = (CDSONE_FLAT_CONTEXT*)data;
+    TCdsLegsPV           legs;
+
+    if (JpmcdsCdsLegsFlatPV (context->flat, hazardRate, context->recoveryRate,
+                             &legs, NULL) != SUCCESS)
+        return FAILURE;
+
+    *diff = legs.contingentPV - context->couponRate *
+        (legs.rpv01 - (context->isPriceClean ? legs.accruedInterest : 0.0)) -
+        context->price;
+    return SUCCESS;
+}
+
+
+/*
+***************************************************************************
+** As cdsoneFlatPrice, with its derivative with respect to the hazard
+** rate.
+***************************************************************************
+*/
+static int cdsoneFlatPriceDeriv
+(double               hazardRate,
+ void                *data,
+ double              *diff,
+ double              *ddiff)
+{
+    CDSONE_FLAT_CONTEXT *context = (CDSONE_FLAT_CONTEXT*)data;
+    TCdsLegsPV           legs;
+    TCdsLegsPV           dlegs;
+
+    if (JpmcdsCdsLegsFlatPV (context->flat, hazardRate, context->recoveryRate,
+                             &legs, &dlegs) != SUCCESS)
+        return FAILURE;
+
+    *diff = legs.contingentPV - context->couponRate *
+        (legs.rpv01 - (context->isPriceClean ? legs.accruedInterest : 0.0)) -
+        context->price;
+    *ddiff = dlegs.contingentPV - context->couponRate * dlegs.rpv01;
+    return SUCCESS;
+}
@@ -0,0 +1,520 @@
+/*
+ * ISDA CDS Standard Model
+ *
+ * Copyright (C) 2009 International Swaps and Derivatives Association, Inc.
+ * Developed and supported in collaboration with Markit
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the ISDA CDS Standard Model Public License.
+ */
+
+#include "cdsrisk.h"
+#include <limits.h>
+#include "cds.h"
+#include "feeleg.h"
+#include "curvecache.h"
+#include "zerocurve.h"
+#include "tcurve.h"
+#include "macros.h"
+#include "cerror.h"
+
+
+/*
+** Number of days beyond the last maturity of the trades for which the
+** factors of each scenario are remembered. Allows for the adjustment of
+** the last payment date.
+*/
+#define RISK_CACHE_EXTRA_DAYS 14
+
+
+/*
+***************************************************************************
+** Returns the last date up to which two curves give the same zero prices.
+***************************************************************************
+*/
+static TDate curvesAgreeUntil
+(TDate            today,
+ TCurve          *a,
+ TCurve          *b);
+
+
+/*
+***************************************************************************
+** Prices the trades against one pair of curves.
+***************************************************************************
+*/
+static int riskPrices
+(TDate            today,
+ TDate            valueDate,
+ TDate            stepinDate,
+ TCurve          *discCurve,
+ TCurve          *spreadCurve,
+ TDate            cacheLastDate,
+ long             nbTrade,
+ TFeeLeg        **fls,
+ TContingentLeg **cls,
+ double          *couponRates,
+ double           recoveryRate,
+ TBoolean         isPriceClean,
+ TCdsLegsSteps  **steps,
+ TBoolean         recordSteps,
+ TDate            unchangedDate,
+ double          *prices);
+
+
+/*
+***************************************************************************
+** Computes bucketed CS01 and IR01 for a set of trades.
+**
+** The trades are first valued against the base curves, and the steps of
+** each walk along their legs are recorded. For each bump, the curves are
+** compared with the base curves to find the last date up to which they
+** agree, and each trade resumes its walk from the last step which only
+** observed the curves up to that date.
+**
+** A bumped benchmark spread only changes the spread curve from its own
+** point, so the spread curve is bootstrapped again from there with
+** JpmcdsCleanSpreadCurveUpdate. A bumped rate changes the discount curve
+** after some date. A benchmark whose legs only observe the discount
+** curve up to that date bootstraps to the same point as before, so the
+** spread curve is bootstrapped again from the first benchmark which
+** observes the discount curve later. The discount curve itself is built
+** again in full, which costs little next to the spread curve.
+***************************************************************************
+*/
+EXPORT int JpmcdsCdsBucketedRisk
+(TDate           today,
+ TDate           valueDate,
+ TDate           stepinDate,
+ TDate           discValueDate,
+ long            nbRate,
+ char           *rateTypes,
+ TDate          *rateDates,
+ double         *rates,
+ long            mmDcc,
+ long            fixedSwapFreq,
+ long            floatSwapFreq,
+ long            fixedSwapDcc,
+ long            floatSwapDcc,
+ long            swapBadDayConv,
+ char           *swapHolidays,
+ TDate           benchmarkStartDate,
+ long            nbDate,
+ TDate          *endDates,
+ double         *couponRates,
+ TBoolean       *includes,
+ double          recoveryRate,
+ TBoolean        payAccOnDefault,
+ TDateInterval  *couponInterval,
+ long            paymentDcc,
+ TStubMethod    *stubType,
+ long            badDayConv,
+ char           *calendar,
+ long            nbTrade,
+ TDate          *tradeStartDates,
+ TDate          *tradeEndDates,
+ double         *tradeCouponRates,
+ TBoolean        isPriceClean,
+ double          csBump,
+ double          irBump,
+ double         *prices,
+ double         *cs01,
+ double         *ir01)
+{
+    static char routine[] = "JpmcdsCdsBucketedRisk";
+    int         status    = FAILURE;
+
+    TCurve          *discCurve     = NULL;
+    TCurve          *spreadCurve   = NULL;
+    TCurve          *bumpedDisc    = NULL;
+    TCurve          *bumpedSpread  = NULL;
+    TFeeLeg        **fls           = NULL;
+    TContingentLeg **cls           = NULL;
+    TCdsLegsSteps  **steps         = NULL;
+    double          *bumpedPrices  = NULL;
+    double          *bumpedRates   = NULL;
+    double          *bumpedCoupons = NULL;
+    TDate           *benchmarkLastDates = NULL;
+    TDate            cacheLastDate;
+    long             i;
+    long             j;
+    long             k;
+
+    REQUIRE (nbRate > 0);
+    REQUIRE (rateTypes != NULL);
+    REQUIRE (rateDates != NULL);
+    REQUIRE (rates != NULL);
+    REQUIRE (nbDate > 0);
+    REQUIRE (endDates != NULL);
+    REQUIRE (couponRates != NULL);
+    REQUIRE (nbTrade > 0);
+    REQUIRE (tradeStartDates != NULL);
+    REQUIRE (tradeEndDates != NULL);
+    REQUIRE (tradeCouponRates != NULL);
+    REQUIRE (prices != NULL);
+    REQUIRE (stepinDate >= today);
+    REQUIRE (valueDate >= today);
+
+    discCurve = JpmcdsBuildIRZeroCurve (discValueDate, rateTypes, rateDates,
+                                        rates, nbRate, mmDcc, fixedSwapFreq,
+                                        floatSwapFreq, fixedSwapDcc,
+                                        floatSwapDcc, swapBadDayConv,
+                                        swapHolidays);
+    if (discCurve == NULL)
+        goto done;
+
+    spreadCurve = JpmcdsCleanSpreadCurve (today, discCurve, benchmarkStartDate,
+                                          stepinDate, valueDate, nbDate,
+                                          endDates, couponRates, includes,
+                                          recoveryRate, payAccOnDefault,
+                                          couponInterval, paymentDcc, stubType,
+                                          badDayConv, calendar);
+    if (spreadCurve == NULL)
+        goto done;
+
+    fls           = NEW_ARRAY(TFeeLeg*, nbTrade);
+    cls           = NEW_ARRAY(TContingentLeg*, nbTrade);
+    steps         = NEW_ARRAY(TCdsLegsSteps*, nbTrade);
+    bumpedPrices  = NEW_ARRAY(double, nbTrade);
+    bumpedRates   = NEW_ARRAY(double, nbRate);
+    bumpedCoupons = NEW_ARRAY(double, nbDate);
+    benchmarkLastDates = NEW_ARRAY(TDate, nbDate);
+    if (fls == NULL || cls == NULL || steps == NULL || bumpedPrices == NULL ||
+        bumpedRates == NULL || bumpedCoupons == NULL ||
+        benchmarkLastDates == NULL)
+        goto done;
+
+    cacheLastDate = MAX(valueDate, today);
+    for (k = 0; k < nbTrade; ++k)
+    {
+        TDate protStartDate = MAX(stepinDate, tradeStartDates[k]);
+
+        fls[k] = JpmcdsCdsFeeLegMake (tradeStartDates[k],
+                                      tradeEndDates[k],
+                                      payAccOnDefault,
+                                      couponInterval,
+                                      stubType,
+                                      1.0, /* notional */
+                                      tradeCouponRates[k],
+                                      paymentDcc,
+                                      badDayConv,
+                                      calendar,
+                                      TRUE);
+        if (fls[k] == NULL)
+        {
+            JpmcdsErrMsg ("%s: Fee leg failed for trade %ld.\n", routine, k);
+            goto done;
+        }
+
+        if (protStartDate <= tradeEndDates[k])
+        {
+            cls[k] = JpmcdsCdsContingentLegMake (protStartDate,
+                                                 tradeEndDates[k],
+                                                 1.0, /* notional */
+                                                 TRUE);
+            if (cls[k] == NULL)
+            {
+                JpmcdsErrMsg ("%s: Contingent leg failed for trade %ld.\n",
+                              routine, k);
+                goto done;
+            }
+        }
+
+        steps[k] = JpmcdsCdsLegsStepsMake (fls[k]->nbDates);
+        if (steps[k] == NULL)
+            goto done;
+
+        cacheLastDate = MAX(cacheLastDate, tradeEndDates[k]);
+    }
+    cacheLastDate += RISK_CACHE_EXTRA_DAYS;
+
+    if (riskPrices (today, valueDate, stepinDate, discCurve, spreadCurve,
+                    cacheLastDate, nbTrade, fls, cls, tradeCouponRates,
+                    recoveryRate, isPriceClean, steps, TRUE, 0,
+                    prices) != SUCCESS)
+        goto done;
+
+    if (cs01 != NULL)
+    {
+        COPY_ARRAY (bumpedCoupons, couponRates, double, nbDate);
+
+        for (j = 0; j < nbDate; ++j)
+        {
+            TDate unchangedDate;
+
+            if (includes != NULL && !includes[j])
+            {
+                for (k = 0; k < nbTrade; ++k)
+                    cs01[k*nbDate + j] = 0.0;
+                continue;
+            }
+
+            bumpedCoupons[j] = couponRates[j] + csBump;
+            bumpedSpread = JpmcdsCleanSpreadCurveUpdate (
+                today, discCurve, benchmarkStartDate, stepinDate, valueDate,
+                nbDate, endDates, bumpedCoupons, includes, recoveryRate,
+                payAccOnDefault, couponInterval, paymentDcc, stubType,
+                badDayConv, calendar, spreadCurve, j);
+            bumpedCoupons[j] = couponRates[j];
+            if (bumpedSpread == NULL)
+                goto done;
+
+            unchangedDate = curvesAgreeUntil (today, spreadCurve, bumpedSpread);
+
+            if (riskPrices (today, valueDate, stepinDate, discCurve,
+                            bumpedSpread, cacheLastDate, nbTrade, fls, cls,
+                            tradeCouponRates, recoveryRate, isPriceClean,
+                            steps, FALSE, unchangedDate,
+                            bumpedPrices) != SUCCESS)
+                goto done;
+
+            for (k = 0; k < nbTrade; ++k)
+                cs01[k*nbDate + j] = bumpedPrices[k] - prices[k];
+
+            JpmcdsFreeTCurve (bumpedSpread);
+            bumpedSpread = NULL;
+        }
+    }
+
+    if (ir01 != NULL)
+    {
+        /* the latest discount factor each benchmark bootstrap observes */
+        for (j = 0; j < nbDate; ++j)
+        {
+            TFeeLeg *fl = JpmcdsCdsFeeLegMake (benchmarkStartDate,
+                                               endDates[j],
+                                               payAccOnDefault,
+                                               couponInterval,
+                                               stubType,
+                                               1.0,
+                                               couponRates[j],
+                                               paymentDcc,
+                                               badDayConv,
+                                               calendar,
+                                               TRUE);
+            if (fl == NULL)
+                goto done;
+
+            benchmarkLastDates[j] = MAX(valueDate, endDates[j]);
+            for (i = 0; i < fl->nbDates; ++i)
+            {
+                benchmarkLastDates[j] = MAX(benchmarkLastDates[j],
+                                            MAX(fl->accEndDates[i],
+                                                fl->payDates[i]));
+            }
+            JpmcdsFeeLegFree (fl);
+        }
+
+        COPY_ARRAY (bumpedRates, rates, double, nbRate);
+
+        for (i = 0; i < nbRate; ++i)
+        {
+            TDate discUnchangedDate;
+            TDate unchangedDate;
+            long  firstChanged;
+
+            bumpedRates[i] = rates[i] + irBump;
+            bumpedDisc = JpmcdsBuildIRZeroCurve (discValueDate, rateTypes,
+                                                 rateDates, bumpedRates, nbRate,
+                                                 mmDcc, fixedSwapFreq,
+                                                 floatSwapFreq, fixedSwapDcc,
+                                                 floatSwapDcc, swapBadDayConv,
+                                                 swapHolidays);
+            bumpedRates[i] = rates[i];
+            if (bumpedDisc == NULL)
+                goto done;
+
+            discUnchangedDate = curvesAgreeUntil (today, discCurve, bumpedDisc);
+
+            for (firstChanged = 0; firstChanged < nbDate; ++firstChanged)
+            {
+                if ((includes == NULL || includes[firstChanged]) &&
+                    benchmarkLastDates[firstChanged] > discUnchangedDate)
+                    break;
+            }
+
+            if (firstChanged < nbDate)
+            {
+                bumpedSpread = JpmcdsCleanSpreadCurveUpdate (
+                    today, bumpedDisc, benchmarkStartDate, stepinDate,
+                    valueDate, nbDate, endDates, couponRates, includes,
+                    recoveryRate, payAccOnDefault, couponInterval, paymentDcc,
+                    stubType, badDayConv, calendar, spreadCurve, firstChanged);
+                if (bumpedSpread == NULL)
+                    goto done;
+
+                unchangedDate = MIN(discUnchangedDate,
+                                    curvesAgreeUntil (today, spreadCurve,
+                                                      bumpedSpread));
+            }
+            else
+            {
+                unchangedDate = discUnchangedDate;
+            }
+
+            if (riskPrices (today, valueDate, stepinDate, bumpedDisc,
+                            bumpedSpread != NULL ? bumpedSpread : spreadCurve,
+                            cacheLastDate, nbTrade, fls, cls,
+                            tradeCouponRates, recoveryRate, isPriceClean,
+                            steps, FALSE, unchangedDate,
+                            bumpedPrices) != SUCCESS)
+                goto done;
+
+            for (k = 0; k < nbTrade; ++k)
+                ir01[k*nbRate + i] = bumpedPrices[k] - prices[k];
+
+            JpmcdsFreeTCurve (bumpedSpread);
+            JpmcdsFreeTCurve (bumpedDisc);
+            bumpedSpread = NULL;
+            bumpedDisc   = NULL;
+        }
+    }
+
+    status = SUCCESS;
+
+ done:
+
+    if (status != SUCCESS)
+        JpmcdsErrMsgFailure (routine);
+
+    for (k = 0; k < nbTrade; ++k)
+    {
+        if (fls != NULL)
+            JpmcdsFeeLegFree (fls[k]);
+        if (cls != NULL)
+            FREE (cls[k]);
+        if (steps != NULL)
+            JpmcdsCdsLegsStepsFree (steps[k]);
+    }
+    FREE (fls);
+    FREE (cls);
+    FREE (steps);
+    FREE (bumpedPrices);
+    FREE (bumpedRates);
+    FREE (bumpedCoupons);
+    FREE (benchmarkLastDates);
+    JpmcdsFreeTCurve (bumpedSpread);
+    JpmcdsFreeTCurve (bumpedDisc);
+    JpmcdsFreeTCurve (spreadCurve);
+    JpmcdsFreeTCurve (discCurve);
+
+    return status;
+}
+
+
+/*
+***************************************************************************
+** Returns the last date up to which two curves give the same zero prices
+** when observed from today, or zero if there is no such date.
+**
+** Zero prices up to a point of a curve depend only on that point and the
+** points before it, so the curves agree up to the point before the first
+** point where they differ.
+***************************************************************************
+*/
+static TDate curvesAgreeUntil
+(TDate            today,
+ TCurve          *a,
+ TCurve          *b)
+{
+    long  i;
+    long  n;
+    TDate agreeDate;
+
+    if (a->fBaseDate != b->fBaseDate ||
+        a->fDayCountConv != b->fDayCountConv ||
+        a->fBasis != b->fBasis)
+        return 0;
+
+    n = MIN(a->fNumItems, b->fNumItems);
+    for (i = 0; i < n; ++i)
+    {
+        if (a->fArray[i].fDate != b->fArray[i].fDate ||
+            a->fArray[i].fRate != b->fArray[i].fRate)
+            break;
+    }
+
+    if (i == 0)
+        return 0;
+
+    if (i == a->fNumItems && i == b->fNumItems)
+        agreeDate = LONG_MAX;
+    else
+        agreeDate = a->fArray[i-1].fDate;
+
+    /* all factors are relative to the zero price at today */
+    return agreeDate < today ? 0 : agreeDate;
+}
+
+
+/*
+***************************************************************************
+** Prices the trades against one pair of curves. With recordSteps the
+** walks are recorded in steps, and otherwise they resume from steps.
+***************************************************************************
+*/
+static int riskPrices
+(TDate            today,
+ TDate            valueDate,
+ TDate            stepinDate,
+ TCurve          *discCurve,
+ TCurve          *spreadCurve,
+ TDate            cacheLastDate,
+ long             nbTrade,
+ TFeeLeg        **fls,
+ TContingentLeg **cls,
+ double          *couponRates,
+ double           recoveryRate,
+ TBoolean         isPriceClean,
+ TCdsLegsSteps  **steps,
+ TBoolean         recordSteps,
+ TDate            unchangedDate,
+ double          *prices)
+{
+    static char routine[] = "riskPrices";
+    int         status    = FAILURE;
+
+    TCurvePairCache *curves = NULL;
+    long             k;
+
+    /* nothing is observed before the start of today */
+    curves = JpmcdsCurvePairCacheMake (today, today - 1, cacheLastDate,
+                                       discCurve, spreadCurve);
+    if (curves == NULL)
+        goto done;
+
+    for (k = 0; k < nbTrade; ++k)
+    {
+        TCdsLegsPV legs;
+
+        if (JpmcdsFeeAndContingentLegPVSteps (fls[k],
+                                              cls[k],
+                                              today,
+                                              stepinDate,
+                                              valueDate,
+                                              curves,
+                                              recoveryRate,
+                                              recordSteps ? NULL : steps[k],
+                                              unchangedDate,
+                                              recordSteps ? steps[k] : NULL,
+                                              &legs) != SUCCESS)
+        {
+            JpmcdsErrMsg ("%s: Legs PV failed for trade %ld.\n", routine, k);
+            goto done;
+        }
+
+        prices[k] = legs.contingentPV - couponRates[k] *
+            (legs.rpv01 - (isPriceClean ? legs.accruedInterest : 0.0));
+    }
+
+    status = SUCCESS;
+
+ done:
+
+    if (status != SUCCESS)
+        JpmcdsErrMsgFailure (routine);
+
+    JpmcdsCurvePairCacheFree (curves);
+
+    return status;
+}
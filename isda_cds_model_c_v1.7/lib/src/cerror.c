@@ -21,6 +21,7 @@
 #include "cmemory.h"
 #include "cfileio.h" 
 #include "macros.h"
+#include "cthread.h"
 
 #define JPMCDS_ERR_MSG_BUFFER 4096
 
@@ -37,6 +38,12 @@
 
 #define TS_SENSITIVITY 2.0      /* min. interval in sec for time stamps */
 
+/* logMutex serialises access to the log file and to the file-level
+ * settings below, so that messages from different threads are written
+ * one at a time. The message record is kept separately for each thread.
+ */
+static TMutex logMutex = JPMCDS_MUTEX_INIT;
+
 static TFile *pFp = NULL;
 
 /* pAppendOnOpen indicates whether the error log should be opened in
@@ -57,15 +64,40 @@ static TBoolean pFileNameSet = FALSE;
 static char pLogFilePath[MAX_LOG_PATH_LEN];
 
 /* pWriteMessage is toggled by JpmcdsErrMsgOn and JpmcdsErrMsgOff. It simply
- * determines whether a call to JpmcdsErrMsg has any effect or not.
+ * determines whether a call to JpmcdsErrMsg has any effect or not. It is
+ * read and written with JPMCDS_ATOMIC_LOAD_INT and JPMCDS_ATOMIC_STORE_INT,
+ * so that JpmcdsErrMsg need not take logMutex when logging is off.
  */
 static TBoolean pWriteMessage = FALSE;  /* Default is OFF */
 
+/* inErrMsg is set while this thread is writing a message, so that any
+ * messages generated in the process are ignored instead of recursing.
+ */
+static JPMCDS_THREAD_LOCAL TBoolean inErrMsg = FALSE;
+
 static JpmcdsErrCallBackFunc *errorUserFunc = NULL;
 static TBoolean          errorSendTimeStamp = TRUE;
 static void             *errorCallBackData;
 
+/* Messages for the user callback are copied while logMutex is held, and
+ * passed to the callback by PassToCallback once it has been released, so
+ * that the callback can take locks of its own. A message is written with
+ * at most three lines of time stamp before it.
+ */
+#define MAX_PENDING_MESSAGES 4
+
+typedef struct
+{
+    JpmcdsErrCallBackFunc *userFunc;
+    void                  *callBackData;
+    int                    count;
+    char                   messages[MAX_PENDING_MESSAGES][JPMCDS_ERR_MSG_BUFFER];
+} PendingMessages;
+
+static JPMCDS_THREAD_LOCAL PendingMessages pending;
+
 static int JpmcdsWriteToLog(TBoolean formatted, char *format, va_list parminfo);
+static void PassToCallback(void);
 static void JpmcdsAddToRecord(char *buffer);
 
 
@@ -115,7 +147,7 @@ typedef struct record_s
    char       **buf;
 } Record;
 
-static Record record = {FALSE, 0, 0, 0, NULL, NULL};
+static JPMCDS_THREAD_LOCAL Record record = {FALSE, 0, 0, 0, NULL, NULL};
 
 
 /*
@@ -126,7 +158,7 @@ static Record record = {FALSE, 0, 0, 0, NULL, NULL};
 */
 void JpmcdsErrMsgOn(void)
 {
-    pWriteMessage = TRUE;
+    JPMCDS_ATOMIC_STORE_INT(&pWriteMessage, TRUE);
 }
 
 
@@ -137,7 +169,7 @@ void JpmcdsErrMsgOn(void)
 */
 void JpmcdsErrMsgOff(void)
 {
-    pWriteMessage = FALSE;
+    JPMCDS_ATOMIC_STORE_INT(&pWriteMessage, FALSE);
 }
 
 
@@ -148,7 +180,7 @@ void JpmcdsErrMsgOff(void)
 */
 EXPORT TBoolean JpmcdsErrMsgStatus(void)
 {
-    return pWriteMessage;
+    return JPMCDS_ATOMIC_LOAD_INT(&pWriteMessage);
 }
 
 
@@ -162,12 +194,11 @@ EXPORT TBoolean JpmcdsErrMsgStatus(void)
 EXPORT int JpmcdsErrMsgFileName(char *fileName, TBoolean append)
 {
     static char routine[] = "JpmcdsErrMsgFileName";
-
-    if (fileName == (char *)NULL)
-        fileName = GetDefaultFileName();
+    int         status    = FAILURE;
+    char        failedName[MAX_LOG_PATH_LEN];
 
 #if defined(UNIX)
-    else if( strchr(fileName, '~') != NULL )
+    if (fileName != (char *)NULL && strchr(fileName, '~') != NULL )
     {
         /* The '~' character is specific to the C shell.  Most users
            are too familiar with the C shell to know this. */
@@ -176,6 +207,11 @@ EXPORT int JpmcdsErrMsgFileName(char *fileName, TBoolean append)
     }
 #endif
 
+    JpmcdsMutexLock(&logMutex);
+
+    if (fileName == (char *)NULL)
+        fileName = GetDefaultFileName();
+
     /* Make sure we can open the file.
      */
     if (FileCreate(fileName, append) == SUCCESS)
@@ -195,27 +231,44 @@ EXPORT int JpmcdsErrMsgFileName(char *fileName, TBoolean append)
          * save the file name for next time.
          */
         SetFileName(fileName);
-        return SUCCESS;
+        status = SUCCESS;
     }
     else
     {
-        /* Comes here on failure.
+        /* Keep the name for the message, which is written once the
+         * lock has been released.
          */
-        JpmcdsErrMsg("%s: Failed to open file \"%s\".\n", routine, fileName);
-        return FAILURE;
+        strncpy(failedName, fileName, MAX_LOG_PATH_LEN-1);
+        failedName[MAX_LOG_PATH_LEN-1] = '\0';
     }
+
+    JpmcdsMutexUnlock(&logMutex);
+
+    if (status != SUCCESS)
+        JpmcdsErrMsg("%s: Failed to open file \"%s\".\n", routine, failedName);
+
+    return status;
 }
 
 
 /*
 ***************************************************************************
-** Returns pointer to privately held error log file name which was set by 
+** Returns a copy of the error log file name which was set by 
 ** JpmcdsErrMsgFileName.
 ***************************************************************************
 */
 EXPORT char* JpmcdsErrMsgGetFileName(void)
 {
-    return GetFileName();
+    /* The name is copied out under the lock, since another thread can
+     * change pLogFilePath as soon as the lock is released.
+     */
+    static JPMCDS_THREAD_LOCAL char fileName[MAX_LOG_PATH_LEN];
+
+    JpmcdsMutexLock(&logMutex);
+    strcpy(fileName, GetFileName());
+    JpmcdsMutexUnlock(&logMutex);
+
+    return fileName;
 }
 
 
@@ -244,23 +297,23 @@ void JpmcdsErrMsg(const char *format,  ...)
 */
 void JpmcdsErrMsgV(const char *format,  va_list parminfo)
 {
-    TBoolean localpWriteMessage;     /* Local copy of pWriteMessage */
+    if (!JPMCDS_ATOMIC_LOAD_INT(&pWriteMessage))
+    {
+        return;                         /* Message writing not turned on */
+    }
 
     /*
-     * We MUST turn off error logging while JpmcdsErrMsg is executing.
-     * If we don't, we could potentially land in an infinite loop.
+     * We MUST turn off error logging in this thread while JpmcdsErrMsg is
+     * executing. If we don't, we could potentially land in an infinite
+     * loop (or deadlock on logMutex).
      */
-    localpWriteMessage = pWriteMessage;
-
-    if (!localpWriteMessage)
+    if (inErrMsg)
     {
-        return;                         /* Message writing not turned on */
+        return;
     }
 
-    pWriteMessage = FALSE; /* Turn off message writing when executing
-                              JpmcdsErrMsg because we don't want an
-                              infinite loop of calls to JpmcdsErrMsg
-                           */
+    inErrMsg = TRUE;
+    JpmcdsMutexLock(&logMutex);
 
     if (pFp == NULL)
     {
@@ -282,11 +335,8 @@ void JpmcdsErrMsgV(const char *format,  va_list parminfo)
     if (TimeStampRequired() != SUCCESS)
         goto done;
 
-    if (JpmcdsWriteToLog(TRUE, format, parminfo) != SUCCESS)
-    {
-        pWriteMessage = localpWriteMessage; /* Restore the variable */
-        return; /* failed */
-    }
+    /* On failure JpmcdsWriteToLog has already closed the file */
+    JpmcdsWriteToLog(TRUE, format, parminfo);
 
     /* Close file in between calls, unless user supplied file pointer to us.
      * Note that if pFp is NULL, JpmcdsFClose does nothing.
@@ -294,7 +344,9 @@ void JpmcdsErrMsgV(const char *format,  va_list parminfo)
  done:
     JpmcdsFclose(pFp);
     pFp = NULL;
-    pWriteMessage = localpWriteMessage; /* Restore the variable */
+    JpmcdsMutexUnlock(&logMutex);
+    PassToCallback();
+    inErrMsg = FALSE;
     return;
 }
 
@@ -306,9 +358,12 @@ void JpmcdsErrMsgV(const char *format,  va_list parminfo)
 */
 void JpmcdsErrLogWrite(char *message)
 {
-    if (!pWriteMessage)
+    if (!JPMCDS_ATOMIC_LOAD_INT(&pWriteMessage) || inErrMsg)
         return;  /* Message writing not turned on */
 
+    inErrMsg = TRUE;
+    JpmcdsMutexLock(&logMutex);
+
     if (pFp == NULL)
     {
         char *fileName = GetFileName();
@@ -329,8 +384,8 @@ void JpmcdsErrLogWrite(char *message)
     if (TimeStampRequired() != SUCCESS)
         goto done;
 
-    if (JpmcdsWriteToLog(FALSE, message, NULL) != SUCCESS)
-        return; /* failed */
+    /* On failure JpmcdsWriteToLog has already closed the file */
+    JpmcdsWriteToLog(FALSE, message, NULL);
 
     /* Close file in between calls, unless user supplied file pointer to us.
      * Note that if pFp is NULL, JpmcdsFClose does nothing.
@@ -338,6 +393,9 @@ void JpmcdsErrLogWrite(char *message)
  done:
     JpmcdsFclose(pFp);
     pFp = NULL;
+    JpmcdsMutexUnlock(&logMutex);
+    PassToCallback();
+    inErrMsg = FALSE;
     return;
 }
  
@@ -366,11 +424,15 @@ int JpmcdsErrMsgFailure
 */
 int JpmcdsErrMsgFlush(void)
 {
+    int status = SUCCESS;
+
+    JpmcdsMutexLock(&logMutex);
     if (pFp)
-    {
-        if (JpmcdsFflush(pFp) != SUCCESS)
-            return JpmcdsErrMsgFailure("JpmcdsErrMsgFlush");
-    }
+        status = JpmcdsFflush(pFp);
+    JpmcdsMutexUnlock(&logMutex);
+
+    if (status != SUCCESS)
+        return JpmcdsErrMsgFailure("JpmcdsErrMsgFlush");
     return SUCCESS;
 }
 
@@ -434,6 +496,7 @@ static int FileCreate
 /*
 ***************************************************************************
 ** Determines if a timestamp should be output with the current error message.
+** Must be called with logMutex held.
 **
 ** If timestamp required, it gets created in the beginning of the  buffer 
 ** argument.
@@ -556,15 +619,14 @@ static int JpmcdsWriteToLog(TBoolean formatted, char *format, va_list parminfo)
             goto done;
         }
     }
-    else
+    else if (pending.count < MAX_PENDING_MESSAGES)
     {
-        if (errorUserFunc(bufp, errorCallBackData) == TRUE)
-        {
-            if (JpmcdsFputs(bufp, pFp) == FAILURE)
-            {
-                goto done;
-            }
-        }
+        /* the callback is called by PassToCallback */
+        pending.userFunc     = errorUserFunc;
+        pending.callBackData = errorCallBackData;
+        strncpy(pending.messages[pending.count], bufp, JPMCDS_ERR_MSG_BUFFER - 1);
+        pending.messages[pending.count][JPMCDS_ERR_MSG_BUFFER - 1] = '\0';
+        ++pending.count;
     }
 
     return SUCCESS;
@@ -576,6 +638,35 @@ static int JpmcdsWriteToLog(TBoolean formatted, char *format, va_list parminfo)
 }
 
 
+/*
+***************************************************************************
+** Passes the messages copied by JpmcdsWriteToLog to the user callback.
+** Must be called without logMutex held. Messages for which the callback
+** returns TRUE are then appended to the log file.
+***************************************************************************
+*/
+static void PassToCallback(void)
+{
+    int i;
+
+    for (i = 0; i < pending.count; ++i)
+    {
+        if (pending.userFunc(pending.messages[i], pending.callBackData) == TRUE)
+        {
+            JpmcdsMutexLock(&logMutex);
+            if (FileCreate(GetFileName(), TRUE) == SUCCESS)
+            {
+                JpmcdsFputs(pending.messages[i], pFp);
+                JpmcdsFclose(pFp);
+                pFp = NULL;
+            }
+            JpmcdsMutexUnlock(&logMutex);
+        }
+    }
+    pending.count = 0;
+}
+
+
 /*
 ***************************************************************************
 ** Turns on the error message record facility.
@@ -600,10 +691,9 @@ EXPORT int JpmcdsErrMsgEnableRecord(
     ** terminator of the array of pointers in JpmcdsErrGetMsgRecord
     */
     record.buf = NEW_ARRAY (char*, record.number+1);
+    all = NEW_ARRAY (char, record.number * messageSize);
     if (record.buf == NULL)
         return FAILURE;
-
-    all = NEW_ARRAY (char, record.number * messageSize);
     if (all == NULL)
         return FAILURE;
     record.alloc = all;
@@ -826,9 +916,11 @@ EXPORT void  JpmcdsErrMsgAddCallback
     TBoolean               sendTimeStamp,
     void                  *callBackData)
 {
+    JpmcdsMutexLock(&logMutex);
     errorUserFunc = userFunc;
     errorSendTimeStamp = sendTimeStamp;
     errorCallBackData = callBackData;
+    JpmcdsMutexUnlock(&logMutex);
 }
 
 /*
@@ -841,7 +933,9 @@ EXPORT void JpmcdsErrMsgGetCallback
     TBoolean               *sendTimeStamp,   /* (O) */
     void                  **callBackData)    /* (O) */
 {
+    JpmcdsMutexLock(&logMutex);
     *userFunc = errorUserFunc;
     *sendTimeStamp = errorSendTimeStamp;
     *callBackData = errorCallBackData;
+    JpmcdsMutexUnlock(&logMutex);
 }
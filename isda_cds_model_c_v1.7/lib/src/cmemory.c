@@ -14,6 +14,15 @@
 #include "cerror.h"
 
 
+/* every allocation from an arena is aligned for any type */
+#define ARENA_ALIGN         16
+#define ARENA_ROUND(n)      (((n) + ARENA_ALIGN - 1) & ~(size_t)(ARENA_ALIGN - 1))
+#define ARENA_HEADER        ARENA_ROUND(sizeof(TArenaBlock))
+#define ARENA_DATA(block)   ((char*)(block) + ARENA_HEADER)
+
+static TArenaBlock* arenaNewBlock(size_t size);
+
+
 /*
 ***************************************************************************
 ** Memory allocator.
@@ -56,3 +65,141 @@ void JpmcdsFreeSafe(void *ptr)
        free(ptr);
 }
 
+
+/*
+***************************************************************************
+** Makes an empty arena.
+***************************************************************************
+*/
+TArena* JpmcdsArenaMake(size_t blockSize)
+{
+    static char routine[]="JpmcdsArenaMake";
+    TArena *arena;
+
+    arena = (TArena*)malloc(sizeof(TArena));
+    if (arena == NULL)
+    {
+        JpmcdsErrMsg("%s: Insufficient memory to allocate %lu bytes.\n",  routine, (unsigned long) sizeof(TArena));
+        return NULL;
+    }
+
+    arena->blocks    = NULL;
+    arena->blockSize = ARENA_ROUND(blockSize > 0 ? blockSize : JPMCDS_ARENA_BLOCK_SIZE);
+    return arena;
+}
+
+
+/*
+***************************************************************************
+** Releases all the memory handed out by an arena.
+***************************************************************************
+*/
+void JpmcdsArenaReset(TArena *arena)
+{
+    TArenaBlock *block;
+    size_t       total = 0;
+
+    if (arena == NULL || arena->blocks == NULL)
+        return;
+
+    if (arena->blocks->next == NULL)
+    {
+        block = arena->blocks;
+        (void)memset(ARENA_DATA(block), 0, block->used);
+        block->used = 0;
+        return;
+    }
+
+    /* one block of the total size holds everything next time */
+    while (arena->blocks != NULL)
+    {
+        block = arena->blocks;
+        arena->blocks = block->next;
+        total += block->size;
+        free(block);
+    }
+    arena->blocks = arenaNewBlock(total);
+}
+
+
+/*
+***************************************************************************
+** Frees an arena and all the memory it handed out.
+***************************************************************************
+*/
+void JpmcdsArenaFree(TArena *arena)
+{
+    if (arena != NULL)
+    {
+        while (arena->blocks != NULL)
+        {
+            TArenaBlock *block = arena->blocks;
+            arena->blocks = block->next;
+            free(block);
+        }
+        free(arena);
+    }
+}
+
+
+/*
+***************************************************************************
+** Takes cleared memory from the latest block of an arena, starting a new
+** block if it does not fit.
+**
+** Returns NULL if no memory left.
+***************************************************************************
+*/
+void* JpmcdsArenaAlloc(TArena *arena, size_t theSize)
+{
+    static char routine[]="JpmcdsArenaAlloc";
+    TArenaBlock *block;
+    void        *ptr;
+
+    if (arena == NULL || theSize <= 0)
+    {
+        JpmcdsErrMsg("%s: Number of bytes (%lu) must be at least 1.\n", routine, (unsigned long) theSize);
+        return NULL;
+    }
+
+    theSize = ARENA_ROUND(theSize);
+    block   = arena->blocks;
+
+    if (block == NULL || block->size - block->used < theSize)
+    {
+        /* arena blocks are cleared when they are made and reset */
+        block = arenaNewBlock(theSize > arena->blockSize ? theSize : arena->blockSize);
+        if (block == NULL)
+        {
+            JpmcdsErrMsg("%s: Insufficient memory to allocate %lu bytes.\n",  routine, (unsigned long) theSize);
+            return NULL;
+        }
+        block->next   = arena->blocks;
+        arena->blocks = block;
+    }
+
+    ptr = ARENA_DATA(block) + block->used;
+    block->used += theSize;
+    return ptr;
+}
+
+
+/*
+***************************************************************************
+** Makes a cleared arena block with size bytes available.
+***************************************************************************
+*/
+static TArenaBlock* arenaNewBlock(size_t size)
+{
+    TArenaBlock *block;
+
+    block = (TArenaBlock*)calloc(1, ARENA_HEADER + size);
+    if (block == NULL)
+        return NULL;
+
+    block->next = NULL;
+    block->size = size;
+    block->used = 0;
+    return block;
+}
+
@@ -18,6 +18,8 @@
 #include "dtlist.h"
 #include "cashflow.h"
 #include "cerror.h"
+#include "curvecache.h"
+#include "segint.h"
 
 
 /*
@@ -29,10 +31,10 @@ static int onePeriodIntegral
 (TDate             today,
  TDate             startDate,
  TDate             endDate,
- TCurve           *discountCurve,
- TCurve           *spreadCurve,
+ TCurvePairCache  *curves,
  double            recoveryRate,
- double           *pv);
+ double           *pv,
+ double           *dpv);
 
 
 /*
@@ -45,10 +47,10 @@ static int onePeriodIntegralAtPayDate
  TDate             startDate,
  TDate             endDate,
  TDate             payDate, 
- TCurve           *discountCurve,
- TCurve           *spreadCurve,
+ TCurvePairCache  *curves,
  double            recoveryRate,
- double           *pv);
+ double           *pv,
+ double           *dpv);
 
 
 /*
@@ -74,15 +76,101 @@ int JpmcdsContingentLegPV
     static char routine[] = "JpmcdsContingentLegPV";
     int         status    = FAILURE;
 
+    TCurvePairCache curves;
+
+    REQUIRE (discountCurve != NULL);
+    REQUIRE (spreadCurve != NULL);
+
+    JpmcdsCurvePairCacheInit (&curves, today, discountCurve, spreadCurve);
+
+    if (JpmcdsContingentLegPVWithCache (cl,
+                                        today,
+                                        valueDate,
+                                        stepinDate,
+                                        &curves,
+                                        recoveryRate,
+                                        pv) != SUCCESS)
+        goto done;
+
+    status = SUCCESS;
+
+ done:
+
+    if (status != SUCCESS)
+        JpmcdsErrMsgFailure (routine);
+
+    return status;
+}
+
+
+/*
+***************************************************************************
+** Computes the PV of a contingent leg as a whole, taking the discount and
+** survival factors from a curve pair cache.
+***************************************************************************
+*/
+int JpmcdsContingentLegPVWithCache
+(TContingentLeg  *cl,               /* (I) Contingent leg                  */
+ TDate            today,            /* (I) No observations before today    */
+ TDate            valueDate,        /* (I) Value date for discounting      */
+ TDate            stepinDate,
+ TCurvePairCache *curves,           /* (I/O) Risk-free and spread curves   */
+ double           recoveryRate,     /* (I) Recovery rate                   */
+ double          *pv)               /* (O) Present value of contingent leg */
+{
+    static char routine[] = "JpmcdsContingentLegPVWithCache";
+    int         status    = FAILURE;
+
+    if (JpmcdsContingentLegPVWithDeriv (cl,
+                                        today,
+                                        valueDate,
+                                        stepinDate,
+                                        curves,
+                                        recoveryRate,
+                                        pv,
+                                        NULL) != SUCCESS)
+        goto done;
+
+    status = SUCCESS;
+
+ done:
+
+    if (status != SUCCESS)
+        JpmcdsErrMsgFailure (routine);
+
+    return status;
+}
+
+
+/*
+***************************************************************************
+** Computes the PV of a contingent leg and optionally its derivative with
+** respect to the rate of point curves->spreadNode of the spread curve.
+***************************************************************************
+*/
+int JpmcdsContingentLegPVWithDeriv
+(TContingentLeg  *cl,               /* (I) Contingent leg                  */
+ TDate            today,            /* (I) No observations before today    */
+ TDate            valueDate,        /* (I) Value date for discounting      */
+ TDate            stepinDate,
+ TCurvePairCache *curves,           /* (I/O) Risk-free and spread curves   */
+ double           recoveryRate,     /* (I) Recovery rate                   */
+ double          *pv,               /* (O) Present value of contingent leg */
+ double          *dpv)              /* (O) Derivative of pv - can be NULL  */
+{
+    static char routine[] = "JpmcdsContingentLegPVWithDeriv";
+    int         status    = FAILURE;
+
     double myPv = 0.0;
+    double myDpv = 0.0;
     double valueDatePv;
     TDate startDate;
 
     int   offset;
 
     REQUIRE (cl != NULL);
-    REQUIRE (discountCurve != NULL);
-    REQUIRE (spreadCurve != NULL);
+    REQUIRE (curves != NULL);
+    REQUIRE (curves->today == today);
     REQUIRE (pv != NULL);
 
     offset = (cl->protectStart ? 1 : 0);
@@ -94,32 +182,38 @@ int JpmcdsContingentLegPV
     case PROT_PAY_MAT:
         {
             double tmp;
+            double dtmp;
             if (onePeriodIntegralAtPayDate (today,
                                             startDate,
                                             cl->endDate,
                                             cl->endDate,
-                                            discountCurve,
-                                            spreadCurve,
+                                            curves,
                                             recoveryRate,
-                                            &tmp) != SUCCESS)
+                                            &tmp,
+                                            dpv == NULL ? NULL : &dtmp) != SUCCESS)
                 goto done;
             
             myPv += tmp * cl->notional;
+            if (dpv != NULL)
+                myDpv += dtmp * cl->notional;
         }
         break;
     case PROT_PAY_DEF:
         {
             double tmp;
+            double dtmp;
             if (onePeriodIntegral (today,
                                    startDate,
                                    cl->endDate,
-                                   discountCurve,
-                                   spreadCurve,
+                                   curves,
                                    recoveryRate,
-                                   &tmp) != SUCCESS)
+                                   &tmp,
+                                   dpv == NULL ? NULL : &dtmp) != SUCCESS)
             goto done;
             
             myPv += tmp * cl->notional;
+            if (dpv != NULL)
+                myDpv += dtmp * cl->notional;
         }
         break;
     default:
@@ -128,10 +222,12 @@ int JpmcdsContingentLegPV
     }
 
     /* myPv has been calculated as at today - need it at valueDate */
-    valueDatePv = JpmcdsForwardZeroPrice (discountCurve, today, valueDate);
+    valueDatePv = JpmcdsCurvePairCacheDiscount (curves, valueDate);
 
     status = SUCCESS;
     *pv    = myPv / valueDatePv;
+    if (dpv != NULL)
+        *dpv = myDpv / valueDatePv;
 
  done:
 
@@ -151,15 +247,18 @@ static int onePeriodIntegral
 (TDate             today,
  TDate             startDate,
  TDate             endDate,
- TCurve           *discCurve,
- TCurve           *spreadCurve,
+ TCurvePairCache  *curves,
  double            recoveryRate,
- double           *pv)
+ double           *pv,
+ double           *dpv)
 {
     static char routine[] = "onePeriodIntegral";
     int         status    = FAILURE;
 
     double  myPv = 0.0;
+    double  myDpv = 0.0;
+    double  g0;
+    double  g1 = 0.0;
     int     i;
 
     double t;
@@ -169,11 +268,13 @@ static int onePeriodIntegral
     double df1;
     double loss;
 
-    TDateList *tl = NULL;
+    TDate          buffer[JPMCDS_TIMELINE_BUFFER_SIZE];
+    TDate         *tl = buffer;
+    TTimeLineView  view;
+    long           numDates;
 
     REQUIRE (endDate > startDate);
-    REQUIRE (discCurve != NULL);
-    REQUIRE (spreadCurve != NULL);
+    REQUIRE (curves != NULL);
     REQUIRE (pv != NULL);
 
     if (today > endDate)
@@ -182,10 +283,29 @@ static int onePeriodIntegral
         goto success;
     }
 
-    tl = JpmcdsRiskyTimeLine (startDate, endDate, discCurve, spreadCurve);
-    if (tl == NULL)
+    /* the critical dates of the curves are read in place if there are any */
+    if (JpmcdsRiskyTimeLineView (startDate, endDate,
+                                 curves->discCurve, curves->spreadCurve,
+                                 curves->criticalDates,
+                                 JPMCDS_TIMELINE_BUFFER_SIZE, buffer,
+                                 &view) != SUCCESS)
         goto done;
 
+    numDates = JPMCDS_TIMELINE_VIEW_SIZE (&view);
+    if (view.dates == NULL)
+    {
+        /* only curves with very many points get here */
+        tl = NEW_ARRAY(TDate, numDates);
+        if (tl == NULL)
+            goto done;
+        if (JpmcdsRiskyTimeLineView (startDate, endDate,
+                                     curves->discCurve, curves->spreadCurve,
+                                     curves->criticalDates,
+                                     numDates, tl,
+                                     &view) != SUCCESS)
+            goto done;
+    }
+
     /* the integration - we can assume flat forwards between points on
        the timeline - this is true for both curves 
 
@@ -196,21 +316,55 @@ static int onePeriodIntegral
        exact integral
     */
 
-    s1  = JpmcdsForwardZeroPrice(spreadCurve, today, startDate);
-    df1 = JpmcdsForwardZeroPrice(discCurve, today, MAX(today, startDate));
+    if (curves->vectorIntegrals && dpv == NULL)
+    {
+        /* the same integral over arrays of factors at the timeline */
+        double  factorBuffer[3 * JPMCDS_TIMELINE_BUFFER_SIZE];
+        double *factors = factorBuffer;
+
+        if (numDates > JPMCDS_TIMELINE_BUFFER_SIZE)
+        {
+            factors = NEW_ARRAY(double, 3 * numDates);
+            if (factors == NULL)
+                goto done;
+        }
+
+        JpmcdsCurvePairCacheViewFactors (curves, &view,
+                                         factors, factors + numDates);
+        for (i = 1; i < numDates; ++i)
+            factors[2 * numDates + i - 1] =
+                (double)(JPMCDS_TIMELINE_VIEW_DATE (&view, i) -
+                         JPMCDS_TIMELINE_VIEW_DATE (&view, i-1))/365.0;
+
+        myPv = JpmcdsProtectionSegmentsPV (numDates - 1,
+                                           1.0 - recoveryRate,
+                                           factors,
+                                           factors + numDates,
+                                           factors + 2 * numDates);
+
+        if (factors != factorBuffer)
+            FREE (factors);
+        goto success;
+    }
+
+    s1  = JpmcdsCurvePairCacheSurvival(curves, startDate);
+    df1 = JpmcdsCurvePairCacheDiscount(curves, MAX(today, startDate));
     loss = 1.0 - recoveryRate;
+    if (dpv != NULL)
+        g1 = JpmcdsCurvePairCacheSurvivalLogDeriv(curves, startDate);
 
-    for (i = 1; i < tl->fNumItems; ++i)
+    for (i = 1; i < numDates; ++i)
     {
         double lambda;
         double fwdRate;
         double thisPv;
+        TDate  date = JPMCDS_TIMELINE_VIEW_DATE (&view, i);
 
         s0  = s1;
         df0 = df1;
-        s1  = JpmcdsForwardZeroPrice(spreadCurve, today, tl->fArray[i]);
-        df1 = JpmcdsForwardZeroPrice(discCurve, today, tl->fArray[i]);
-        t   = (double)(tl->fArray[i] - tl->fArray[i-1])/365.0;
+        s1  = JpmcdsCurvePairCacheSurvival(curves, date);
+        df1 = JpmcdsCurvePairCacheDiscount(curves, date);
+        t   = (double)(date - JPMCDS_TIMELINE_VIEW_DATE (&view, i-1))/365.0;
         
         lambda  = log(s0/s1)/t;
         fwdRate = log(df0/df1)/t;
@@ -219,19 +373,40 @@ static int onePeriodIntegral
             (1.0 - exp(-(lambda + fwdRate) * t)) * s0 * df0;
         
         myPv += thisPv;
+
+        if (dpv != NULL)
+        {
+            /* g is the derivative of log(S), so lambda moves by
+               (g0-g1)/t and s0 by s0.g0 */
+            double lambdaFwd = lambda + fwdRate;
+            double expTerm   = exp(-lambdaFwd * t);
+            double dLambda;
+
+            g0 = g1;
+            g1 = JpmcdsCurvePairCacheSurvivalLogDeriv(curves, date);
+            dLambda = (g0 - g1) / t;
+
+            myDpv += loss * s0 * df0 * (
+                dLambda * (fwdRate / (lambdaFwd * lambdaFwd) * (1.0 - expTerm) +
+                           lambda * t * expTerm / lambdaFwd) +
+                lambda / lambdaFwd * (1.0 - expTerm) * g0);
+        }
     }
 
  success:
 
     status = SUCCESS;
     *pv = myPv;
+    if (dpv != NULL)
+        *dpv = myDpv;
         
  done:
 
     if (status != SUCCESS)
         JpmcdsErrMsgFailure (routine);
 
-    JpmcdsFreeDateList (tl);
+    if (tl != buffer)
+        FREE (tl);
     return status;
 }
 
@@ -247,10 +422,10 @@ static int onePeriodIntegralAtPayDate
  TDate             startDate,
  TDate             endDate,
  TDate             payDate, 
- TCurve           *discCurve,
- TCurve           *spreadCurve,
+ TCurvePairCache  *curves,
  double            recoveryRate,
- double           *pv)
+ double           *pv,
+ double           *dpv)
 {
     static char routine[] = "onePeriodIntegralAtPayDate";
     int         status    = FAILURE;
@@ -261,21 +436,28 @@ static int onePeriodIntegralAtPayDate
     double loss;
 
     REQUIRE (endDate > startDate);
-    REQUIRE (discCurve != NULL);
-    REQUIRE (spreadCurve != NULL);
+    REQUIRE (curves != NULL);
     REQUIRE (pv != NULL);
 
     if (today > endDate)
     {
         *pv = 0.0;
+        if (dpv != NULL)
+            *dpv = 0.0;
     }
     else
     {
-        s0  = JpmcdsForwardZeroPrice(spreadCurve, today, startDate);
-        s1  = JpmcdsForwardZeroPrice(spreadCurve, today, endDate);
-        df  = JpmcdsForwardZeroPrice(discCurve, today, payDate);
+        s0  = JpmcdsCurvePairCacheSurvival(curves, startDate);
+        s1  = JpmcdsCurvePairCacheSurvival(curves, endDate);
+        df  = JpmcdsCurvePairCacheDiscount(curves, payDate);
         loss = 1.0 - recoveryRate;
         *pv = (s0 - s1) * df * loss;
+        if (dpv != NULL)
+        {
+            *dpv = (s0 * JpmcdsCurvePairCacheSurvivalLogDeriv(curves, startDate) -
+                    s1 * JpmcdsCurvePairCacheSurvivalLogDeriv(curves, endDate)) *
+                df * loss;
+        }
     }
 
     status = SUCCESS;
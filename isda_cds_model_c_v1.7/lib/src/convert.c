@@ -18,6 +18,7 @@
 #include "cfileio.h"
 #include "cdate.h"
 #include "dateconv.h"
+#include "cthread.h"
 
 #define CROSSOVER_YEAR 60     /* If double digit year less than this, assume year belongs to 21 century. */
 
@@ -152,39 +153,53 @@ done:
 */
 char* JpmcdsFormatDate(TDate date) /* (I) */
 {
-    static int ibuf;
-#define MAX_STR_LEN 16
 #define MAX_AT_ONCE 8                  /* Must be a power of 2 */
-    static char format[MAX_AT_ONCE][MAX_STR_LEN];
-    TMonthDayYear mdy;
+    static JPMCDS_THREAD_LOCAL int ibuf;
+    static JPMCDS_THREAD_LOCAL char format[MAX_AT_ONCE][JPMCDS_FORMAT_DATE_LEN];
     ibuf = (ibuf+1)&(MAX_AT_ONCE-1); /* Toggle buffers */
 
+    return JpmcdsFormatDateToBuffer(date, &format[ibuf][0]);
+}
+
+
+/*
+***************************************************************************
+** Formats a TDate for printing into a buffer provided by the caller.
+** The print format is YYYYMMDD.
+***************************************************************************
+*/
+char* JpmcdsFormatDateToBuffer
+    (TDate date,                /* (I) */
+     char *buffer)              /* (O) [JPMCDS_FORMAT_DATE_LEN] */
+{
+    TMonthDayYear mdy;
+
     if (JpmcdsDateToMDY(date, &mdy) == FAILURE)
-        sprintf(&format[ibuf][0], "%s", "bad date");
+        sprintf(buffer, "%s", "bad date");
     else
     {
         if (mdy.month < 10 && mdy.day < 10)
         {
-            sprintf(&format[ibuf][0], "%ld0%ld0%ld",
+            sprintf(buffer, "%ld0%ld0%ld",
                     mdy.year, mdy.month, mdy.day );
         }
         else if (mdy.month < 10 && mdy.day >= 10)
         {
-            sprintf(&format[ibuf][0], "%ld0%ld%ld",
+            sprintf(buffer, "%ld0%ld%ld",
                     mdy.year, mdy.month, mdy.day );
         }
         else if (mdy.month >= 10 && mdy.day < 10)
         {
-            sprintf(&format[ibuf][0], "%ld%ld0%ld",
+            sprintf(buffer, "%ld%ld0%ld",
                     mdy.year, mdy.month, mdy.day );
         }
         else   /* month && day >= 10 */
         {
-            sprintf(&format[ibuf][0], "%ld%ld%ld",
+            sprintf(buffer, "%ld%ld%ld",
                     mdy.year, mdy.month, mdy.day );
         }
     }
-    return &format[ibuf][0];
+    return buffer;
 }
 
 
@@ -196,18 +211,31 @@ char* JpmcdsFormatDate(TDate date) /* (I) */
 */
 char* JpmcdsFormatDateInterval(TDateInterval *interval) /* (I) */
 {
-    static int ibuf;
-#define MAX_STR_LEN 16
-    static char format[2][MAX_STR_LEN];
-    char periodType;
-    int numPeriods;
+    static JPMCDS_THREAD_LOCAL int ibuf;
+    static JPMCDS_THREAD_LOCAL char format[2][JPMCDS_FORMAT_DATE_LEN];
 
     ibuf = !ibuf;                       /* Toggle buffers */
 
+    return JpmcdsFormatDateIntervalToBuffer(interval, &format[ibuf][0]);
+}
+
+
+/*
+***************************************************************************
+** Formats a TDateInterval into a buffer provided by the caller.
+***************************************************************************
+*/
+char* JpmcdsFormatDateIntervalToBuffer
+    (TDateInterval *interval,   /* (I) */
+     char          *buffer)     /* (O) [JPMCDS_FORMAT_DATE_LEN] */
+{
+    char periodType;
+    int numPeriods;
+
     if (interval == NULL)
     {
-        format[ibuf][0] = 0; /* empty string */
-        return &format[ibuf][0];
+        buffer[0] = 0; /* empty string */
+        return buffer;
     }
 
     switch(interval->prd_typ)
@@ -252,8 +280,8 @@ char* JpmcdsFormatDateInterval(TDateInterval *interval) /* (I) */
             numPeriods = interval->prd;
     }
 
-    sprintf(&format[ibuf][0], "%d%c", numPeriods, periodType);
-    return &format[ibuf][0];
+    sprintf(buffer, "%d%c", numPeriods, periodType);
+    return buffer;
 }
 
 
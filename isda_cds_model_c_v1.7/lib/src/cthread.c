@@ -0,0 +1,351 @@
+/*
+ * ISDA CDS Standard Model
+ *
+ * Copyright (C) 2009 International Swaps and Derivatives Association, Inc.
+ * Developed and supported in collaboration with Markit
+ * 
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the ISDA CDS Standard Model Public License.
+ */
+
+#include "cthread.h"
+#include "macros.h"
+#include "cerror.h"
+
+#if !defined(WIN32) && !defined(_WIN32)
+#include <unistd.h>
+#endif
+
+
+/*
+***************************************************************************
+** Shared state of the workers in JpmcdsParallelFor.
+***************************************************************************
+*/
+typedef struct
+{
+    long           n;           /* number of tasks */
+    long           next;        /* next task to hand out */
+    TParallelFunc  func;
+    void          *data;
+    TMutex         lock;        /* guards next */
+} TParallelJob;
+
+
+static void parallelJobRun(TParallelJob *job);
+
+
+#if defined(WIN32) || defined(_WIN32)
+
+/*
+***************************************************************************
+** Acquires a mutex.
+***************************************************************************
+*/
+void JpmcdsMutexLock(TMutex *mutex)
+{
+    AcquireSRWLockExclusive(mutex);
+}
+
+
+/*
+***************************************************************************
+** Releases a mutex.
+***************************************************************************
+*/
+void JpmcdsMutexUnlock(TMutex *mutex)
+{
+    ReleaseSRWLockExclusive(mutex);
+}
+
+
+/*
+***************************************************************************
+** Acquires a reader/writer lock for reading.
+***************************************************************************
+*/
+void JpmcdsRWLockRead(TRWLock *lock)
+{
+    AcquireSRWLockShared(lock);
+}
+
+
+/*
+***************************************************************************
+** Releases a reader/writer lock held for reading.
+***************************************************************************
+*/
+void JpmcdsRWLockReadUnlock(TRWLock *lock)
+{
+    ReleaseSRWLockShared(lock);
+}
+
+
+/*
+***************************************************************************
+** Acquires a reader/writer lock for writing.
+***************************************************************************
+*/
+void JpmcdsRWLockWrite(TRWLock *lock)
+{
+    AcquireSRWLockExclusive(lock);
+}
+
+
+/*
+***************************************************************************
+** Releases a reader/writer lock held for writing.
+***************************************************************************
+*/
+void JpmcdsRWLockWriteUnlock(TRWLock *lock)
+{
+    ReleaseSRWLockExclusive(lock);
+}
+
+
+/*
+***************************************************************************
+** Returns the number of processors available to the process.
+***************************************************************************
+*/
+int JpmcdsNumProcessors(void)
+{
+    SYSTEM_INFO info;
+
+    GetSystemInfo(&info);
+    return info.dwNumberOfProcessors > 0 ? (int)info.dwNumberOfProcessors : 1;
+}
+
+
+typedef HANDLE TThread;
+
+static DWORD WINAPI parallelThread(LPVOID arg)
+{
+    parallelJobRun((TParallelJob*)arg);
+    return 0;
+}
+
+static void parallelJobInit(TParallelJob *job)
+{
+    InitializeSRWLock(&job->lock);
+}
+
+static void parallelJobDestroy(TParallelJob *job)
+{
+    /* slim locks need no clean up */
+}
+
+static int threadStart(TThread *thread, TParallelJob *job)
+{
+    *thread = CreateThread(NULL, 0, parallelThread, (LPVOID)job, 0, NULL);
+    return *thread != NULL ? SUCCESS : FAILURE;
+}
+
+static void threadJoin(TThread thread)
+{
+    WaitForSingleObject(thread, INFINITE);
+    CloseHandle(thread);
+}
+
+#else
+
+/*
+***************************************************************************
+** Acquires a mutex.
+***************************************************************************
+*/
+void JpmcdsMutexLock(TMutex *mutex)
+{
+    pthread_mutex_lock(mutex);
+}
+
+
+/*
+***************************************************************************
+** Releases a mutex.
+***************************************************************************
+*/
+void JpmcdsMutexUnlock(TMutex *mutex)
+{
+    pthread_mutex_unlock(mutex);
+}
+
+
+/*
+***************************************************************************
+** Acquires a reader/writer lock for reading.
+***************************************************************************
+*/
+void JpmcdsRWLockRead(TRWLock *lock)
+{
+    pthread_rwlock_rdlock(lock);
+}
+
+
+/*
+***************************************************************************
+** Releases a reader/writer lock held for reading.
+***************************************************************************
+*/
+void JpmcdsRWLockReadUnlock(TRWLock *lock)
+{
+    pthread_rwlock_unlock(lock);
+}
+
+
+/*
+***************************************************************************
+** Acquires a reader/writer lock for writing.
+***************************************************************************
+*/
+void JpmcdsRWLockWrite(TRWLock *lock)
+{
+    pthread_rwlock_wrlock(lock);
+}
+
+
+/*
+***************************************************************************
+** Releases a reader/writer lock held for writing.
+***************************************************************************
+*/
+void JpmcdsRWLockWriteUnlock(TRWLock *lock)
+{
+    pthread_rwlock_unlock(lock);
+}
+
+
+/*
+***************************************************************************
+** Returns the number of processors available to the process.
+***************************************************************************
+*/
+int JpmcdsNumProcessors(void)
+{
+    long n = sysconf(_SC_NPROCESSORS_ONLN);
+
+    return n > 0 ? (int)n : 1;
+}
+
+
+typedef pthread_t TThread;
+
+static void* parallelThread(void *arg)
+{
+    parallelJobRun((TParallelJob*)arg);
+    return NULL;
+}
+
+static void parallelJobInit(TParallelJob *job)
+{
+    pthread_mutex_init(&job->lock, NULL);
+}
+
+static void parallelJobDestroy(TParallelJob *job)
+{
+    pthread_mutex_destroy(&job->lock);
+}
+
+static int threadStart(TThread *thread, TParallelJob *job)
+{
+    return pthread_create(thread, NULL, parallelThread, (void*)job) == 0 ?
+        SUCCESS : FAILURE;
+}
+
+static void threadJoin(TThread thread)
+{
+    pthread_join(thread, NULL);
+}
+
+#endif
+
+
+/*
+***************************************************************************
+** Calls func(data, i) for each i in [0,n) on a pool of worker threads.
+***************************************************************************
+*/
+int JpmcdsParallelFor
+(long           n,
+ int            nbThreads,
+ TParallelFunc  func,
+ void          *data)
+{
+    static char routine[] = "JpmcdsParallelFor";
+    int         status    = FAILURE;
+
+    TParallelJob job;
+    TThread     *threads   = NULL;
+    int          nbStarted = 0;
+    int          i;
+
+    REQUIRE (n >= 0);
+    REQUIRE (func != NULL);
+
+    if (nbThreads <= 0)
+        nbThreads = JpmcdsNumProcessors();
+    if (nbThreads > n)
+        nbThreads = (int)n;
+
+    job.n    = n;
+    job.next = 0;
+    job.func = func;
+    job.data = data;
+    parallelJobInit(&job);
+
+    /* the calling thread is the last worker */
+    if (nbThreads > 1)
+    {
+        threads = NEW_ARRAY(TThread, nbThreads - 1);
+        if (threads != NULL)
+        {
+            for (i = 0; i < nbThreads - 1; ++i)
+            {
+                if (threadStart(&threads[i], &job) != SUCCESS)
+                    break;
+                ++nbStarted;
+            }
+        }
+    }
+
+    parallelJobRun(&job);
+
+    for (i = 0; i < nbStarted; ++i)
+        threadJoin(threads[i]);
+
+    parallelJobDestroy(&job);
+    FREE(threads);
+    status = SUCCESS;
+
+ done:
+
+    if (status != SUCCESS)
+        JpmcdsErrMsgFailure(routine);
+
+    return status;
+}
+
+
+/*
+***************************************************************************
+** Runs tasks until none are left.
+***************************************************************************
+*/
+static void parallelJobRun(TParallelJob *job)
+{
+    long i;
+
+    for (;;)
+    {
+        JpmcdsMutexLock(&job->lock);
+        i = job->next;
+        if (i < job->n)
+            ++job->next;
+        JpmcdsMutexUnlock(&job->lock);
+
+        if (i >= job->n)
+            break;
+
+        job->func(job->data, i);
+    }
+}
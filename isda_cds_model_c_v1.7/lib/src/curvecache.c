@@ -0,0 +1,350 @@
+/*
+ * ISDA CDS Standard Model
+ *
+ * Copyright (C) 2009 International Swaps and Derivatives Association, Inc.
+ * Developed and supported in collaboration with Markit
+ * 
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the ISDA CDS Standard Model Public License.
+ */
+
+#include "curvecache.h"
+#include "timeline.h"
+#include "cxzerocurve.h"
+#include "macros.h"
+#include "cerror.h"
+#include "datelist.h"
+
+
+/*
+***************************************************************************
+** Initialises a cache which remembers nothing and has no critical dates.
+***************************************************************************
+*/
+void JpmcdsCurvePairCacheInit
+(TCurvePairCache *cache,
+ TDate            today,
+ TCurve          *discCurve,
+ TCurve          *spreadCurve)
+{
+    cache->today         = today;
+    cache->discCurve     = discCurve;
+    cache->spreadCurve   = spreadCurve;
+    cache->criticalDates = NULL;
+    cache->firstDate     = today;
+    cache->numDates      = 0;
+    cache->discount      = NULL;
+    cache->survival      = NULL;
+    cache->spreadNode    = 0;
+    cache->discPrepared  = NULL;
+    cache->spreadPrepared = NULL;
+    cache->vectorIntegrals = FALSE;
+    cache->arena         = NULL;
+}
+
+
+/*
+***************************************************************************
+** Prepares both curves of a cache, leaving a curve unprepared when it
+** cannot be prepared.
+***************************************************************************
+*/
+int JpmcdsCurvePairCachePrepare
+(TCurvePairCache *cache)
+{
+    static char routine[] = "JpmcdsCurvePairCachePrepare";
+    int         status    = FAILURE;
+
+    REQUIRE (cache != NULL);
+
+    /* a curve with repeated dates is valued with JpmcdsZeroPrice, as it
+       always was */
+    if (cache->discPrepared == NULL &&
+        JpmcdsPreparedCurveValid (cache->discCurve))
+    {
+        cache->discPrepared = JpmcdsPreparedCurveMake (cache->discCurve);
+        if (cache->discPrepared == NULL)
+            goto done;
+    }
+
+    if (cache->spreadPrepared == NULL &&
+        JpmcdsPreparedCurveValid (cache->spreadCurve))
+    {
+        cache->spreadPrepared = JpmcdsPreparedCurveMake (cache->spreadCurve);
+        if (cache->spreadPrepared == NULL)
+            goto done;
+    }
+
+    status = SUCCESS;
+
+ done:
+
+    if (status != SUCCESS)
+        JpmcdsErrMsgFailure (routine);
+
+    return status;
+}
+
+
+/*
+***************************************************************************
+** Frees the memory held by a cache, but not the cache itself.
+***************************************************************************
+*/
+void JpmcdsCurvePairCacheClear
+(TCurvePairCache *cache)
+{
+    if (cache != NULL)
+    {
+        JpmcdsFreeDateList (cache->criticalDates);
+        FREE (cache->discount);
+        FREE (cache->survival);
+        JpmcdsPreparedCurveFree (cache->discPrepared);
+        JpmcdsPreparedCurveFree (cache->spreadPrepared);
+        cache->criticalDates  = NULL;
+        cache->discount       = NULL;
+        cache->survival       = NULL;
+        cache->discPrepared   = NULL;
+        cache->spreadPrepared = NULL;
+        cache->numDates       = 0;
+    }
+}
+
+
+/*
+***************************************************************************
+** Chooses whether the legs valued with a cache use the segment integrals.
+***************************************************************************
+*/
+void JpmcdsCurvePairCacheSetVectorIntegrals
+(TCurvePairCache *cache,
+ TBoolean         vectorIntegrals)
+{
+    cache->vectorIntegrals = vectorIntegrals;
+}
+
+
+/*
+***************************************************************************
+** Gives a cache an arena for the scratch memory of the legs.
+***************************************************************************
+*/
+void JpmcdsCurvePairCacheSetArena
+(TCurvePairCache *cache,
+ TArena          *arena)
+{
+    cache->arena = arena;
+}
+
+
+/*
+***************************************************************************
+** Makes a cache which remembers factors for dates in [firstDate,lastDate]
+** and holds the critical dates of both curves.
+***************************************************************************
+*/
+TCurvePairCache* JpmcdsCurvePairCacheMake
+(TDate            today,
+ TDate            firstDate,
+ TDate            lastDate,
+ TCurve          *discCurve,
+ TCurve          *spreadCurve)
+{
+    static char routine[] = "JpmcdsCurvePairCacheMake";
+    int         status    = FAILURE;
+
+    TCurvePairCache *cache = NULL;
+
+    REQUIRE (discCurve != NULL);
+    REQUIRE (spreadCurve != NULL);
+    REQUIRE (lastDate >= firstDate);
+
+    cache = NEW(TCurvePairCache);
+    if (cache == NULL)
+        goto done;
+
+    JpmcdsCurvePairCacheInit (cache, today, discCurve, spreadCurve);
+
+    cache->criticalDates = JpmcdsRiskyCriticalDates (discCurve, spreadCurve);
+    if (cache->criticalDates == NULL)
+        goto done;
+
+    cache->firstDate = firstDate;
+    cache->numDates  = lastDate - firstDate + 1;
+    cache->discount  = NEW_ARRAY(double, cache->numDates);
+    cache->survival  = NEW_ARRAY(double, cache->numDates);
+    if (cache->discount == NULL || cache->survival == NULL)
+        goto done;
+
+    if (JpmcdsCurvePairCachePrepare (cache) != SUCCESS)
+        goto done;
+
+    status = SUCCESS;
+
+ done:
+
+    if (status != SUCCESS)
+    {
+        JpmcdsErrMsgFailure (routine);
+        JpmcdsCurvePairCacheFree (cache);
+        cache = NULL;
+    }
+
+    return cache;
+}
+
+
+/*
+***************************************************************************
+** Frees a cache made by JpmcdsCurvePairCacheMake.
+***************************************************************************
+*/
+void JpmcdsCurvePairCacheFree(TCurvePairCache *cache)
+{
+    if (cache != NULL)
+    {
+        JpmcdsCurvePairCacheClear (cache);
+        FREE (cache);
+    }
+}
+
+
+/*
+***************************************************************************
+** Evaluates factors from the prepared curves when there are any.
+***************************************************************************
+*/
+static double cacheDiscount
+(TCurvePairCache *cache,
+ TDate            date)
+{
+    if (cache->discPrepared != NULL)
+        return JpmcdsPreparedForwardZeroPrice (cache->discPrepared, cache->today, date);
+    return JpmcdsForwardZeroPrice (cache->discCurve, cache->today, date);
+}
+
+static double cacheSurvival
+(TCurvePairCache *cache,
+ TDate            date)
+{
+    if (cache->spreadPrepared != NULL)
+        return JpmcdsPreparedForwardZeroPrice (cache->spreadPrepared, cache->today, date);
+    return JpmcdsForwardZeroPrice (cache->spreadCurve, cache->today, date);
+}
+
+
+
+/*
+***************************************************************************
+** Returns the discount factor from today to the given date.
+**
+** A discount factor is never zero, so zero marks an empty slot.
+***************************************************************************
+*/
+double JpmcdsCurvePairCacheDiscount
+(TCurvePairCache *cache,
+ TDate            date)
+{
+    long idx = date - cache->firstDate;
+
+    if (idx >= 0 && idx < cache->numDates)
+    {
+        if (cache->discount[idx] == 0.0)
+        {
+            cache->discount[idx] = cacheDiscount (cache, date);
+        }
+        return cache->discount[idx];
+    }
+
+    return cacheDiscount (cache, date);
+}
+
+
+/*
+***************************************************************************
+** Returns the survival probability from today to the given date.
+**
+** A survival probability which underflows to zero is simply evaluated
+** again on each call, which gives the same result.
+***************************************************************************
+*/
+double JpmcdsCurvePairCacheSurvival
+(TCurvePairCache *cache,
+ TDate            date)
+{
+    long idx = date - cache->firstDate;
+
+    if (idx >= 0 && idx < cache->numDates)
+    {
+        if (cache->survival[idx] == 0.0)
+        {
+            cache->survival[idx] = cacheSurvival (cache, date);
+        }
+        return cache->survival[idx];
+    }
+
+    return cacheSurvival (cache, date);
+}
+
+
+/*
+***************************************************************************
+** Returns the survival probability and the discount factor from today to
+** each of an array of dates.
+***************************************************************************
+*/
+void JpmcdsCurvePairCacheFactors
+(TCurvePairCache *cache,
+ long             numDates,
+ TDate           *dates,
+ double          *survival,
+ double          *discount)
+{
+    long i;
+
+    for (i = 0; i < numDates; ++i)
+    {
+        survival[i] = JpmcdsCurvePairCacheSurvival (cache, dates[i]);
+        discount[i] = JpmcdsCurvePairCacheDiscount (cache, MAX(cache->today, dates[i]));
+    }
+}
+
+
+/*
+***************************************************************************
+** Returns the survival probability and the discount factor from today to
+** each date of a timeline view.
+**
+** The dates between the two ends of the view are read where they are.
+***************************************************************************
+*/
+void JpmcdsCurvePairCacheViewFactors
+(TCurvePairCache *cache,
+ TTimeLineView   *view,
+ double          *survival,
+ double          *discount)
+{
+    long n = JPMCDS_TIMELINE_VIEW_SIZE (view);
+
+    JpmcdsCurvePairCacheFactors (cache, 1, &view->startDate,
+                                 survival, discount);
+    JpmcdsCurvePairCacheFactors (cache, n - 2, view->dates + view->begin,
+                                 survival + 1, discount + 1);
+    JpmcdsCurvePairCacheFactors (cache, 1, &view->endDate,
+                                 survival + n - 1, discount + n - 1);
+}
+
+
+/*
+***************************************************************************
+** Returns the derivative of the log of the survival probability from
+** today to the given date with respect to the rate of point spreadNode.
+***************************************************************************
+*/
+double JpmcdsCurvePairCacheSurvivalLogDeriv
+(TCurvePairCache *cache,
+ TDate            date)
+{
+    return JpmcdsLogZeroPriceDeriv (cache->spreadCurve, date, cache->spreadNode) -
+        JpmcdsLogZeroPriceDeriv (cache->spreadCurve, cache->today, cache->spreadNode);
+}
@@ -31,6 +31,8 @@
 
 static int zcInterpRate (TCurve*, TDate, long, long, double*);
 static int zcRateCC (TCurve*, int, double*);
+static int zcRateCCDeriv (TCurve*, int, double*);
+static double zcInterpWeight (TCurve*, TDate, long, long, long);
 
 
 /*
@@ -75,6 +77,131 @@ EXPORT double JpmcdsZeroPrice
 }
 
 
+/*
+***************************************************************************
+** Calculates the zero prices for an array of dates in ascending order.
+**
+** Follows JpmcdsZeroRate and zcInterpRate for each date, with the curve
+** point found by advancing from that of the previous date, and with the
+** continuously compounded rates of the segment converted once for all the
+** dates which fall in it.
+***************************************************************************
+*/
+int JpmcdsZeroPrices
+(TCurve* zeroCurve,
+ long    numDates,
+ TDate  *dates,
+ double *prices,
+ double *fwdRates)
+{
+    static char routine[] = "JpmcdsZeroPrices";
+    int         status    = FAILURE;
+
+    long        numItems;
+    long        hi = 0;
+    long        segHi = -1;
+    long        i;
+    double      z1 = 0.0;
+    double      z2 = 0.0;
+
+    REQUIRE (zeroCurve != NULL);
+    REQUIRE (zeroCurve->fNumItems > 0);
+    REQUIRE (zeroCurve->fArray != NULL);
+    REQUIRE (numDates >= 0);
+    REQUIRE (numDates == 0 || (dates != NULL && prices != NULL));
+
+    numItems = zeroCurve->fNumItems;
+
+    for (i = 0; i < numDates; ++i)
+    {
+        TDate  date = dates[i];
+        double rate;
+
+        if (i > 0 && date < dates[i-1])
+        {
+            JpmcdsErrMsg ("%s: Dates must be in ascending order.\n", routine);
+            goto done;
+        }
+
+        /* first point on or after date */
+        while (hi < numItems && zeroCurve->fArray[hi].fDate < date)
+            ++hi;
+
+        if (hi < numItems && zeroCurve->fArray[hi].fDate == date)
+        {
+            /* date found in zeroDates */
+            if (zcRateCC (zeroCurve, hi, &rate) != SUCCESS)
+                goto done;
+        }
+        else if (hi == 0 || numItems == 1)
+        {
+            /* date before start of zeroDates, or only one point */
+            if (zcRateCC (zeroCurve, 0, &rate) != SUCCESS)
+                goto done;
+        }
+        else
+        {
+            /* between points, or extrapolated using the last segment */
+            long   seg = (hi < numItems ? hi : numItems - 1);
+            long   t1  = zeroCurve->fArray[seg-1].fDate - zeroCurve->fBaseDate;
+            long   t2  = zeroCurve->fArray[seg].fDate - zeroCurve->fBaseDate;
+            long   t   = date - zeroCurve->fBaseDate;
+            double z1t1;
+            double z2t2;
+
+            if (seg != segHi)
+            {
+                if (zcRateCC (zeroCurve, seg-1, &z1) != SUCCESS ||
+                    zcRateCC (zeroCurve, seg, &z2) != SUCCESS)
+                    goto done;
+                segHi = seg;
+            }
+
+            /* as zcInterpRate */
+            z1t1 = z1 * t1;
+            z2t2 = z2 * t2;
+            if (t == 0 && t2 == 0)
+            {
+                rate = z2;
+            }
+            else
+            {
+                double zt;
+
+                if (t == 0)
+                    t = 1;
+                zt   = z1t1 + (z2t2 - z1t1) * (double)(t - t1) / (double)(t2 - t1);
+                rate = zt / t;
+            }
+        }
+
+        /* as JpmcdsZeroPrice */
+        prices[i] = exp(-rate * ((date - zeroCurve->fBaseDate) / 365.0));
+    }
+
+    if (fwdRates != NULL)
+    {
+        for (i = 0; i + 1 < numDates; ++i)
+        {
+            if (dates[i+1] == dates[i])
+                fwdRates[i] = 0.0;
+            else
+                fwdRates[i] = log(prices[i]/prices[i+1]) /
+                    ((double)(dates[i+1] - dates[i])/365.0);
+        }
+    }
+
+    status = SUCCESS;
+
+ done:
+
+    if (status != SUCCESS)
+        JpmcdsErrMsgFailure (routine);
+
+    return status;
+}
+
+
 /*
 ***************************************************************************
 ** Calculates the zero rate for a given date using ACT/365F and continously
@@ -159,6 +286,259 @@ double JpmcdsZeroRate
 }
 
 
+/*
+***************************************************************************
+** Calculates the derivative of the log of the zero price for a given date
+** with respect to the rate of point idx of the curve.
+**
+** The curve must be continuously compounded ACT/365F, so that the zero
+** rate for the date is linear in the rates of the curve. The weights
+** follow the interpolation and extrapolation of JpmcdsZeroRate.
+**
+** Returns NaN for errors.
+***************************************************************************
+*/
+double JpmcdsLogZeroPriceDeriv
+(TCurve* zeroCurve,
+ TDate   date,
+ long    idx)
+{
+    static char routine[] = "JpmcdsLogZeroPriceDeriv";
+    int         status    = FAILURE;
+
+    long        exact;
+    long        lo;
+    long        hi;
+    double      weight = 0.0;
+
+    REQUIRE (zeroCurve != NULL);
+    REQUIRE (zeroCurve->fNumItems > 0);
+    REQUIRE (zeroCurve->fArray != NULL);
+    REQUIRE (IS_EQUAL(zeroCurve->fBasis, JPMCDS_CONTINUOUS_BASIS));
+    REQUIRE (zeroCurve->fDayCountConv == JPMCDS_ACT_365F);
+    REQUIRE (idx >= 0 && idx < zeroCurve->fNumItems);
+
+    if (JpmcdsBinarySearchLong (date,
+                            &zeroCurve->fArray[0].fDate,
+                            sizeof(TRatePt),
+                            zeroCurve->fNumItems,
+                            &exact,
+                            &lo,
+                            &hi) != SUCCESS) 
+        goto done;
+
+    if (exact >= 0)
+    {
+        weight = (exact == idx ? 1.0 : 0.0);
+    }
+    else if (lo < 0)
+    {
+        weight = (idx == 0 ? 1.0 : 0.0);
+    }
+    else if (hi >= zeroCurve->fNumItems)
+    {
+        if (zeroCurve->fNumItems == 1)
+            weight = (idx == 0 ? 1.0 : 0.0);
+        else
+            weight = zcInterpWeight (zeroCurve, date,
+                                     zeroCurve->fNumItems-2,
+                                     zeroCurve->fNumItems-1,
+                                     idx);
+    }
+    else
+    {
+        weight = zcInterpWeight (zeroCurve, date, lo, hi, idx);
+    }
+
+    status = SUCCESS;
+
+ done:
+
+    if (status != SUCCESS)
+    {
+        JpmcdsErrMsgFailure (routine);
+        return NaN;
+    }
+
+    return -weight * (date - zeroCurve->fBaseDate) / 365.0;
+}
+
+
+/*
+***************************************************************************
+** Adds adjoint times the derivative of the log of the zero price for a
+** given date with respect to the rate of each point of the curve to grad.
+**
+** The points and weights are those of JpmcdsLogZeroPriceDeriv, which are
+** derivatives with respect to the continuously compounded rates. They are
+** chained to the rates of the curve by zcRateCCDeriv.
+***************************************************************************
+*/
+int JpmcdsLogZeroPriceAdjoint
+(TCurve* zeroCurve,
+ TDate   date,
+ double  adjoint,
+ double *grad)
+{
+    static char routine[] = "JpmcdsLogZeroPriceAdjoint";
+    int         status    = FAILURE;
+
+    long        exact;
+    long        lo;
+    long        hi;
+    long        idx;
+    double      time;
+
+    REQUIRE (zeroCurve != NULL);
+    REQUIRE (zeroCurve->fNumItems > 0);
+    REQUIRE (zeroCurve->fArray != NULL);
+    REQUIRE (grad != NULL);
+
+    if (JpmcdsBinarySearchLong (date,
+                            &zeroCurve->fArray[0].fDate,
+                            sizeof(TRatePt),
+                            zeroCurve->fNumItems,
+                            &exact,
+                            &lo,
+                            &hi) != SUCCESS) 
+        goto done;
+
+    /* the rate for the date depends on points lo and hi only */
+    if (exact >= 0)
+    {
+        lo = exact;
+        hi = exact;
+    }
+    else if (lo < 0 || zeroCurve->fNumItems == 1)
+    {
+        lo = 0;
+        hi = 0;
+    }
+    else if (hi >= zeroCurve->fNumItems)
+    {
+        lo = zeroCurve->fNumItems-2;
+        hi = zeroCurve->fNumItems-1;
+    }
+
+    time = (date - zeroCurve->fBaseDate) / 365.0;
+
+    for (idx = lo; idx <= hi; ++idx)
+    {
+        double weight = (lo == hi ? 1.0 :
+                         zcInterpWeight (zeroCurve, date, lo, hi, idx));
+        double ccDeriv;
+
+        if (zcRateCCDeriv (zeroCurve, idx, &ccDeriv) != SUCCESS)
+            goto done;
+
+        grad[idx] -= adjoint * weight * time * ccDeriv;
+    }
+
+    status = SUCCESS;
+
+ done:
+
+    if (status != SUCCESS)
+        JpmcdsErrMsgFailure (routine);
+
+    return status;
+}
+
+
+/*
+***************************************************************************
+** Calculates the derivative of the rate interpolated by zcInterpRate with
+** respect to the rate of point idx.
+***************************************************************************
+*/
+static double zcInterpWeight
+(TCurve* zc, TDate date, long lo, long hi, long idx)
+{
+    long   t1;
+    long   t2;
+    long   t;
+    double w;
+
+    if (idx != lo && idx != hi)
+        return 0.0;
+
+    t1   = zc->fArray[lo].fDate - zc->fBaseDate;
+    t2   = zc->fArray[hi].fDate - zc->fBaseDate;
+    t    = date - zc->fBaseDate;
+
+    if (t == 0)
+    {
+        /* as zcInterpRate */
+        if (t2 == 0)
+            return (idx == hi ? 1.0 : 0.0);
+        t = 1;
+    }
+
+    w = (double)(t - t1) / (double)(t2 - t1);
+    if (idx == lo)
+        return t1 * (1.0 - w) / t;
+    return t2 * w / t;
+}
+
+
+/*
+***************************************************************************
+** Calculates the derivative of the rate given by zcRateCC with respect to
+** the rate of point idx, for the conversions JpmcdsConvertCompoundRate
+** makes to continuously compounded ACT/365F.
+***************************************************************************
+*/
+static int zcRateCCDeriv
+(TCurve *tc,
+ int     idx,
+ double *ccDeriv)
+{
+    static char routine[] = "zcRateCCDeriv";
+    int         status    = FAILURE;
+
+    double      dayFactor;
+
+    if (tc->fDayCountConv == JPMCDS_ACT_365F)
+    {
+        dayFactor = 1.0;
+    }
+    else if (tc->fDayCountConv == JPMCDS_ACT_360)
+    {
+        dayFactor = 365.0/360.0;
+    }
+    else
+    {
+        JpmcdsErrMsg ("%s: Can only convert between ACT/360 and ACT/365F day count "
+                      "conventions\n", routine);
+        goto done;
+    }
+
+    if (IS_EQUAL(tc->fBasis, JPMCDS_CONTINUOUS_BASIS))
+    {
+        *ccDeriv = dayFactor;
+    }
+    else if (tc->fBasis >= 1.0 && tc->fBasis <= 365.0)
+    {
+        *ccDeriv = dayFactor / (1.0 + tc->fArray[idx].fRate / tc->fBasis);
+    }
+    else
+    {
+        JpmcdsErrMsg ("%s: Input basis %f is not a compounding frequency\n",
+                      routine, tc->fBasis);
+        goto done;
+    }
+
+    status = SUCCESS;
+
+ done:
+
+    if (status != SUCCESS)
+        JpmcdsErrMsgFailure (routine);
+
+    return status;
+}
+
+
 /*
 ***************************************************************************
 ** Interpolates a rate segment of a zero curve expressed with continuously
@@ -19,6 +19,8 @@
 #include "ldate.h"
 #include "cerror.h"
 #include "cashflow.h"
+#include "curvecache.h"
+#include "segint.h"
 
 
 /*
@@ -37,121 +39,1278 @@ static int FeePaymentPVWithTimeLine
  long            accrueDCC,
  double          notional,
  double          couponRate,
- TCurve         *discCurve,
- TCurve         *spreadCurve,
+ TCurvePairCache *curves,
  TDateList      *tl,
  TBoolean        obsStartOfDay,
- double         *pv);
+ double         *pv,
+ double         *dpv);
+
+
+/*
+***************************************************************************
+** Calculates the accrued interest as of today
+***************************************************************************
+*/
+static int FeeLegAI
+(TFeeLeg      *fl,
+ TDate         today,
+ double       *ai);
+
+
+/*
+***************************************************************************
+** Calculates the PV of the accruals which occur on default.
+***************************************************************************
+*/
+static int AccrualOnDefaultPV
+(TDate            today,
+ TDate            stepinDate,
+ TDate            startDate,
+ TDate            endDate,
+ double           amount,
+ TCurvePairCache *curves,
+ TDateList       *criticalDates,
+ double          *pv,
+ double          *dpv);
+
+
+/*
+***************************************************************************
+** State of the reverse accumulation of JpmcdsFeeAndContingentLegPVAdjoint.
+**
+** The adjoints are those of the log of the survival probabilities and
+** discount factors. Each factor is relative to today, so the adjoints of
+** the log zero prices at today are the negative of their sums.
+***************************************************************************
+*/
+typedef struct
+{
+    TCdsLegsAdjoint *adjoint;
+    TCurve          *discCurve;
+    TCurve          *spreadCurve;
+    double           contingentBar;  /* adjoint of the protection sum */
+    double           feeBar;         /* adjoint of the fee leg sums */
+    double           todayDiscBar;
+    double           todaySpreadBar;
+} TLegsAdjointWalk;
+
+
+/*
+***************************************************************************
+** Adds the adjoints of the log survival probability to one date and the
+** log discount factor to another.
+***************************************************************************
+*/
+static int LegsAdjointAdd
+(TLegsAdjointWalk *walk,
+ TDate             survivalDate,
+ double            survivalBar,
+ TDate             discountDate,
+ double            discountBar);
+
+
+/*
+***************************************************************************
+** Values the legs for JpmcdsFeeAndContingentLegPVSteps and
+** JpmcdsFeeAndContingentLegPVAdjoint.
+***************************************************************************
+*/
+static int FeeAndContingentLegWalk
+(TFeeLeg         *fl,
+ TContingentLeg  *cl,
+ TDate            today,
+ TDate            stepinDate,
+ TDate            valueDate,
+ TCurvePairCache *curves,
+ double           recoveryRate,
+ TCdsLegsSteps   *from,
+ TDate            unchangedDate,
+ TCdsLegsSteps   *record,
+ TCdsLegsAdjoint *adjoint,
+ TCdsLegsFlat    *flat,
+ TCdsLegsPV      *legs);
+
+
+/*
+***************************************************************************
+** Walks the timeline of one interval for JpmcdsFeeAndContingentLegPV.
+***************************************************************************
+*/
+static int LegsIntervalPV
+(TDate            today,
+ TDate            startDate,
+ TDate            endDate,
+ TDate            protStartDate,
+ TDate            protEndDate,
+ TBoolean         accrues,
+ TDate            accStartDate,
+ double           accRate,
+ TCurvePairCache *curves,
+ TLegsAdjointWalk *walk,
+ TCdsLegsFlat    *flat,
+ double          *contingentPv,
+ double          *accrualPv);
+
+
+/*
+***************************************************************************
+** Calculates the PV of a fee leg with fixed fee payments.
+***************************************************************************
+*/
+int JpmcdsFeeLegPV
+(TFeeLeg      *fl,
+ TDate         today,
+ TDate         stepinDate,
+ TDate         valueDate,
+ TCurve       *discCurve,
+ TCurve       *spreadCurve,
+ TBoolean      payAccruedAtStart,
+ double       *pv)
+{
+    static char routine[] = "JpmcdsFeeLegPV";
+    int         status    = FAILURE;
+
+    TCurvePairCache curves;
+
+    REQUIRE (discCurve != NULL);
+    REQUIRE (spreadCurve != NULL);
+
+    JpmcdsCurvePairCacheInit (&curves, today, discCurve, spreadCurve);
+
+    if (JpmcdsFeeLegPVWithCache (fl,
+                                 today,
+                                 stepinDate,
+                                 valueDate,
+                                 &curves,
+                                 payAccruedAtStart,
+                                 pv) != SUCCESS)
+        goto done;
+
+    status = SUCCESS;
+
+ done:
+
+    if (status != SUCCESS)
+        JpmcdsErrMsgFailure (routine);
+
+    return status;
+}
+
+
+/*
+***************************************************************************
+** Calculates the PV of a fee leg with fixed fee payments using the
+** factors and critical dates of a curve pair cache.
+***************************************************************************
+*/
+int JpmcdsFeeLegPVWithCache
+(TFeeLeg         *fl,
+ TDate            today,
+ TDate            stepinDate,
+ TDate            valueDate,
+ TCurvePairCache *curves,
+ TBoolean         payAccruedAtStart,
+ double          *pv)
+{
+    static char routine[] = "JpmcdsFeeLegPVWithCache";
+    int         status    = FAILURE;
+
+    if (JpmcdsFeeLegPVWithDeriv (fl,
+                                 today,
+                                 stepinDate,
+                                 valueDate,
+                                 curves,
+                                 payAccruedAtStart,
+                                 pv,
+                                 NULL) != SUCCESS)
+        goto done;
+
+    status = SUCCESS;
+
+ done:
+
+    if (status != SUCCESS)
+        JpmcdsErrMsgFailure (routine);
+
+    return status;
+}
+
+
+/*
+***************************************************************************
+** Calculates the PV of a fee leg with fixed fee payments and optionally
+** its derivative with respect to the rate of point curves->spreadNode of
+** the spread curve.
+**
+** Payments whose accrual ends on or before the step-in date are worth
+** nothing, so the valuation starts at the first live payment, found by
+** binary search, and the timeline starts within its accrual period.
+***************************************************************************
+*/
+int JpmcdsFeeLegPVWithDeriv
+(TFeeLeg         *fl,
+ TDate            today,
+ TDate            stepinDate,
+ TDate            valueDate,
+ TCurvePairCache *curves,
+ TBoolean         payAccruedAtStart,
+ double          *pv,
+ double          *dpv)
+{
+    static char routine[] = "JpmcdsFeeLegPVWithDeriv";
+    int         status    = FAILURE;
+    int         i;
+    double      myPv;
+    double      myDpv;
+    double      valueDatePv;
+    TDateList  *tl = NULL;
+    TDateList  *criticalDates = NULL;
+    TDateList   arenaTl;
+    TDate       matDate;
+    long        exact;
+    long        lo;
+    long        first;
+
+    REQUIRE (fl != NULL);
+    REQUIRE (curves != NULL);
+    REQUIRE (curves->today == today);
+    REQUIRE (pv != NULL);
+    REQUIRE (valueDate >= today);
+    REQUIRE (stepinDate >= today);
+
+    myPv  = 0.0;
+    myDpv = 0.0;
+
+    matDate = (fl->obsStartOfDay == TRUE ? 
+               fl->accEndDates[fl->nbDates - 1] - 1 :
+               fl->accEndDates[fl->nbDates - 1]);
+
+    if(today > matDate || stepinDate > matDate)
+    {
+        status = SUCCESS;
+        *pv = 0;
+        if (dpv != NULL)
+            *dpv = 0;
+        goto done;
+    }
+
+    /* the first payment whose accrual ends after stepinDate */
+    if (JpmcdsBinarySearchLong (stepinDate, fl->accEndDates, sizeof(TDate),
+                                fl->nbDates, &exact, &lo, &first) != SUCCESS)
+        goto done;
+
+    if (curves->criticalDates != NULL &&
+        (first > 0 || !fl->obsStartOfDay || fl->nbDates == 1))
+    {
+        /* truncating the shared critical dates for each payment gives
+           the same timelines as the risky timeline of the whole leg
+
+           except when the first payment is observed from the day before
+           the start of the leg, when the start of the leg is a point of
+           its timeline inside the first payment */
+        criticalDates = curves->criticalDates;
+    }
+    else if (fl->nbDates - first > 1)
+    {
+        /* it is more efficient to compute the timeLine just the once
+           and truncate it for each payment
+
+           after the first payment the timeline starts where the first live
+           period is observed from, which truncates to the same timelines */
+        TDate startDate = first == 0 ? fl->accStartDates[0] :
+            fl->accStartDates[first] + (fl->obsStartOfDay ? -1 : 0);
+        TDate endDate   = fl->accEndDates[fl->nbDates-1];
+        
+        if (curves->arena != NULL)
+        {
+            /* the same dates in scratch memory from the arena - there
+               are no more than the points of both curves and the ends */
+            long maxDates = curves->discCurve->fNumItems +
+                            curves->spreadCurve->fNumItems + 2;
+            long numDates;
+
+            arenaTl.fArray = (TDate*)JpmcdsArenaAlloc (curves->arena,
+                                                       maxDates * sizeof(TDate));
+            if (arenaTl.fArray == NULL)
+                goto done;
+
+            if (JpmcdsRiskyTimeLineToBuffer (startDate, endDate,
+                                             curves->discCurve,
+                                             curves->spreadCurve,
+                                             NULL, maxDates, arenaTl.fArray,
+                                             &numDates) != SUCCESS)
+                goto done;
+
+            arenaTl.fNumItems = (int)numDates;
+            criticalDates = &arenaTl;
+        }
+        else
+        {
+            tl = JpmcdsRiskyTimeLine(startDate,
+                                     endDate,
+                                     curves->discCurve,
+                                     curves->spreadCurve);
+
+            if (tl == NULL)
+                goto done;
+
+            criticalDates = tl;
+        }
+    }
+
+    for (i = (int)first; i < fl->nbDates; ++i)
+    {
+        double thisPv = 0;
+        double thisDpv = 0;
+        
+        if (FeePaymentPVWithTimeLine (fl->accrualPayConv,
+                                      today,
+                                      stepinDate,
+                                      fl->accStartDates[i],
+                                      fl->accEndDates[i],
+                                      fl->payDates[i],
+                                      fl->dcc,
+                                      fl->notional,
+                                      fl->couponRate,
+                                      curves,
+                                      criticalDates,
+                                      fl->obsStartOfDay,
+                                      &thisPv,
+                                      dpv == NULL ? NULL : &thisDpv) != SUCCESS)
+            goto done;
+
+        myPv += thisPv;
+        myDpv += thisDpv;
+    }
+
+    valueDatePv = JpmcdsCurvePairCacheDiscount (curves, valueDate);
+
+    *pv = myPv / valueDatePv;
+    if (dpv != NULL)
+        *dpv = myDpv / valueDatePv;
+    
+    if(payAccruedAtStart) /* clean price */
+    {
+        double ai;
+        if(FeeLegAI(fl, stepinDate, &ai) == FAILURE)
+        {
+           JpmcdsErrMsg ("%s: accrued interest calculation failed.\n", routine);
+           goto done;
+        }
+        *pv -= ai;
+    }
+
+    status = SUCCESS;
+
+ done:
+
+    if (status != SUCCESS)
+        JpmcdsErrMsgFailure (routine);
+
+    JpmcdsFreeDateList (tl);
+
+    return status;
+}
+
+
+/*
+***************************************************************************
+** Values a fee leg and a contingent leg in one walk along their shared
+** timeline.
+**
+** The walk visits the accrual periods in order. Each period, and each
+** gap before a period where only protection is live, is one interval
+** whose timeline is built once and used for the accrual on default of
+** the period and for any protection within it.
+***************************************************************************
+*/
+int JpmcdsFeeAndContingentLegPV
+(TFeeLeg         *fl,
+ TContingentLeg  *cl,
+ TDate            today,
+ TDate            stepinDate,
+ TDate            valueDate,
+ TCurvePairCache *curves,
+ double           recoveryRate,
+ TCdsLegsPV      *legs)
+{
+    return FeeAndContingentLegWalk (fl, cl, today, stepinDate, valueDate,
+                                    curves, recoveryRate, NULL, 0, NULL, NULL,
+                                    NULL, legs);
+}
+
+
+/*
+***************************************************************************
+** Makes an empty record of steps.
+***************************************************************************
+*/
+TCdsLegsSteps* JpmcdsCdsLegsStepsMake
+(long             maxSteps)
+{
+    static char routine[] = "JpmcdsCdsLegsStepsMake";
+    int         status    = FAILURE;
+
+    TCdsLegsSteps *p = NULL;
+
+    REQUIRE (maxSteps >= 0);
+
+    p = NEW(TCdsLegsSteps);
+    if (p == NULL)
+        goto done;
+
+    p->maxSteps     = maxSteps;
+    p->nbSteps      = 0;
+    p->lastDates    = NEW_ARRAY(TDate, MAX(maxSteps, 1));
+    p->protDone     = NEW_ARRAY(TDate, MAX(maxSteps, 1));
+    p->paymentsPv   = NEW_ARRAY(double, MAX(maxSteps, 1));
+    p->accrualPv    = NEW_ARRAY(double, MAX(maxSteps, 1));
+    p->contingentPv = NEW_ARRAY(double, MAX(maxSteps, 1));
+    if (p->lastDates == NULL || p->protDone == NULL ||
+        p->paymentsPv == NULL || p->accrualPv == NULL ||
+        p->contingentPv == NULL)
+        goto done;
+
+    status = SUCCESS;
+
+ done:
+
+    if (status != SUCCESS)
+    {
+        JpmcdsErrMsgFailure (routine);
+        JpmcdsCdsLegsStepsFree (p);
+        p = NULL;
+    }
+
+    return p;
+}
+
+
+/*
+***************************************************************************
+** Frees a record of steps.
+***************************************************************************
+*/
+void JpmcdsCdsLegsStepsFree
+(TCdsLegsSteps   *steps)
+{
+    if (steps != NULL)
+    {
+        FREE (steps->lastDates);
+        FREE (steps->protDone);
+        FREE (steps->paymentsPv);
+        FREE (steps->accrualPv);
+        FREE (steps->contingentPv);
+        FREE (steps);
+    }
+}
+
+
+/*
+***************************************************************************
+** Values a fee leg and a contingent leg, resuming an earlier walk.
+***************************************************************************
+*/
+int JpmcdsFeeAndContingentLegPVSteps
+(TFeeLeg         *fl,
+ TContingentLeg  *cl,
+ TDate            today,
+ TDate            stepinDate,
+ TDate            valueDate,
+ TCurvePairCache *curves,
+ double           recoveryRate,
+ TCdsLegsSteps   *from,
+ TDate            unchangedDate,
+ TCdsLegsSteps   *record,
+ TCdsLegsPV      *legs)
+{
+    return FeeAndContingentLegWalk (fl, cl, today, stepinDate, valueDate,
+                                    curves, recoveryRate, from, unchangedDate,
+                                    record, NULL, NULL, legs);
+}
+
+
+/*
+***************************************************************************
+** Values a fee leg and a contingent leg with the gradient of their
+** weighted sum.
+***************************************************************************
+*/
+int JpmcdsFeeAndContingentLegPVAdjoint
+(TFeeLeg         *fl,
+ TContingentLeg  *cl,
+ TDate            today,
+ TDate            stepinDate,
+ TDate            valueDate,
+ TCurvePairCache *curves,
+ double           recoveryRate,
+ TCdsLegsAdjoint *adjoint,
+ TCdsLegsPV      *legs)
+{
+    static char routine[] = "JpmcdsFeeAndContingentLegPVAdjoint";
+    int         status    = FAILURE;
+
+    REQUIRE (adjoint != NULL);
+    REQUIRE (adjoint->discGrad != NULL);
+    REQUIRE (adjoint->spreadGrad != NULL);
+
+    status = FeeAndContingentLegWalk (fl, cl, today, stepinDate, valueDate,
+                                      curves, recoveryRate, NULL, 0, NULL,
+                                      adjoint, NULL, legs);
+
+ done:
+
+    if (status != SUCCESS)
+        JpmcdsErrMsgFailure (routine);
+
+    return status;
+}
+
+
+/*
+***************************************************************************
+** Makes a record of the contributions to the values of the legs.
+**
+** Each interval of the walk has a timeline of the critical dates in it,
+** its ends and the ends of protection. An interval starts where the one
+** before it ends, so each critical date is in at most two of them, and
+** there are at most two intervals for each period and one after them.
+***************************************************************************
+*/
+TCdsLegsFlat* JpmcdsCdsLegsFlatMake
+(TFeeLeg         *fl,
+ TContingentLeg  *cl,
+ TDate            today,
+ TDate            stepinDate,
+ TDate            valueDate,
+ TCurvePairCache *curves)
+{
+    static char routine[] = "JpmcdsCdsLegsFlatMake";
+    int         status    = FAILURE;
+
+    TCdsLegsFlat *p = NULL;
+    TCdsLegsPV    legs;
+    long          numCritical;
+    long          i;
+    long          k;
+
+    REQUIRE (fl != NULL);
+    REQUIRE (curves != NULL);
+    REQUIRE (curves->discCurve != NULL);
+
+    if (curves->criticalDates != NULL)
+    {
+        numCritical = curves->criticalDates->fNumItems;
+    }
+    else
+    {
+        numCritical = curves->discCurve->fNumItems;
+        if (curves->spreadCurve != NULL)
+            numCritical += curves->spreadCurve->fNumItems;
+    }
+
+    p = NEW(TCdsLegsFlat);
+    if (p == NULL)
+        goto done;
+
+    p->maxSegments    = 2 * numCritical + 3 * (2 * fl->nbDates + 1);
+    p->nbSegments     = 0;
+    p->startTimes     = NEW_ARRAY(double, p->maxSegments);
+    p->endTimes       = NEW_ARRAY(double, p->maxSegments);
+    p->startDiscounts = NEW_ARRAY(double, p->maxSegments);
+    p->endDiscounts   = NEW_ARRAY(double, p->maxSegments);
+    p->fwdRates       = NEW_ARRAY(double, p->maxSegments);
+    p->protects       = NEW_ARRAY(TBoolean, p->maxSegments);
+    p->accRates       = NEW_ARRAY(double, p->maxSegments);
+    p->accStartTimes  = NEW_ARRAY(double, p->maxSegments);
+    p->accEndTimes    = NEW_ARRAY(double, p->maxSegments);
+    p->maxPayments    = MAX(fl->nbDates, 1);
+    p->nbPayments     = 0;
+    p->paymentTimes   = NEW_ARRAY(double, p->maxPayments);
+    p->paymentPvs     = NEW_ARRAY(double, p->maxPayments);
+    p->paymentSegments = NEW_ARRAY(long, p->maxPayments);
+    if (p->startTimes == NULL || p->endTimes == NULL ||
+        p->startDiscounts == NULL || p->endDiscounts == NULL ||
+        p->fwdRates == NULL || p->protects == NULL ||
+        p->accRates == NULL || p->accStartTimes == NULL ||
+        p->accEndTimes == NULL || p->paymentTimes == NULL ||
+        p->paymentPvs == NULL || p->paymentSegments == NULL)
+        goto done;
+
+    if (FeeAndContingentLegWalk (fl, cl, today, stepinDate, valueDate,
+                                 curves, 0.0, NULL, 0, NULL, NULL, p,
+                                 &legs) != SUCCESS)
+        goto done;
+
+    /* the segments and the payments are both in order of time, so the
+       segments of the payments are found in one pass */
+    k = 0;
+    for (i = 0; i < p->nbPayments; ++i)
+    {
+        while (k < p->nbSegments && p->endTimes[k] < p->paymentTimes[i])
+            ++k;
+        p->paymentSegments[i] = -1;
+        if (k < p->nbSegments && p->endTimes[k] == p->paymentTimes[i])
+            p->paymentSegments[i] = k;
+    }
+
+    status = SUCCESS;
+
+ done:
+
+    if (status != SUCCESS)
+    {
+        JpmcdsErrMsgFailure (routine);
+        JpmcdsCdsLegsFlatFree (p);
+        p = NULL;
+    }
+
+    return p;
+}
+
+
+/*
+***************************************************************************
+** Frees a record of the contributions to the values of the legs.
+***************************************************************************
+*/
+void JpmcdsCdsLegsFlatFree
+(TCdsLegsFlat    *flat)
+{
+    if (flat != NULL)
+    {
+        FREE (flat->startTimes);
+        FREE (flat->endTimes);
+        FREE (flat->startDiscounts);
+        FREE (flat->endDiscounts);
+        FREE (flat->fwdRates);
+        FREE (flat->protects);
+        FREE (flat->accRates);
+        FREE (flat->accStartTimes);
+        FREE (flat->accEndTimes);
+        FREE (flat->paymentTimes);
+        FREE (flat->paymentPvs);
+        FREE (flat->paymentSegments);
+        FREE (flat);
+    }
+}
+
+
+/*
+***************************************************************************
+** Values the legs of a record for a flat hazard rate.
+**
+** The integrals are those of LegsIntervalPV with lambda equal to the
+** hazard rate, written in terms of p = s * df at the ends of the segment
+** since s1/s0 = exp(-lambda * t). Each survival probability is found
+** from its time, so consecutive segments share one exponential, and a
+** payment shares that of the segment which ends at its observation.
+***************************************************************************
+*/
+int JpmcdsCdsLegsFlatPV
+(TCdsLegsFlat    *flat,
+ double           hazardRate,
+ double           recoveryRate,
+ TCdsLegsPV      *legs,
+ TCdsLegsPV      *dlegs)
+{
+    static char routine[] = "JpmcdsCdsLegsFlatPV";
+    int         status    = FAILURE;
+
+    double  lambda       = hazardRate;
+    double  contingentPv = 0.0;
+    double  accrualPv    = 0.0;
+    double  paymentsPv   = 0.0;
+    double  dContingent  = 0.0;
+    double  dAccrual     = 0.0;
+    double  dPayments    = 0.0;
+    double  s1           = 0.0;
+    long    k;
+    long    i            = 0;
+
+    REQUIRE (flat != NULL);
+    REQUIRE (legs != NULL);
+
+    for (k = 0; k < flat->nbSegments; ++k)
+    {
+        double T0 = flat->startTimes[k];
+        double T1 = flat->endTimes[k];
+        double s0;
+        double p0;
+        double p1;
+        double lf;
+        double inv;
+
+        /* the times are found from the same dates, so compare exactly */
+        if (k > 0 && T0 == flat->endTimes[k-1])
+            s0 = s1;
+        else
+            s0 = exp(-lambda * T0);
+        s1 = exp(-lambda * T1);
+
+        p0 = s0 * flat->startDiscounts[k];
+        p1 = s1 * flat->endDiscounts[k];
+        lf = lambda + flat->fwdRates[k];
+
+        if (flat->protects[k])
+        {
+            /* lambda/(lambda+fwdRate) * (p0 - p1) */
+            inv = 1.0 / lf;
+            contingentPv += lambda * inv * (p0 - p1);
+            dContingent  += flat->fwdRates[k] * inv * inv * (p0 - p1) +
+                lambda * inv * (T1 * p1 - T0 * p0);
+        }
+
+        if (flat->accRates[k] != 0.0)
+        {
+            /* lambda * accRate * (p0*g(t0) - p1*g(t1)) with
+               g(x) = (x + 1/lf)/lf as in AccrualOnDefaultPV */
+            double accRate = flat->accRates[k];
+            double g0;
+            double g1;
+            double dg0;
+            double dg1;
+
+            inv = 1.0 / (lf + 1.0e-50);
+            g0  = (flat->accStartTimes[k] + inv) * inv;
+            g1  = (flat->accEndTimes[k] + inv) * inv;
+            dg0 = -(flat->accStartTimes[k] + 2.0 * inv) * inv * inv;
+            dg1 = -(flat->accEndTimes[k] + 2.0 * inv) * inv * inv;
+
+            accrualPv += lambda * accRate * (p0 * g0 - p1 * g1);
+            dAccrual  += accRate * (p0 * g0 - p1 * g1) +
+                lambda * accRate * (p0 * (dg0 - T0 * g0) - p1 * (dg1 - T1 * g1));
+        }
+
+        /* payments without a segment are skipped here */
+        for (; i < flat->nbPayments && flat->paymentSegments[i] <= k; ++i)
+        {
+            if (flat->paymentSegments[i] == k)
+            {
+                double paymentPv = flat->paymentPvs[i] * s1;
+
+                paymentsPv += paymentPv;
+                dPayments  -= flat->paymentTimes[i] * paymentPv;
+            }
+        }
+    }
+
+    for (i = 0; i < flat->nbPayments; ++i)
+    {
+        if (flat->paymentSegments[i] < 0)
+        {
+            double paymentPv = flat->paymentPvs[i] *
+                exp(-lambda * flat->paymentTimes[i]);
+
+            paymentsPv += paymentPv;
+            dPayments  -= flat->paymentTimes[i] * paymentPv;
+        }
+    }
+
+    legs->contingentPV = contingentPv * (1.0 - recoveryRate) *
+        flat->notional / flat->valueDatePv;
+    legs->rpv01              = (paymentsPv + accrualPv) / flat->valueDatePv;
+    legs->accrualOnDefaultPV = accrualPv / flat->valueDatePv;
+    legs->accruedInterest    = flat->accruedInterest;
+
+    if (dlegs != NULL)
+    {
+        dlegs->contingentPV = dContingent * (1.0 - recoveryRate) *
+            flat->notional / flat->valueDatePv;
+        dlegs->rpv01              = (dPayments + dAccrual) / flat->valueDatePv;
+        dlegs->accrualOnDefaultPV = dAccrual / flat->valueDatePv;
+        dlegs->accruedInterest    = 0.0;
+    }
+
+    status = SUCCESS;
+
+ done:
+
+    if (status != SUCCESS)
+        JpmcdsErrMsgFailure (routine);
+
+    return status;
+}
+
+
+/*
+***************************************************************************
+** Walks along the legs, resuming an earlier walk if one is given, and
+** accumulating the gradient in reverse if adjoint is given.
+**
+** A step observes the survival at the end of its period, the discount
+** factor at its pay date and the timeline up to the end of the period.
+** The steps of from are reused while all of these are on or before
+** unchangedDate. The walk then continues exactly as it would have done
+** from the start, so the sums are added in the same order.
+**
+** The sums are linear in the contributions of the segments and the fee
+** payments, and the weights of the sums in the result are known before
+** the walk. So the adjoint of each contribution is known when it is
+** added, and the reverse accumulation is done along the walk itself.
+**
+** If flat is given, each contribution is also recorded in it. A walk
+** which resumes from earlier steps does not see all of them.
+***************************************************************************
+*/
+static int FeeAndContingentLegWalk
+(TFeeLeg         *fl,
+ TContingentLeg  *cl,
+ TDate            today,
+ TDate            stepinDate,
+ TDate            valueDate,
+ TCurvePairCache *curves,
+ double           recoveryRate,
+ TCdsLegsSteps   *from,
+ TDate            unchangedDate,
+ TCdsLegsSteps   *record,
+ TCdsLegsAdjoint *adjoint,
+ TCdsLegsFlat    *flat,
+ TCdsLegsPV      *legs)
+{
+    static char routine[] = "FeeAndContingentLegWalk";
+    int         status    = FAILURE;
+
+    TLegsAdjointWalk  adjointWalk;
+    TLegsAdjointWalk *walk = NULL;
+
+    double      paymentsPv   = 0.0;
+    double      accrualPv    = 0.0;
+    double      contingentPv = 0.0;
+    double      valueDatePv;
+    double      ai = 0.0;
+    TBoolean    feeLive;
+    TBoolean    protLive = FALSE;
+    TDate       protStartDate = 0;
+    TDate       protEndDate = 0;
+    TDate       protDone;
+    TDate       matDate;
+    TDate       lastDate = 0;
+    int         obsOffset;
+    int         firstStep = 0;
+    int         i;
+
+    REQUIRE (fl != NULL);
+    REQUIRE (fl->nbDates > 0);
+    REQUIRE (from == NULL || from->nbSteps <= fl->nbDates);
+    REQUIRE (record == NULL || (record != from && record->maxSteps >= fl->nbDates));
+    REQUIRE (flat == NULL || from == NULL);
+    REQUIRE (cl == NULL || cl->payType == PROT_PAY_DEF);
+    REQUIRE (curves != NULL);
+    REQUIRE (curves->today == today);
+    REQUIRE (legs != NULL);
+    REQUIRE (valueDate >= today);
+    REQUIRE (stepinDate >= today);
+
+    /* as in FeePaymentPVWithTimeLine */
+    obsOffset = fl->obsStartOfDay ? -1 : 0;
+    matDate   = fl->accEndDates[fl->nbDates - 1] + obsOffset;
+    feeLive   = today <= matDate && stepinDate <= matDate;
+
+    /* as in JpmcdsContingentLegPVWithDeriv and onePeriodIntegral */
+    if (cl != NULL && today <= cl->endDate)
+    {
+        int offset = cl->protectStart ? 1 : 0;
+        protStartDate = MAX(cl->startDate, stepinDate - offset);
+        protStartDate = MAX(protStartDate, today - offset);
+        protEndDate   = cl->endDate;
+        protLive      = protEndDate > protStartDate;
+    }
+
+    /* protection is integrated from protDone onwards */
+    protDone = protStartDate;
+
+    valueDatePv = JpmcdsCurvePairCacheDiscount (curves, valueDate);
 
+    if (adjoint != NULL)
+    {
+        walk = &adjointWalk;
+        walk->adjoint        = adjoint;
+        walk->discCurve      = curves->discCurve;
+        walk->spreadCurve    = curves->spreadCurve;
+        walk->contingentBar  = cl == NULL ? 0.0 :
+            adjoint->contingentWeight * (1.0 - recoveryRate) * cl->notional /
+            valueDatePv;
+        walk->feeBar         = adjoint->feeWeight / valueDatePv;
+        walk->todayDiscBar   = 0.0;
+        walk->todaySpreadBar = 0.0;
+    }
 
-/*
-***************************************************************************
-** Calculates the accrued interest as of today
-***************************************************************************
-*/
-static int FeeLegAI
-(TFeeLeg      *fl,
- TDate         today,
- double       *ai);
+    if (record != NULL)
+        record->nbSteps = 0;
+
+    if (flat != NULL)
+    {
+        flat->nbSegments = 0;
+        flat->nbPayments = 0;
+    }
+
+    /* steps which only saw the curves where they are unchanged */
+    while (feeLive && from != NULL && firstStep < from->nbSteps &&
+           from->lastDates[firstStep] <= unchangedDate)
+    {
+        if (record != NULL)
+        {
+            record->lastDates[firstStep]    = from->lastDates[firstStep];
+            record->protDone[firstStep]     = from->protDone[firstStep];
+            record->paymentsPv[firstStep]   = from->paymentsPv[firstStep];
+            record->accrualPv[firstStep]    = from->accrualPv[firstStep];
+            record->contingentPv[firstStep] = from->contingentPv[firstStep];
+            record->nbSteps = firstStep + 1;
+        }
+        ++firstStep;
+    }
+
+    if (firstStep > 0)
+    {
+        lastDate     = from->lastDates[firstStep-1];
+        protDone     = from->protDone[firstStep-1];
+        paymentsPv   = from->paymentsPv[firstStep-1];
+        accrualPv    = from->accrualPv[firstStep-1];
+        contingentPv = from->contingentPv[firstStep-1];
+    }
+
+    for (i = firstStep; feeLive && i < fl->nbDates; ++i)
+    {
+        double accTime;
+        double amount;
+        double survival;
+        double discount;
+        double paymentPv;
+        TDate  accStartDate = fl->accStartDates[i] + obsOffset;
+        TDate  accEndDate   = fl->accEndDates[i] + obsOffset;
+        TDate  subStartDate = MAX(stepinDate + obsOffset, accStartDate);
+
+        if (fl->accEndDates[i] <= stepinDate)
+            goto recordStep;
+
+        if (JpmcdsDayCountFraction (fl->accStartDates[i], fl->accEndDates[i],
+                                    fl->dcc, &accTime) != SUCCESS)
+            goto done;
+
+        amount    = fl->notional * accTime;
+        survival  = JpmcdsCurvePairCacheSurvival (curves, accEndDate);
+        discount  = JpmcdsCurvePairCacheDiscount (curves, fl->payDates[i]);
+        paymentPv = amount * survival * discount;
+        paymentsPv += paymentPv;
+
+        if (flat != NULL)
+        {
+            long k = flat->nbPayments;
+
+            REQUIRE (k < flat->maxPayments);
+            flat->paymentTimes[k] = (double)(accEndDate - today) / 365.0;
+            flat->paymentPvs[k]   = amount * discount;
+            flat->nbPayments      = k + 1;
+        }
+
+        if (walk != NULL &&
+            LegsAdjointAdd (walk, accEndDate, walk->feeBar * paymentPv,
+                            fl->payDates[i], walk->feeBar * paymentPv) != SUCCESS)
+            goto done;
+
+        lastDate = MAX(lastDate, MAX(accEndDate, fl->payDates[i]));
+
+        if (fl->accrualPayConv != ACCRUAL_PAY_ALL)
+            goto recordStep;
+
+        /* protection only, up to the start of this period */
+        if (protLive && protDone < MIN(subStartDate, protEndDate))
+        {
+            if (LegsIntervalPV (today, protDone, MIN(subStartDate, protEndDate),
+                                protStartDate, protEndDate,
+                                FALSE, 0, 0.0,
+                                curves, walk, flat, &contingentPv, NULL) != SUCCESS)
+                goto done;
+        }
+
+        if (LegsIntervalPV (today, subStartDate, accEndDate,
+                            MAX(protStartDate, protDone), protEndDate,
+                            TRUE,
+                            accStartDate,
+                            amount / ((double)(accEndDate - accStartDate) / 365.0),
+                            curves, walk, flat, &contingentPv, &accrualPv) != SUCCESS)
+            goto done;
+
+        protDone = MAX(protDone, accEndDate);
+
+    recordStep:
+        if (record != NULL)
+        {
+            record->lastDates[i]    = lastDate;
+            record->protDone[i]     = protDone;
+            record->paymentsPv[i]   = paymentsPv;
+            record->accrualPv[i]    = accrualPv;
+            record->contingentPv[i] = contingentPv;
+            record->nbSteps = i + 1;
+        }
+    }
+
+    /* protection beyond the accrual periods */
+    if (protLive && protDone < protEndDate)
+    {
+        if (LegsIntervalPV (today, protDone, protEndDate,
+                            protStartDate, protEndDate,
+                            FALSE, 0, 0.0,
+                            curves, walk, flat, &contingentPv, NULL) != SUCCESS)
+            goto done;
+    }
+
+    if (feeLive)
+    {
+        TFeeLeg unitFl = *fl;
+
+        unitFl.couponRate = 1.0;
+        if (FeeLegAI (&unitFl, stepinDate, &ai) != SUCCESS)
+            goto done;
+    }
+
+    legs->contingentPV = cl == NULL ? 0.0 :
+        contingentPv * (1.0 - recoveryRate) * cl->notional / valueDatePv;
+    legs->rpv01              = (paymentsPv + accrualPv) / valueDatePv;
+    legs->accrualOnDefaultPV = accrualPv / valueDatePv;
+    legs->accruedInterest    = ai;
+
+    if (flat != NULL)
+    {
+        flat->notional        = cl == NULL ? 0.0 : cl->notional;
+        flat->valueDatePv     = valueDatePv;
+        flat->accruedInterest = ai;
+    }
+
+    if (walk != NULL)
+    {
+        /* the weighted sum is divided by the discount factor to valueDate */
+        double value = adjoint->contingentWeight * legs->contingentPV +
+            adjoint->feeWeight * legs->rpv01;
+
+        if (LegsAdjointAdd (walk, today, 0.0, valueDate, -value) != SUCCESS)
+            goto done;
+
+        if (JpmcdsLogZeroPriceAdjoint (walk->spreadCurve, today,
+                                       walk->todaySpreadBar,
+                                       adjoint->spreadGrad) != SUCCESS ||
+            JpmcdsLogZeroPriceAdjoint (walk->discCurve, today,
+                                       walk->todayDiscBar,
+                                       adjoint->discGrad) != SUCCESS)
+            goto done;
+    }
+
+    status = SUCCESS;
+
+ done:
+
+    if (status != SUCCESS)
+        JpmcdsErrMsgFailure (routine);
+
+    return status;
+}
 
 
 /*
 ***************************************************************************
-** Calculates the PV of a fee leg with fixed fee payments.
+** Walks the timeline of [startDate, endDate] once. Adds the protection
+** integral for the parts in [protStartDate, protEndDate] to contingentPv
+** and, if the interval accrues, the accrual on default integral to
+** accrualPv. Both are as at today, per unit of loss and amount.
 ***************************************************************************
 */
-int JpmcdsFeeLegPV
-(TFeeLeg      *fl,
- TDate         today,
- TDate         stepinDate,
- TDate         valueDate,
- TCurve       *discCurve,
- TCurve       *spreadCurve,
- TBoolean      payAccruedAtStart,
- double       *pv)
+static int LegsIntervalPV
+(TDate            today,
+ TDate            startDate,
+ TDate            endDate,
+ TDate            protStartDate,
+ TDate            protEndDate,
+ TBoolean         accrues,
+ TDate            accStartDate,
+ double           accRate,
+ TCurvePairCache *curves,
+ TLegsAdjointWalk *walk,
+ TCdsLegsFlat    *flat,
+ double          *contingentPv,
+ double          *accrualPv)
 {
-    static char routine[] = "JpmcdsFeeLegPV";
+    static char routine[] = "LegsIntervalPV";
     int         status    = FAILURE;
-    int         i;
-    double      myPv;
-    double      valueDatePv;
-    TDateList  *tl = NULL;
-    TDate       matDate;
 
-    REQUIRE (spreadCurve != NULL);
+    TDate   buffer[JPMCDS_TIMELINE_BUFFER_SIZE];
+    TDate  *tl = buffer;
+    long    numDates;
+    long    i;
+    int     k;
+    double  s0;
+    double  s1;
+    double  df0;
+    double  df1;
+    double  s0Bar  = 0.0;   /* adjoints of the log factors at tl[i-1] */
+    double  df0Bar = 0.0;
 
-    REQUIRE (fl != NULL);
-    REQUIRE (discCurve != NULL);
-    REQUIRE (spreadCurve != NULL);
-    REQUIRE (pv != NULL);
-    REQUIRE (valueDate >= today);
-    REQUIRE (stepinDate >= today);
+    REQUIRE (endDate > startDate);
 
-    myPv = 0.0;
+    /* room is left for the ends of protection */
+    if (JpmcdsRiskyTimeLineToBuffer (startDate, endDate,
+                                     curves->discCurve, curves->spreadCurve,
+                                     curves->criticalDates,
+                                     JPMCDS_TIMELINE_BUFFER_SIZE - 2, buffer,
+                                     &numDates) != SUCCESS)
+        goto done;
 
-    if (fl->nbDates > 1)
+    if (numDates > JPMCDS_TIMELINE_BUFFER_SIZE - 2)
     {
-        /* it is more efficient to compute the timeLine just the once
-           and truncate it for each payment */
-        TDate startDate = fl->accStartDates[0];
-        TDate endDate   = fl->accEndDates[fl->nbDates-1];
-        
-        tl = JpmcdsRiskyTimeLine(startDate,
-                                 endDate,
-                                 discCurve,
-                                 spreadCurve);
+        long maxDates = numDates;
 
+        tl = NEW_ARRAY(TDate, maxDates + 2);
         if (tl == NULL)
             goto done;
+        if (JpmcdsRiskyTimeLineToBuffer (startDate, endDate,
+                                         curves->discCurve, curves->spreadCurve,
+                                         curves->criticalDates,
+                                         maxDates, tl,
+                                         &numDates) != SUCCESS)
+            goto done;
     }
 
-    matDate = (fl->obsStartOfDay == TRUE ? 
-               fl->accEndDates[fl->nbDates - 1] - 1 :
-               fl->accEndDates[fl->nbDates - 1]);
-
-    if(today > matDate || stepinDate > matDate)
+    /* protection must start and end on the timeline */
+    for (k = 0; k < 2; ++k)
     {
-        status = SUCCESS;
-        *pv = 0;
-        goto done;
+        TDate date = (k == 0 ? protStartDate : protEndDate);
+
+        if (date > startDate && date < endDate)
+        {
+            long j = numDates;
+            while (tl[j-1] > date)
+            {
+                tl[j] = tl[j-1];
+                --j;
+            }
+            if (tl[j-1] == date)
+            {
+                /* already there - undo the shift */
+                for (; j < numDates; ++j)
+                    tl[j] = tl[j+1];
+            }
+            else
+            {
+                tl[j] = date;
+                ++numDates;
+            }
+        }
     }
 
-    for (i = 0; i < fl->nbDates; ++i)
+    s1  = JpmcdsCurvePairCacheSurvival (curves, tl[0]);
+    df1 = JpmcdsCurvePairCacheDiscount (curves, MAX(today, tl[0]));
+
+    for (i = 1; i < numDates; ++i)
     {
-        double thisPv = 0;
-        
-        if (FeePaymentPVWithTimeLine (fl->accrualPayConv,
-                                      today,
-                                      stepinDate,
-                                      fl->accStartDates[i],
-                                      fl->accEndDates[i],
-                                      fl->payDates[i],
-                                      fl->dcc,
-                                      fl->notional,
-                                      fl->couponRate,
-                                      discCurve,
-                                      spreadCurve,
-                                      tl,
-                                      fl->obsStartOfDay,
-                                      &thisPv) != SUCCESS)
-            goto done;
+        double t;
+        double lambda;
+        double fwdRate;
+        double s1Bar  = 0.0;
+        double df1Bar = 0.0;
+        TBoolean protects;
 
-        myPv += thisPv;
-    }
+        s0  = s1;
+        df0 = df1;
+        s1  = JpmcdsCurvePairCacheSurvival (curves, tl[i]);
+        df1 = JpmcdsCurvePairCacheDiscount (curves, tl[i]);
+        t   = (double)(tl[i] - tl[i-1]) / 365.0;
 
-    valueDatePv = JpmcdsForwardZeroPrice (discCurve, today, valueDate);
+        lambda  = log(s0/s1)/t;
+        fwdRate = log(df0/df1)/t;
 
-    *pv = myPv / valueDatePv;
-    
-    if(payAccruedAtStart) /* clean price */
-    {
-        double ai;
-        if(FeeLegAI(fl, stepinDate, &ai) == FAILURE)
+        protects = tl[i-1] >= protStartDate && tl[i] <= protEndDate;
+
+        if (flat != NULL && (protects || accrues))
         {
-           JpmcdsErrMsg ("%s: accrued interest calculation failed.\n", routine);
-           goto done;
+            long k = flat->nbSegments;
+
+            REQUIRE (k < flat->maxSegments);
+            flat->startTimes[k]     = (double)(tl[i-1] - today) / 365.0;
+            flat->endTimes[k]       = (double)(tl[i] - today) / 365.0;
+            flat->startDiscounts[k] = df0;
+            flat->endDiscounts[k]   = df1;
+            flat->fwdRates[k]       = fwdRate;
+            flat->protects[k]       = protects;
+            flat->accRates[k]       = accrues ? accRate : 0.0;
+            flat->accStartTimes[k]  = accrues ?
+                (double)(tl[i-1] + 0.5 - accStartDate)/365.0 : 0.0;
+            flat->accEndTimes[k]    = accrues ?
+                (double)(tl[i] + 0.5 - accStartDate)/365.0 : 0.0;
+            flat->nbSegments        = k + 1;
         }
-        *pv -= ai;
+
+        if (protects)
+        {
+            /* as in onePeriodIntegral */
+            *contingentPv += lambda / (lambda + fwdRate) *
+                (1.0 - exp(-(lambda + fwdRate) * t)) * s0 * df0;
+
+            if (walk != NULL)
+            {
+                /* lambda/(lambda+fwdRate) * (s0*df0 - s1*df1) */
+                double lf    = lambda + fwdRate;
+                double ratio = lambda / lf;
+                double q     = (1.0 - exp(-lf * t)) * s0 * df0 / (lf * lf * t);
+                double bar   = walk->contingentBar;
+
+                s0Bar  += bar * (fwdRate * q + ratio * s0 * df0);
+                df0Bar += bar * (-lambda * q + ratio * s0 * df0);
+                s1Bar  += bar * (-fwdRate * q - ratio * s1 * df1);
+                df1Bar += bar * (lambda * q - ratio * s1 * df1);
+            }
+        }
+
+        if (accrues)
+        {
+            /* as in AccrualOnDefaultPV */
+            double t0 = (double)(tl[i-1] + 0.5 - accStartDate)/365.0;
+            double t1 = (double)(tl[i] + 0.5 - accStartDate)/365.0;
+            double lambdafwdRate = lambda + fwdRate + 1.0e-50;
+
+            *accrualPv += lambda * accRate * s0 * df0 * (
+                (t0 + 1.0/(lambdafwdRate))/(lambdafwdRate) -
+                (t1 + 1.0/(lambdafwdRate))/(lambdafwdRate) *
+                s1/s0 * df1/df0);
+
+            if (walk != NULL)
+            {
+                /* lambda * accRate * (s0*df0*g(t0) - s1*df1*g(t1)) with
+                   g(x) = (x + 1/lf)/lf, differentiated through lf too */
+                double lf   = lambdafwdRate;
+                double p0   = s0 * df0;
+                double p1   = s1 * df1;
+                double g0   = (t0 + 1.0/lf)/lf;
+                double g1   = (t1 + 1.0/lf)/lf;
+                double dg0  = -t0/(lf*lf) - 2.0/(lf*lf*lf);
+                double dg1  = -t1/(lf*lf) - 2.0/(lf*lf*lf);
+                double d    = (p0 * g0 - p1 * g1) / t;
+                double dlf  = (p0 * dg0 - p1 * dg1) / t;
+                double bar  = walk->feeBar * accRate;
+
+                s0Bar  += bar * (d + lambda * (dlf + p0 * g0));
+                df0Bar += bar * lambda * (dlf + p0 * g0);
+                s1Bar  += bar * (-d - lambda * (dlf + p1 * g1));
+                df1Bar += bar * lambda * (-dlf - p1 * g1);
+            }
+        }
+
+        if (walk != NULL)
+        {
+            /* tl[i-1] is not seen again */
+            if (LegsAdjointAdd (walk, tl[i-1], s0Bar,
+                                i == 1 ? MAX(today, tl[0]) : tl[i-1],
+                                df0Bar) != SUCCESS)
+                goto done;
+            s0Bar  = s1Bar;
+            df0Bar = df1Bar;
+        }
+    }
+
+    if (walk != NULL && numDates > 1)
+    {
+        if (LegsAdjointAdd (walk, tl[numDates-1], s0Bar,
+                            tl[numDates-1], df0Bar) != SUCCESS)
+            goto done;
     }
 
     status = SUCCESS;
@@ -161,7 +1320,52 @@ int JpmcdsFeeLegPV
     if (status != SUCCESS)
         JpmcdsErrMsgFailure (routine);
 
-    JpmcdsFreeDateList (tl);
+    if (tl != buffer)
+        FREE (tl);
+    return status;
+}
+
+
+/*
+***************************************************************************
+** Adds the adjoints of two log factors. The adjoints of the log zero
+** prices at today are accumulated and added at the end of the walk.
+***************************************************************************
+*/
+static int LegsAdjointAdd
+(TLegsAdjointWalk *walk,
+ TDate             survivalDate,
+ double            survivalBar,
+ TDate             discountDate,
+ double            discountBar)
+{
+    static char routine[] = "LegsAdjointAdd";
+    int         status    = FAILURE;
+
+    if (survivalBar != 0.0)
+    {
+        if (JpmcdsLogZeroPriceAdjoint (walk->spreadCurve, survivalDate,
+                                       survivalBar,
+                                       walk->adjoint->spreadGrad) != SUCCESS)
+            goto done;
+        walk->todaySpreadBar -= survivalBar;
+    }
+
+    if (discountBar != 0.0)
+    {
+        if (JpmcdsLogZeroPriceAdjoint (walk->discCurve, discountDate,
+                                       discountBar,
+                                       walk->adjoint->discGrad) != SUCCESS)
+            goto done;
+        walk->todayDiscBar -= discountBar;
+    }
+
+    status = SUCCESS;
+
+ done:
+
+    if (status != SUCCESS)
+        JpmcdsErrMsgFailure (routine);
 
     return status;
 }
@@ -191,16 +1395,17 @@ static int FeePaymentPVWithTimeLine
  long            accrueDCC,
  double          notional,
  double          couponRate,
- TCurve         *discCurve,
- TCurve         *spreadCurve,
+ TCurvePairCache *curves,
  TDateList      *tl,
  TBoolean        obsStartOfDay,
- double         *pv)
+ double         *pv,
+ double         *dpv)
 {
     static char routine[] = "FeePaymentPVWithTimeLine";
     int         status    = FAILURE;
 
     double myPv = 0.0;
+    double myDpv = 0.0;
 
     /*
      * Because survival is calculated at the end of the day, then if
@@ -209,13 +1414,14 @@ static int FeePaymentPVWithTimeLine
      */
     int    obsOffset = obsStartOfDay ? -1 : 0;
 
-    REQUIRE (discCurve != NULL);
-    REQUIRE (spreadCurve != NULL);
+    REQUIRE (curves != NULL);
     REQUIRE (pv != NULL);
 
     if(accEndDate <= stepinDate)
     {
         *pv = 0;
+        if (dpv != NULL)
+            *dpv = 0;
         return SUCCESS;
     }
 
@@ -233,9 +1439,11 @@ static int FeePaymentPVWithTimeLine
             goto done;
         
         amount   = notional * couponRate * accTime;
-        survival = JpmcdsForwardZeroPrice(spreadCurve, today, accEndDate + obsOffset);
-        discount = JpmcdsForwardZeroPrice(discCurve, today, payDate);
+        survival = JpmcdsCurvePairCacheSurvival(curves, accEndDate + obsOffset);
+        discount = JpmcdsCurvePairCacheDiscount(curves, payDate);
         myPv = amount * survival * discount;
+        if (dpv != NULL)
+            myDpv = myPv * JpmcdsCurvePairCacheSurvivalLogDeriv(curves, accEndDate + obsOffset);
         break;
     }
     case ACCRUAL_PAY_ALL:
@@ -247,29 +1455,34 @@ static int FeePaymentPVWithTimeLine
         double survival;
         double discount;
         double accrual;
+        double dAccrual;
         
         if (JpmcdsDayCountFraction(accStartDate, accEndDate, accrueDCC, &accTime) != SUCCESS)
             goto done;
 
         amount   = notional * couponRate * accTime;
-        survival = JpmcdsForwardZeroPrice(spreadCurve, today, accEndDate + obsOffset);
-        discount = JpmcdsForwardZeroPrice(discCurve, today, payDate);
+        survival = JpmcdsCurvePairCacheSurvival(curves, accEndDate + obsOffset);
+        discount = JpmcdsCurvePairCacheDiscount(curves, payDate);
         myPv = amount * survival * discount;
+        if (dpv != NULL)
+            myDpv = myPv * JpmcdsCurvePairCacheSurvivalLogDeriv(curves, accEndDate + obsOffset);
         
         /* also need to calculate accrual PV */
         
-        if (JpmcdsAccrualOnDefaultPVWithTimeLine(today,
-                                                 stepinDate + obsOffset,
-                                                 accStartDate + obsOffset,
-                                                 accEndDate + obsOffset,
-                                                 amount,
-                                                 discCurve,
-                                                 spreadCurve,
-                                                 tl,
-                                                 &accrual) != SUCCESS)
+        if (AccrualOnDefaultPV(today,
+                               stepinDate + obsOffset,
+                               accStartDate + obsOffset,
+                               accEndDate + obsOffset,
+                               amount,
+                               curves,
+                               tl,
+                               &accrual,
+                               dpv == NULL ? NULL : &dAccrual) != SUCCESS)
             goto done;
         
         myPv += accrual;
+        if (dpv != NULL)
+            myDpv += dAccrual;
         break;
     }
     default:
@@ -279,6 +1492,8 @@ static int FeePaymentPVWithTimeLine
 
     status = SUCCESS;
     *pv = myPv;
+    if (dpv != NULL)
+        *dpv = myDpv;
 
  done:
 
@@ -309,7 +1524,59 @@ int JpmcdsAccrualOnDefaultPVWithTimeLine
     static char routine[] = "JpmcdsAccrualOnDefaultPVWithTimeLine";
     int         status    = FAILURE;
 
+    TCurvePairCache curves;
+
+    REQUIRE (discCurve != NULL);
+    REQUIRE (spreadCurve != NULL);
+
+    JpmcdsCurvePairCacheInit (&curves, today, discCurve, spreadCurve);
+
+    if (AccrualOnDefaultPV (today,
+                            stepinDate,
+                            startDate,
+                            endDate,
+                            amount,
+                            &curves,
+                            criticalDates,
+                            pv,
+                            NULL) != SUCCESS)
+        goto done;
+
+    status = SUCCESS;
+
+ done:
+
+    if (status != SUCCESS)
+        JpmcdsErrMsgFailure (routine);
+
+    return status;
+}
+
+
+/*
+***************************************************************************
+** Calculates the PV of the accruals which occur on default.
+** Uses a pre-calculated timeline for efficiency.
+***************************************************************************
+*/
+static int AccrualOnDefaultPV
+(TDate            today,
+ TDate            stepinDate,
+ TDate            startDate,
+ TDate            endDate,
+ double           amount,
+ TCurvePairCache *curves,
+ TDateList       *criticalDates,
+ double          *pv,
+ double          *dpv)
+{
+    static char routine[] = "AccrualOnDefaultPV";
+    int         status    = FAILURE;
+
     double  myPv = 0.0;
+    double  myDpv = 0.0;
+    double  g0 = 0.0;
+    double  g1;
     int     i;
 
     double t;
@@ -320,28 +1587,42 @@ int JpmcdsAccrualOnDefaultPVWithTimeLine
     double accRate;
     TDate  subStartDate;
 
-    TDateList  *tl = NULL;
+    TDate          buffer[JPMCDS_TIMELINE_BUFFER_SIZE];
+    TDate         *tl = buffer;
+    TTimeLineView  view;
+    long           numDates;
 
     REQUIRE (endDate > startDate);
-    REQUIRE (discCurve != NULL);
-    REQUIRE (spreadCurve != NULL);
+    REQUIRE (curves != NULL);
     REQUIRE (pv != NULL);
     
     /*
     ** Timeline is points on the spreadCurve between startDate and endDate,
     ** combined with points from the discCurve, plus
-    ** the startDate and endDate.
+    ** the startDate and endDate. The points are read in place from the
+    ** critical dates if there are any.
     */
-    if (criticalDates != NULL)
-    {
-        tl = JpmcdsTruncateTimeLine (criticalDates, startDate, endDate);
-    }
-    else
+    if (JpmcdsRiskyTimeLineView (startDate, endDate,
+                                 curves->discCurve, curves->spreadCurve,
+                                 criticalDates,
+                                 JPMCDS_TIMELINE_BUFFER_SIZE, buffer,
+                                 &view) != SUCCESS)
+        goto done;
+
+    numDates = JPMCDS_TIMELINE_VIEW_SIZE (&view);
+    if (view.dates == NULL)
     {
-        tl = JpmcdsRiskyTimeLine (startDate, endDate, discCurve, spreadCurve);
+        /* only curves with very many points get here */
+        tl = NEW_ARRAY(TDate, numDates);
+        if (tl == NULL)
+            goto done;
+        if (JpmcdsRiskyTimeLineView (startDate, endDate,
+                                     curves->discCurve, curves->spreadCurve,
+                                     criticalDates,
+                                     numDates, tl,
+                                     &view) != SUCCESS)
+            goto done;
     }
-    if (tl == NULL)
-        goto done;
 
     /* the integration - we can assume flat forwards between points on
        the timeline - this is true for both curves 
@@ -356,10 +1637,68 @@ int JpmcdsAccrualOnDefaultPVWithTimeLine
     subStartDate = MAX(stepinDate, startDate);
     t       = (double)(endDate-startDate)/365.0;
     accRate = amount/t;
-    s0      = JpmcdsForwardZeroPrice(spreadCurve, today, subStartDate);
-    df0     = JpmcdsForwardZeroPrice(discCurve, today, MAX(today, subStartDate));
 
-    for (i = 1; i < tl->fNumItems; ++i)
+    if (curves->vectorIntegrals && dpv == NULL)
+    {
+        /* the same integral over arrays of factors at the timeline from
+           subStartDate */
+        double  factorBuffer[3 * JPMCDS_TIMELINE_BUFFER_SIZE];
+        double *factors = factorBuffer;
+        long    first;
+        long    n;
+
+        for (first = 1;
+             first < numDates &&
+                 JPMCDS_TIMELINE_VIEW_DATE (&view, first) <= stepinDate;
+             ++first)
+            ;
+        --first;
+        n = numDates - first;
+
+        if (n == 1)
+        {
+            /* the whole period is before stepinDate */
+            status = SUCCESS;
+            *pv = 0.0;
+            goto done;
+        }
+
+        /* the view from subStartDate, in place of the last date which
+           is not after stepinDate */
+        view.startDate = subStartDate;
+        view.begin    += first;
+
+        if (numDates > JPMCDS_TIMELINE_BUFFER_SIZE)
+        {
+            factors = NEW_ARRAY(double, 3 * numDates);
+            if (factors == NULL)
+                goto done;
+        }
+
+        JpmcdsCurvePairCacheViewFactors (curves, &view,
+                                         factors, factors + n);
+        for (i = 0; i < n; ++i)
+            factors[2 * n + i] = (double)(JPMCDS_TIMELINE_VIEW_DATE (&view, i) +
+                                          0.5 - startDate)/365.0;
+
+        myPv = JpmcdsAccrualSegmentsPV (n - 1, accRate,
+                                        factors,
+                                        factors + n,
+                                        factors + 2 * n);
+
+        if (factors != factorBuffer)
+            FREE (factors);
+
+        status = SUCCESS;
+        *pv = myPv;
+        goto done;
+    }
+    s0      = JpmcdsCurvePairCacheSurvival(curves, subStartDate);
+    df0     = JpmcdsCurvePairCacheDiscount(curves, MAX(today, subStartDate));
+    if (dpv != NULL)
+        g0 = JpmcdsCurvePairCacheSurvivalLogDeriv(curves, subStartDate);
+
+    for (i = 1; i < numDates; ++i)
     {
         double lambda;
         double fwdRate;
@@ -367,14 +1706,15 @@ int JpmcdsAccrualOnDefaultPVWithTimeLine
         double t0;
         double t1;
         double lambdafwdRate;
-        if(tl->fArray[i] <= stepinDate)
+        TDate  date = JPMCDS_TIMELINE_VIEW_DATE (&view, i);
+        if(date <= stepinDate)
             continue;
 
-        s1  = JpmcdsForwardZeroPrice(spreadCurve, today, tl->fArray[i]);
-        df1 = JpmcdsForwardZeroPrice(discCurve, today, tl->fArray[i]);
+        s1  = JpmcdsCurvePairCacheSurvival(curves, date);
+        df1 = JpmcdsCurvePairCacheDiscount(curves, date);
 
         t0  = (double)(subStartDate + 0.5 - startDate)/365.0;
-        t1  = (double)(tl->fArray[i] + 0.5- startDate)/365.0;
+        t1  = (double)(date + 0.5- startDate)/365.0;
         t   = t1-t0;
 
         lambda  = log(s0/s1)/t;
@@ -387,20 +1727,46 @@ int JpmcdsAccrualOnDefaultPVWithTimeLine
             s1/s0 * df1/df0);
 
         myPv += thisPv;
+
+        if (dpv != NULL)
+        {
+            /* g is the derivative of log(S), so lambda moves by
+               (g0-g1)/t and s by s.g */
+            double p0 = s0 * df0;
+            double p1 = s1 * df1;
+            double h0 = (t0 + 1.0/lambdafwdRate)/lambdafwdRate;
+            double h1 = (t1 + 1.0/lambdafwdRate)/lambdafwdRate;
+            double dh0 = -(t0 + 2.0/lambdafwdRate)/(lambdafwdRate*lambdafwdRate);
+            double dh1 = -(t1 + 2.0/lambdafwdRate)/(lambdafwdRate*lambdafwdRate);
+            double dLambda;
+
+            g1 = JpmcdsCurvePairCacheSurvivalLogDeriv(curves, date);
+            dLambda = (g0 - g1)/t;
+
+            myDpv += accRate * (
+                dLambda * (p0 * h0 - p1 * h1) +
+                lambda * (p0 * g0 * h0 - p1 * g1 * h1 +
+                          (p0 * dh0 - p1 * dh1) * dLambda));
+            g0 = g1;
+        }
+
         s0  = s1;
         df0 = df1;
-        subStartDate = tl->fArray[i];
+        subStartDate = date;
     }
 
     status = SUCCESS;
     *pv = myPv;
+    if (dpv != NULL)
+        *dpv = myDpv;
         
  done:
 
     if (status != SUCCESS)
         JpmcdsErrMsgFailure (routine);
 
-    JpmcdsFreeDateList (tl);
+    if (tl != buffer)
+        FREE (tl);
     return status;
 }
 
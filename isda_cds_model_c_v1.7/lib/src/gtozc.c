@@ -37,26 +37,6 @@ static int CheckZCCashInputs(
         long      dayCountConv);
 
 
-/*
-***************************************************************************
-** Check input arguments for adding swaps to a given zero curve.
-***************************************************************************
-*/
-static int CheckZCSwapsInputs(
-        TCurve     *zeroCurve,
-        TCurve     *discZC,
-        TDate      *dates,
-        double     *rates,
-        int        numSwaps,
-        int        fixedSwapFreq,
-        int        floatSwapFreq,
-        long       fixDayCountConv,
-        long       floatDayCountConv,
-        char       fwdLength,
-        long       badDayConv,
-        char       *holidayFile);
-
-
 /*
 ***************************************************************************
 ** Adds cash points to a given zero curve.
@@ -193,7 +173,7 @@ TCurve* JpmcdsZCSwaps(
         goto done;
 
    /* Check inputs */
-   if (CheckZCSwapsInputs(
+   if (JpmcdsZCSwapsCheckInputs(
              zeroCurve,
              discZC,
              dates,
@@ -362,7 +342,7 @@ static int CheckZCCashInputs(
 ** Check input arguments for adding swaps to a given zero curve.
 ***************************************************************************
 */
-static int CheckZCSwapsInputs(
+int JpmcdsZCSwapsCheckInputs(
         TCurve     *zeroCurve,
         TCurve     *discZC,
         TDate      *dates,
@@ -379,7 +359,7 @@ static int CheckZCSwapsInputs(
    int         i;
    TBoolean    isBusDay;
    int         status = SUCCESS;   /* Until proven a failure */
-   static char routine[] = "CheckZCSwapsInputs";
+   static char routine[] = "JpmcdsZCSwapsCheckInputs";
 
 
    /* Check whether zeroCurve exists 
@@ -0,0 +1,746 @@
+/*
+ * ISDA CDS Standard Model
+ *
+ * Copyright (C) 2009 International Swaps and Derivatives Association, Inc.
+ * Developed and supported in collaboration with Markit
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the ISDA CDS Standard Model Public License.
+ */
+
+#include "holfile.h"
+#include <ctype.h>
+#include <stdio.h>
+#include <string.h>
+#include "cmemory.h"
+#include "dtlist.h"
+#include "macros.h"
+#include "cerror.h"
+
+#if defined(WIN32) || defined(_WIN32)
+#include <windows.h>
+#else
+#include <dirent.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+
+#define HOLIDAY_FILE_MAGIC      "JHOL"
+#define HOLIDAY_FILE_BYTE_ORDER 0x01020304
+#define HOLIDAY_FILE_VERSION    1
+
+
+/*
+** Start of a binary holiday file. Followed by the holidays and the index
+** as described in holfile.h.
+*/
+typedef struct _THolidayFileHeader
+{
+    char  magic[4];     /* HOLIDAY_FILE_MAGIC */
+    int   byteOrder;    /* HOLIDAY_FILE_BYTE_ORDER */
+    int   version;      /* HOLIDAY_FILE_VERSION */
+    int   weekends;     /* JPMCDS_WEEKEND_... flags */
+    int   numHolidays;  /* number of holidays */
+    int   indexStart;   /* first date of the index */
+    int   indexWords;   /* words in the bitmap, zero if no index */
+    int   indexBits;    /* days in each word of the bitmap */
+} THolidayFileHeader;
+
+
+/* A binary holiday file mapped into memory. */
+typedef struct _THolidayFileView
+{
+    char   *data;
+    size_t  size;
+} THolidayFileView;
+
+
+static int holidayFileMap
+(char             *fileName,
+ THolidayFileView *view);
+
+static void holidayFileUnmap
+(THolidayFileView *view);
+
+static TBoolean holidayFileHasExtension
+(char             *fileName,
+ char             *extension);
+
+static TBoolean holidayIndexValid
+(THolidayIndex    *index,
+ THolidayList     *hl);
+
+static long holidayIndexBitCount
+(unsigned long     bits);
+
+
+/*
+***************************************************************************
+** Writes a holiday list to a binary holiday file.
+***************************************************************************
+*/
+int JpmcdsHolidayListWriteBinary
+(THolidayList *hl,          /* (I/O) Holiday list */
+ char         *fileName,    /* (I) File to write */
+ TBoolean      withIndex)   /* (I) Include the business day index */
+{
+    static char routine[] = "JpmcdsHolidayListWriteBinary";
+    int         status    = FAILURE;
+
+    THolidayFileHeader  header;
+    THolidayIndex      *index = NULL;
+    int                *body  = NULL;
+    long                numHols;
+    long                numBody;
+    long                i;
+    FILE               *fp = NULL;
+
+    if (hl == NULL || hl->dateList == NULL || fileName == NULL)
+    {
+        JpmcdsErrMsg ("%s: NULL inputs.\n", routine);
+        goto done;
+    }
+
+    if (withIndex)
+    {
+        index = JPMCDS_HOLIDAY_LIST_INDEX (hl);
+        if (index == NULL)
+        {
+            if (JpmcdsHolidayListBuildIndex (hl) != SUCCESS)
+                goto done;
+            index = hl->index;
+        }
+    }
+
+    numHols = hl->dateList->fNumItems;
+
+    memcpy (header.magic, HOLIDAY_FILE_MAGIC, sizeof(header.magic));
+    header.byteOrder   = HOLIDAY_FILE_BYTE_ORDER;
+    header.version     = HOLIDAY_FILE_VERSION;
+    header.weekends    = (int)hl->weekends;
+    header.numHolidays = (int)numHols;
+    header.indexStart  = index == NULL ? 0 : (int)index->startDate;
+    header.indexWords  = index == NULL ? 0 : (int)index->nbWords;
+    header.indexBits   = JPMCDS_HOLIDAY_INDEX_BITS;
+
+    /* holidays, then the bitmap and counts including their last word */
+    numBody = numHols;
+    if (index != NULL)
+        numBody += 2 * (index->nbWords + 1);
+
+    body = NEW_ARRAY(int, numBody + 1);
+    if (body == NULL)
+        goto done;
+
+    for (i = 0; i < numHols; ++i)
+        body[i] = (int)hl->dateList->fArray[i];
+
+    if (index != NULL)
+    {
+        unsigned int *bits  = (unsigned int*)(body + numHols);
+        int          *ranks = body + numHols + index->nbWords + 1;
+
+        for (i = 0; i <= index->nbWords; ++i)
+        {
+            bits[i]  = (unsigned int)index->bits[i];
+            ranks[i] = (int)index->ranks[i];
+        }
+    }
+
+    /* binary mode, so not through JpmcdsFopen */
+    fp = fopen (fileName, "wb");
+    if (fp == NULL)
+    {
+        JpmcdsErrMsg ("%s: Couldn't open file %s.\n", routine, fileName);
+        goto done;
+    }
+
+    if (fwrite (&header, sizeof(header), 1, fp) != 1 ||
+        (numBody > 0 &&
+         fwrite (body, sizeof(int), (size_t)numBody, fp) != (size_t)numBody))
+    {
+        JpmcdsErrMsg ("%s: Couldn't write to file %s.\n", routine, fileName);
+        goto done;
+    }
+
+    if (fclose (fp) != 0)
+    {
+        fp = NULL;
+        JpmcdsErrMsg ("%s: Couldn't close file %s.\n", routine, fileName);
+        goto done;
+    }
+    fp = NULL;
+
+    status = SUCCESS;
+
+done:
+
+    if (fp != NULL)
+        fclose (fp);
+    FREE(body);
+
+    if (status != SUCCESS)
+        JpmcdsErrMsg ("%s: Failed.\n", routine);
+
+    return status;
+}
+
+
+/*
+***************************************************************************
+** Reads a holiday list from a binary holiday file.
+**
+** The file is mapped into memory rather than read. Its dates and index are
+** copied out of the mapping since TDate and the words of the index may be
+** wider than the 32 bits held in the file.
+**
+** An index which does not agree with the weekends and holidays of the file
+** is made again by JpmcdsHolidayListBuildIndex.
+***************************************************************************
+*/
+THolidayList* JpmcdsHolidayListReadBinary
+(char         *fileName)    /* (I) File to read */
+{
+    static char routine[] = "JpmcdsHolidayListReadBinary";
+    int         status    = FAILURE;
+
+    THolidayFileView    view  = {NULL, 0};
+    THolidayFileHeader *header;
+    int                *dates;
+    THolidayList       *hl    = NULL;
+    TDateList          *dl    = NULL;
+    THolidayIndex      *index = NULL;
+    size_t              size;
+    long                i;
+
+    if (holidayFileMap (fileName, &view) != SUCCESS)
+        goto done;
+
+    header = (THolidayFileHeader*)view.data;
+    if (view.size < sizeof(THolidayFileHeader) ||
+        memcmp (header->magic, HOLIDAY_FILE_MAGIC, sizeof(header->magic)) != 0)
+    {
+        JpmcdsErrMsg ("%s: %s is not a binary holiday file.\n", routine, fileName);
+        goto done;
+    }
+
+    if (header->byteOrder != HOLIDAY_FILE_BYTE_ORDER)
+    {
+        JpmcdsErrMsg ("%s: %s was written with a different byte order.\n",
+                      routine, fileName);
+        goto done;
+    }
+
+    if (header->version != HOLIDAY_FILE_VERSION)
+    {
+        JpmcdsErrMsg ("%s: %s has version %d, not %d.\n",
+                      routine, fileName, header->version, HOLIDAY_FILE_VERSION);
+        goto done;
+    }
+
+    size = sizeof(THolidayFileHeader);
+    if (header->numHolidays >= 0 && header->indexWords >= 0)
+    {
+        size += sizeof(int) * (size_t)header->numHolidays;
+        if (header->indexWords > 0)
+            size += 2 * sizeof(int) * ((size_t)header->indexWords + 1);
+    }
+    if (header->numHolidays < 0 || header->indexWords < 0 || size != view.size)
+    {
+        JpmcdsErrMsg ("%s: %s is not complete.\n", routine, fileName);
+        goto done;
+    }
+
+    dates = (int*)(header + 1);
+
+    dl = JpmcdsNewEmptyDateList (header->numHolidays);
+    if (dl == NULL)
+        goto done;
+
+    for (i = 0; i < header->numHolidays; ++i)
+    {
+        if (i > 0 && dates[i] <= dates[i-1])
+        {
+            JpmcdsErrMsg ("%s: Dates are not in strictly increasing order.\n",
+                          routine);
+            goto done;
+        }
+        dl->fArray[i] = dates[i];
+    }
+
+    hl = JpmcdsHolidayListNewGeneral (dl, header->weekends);
+    if (hl == NULL)
+        goto done;
+
+    /* an index made with words of another size, or which does not cover
+       all the holidays, is left for JpmcdsHolidayListBuildIndex to make */
+    if (header->indexWords > 0 &&
+        header->indexBits == JPMCDS_HOLIDAY_INDEX_BITS &&
+        (header->numHolidays == 0 ||
+         (dates[0] >= header->indexStart &&
+          dates[header->numHolidays-1] - header->indexStart <
+          (long)header->indexWords * JPMCDS_HOLIDAY_INDEX_BITS)))
+    {
+        unsigned int *bits  = (unsigned int*)(dates + header->numHolidays);
+        int          *ranks = (int*)(bits + header->indexWords + 1);
+
+        index = NEW(THolidayIndex);
+        if (index == NULL)
+            goto done;
+
+        index->nbWords   = header->indexWords;
+        index->startDate = header->indexStart;
+        index->endDate   = index->startDate + index->nbWords * JPMCDS_HOLIDAY_INDEX_BITS;
+        index->bits      = NEW_ARRAY(unsigned long, index->nbWords + 1);
+        index->ranks     = NEW_ARRAY(long, index->nbWords + 1);
+        if (index->bits == NULL || index->ranks == NULL)
+            goto done;
+
+        for (i = 0; i <= index->nbWords; ++i)
+        {
+            index->bits[i]  = bits[i];
+            index->ranks[i] = ranks[i];
+        }
+
+        index->dateList    = hl->dateList;
+        index->numHolidays = hl->dateList->fNumItems;
+        index->weekends    = hl->weekends;
+
+        if (holidayIndexValid (index, hl))
+        {
+            hl->index = index;
+            index     = NULL; /* Now owned by hl */
+        }
+        else if (JpmcdsHolidayListBuildIndex (hl) != SUCCESS)
+            goto done;
+    }
+
+    status = SUCCESS;
+
+done:
+
+    holidayFileUnmap (&view);
+    JpmcdsFreeDateList (dl);
+    if (index != NULL)
+    {
+        FREE(index->bits);
+        FREE(index->ranks);
+        FREE(index);
+    }
+
+    if (status != SUCCESS)
+    {
+        JpmcdsHolidayListDelete (hl);
+        hl = NULL;
+        JpmcdsErrMsg ("%s: Failed.\n", routine);
+    }
+
+    return hl;
+}
+
+
+/*
+***************************************************************************
+** Returns TRUE if the bitmap of an index has the business days of a
+** holiday list, and the counts of each word are the business days before
+** it. Only then can the business day functions use the index.
+***************************************************************************
+*/
+static TBoolean holidayIndexValid
+(THolidayIndex    *index,
+ THolidayList     *hl)
+{
+    unsigned long weekdays[7];
+    TDate        *hols    = hl->dateList->fArray;
+    long          numHols = hl->dateList->fNumItems;
+    long          holIdx  = 0;
+    long          word;
+    long          i;
+
+    if (index->ranks[0] != 0 || index->bits[index->nbWords] != 0)
+        return FALSE;
+
+    /* the weekdays of a word which starts on each day of the week */
+    for (i = 0; i < 7; ++i)
+    {
+        long day;
+
+        weekdays[i] = 0;
+        for (day = 0; day < JPMCDS_HOLIDAY_INDEX_BITS; ++day)
+        {
+            if (JPMCDS_IS_WEEKDAY (i + day, hl->weekends))
+                weekdays[i] |= 1UL << day;
+        }
+    }
+
+    /* the holidays are all within the index */
+    for (word = 0; word < index->nbWords; ++word)
+    {
+        TDate         first = index->startDate + word * JPMCDS_HOLIDAY_INDEX_BITS;
+        unsigned long bits  = weekdays[first % 7];
+
+        for (; holIdx < numHols && hols[holIdx] < first + JPMCDS_HOLIDAY_INDEX_BITS;
+             ++holIdx)
+            bits &= ~(1UL << (hols[holIdx] - first));
+
+        if (index->bits[word] != bits ||
+            index->ranks[word+1] != index->ranks[word] + holidayIndexBitCount (bits))
+            return FALSE;
+    }
+
+    return TRUE;
+}
+
+
+/*
+***************************************************************************
+** Returns the number of bits set in a word of an index.
+***************************************************************************
+*/
+static long holidayIndexBitCount
+(unsigned long     bits)
+{
+    bits = bits - ((bits >> 1) & 0x55555555UL);
+    bits = (bits & 0x33333333UL) + ((bits >> 2) & 0x33333333UL);
+    bits = (bits + (bits >> 4)) & 0x0F0F0F0FUL;
+    return (long)(((bits * 0x01010101UL) & 0xFFFFFFFFUL) >> 24);
+}
+
+
+/*
+***************************************************************************
+** Returns TRUE if a file is a binary holiday file.
+***************************************************************************
+*/
+TBoolean JpmcdsHolidayFileIsBinary
+(char         *fileName)    /* (I) File to test */
+{
+    char      magic[4];
+    TBoolean  isBinary = FALSE;
+    FILE     *fp;
+
+    if (fileName == NULL)
+        return FALSE;
+
+    fp = fopen (fileName, "rb");
+    if (fp == NULL)
+        return FALSE;
+
+    if (fread (magic, sizeof(magic), 1, fp) == 1 &&
+        memcmp (magic, HOLIDAY_FILE_MAGIC, sizeof(magic)) == 0)
+        isBinary = TRUE;
+
+    fclose (fp);
+    return isBinary;
+}
+
+
+/*
+***************************************************************************
+** Converts a text holiday file to a binary holiday file.
+***************************************************************************
+*/
+int JpmcdsHolidayFileConvert
+(char         *textFileName,   /* (I) Text holiday file to read */
+ char         *binaryFileName, /* (I) Binary holiday file to write */
+ TBoolean      withIndex)      /* (I) Include the business day index */
+{
+    static char routine[] = "JpmcdsHolidayFileConvert";
+    int         status    = FAILURE;
+
+    THolidayList *hl = NULL;
+
+    hl = JpmcdsHolidayListRead (textFileName);
+    if (hl == NULL)
+        goto done;
+
+    if (JpmcdsHolidayListWriteBinary (hl, binaryFileName, withIndex) != SUCCESS)
+        goto done;
+
+    status = SUCCESS;
+
+done:
+
+    JpmcdsHolidayListDelete (hl);
+
+    if (status != SUCCESS)
+        JpmcdsErrMsg ("%s: Failed.\n", routine);
+
+    return status;
+}
+
+
+/*
+***************************************************************************
+** Adds every binary holiday file of a directory to the holiday cache.
+***************************************************************************
+*/
+int JpmcdsHolidayLoadDirectory
+(char         *directory,   /* (I) Directory to load */
+ char         *extension,   /* (I) Extension of the files, or NULL */
+ long         *numLoaded)   /* (O) Number of calendars loaded, or NULL */
+{
+    static char routine[] = "JpmcdsHolidayLoadDirectory";
+    int         status    = FAILURE;
+
+    THolidayList *hl       = NULL;
+    char         *path     = NULL;
+    size_t        nameLen;
+    long          count    = 0;
+#if defined(WIN32) || defined(_WIN32)
+    WIN32_FIND_DATAA  found;
+    HANDLE            search  = INVALID_HANDLE_VALUE;
+    char             *pattern = NULL;
+#else
+    DIR              *dir     = NULL;
+    struct dirent    *entry;
+#endif
+
+    if (directory == NULL)
+    {
+        JpmcdsErrMsg ("%s: NULL inputs.\n", routine);
+        goto done;
+    }
+
+    if (extension == NULL)
+        extension = JPMCDS_HOLIDAY_FILE_EXT;
+
+#if defined(WIN32) || defined(_WIN32)
+    pattern = NEW_ARRAY(char, strlen(directory) + 3);
+    if (pattern == NULL)
+        goto done;
+    sprintf (pattern, "%s/*", directory);
+
+    search = FindFirstFileA (pattern, &found);
+    if (search == INVALID_HANDLE_VALUE)
+    {
+        JpmcdsErrMsg ("%s: Couldn't open directory %s.\n", routine, directory);
+        goto done;
+    }
+
+    do
+    {
+        char *fileName = found.cFileName;
+
+        if (found.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY)
+            continue;
+#else
+    dir = opendir (directory);
+    if (dir == NULL)
+    {
+        JpmcdsErrMsg ("%s: Couldn't open directory %s.\n", routine, directory);
+        goto done;
+    }
+
+    while ((entry = readdir (dir)) != NULL)
+    {
+        char *fileName = entry->d_name;
+#endif
+        if (!holidayFileHasExtension (fileName, extension))
+            continue;
+
+        path = NEW_ARRAY(char, strlen(directory) + strlen(fileName) + 2);
+        if (path == NULL)
+            goto done;
+        sprintf (path, "%s/%s", directory, fileName);
+
+        hl = JpmcdsHolidayListReadBinary (path);
+        if (hl == NULL)
+        {
+            JpmcdsErrMsg ("%s: Couldn't load %s.\n", routine, path);
+            goto done;
+        }
+
+        /* the calendar is named by the file name without its extension,
+           which is written over in the path */
+        nameLen = strlen(fileName) - strlen(extension);
+        path[strlen(directory) + 1 + nameLen] = '\0';
+
+        if (JpmcdsHolidayListAddToCache (path + strlen(directory) + 1, hl) != SUCCESS)
+        {
+            hl = NULL; /* Deleted by the cache */
+            goto done;
+        }
+        hl = NULL; /* Now owned by the cache */
+
+        FREE(path);
+        path = NULL;
+        ++count;
+#if defined(WIN32) || defined(_WIN32)
+    }
+    while (FindNextFileA (search, &found));
+#else
+    }
+#endif
+
+    status = SUCCESS;
+
+done:
+
+#if defined(WIN32) || defined(_WIN32)
+    if (search != INVALID_HANDLE_VALUE)
+        FindClose (search);
+    FREE(pattern);
+#else
+    if (dir != NULL)
+        closedir (dir);
+#endif
+    JpmcdsHolidayListDelete (hl);
+    FREE(path);
+
+    if (numLoaded != NULL)
+        *numLoaded = count;
+
+    if (status != SUCCESS)
+        JpmcdsErrMsg ("%s: Failed.\n", routine);
+
+    return status;
+}
+
+
+/*
+***************************************************************************
+** Maps a file into memory for reading.
+***************************************************************************
+*/
+static int holidayFileMap
+(char             *fileName,    /* (I) File to map */
+ THolidayFileView *view)        /* (O) Mapped file */
+{
+    static char routine[] = "holidayFileMap";
+    int         status    = FAILURE;
+
+#if defined(WIN32) || defined(_WIN32)
+    HANDLE          file    = INVALID_HANDLE_VALUE;
+    HANDLE          mapping = NULL;
+    LARGE_INTEGER   size;
+#else
+    int             fd      = -1;
+    struct stat     info;
+#endif
+
+    view->data = NULL;
+    view->size = 0;
+
+    if (fileName == NULL)
+    {
+        JpmcdsErrMsg ("%s: NULL inputs.\n", routine);
+        goto done;
+    }
+
+#if defined(WIN32) || defined(_WIN32)
+    file = CreateFileA (fileName, GENERIC_READ, FILE_SHARE_READ, NULL,
+                        OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (file == INVALID_HANDLE_VALUE || !GetFileSizeEx (file, &size))
+    {
+        JpmcdsErrMsg ("%s: Couldn't open file %s.\n", routine, fileName);
+        goto done;
+    }
+    view->size = (size_t)size.QuadPart;
+
+    /* empty files cannot be mapped, and are rejected by the caller */
+    if (view->size > 0)
+    {
+        mapping = CreateFileMappingA (file, NULL, PAGE_READONLY, 0, 0, NULL);
+        if (mapping != NULL)
+            view->data = (char*)MapViewOfFile (mapping, FILE_MAP_READ, 0, 0, 0);
+        if (view->data == NULL)
+        {
+            JpmcdsErrMsg ("%s: Couldn't map file %s.\n", routine, fileName);
+            goto done;
+        }
+    }
+#else
+    fd = open (fileName, O_RDONLY);
+    if (fd < 0 || fstat (fd, &info) != 0)
+    {
+        JpmcdsErrMsg ("%s: Couldn't open file %s.\n", routine, fileName);
+        goto done;
+    }
+    view->size = (size_t)info.st_size;
+
+    /* empty files cannot be mapped, and are rejected by the caller */
+    if (view->size > 0)
+    {
+        void *data = mmap (NULL, view->size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (data == MAP_FAILED)
+        {
+            JpmcdsErrMsg ("%s: Couldn't map file %s.\n", routine, fileName);
+            goto done;
+        }
+        view->data = (char*)data;
+    }
+#endif
+
+    status = SUCCESS;
+
+done:
+
+    /* the mapping stays valid once the file is closed */
+#if defined(WIN32) || defined(_WIN32)
+    if (mapping != NULL)
+        CloseHandle (mapping);
+    if (file != INVALID_HANDLE_VALUE)
+        CloseHandle (file);
+#else
+    if (fd >= 0)
+        close (fd);
+#endif
+
+    if (status != SUCCESS)
+        view->size = 0;
+
+    return status;
+}
+
+
+/*
+***************************************************************************
+** Unmaps a file mapped by holidayFileMap.
+***************************************************************************
+*/
+static void holidayFileUnmap
+(THolidayFileView *view)        /* (I/O) Mapped file */
+{
+    if (view->data != NULL)
+    {
+#if defined(WIN32) || defined(_WIN32)
+        UnmapViewOfFile (view->data);
+#else
+        munmap (view->data, view->size);
+#endif
+    }
+    view->data = NULL;
+    view->size = 0;
+}
+
+
+/*
+***************************************************************************
+** Returns TRUE if a file name is longer than an extension and ends with
+** it, without regard to case.
+***************************************************************************
+*/
+static TBoolean holidayFileHasExtension
+(char             *fileName,    /* (I) File name */
+ char             *extension)   /* (I) Extension */
+{
+    size_t nameLen = strlen(fileName);
+    size_t extLen  = strlen(extension);
+    size_t i;
+
+    if (nameLen <= extLen)
+        return FALSE;
+
+    for (i = 0; i < extLen; ++i)
+    {
+        if (toupper((unsigned char)fileName[nameLen - extLen + i]) !=
+            toupper((unsigned char)extension[i]))
+            return FALSE;
+    }
+
+    return TRUE;
+}
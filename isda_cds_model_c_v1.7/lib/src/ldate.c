@@ -32,6 +32,7 @@ extern "C"
 #include "macros.h"
 #include "date_sup.h"
 #include "convert.h"
+#include "cthread.h"
 
 
 static int dateToMDYFast
@@ -188,8 +189,9 @@ static int dateToMDYFast
     (TDate         startDate,           /* (I) */
      TMonthDayYear *mdy)                /* (O) */
 {
-    static TDate         lastStartDate; /* For efficiency */
-    static TMonthDayYear lastMDY;       /* For efficiency */
+    /* For efficiency - kept for each thread since both must agree */
+    static JPMCDS_THREAD_LOCAL TDate         lastStartDate;
+    static JPMCDS_THREAD_LOCAL TMonthDayYear lastMDY;
 
     /* Check if we've already done this before to avoid
      * calling JpmcdsDateToMDY if not necessary.
@@ -0,0 +1,331 @@
+/*
+ * ISDA CDS Standard Model
+ *
+ * Copyright (C) 2009 International Swaps and Derivatives Association, Inc.
+ * Developed and supported in collaboration with Markit
+ * 
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the ISDA CDS Standard Model Public License.
+ */
+
+#include <math.h>
+#include "prepcurve.h"
+#include "cxzerocurve.h"
+#include "tcurve.h"
+#include "ldate.h"
+#include "macros.h"
+#include "cerror.h"
+
+
+static int preparedCurvePoint (TPreparedCurve*, TCurve*, long);
+
+
+/*
+***************************************************************************
+** Returns TRUE if JpmcdsPreparedCurveMake can prepare a zero curve.
+***************************************************************************
+*/
+TBoolean JpmcdsPreparedCurveValid
+(TCurve         *curve)
+{
+    long i;
+
+    if (curve == NULL || curve->fNumItems <= 0 || curve->fArray == NULL)
+        return FALSE;
+
+    for (i = 1; i < curve->fNumItems; ++i)
+    {
+        if (curve->fArray[i].fDate <= curve->fArray[i-1].fDate)
+            return FALSE;
+    }
+
+    return TRUE;
+}
+
+
+/*
+***************************************************************************
+** Prepares a zero curve for fast evaluation of zero prices.
+***************************************************************************
+*/
+TPreparedCurve* JpmcdsPreparedCurveMake
+(TCurve         *curve)
+{
+    static char routine[] = "JpmcdsPreparedCurveMake";
+    int         status    = FAILURE;
+
+    TPreparedCurve *pc = NULL;
+    long            n;
+    long            i;
+
+    REQUIRE (curve != NULL);
+    REQUIRE (curve->fNumItems > 0);
+    REQUIRE (curve->fArray != NULL);
+
+    n = curve->fNumItems;
+    for (i = 1; i < n; ++i)
+    {
+        REQUIRE (curve->fArray[i].fDate > curve->fArray[i-1].fDate);
+    }
+
+    pc = NEW(TPreparedCurve);
+    if (pc == NULL)
+        goto done;
+
+    pc->baseDate    = curve->fBaseDate;
+    pc->numItems    = n;
+    pc->dates       = NEW_ARRAY(TDate, n);
+    pc->days        = NEW_ARRAY(long, n);
+    pc->rates       = NEW_ARRAY(double, n);
+    pc->rateDays    = NEW_ARRAY(double, n);
+    pc->segRateDays = NEW_ARRAY(double, n);
+    pc->segDays     = NEW_ARRAY(double, n);
+    if (pc->dates == NULL || pc->days == NULL || pc->rates == NULL ||
+        pc->rateDays == NULL || pc->segRateDays == NULL || pc->segDays == NULL)
+        goto done;
+
+    for (i = 0; i < n; ++i)
+    {
+        pc->dates[i] = curve->fArray[i].fDate;
+        pc->days[i]  = curve->fArray[i].fDate - curve->fBaseDate;
+        if (preparedCurvePoint (pc, curve, i) != SUCCESS)
+            goto done;
+    }
+
+    status = SUCCESS;
+
+ done:
+
+    if (status != SUCCESS)
+    {
+        JpmcdsPreparedCurveFree (pc);
+        pc = NULL;
+        JpmcdsErrMsgFailure (routine);
+    }
+
+    return pc;
+}
+
+
+/*
+***************************************************************************
+** Frees a prepared curve.
+***************************************************************************
+*/
+void JpmcdsPreparedCurveFree
+(TPreparedCurve *pc)
+{
+    if (pc != NULL)
+    {
+        FREE (pc->dates);
+        FREE (pc->days);
+        FREE (pc->rates);
+        FREE (pc->rateDays);
+        FREE (pc->segRateDays);
+        FREE (pc->segDays);
+        FREE (pc);
+    }
+}
+
+
+/*
+***************************************************************************
+** Changes the rate of point idx of a prepared curve.
+***************************************************************************
+*/
+int JpmcdsPreparedCurveSetRate
+(TPreparedCurve *pc,
+ TCurve         *curve,
+ long            idx,
+ double          rate)
+{
+    static char routine[] = "JpmcdsPreparedCurveSetRate";
+    int         status    = FAILURE;
+
+    REQUIRE (curve != NULL);
+    REQUIRE (pc == NULL || curve->fNumItems == pc->numItems);
+    REQUIRE (idx >= 0 && idx < curve->fNumItems);
+
+    curve->fArray[idx].fRate = rate;
+
+    if (pc != NULL)
+    {
+        if (preparedCurvePoint (pc, curve, idx) != SUCCESS)
+            goto done;
+
+        /* the following segment starts at this point */
+        if (idx + 1 < pc->numItems)
+            pc->segRateDays[idx+1] = pc->rateDays[idx+1] - pc->rateDays[idx];
+    }
+
+    status = SUCCESS;
+
+ done:
+
+    if (status != SUCCESS)
+        JpmcdsErrMsgFailure (routine);
+
+    return status;
+}
+
+
+/*
+***************************************************************************
+** Makes a TCurve from a prepared curve.
+***************************************************************************
+*/
+TCurve* JpmcdsPreparedCurveToTCurve
+(TPreparedCurve *pc)
+{
+    static char routine[] = "JpmcdsPreparedCurveToTCurve";
+
+    TCurve *curve = NULL;
+
+    REQUIRE (pc != NULL);
+
+    curve = JpmcdsMakeTCurveNoRateCheck (pc->baseDate,
+                                         pc->dates,
+                                         pc->rates,
+                                         (int)pc->numItems,
+                                         JPMCDS_CONTINUOUS_BASIS,
+                                         JPMCDS_ACT_365F);
+
+ done:
+
+    if (curve == NULL)
+        JpmcdsErrMsgFailure (routine);
+
+    return curve;
+}
+
+
+/*
+***************************************************************************
+** Returns the index of the first point on or after a date.
+**
+** The search halves the range without branching on the comparison, so
+** that the loop runs the same number of times for every date. The result
+** of the comparison is used as a mask rather than as a condition.
+***************************************************************************
+*/
+long JpmcdsPreparedCurveSearch
+(TPreparedCurve *pc,
+ TDate           date)
+{
+    const TDate *base = pc->dates;
+    long         len  = pc->numItems;
+
+    while (len > 1)
+    {
+        long half = len / 2;
+        base += half & -(long)(base[half - 1] < date);
+        len  -= half;
+    }
+
+    return (long)(base - pc->dates) + (*base < date);
+}
+
+
+/*
+***************************************************************************
+** Calculates the zero price for a given date.
+**
+** Follows JpmcdsZeroRate and zcInterpRate operation by operation so that
+** the result is identical.
+***************************************************************************
+*/
+double JpmcdsPreparedZeroPrice
+(TPreparedCurve *pc,
+ TDate           date)
+{
+    long   hi = JpmcdsPreparedCurveSearch (pc, date);
+    long   t;
+    double rate;
+
+    if (hi < pc->numItems && pc->dates[hi] == date)
+    {
+        /* date found in curve dates */
+        rate = pc->rates[hi];
+    }
+    else if (hi == 0 || pc->numItems == 1)
+    {
+        /* date before start of curve dates, or only one point */
+        rate = pc->rates[0];
+    }
+    else
+    {
+        double zt;
+
+        /* extrapolate beyond the end using the last segment */
+        if (hi == pc->numItems)
+            hi = pc->numItems - 1;
+
+        t = date - pc->baseDate;
+        if (t == 0)
+        {
+            /* as zcInterpRate */
+            if (pc->days[hi] == 0)
+            {
+                rate = pc->rates[hi];
+                return exp(-rate * ((date - pc->baseDate) / 365.0));
+            }
+            t = 1;
+        }
+        zt   = pc->rateDays[hi-1] + pc->segRateDays[hi] *
+            (double)(t - pc->days[hi-1]) / pc->segDays[hi];
+        rate = zt / t;
+    }
+
+    return exp(-rate * ((date - pc->baseDate) / 365.0));
+}
+
+
+/*
+***************************************************************************
+** Calculates the zero price for a given start date and maturity date.
+***************************************************************************
+*/
+double JpmcdsPreparedForwardZeroPrice
+(TPreparedCurve *pc,
+ TDate           startDate,
+ TDate           maturityDate)
+{
+    double startPrice    = JpmcdsPreparedZeroPrice(pc, startDate);
+    double maturityPrice = JpmcdsPreparedZeroPrice(pc, maturityDate);
+    return maturityPrice / startPrice;
+}
+
+
+/*
+***************************************************************************
+** Sets the continuously compounded rate of point idx from the curve, and
+** the segment which ends at the point.
+***************************************************************************
+*/
+static int preparedCurvePoint
+(TPreparedCurve *pc,
+ TCurve         *curve,
+ long            idx)
+{
+    if (JpmcdsConvertCompoundRate (curve->fArray[idx].fRate,
+                                   curve->fBasis,
+                                   curve->fDayCountConv,
+                                   JPMCDS_CONTINUOUS_BASIS,
+                                   JPMCDS_ACT_365F,
+                                   &pc->rates[idx]) != SUCCESS)
+        return FAILURE;
+
+    pc->rateDays[idx] = pc->rates[idx] * pc->days[idx];
+    if (idx > 0)
+    {
+        pc->segRateDays[idx] = pc->rateDays[idx] - pc->rateDays[idx-1];
+        pc->segDays[idx]     = (double)(pc->days[idx] - pc->days[idx-1]);
+    }
+    else
+    {
+        pc->segRateDays[idx] = 0.0;
+        pc->segDays[idx]     = 0.0;
+    }
+
+    return SUCCESS;
+}
@@ -0,0 +1,98 @@
+/*
+ * ISDA CDS Standard Model
+ *
+ * Copyright (C) 2009 International Swaps and Derivatives Association, Inc.
+ * Developed and supported in collaboration with Markit
+ * 
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the ISDA CDS Standard Model Public License.
+ */
+
+#include <math.h>
+#include "macros.h"
+#include "cgeneral.h" 
+#include "cerror.h" 
+#include "rtnewton.h"
+
+
+/*
+***************************************************************************
+** Finds the root of f(x) = 0 using Newton's method.
+**
+** Converges when |f(x)| <= facc, or when the Newton step is no larger
+** than xacc in which case the solution is the stepped x.
+***************************************************************************
+*/
+int JpmcdsRootFindNewton(
+   TObjectDerivFunc funcd,         /* (I) function to be solved */
+   void        *data,              /* (I) data to pass into funcd */
+   double      boundLo,            /* (I) lower bound on legal X */
+   double      boundHi,            /* (I) upper bound on legal X */
+   int         numIterations,      /* (I) Maximum number of iterations */
+   double      guess,              /* (I) Initial guess */
+   double      xacc,               /* (I) X accuracy tolerance */
+   double      facc,               /* (I) function accuracy tolerance */
+   TBoolean    *foundIt,           /* (O) If the root was found */
+   double      *solution)          /* (O) root found */
+{
+    static char routine[] = "JpmcdsRootFindNewton";
+    int         status    = FAILURE;
+
+    double      x = guess;
+    double      xNew;
+    double      f;
+    double      df;
+    int         j;
+
+    REQUIRE (funcd != NULL);
+    REQUIRE (boundLo < boundHi);
+    REQUIRE (foundIt != NULL);
+    REQUIRE (solution != NULL);
+
+    *foundIt = FALSE;
+
+    if (x < boundLo || x > boundHi)
+    {
+        status = SUCCESS;
+        goto done;
+    }
+
+    for (j = 0; j < numIterations; ++j)
+    {
+        if ((*funcd)(x, data, &f, &df) != SUCCESS)
+            goto done;
+
+        if (fabs(f) <= facc)
+        {
+            *foundIt  = TRUE;
+            *solution = x;
+            break;
+        }
+
+        /* this also rejects NaN */
+        if (!(df != 0.0))
+            break;
+
+        xNew = x - f / df;
+        if (!(xNew >= boundLo && xNew <= boundHi))
+            break;
+
+        if (fabs(xNew - x) <= xacc)
+        {
+            *foundIt  = TRUE;
+            *solution = xNew;
+            break;
+        }
+
+        x = xNew;
+    }
+
+    status = SUCCESS;
+
+ done:
+
+    if (status != SUCCESS)
+        JpmcdsErrMsgFailure (routine);
+
+    return status;
+}
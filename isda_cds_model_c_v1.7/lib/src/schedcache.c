@@ -0,0 +1,696 @@
+/*
+ * ISDA CDS Standard Model
+ *
+ * Copyright (C) 2009 International Swaps and Derivatives Association, Inc.
+ * Developed and supported in collaboration with Markit
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the ISDA CDS Standard Model Public License.
+ */
+
+#include "schedcache.h"
+#include <ctype.h>
+#include <string.h>
+#include "buscache.h"
+#include "busday.h"
+#include "cdsimm.h"
+#include "cmemory.h"
+#include "cthread.h"
+#include "cxdatelist.h"
+#include "dtlist.h"
+#include "macros.h"
+#include "cerror.h"
+
+
+/* number of hash buckets when the first schedule is added */
+#define SCHEDULE_CACHE_MIN_BUCKETS 64
+
+
+/*
+** A schedule in the cache. The schedule comes first so that the schedule
+** handed out is also the address of its entry.
+**
+** The cache holds a reference to each of its entries; an entry removed
+** from the cache is freed once its last holder releases it.
+*/
+typedef struct _TScheduleEntry
+{
+    TFeeLegSchedule          schedule;
+    TDate                    startDate;
+    TDate                    endDate;
+    int                      prd;
+    char                     prdType;
+    int                      flag;
+    TBoolean                 stubAtEnd;
+    TBoolean                 longStub;
+    long                     badDayConv;
+    char                    *calendar;      /* upper case, or NULL */
+    TBoolean                 protectStart;
+    unsigned long            hash;
+    long                     holidayVersion;
+    long                     refCount;
+    struct _TScheduleEntry  *hashNext;
+    struct _TScheduleEntry  *lruPrev;       /* more recently used */
+    struct _TScheduleEntry  *lruNext;       /* less recently used */
+} TScheduleEntry;
+
+
+/* Guards everything below, including the reference counts of entries. */
+static TMutex cacheMutex = JPMCDS_MUTEX_INIT;
+
+static TScheduleEntry **buckets     = NULL;
+static long             nbBuckets   = 0;
+static long             nbEntries   = 0;
+static long             maxEntries  = JPMCDS_FEE_SCHEDULE_CACHE_SIZE;
+static TScheduleEntry  *lruFirst    = NULL;
+static TScheduleEntry  *lruLast     = NULL;
+static long             cacheHits   = 0;
+static long             cacheMisses = 0;
+
+
+static TScheduleEntry* scheduleMake
+(TScheduleEntry *key);
+
+static int scheduleMakeRegular
+(TScheduleEntry  *key,
+ TDateInterval   *ivl,
+ TStubMethod     *stub,
+ THolidayList    *hl,
+ TFeeLegSchedule *schedule);
+
+static void entryFree
+(TScheduleEntry *entry);
+
+static TBoolean entryMatch
+(TScheduleEntry *a,
+ TScheduleEntry *b);
+
+static TScheduleEntry* cacheFind
+(TScheduleEntry *key);
+
+static void cacheRemove
+(TScheduleEntry *entry);
+
+static TBoolean cacheInsert
+(TScheduleEntry *entry);
+
+static void lruRemove
+(TScheduleEntry *entry);
+
+static void lruPush
+(TScheduleEntry *entry);
+
+static void cacheTrim
+(long            size);
+
+
+/*
+***************************************************************************
+** Returns the schedule of a vanilla CDS fee leg with the given terms,
+** taking it from the schedule cache if it is there and adding it if not.
+***************************************************************************
+*/
+TFeeLegSchedule* JpmcdsFeeLegScheduleGet
+(TDate           startDate,
+ TDate           endDate,
+ TDateInterval  *dateInterval,
+ TStubMethod    *stubType,
+ long            badDayConv,
+ char           *calendar,
+ TBoolean        protectStart)
+{
+    static char routine[] = "JpmcdsFeeLegScheduleGet";
+
+    TScheduleEntry  key;
+    TScheduleEntry *entry = NULL;
+    TScheduleEntry *made  = NULL;
+    char            calendarBuffer[256];
+    char           *calendarKey = calendarBuffer;
+    unsigned long   hash;
+    size_t          i;
+
+    if (dateInterval == NULL || stubType == NULL)
+    {
+        JpmcdsErrMsg ("%s: Date interval and stub type must be given.\n", routine);
+        goto done;
+    }
+
+    if (badDayConv == JPMCDS_BAD_DAY_NONE)
+        calendar = NULL;
+
+    memset (&key, 0, sizeof(key));
+    key.startDate    = startDate;
+    key.endDate      = endDate;
+    key.prd          = dateInterval->prd;
+    key.prdType      = (char)toupper((int)dateInterval->prd_typ);
+    key.flag         = dateInterval->flag;
+    key.stubAtEnd    = stubType->stubAtEnd;
+    key.longStub     = stubType->longStub;
+    key.badDayConv   = badDayConv;
+    key.protectStart = protectStart;
+
+    hash = (unsigned long)startDate * 31UL + (unsigned long)endDate;
+    hash = hash * 31UL + (unsigned long)key.prd;
+    hash = hash * 31UL + (unsigned long)(unsigned char)key.prdType;
+    hash = hash * 31UL + (unsigned long)key.flag;
+    hash = hash * 31UL + (unsigned long)(key.stubAtEnd * 2 + key.longStub);
+    hash = hash * 31UL + (unsigned long)badDayConv;
+    hash = hash * 31UL + (unsigned long)protectStart;
+
+    if (calendar != NULL)
+    {
+        /* names too long for the buffer are upper cased on the heap */
+        if (strlen (calendar) >= sizeof(calendarBuffer))
+        {
+            calendarKey = NEW_ARRAY(char, strlen (calendar) + 1);
+            if (calendarKey == NULL)
+                goto done;
+        }
+        for (i = 0; calendar[i] != '\0'; ++i)
+        {
+            calendarKey[i] = (char)toupper((int)calendar[i]);
+            hash = hash * 31UL + (unsigned long)(unsigned char)calendarKey[i];
+        }
+        calendarKey[i] = '\0';
+        key.calendar = calendarKey;
+        key.holidayVersion = JpmcdsHolidayCacheVersion();
+    }
+    key.hash = hash;
+
+    JpmcdsMutexLock (&cacheMutex);
+    entry = cacheFind (&key);
+    if (entry != NULL && entry->holidayVersion == key.holidayVersion)
+    {
+        ++cacheHits;
+        ++entry->refCount;
+        lruRemove (entry);
+        lruPush (entry);
+        JpmcdsMutexUnlock (&cacheMutex);
+        goto done;
+    }
+    ++cacheMisses;
+    JpmcdsMutexUnlock (&cacheMutex);
+    entry = NULL;
+
+    /* other threads can use the cache while the schedule is made */
+    made = scheduleMake (&key);
+    if (made == NULL)
+        goto done;
+
+    JpmcdsMutexLock (&cacheMutex);
+    entry = cacheFind (&key);
+    if (entry != NULL && entry->holidayVersion == key.holidayVersion)
+    {
+        /* made by another thread in the meantime */
+        ++entry->refCount;
+    }
+    else
+    {
+        if (entry != NULL)
+        {
+            cacheRemove (entry);
+            if (--entry->refCount == 0)
+                entryFree (entry);
+        }
+        entry = made;
+        made  = NULL;
+        if (maxEntries > 0 && cacheInsert (entry))
+        {
+            ++entry->refCount;
+            cacheTrim (maxEntries);
+        }
+    }
+    JpmcdsMutexUnlock (&cacheMutex);
+
+ done:
+
+    if (made != NULL)
+        entryFree (made);
+
+    if (calendarKey != calendarBuffer)
+        FREE (calendarKey);
+
+    if (entry == NULL)
+    {
+        JpmcdsErrMsgFailure (routine);
+        return NULL;
+    }
+    return &entry->schedule;
+}
+
+
+/*
+***************************************************************************
+** Gives up a reference to a schedule.
+***************************************************************************
+*/
+void JpmcdsFeeLegScheduleRelease
+(TFeeLegSchedule *schedule)
+{
+    TScheduleEntry *entry = (TScheduleEntry*)schedule;
+
+    if (entry == NULL)
+        return;
+
+    JpmcdsMutexLock (&cacheMutex);
+    if (--entry->refCount == 0)
+        entryFree (entry);
+    JpmcdsMutexUnlock (&cacheMutex);
+}
+
+
+/*
+***************************************************************************
+** Sets the number of schedules which the cache keeps.
+***************************************************************************
+*/
+void JpmcdsFeeLegScheduleCacheSetMaxSize
+(long            size)
+{
+    if (size < 0)
+        size = 0;
+
+    JpmcdsMutexLock (&cacheMutex);
+    maxEntries = size;
+    cacheTrim (maxEntries);
+    JpmcdsMutexUnlock (&cacheMutex);
+}
+
+
+/*
+***************************************************************************
+** Returns the counts of the schedule cache.
+***************************************************************************
+*/
+void JpmcdsFeeLegScheduleCacheStats
+(long           *hits,
+ long           *misses,
+ long           *numEntries)
+{
+    JpmcdsMutexLock (&cacheMutex);
+    if (hits != NULL)
+        *hits = cacheHits;
+    if (misses != NULL)
+        *misses = cacheMisses;
+    if (numEntries != NULL)
+        *numEntries = nbEntries;
+    JpmcdsMutexUnlock (&cacheMutex);
+}
+
+
+/*
+***************************************************************************
+** Removes all the schedules from the cache and resets its counts.
+***************************************************************************
+*/
+void JpmcdsFeeLegScheduleCacheEmpty(void)
+{
+    JpmcdsMutexLock (&cacheMutex);
+    cacheTrim (0);
+    FREE (buckets);
+    buckets     = NULL;
+    nbBuckets   = 0;
+    cacheHits   = 0;
+    cacheMisses = 0;
+    JpmcdsMutexUnlock (&cacheMutex);
+}
+
+
+/*
+***************************************************************************
+** Makes the schedule for the terms of the key, as an entry with a single
+** reference which is not yet in the cache.
+**
+** The dates are those which JpmcdsCdsFeeLegMake has always used: the
+** first accrual starts on the unadjusted start date and the others on the
+** adjusted end of the period before. The last accrual ends on the
+** unadjusted end date, or the day after it when protection starts at the
+** start of the day.
+***************************************************************************
+*/
+static TScheduleEntry* scheduleMake
+(TScheduleEntry *key)
+{
+    static char routine[] = "scheduleMake";
+    int         status    = FAILURE;
+
+    TScheduleEntry *entry = NULL;
+    THolidayList   *hl    = NULL;
+    TDateInterval   ivl;
+    TStubMethod     stub;
+
+    ivl.prd        = key->prd;
+    ivl.prd_typ    = key->prdType;
+    ivl.flag       = key->flag;
+    stub.stubAtEnd = key->stubAtEnd;
+    stub.longStub  = key->longStub;
+
+    /* the calendar is found once for all the dates */
+    if (key->badDayConv != JPMCDS_BAD_DAY_NONE)
+    {
+        hl = JpmcdsHolidayListFromCache (key->calendar);
+        if (hl == NULL)
+            goto done;
+    }
+
+    entry = NEW(TScheduleEntry);
+    if (entry == NULL)
+        goto done;
+    *entry = *key;
+    entry->calendar = NULL;
+    entry->schedule.accStartDates = NULL;
+    entry->refCount = 1;
+    entry->hashNext = NULL;
+    entry->lruPrev  = NULL;
+    entry->lruNext  = NULL;
+
+    if (key->calendar != NULL)
+    {
+        entry->calendar = NEW_ARRAY(char, strlen(key->calendar) + 1);
+        if (entry->calendar == NULL)
+            goto done;
+        strcpy (entry->calendar, key->calendar);
+    }
+
+    /* standard quarterly IMM schedules come straight from the IMM dates */
+    if (JpmcdsCdsImmScheduleValid (key->startDate, key->endDate, &ivl, &stub))
+    {
+        if (JpmcdsCdsImmScheduleMake (key->startDate, key->endDate, &ivl, &stub,
+                                      key->badDayConv, hl, key->protectStart,
+                                      &entry->schedule) != SUCCESS)
+            goto done;
+    }
+    else if (scheduleMakeRegular (key, &ivl, &stub, hl, &entry->schedule) != SUCCESS)
+        goto done;
+
+    status = SUCCESS;
+
+ done:
+
+    if (status != SUCCESS)
+    {
+        JpmcdsErrMsgFailure (routine);
+        if (entry != NULL)
+            entryFree (entry);
+        entry = NULL;
+    }
+
+    return entry;
+}
+
+
+/*
+***************************************************************************
+** Makes a schedule by rolling the payment dates with
+** JpmcdsDateListMakeRegular and adjusting each of them.
+***************************************************************************
+*/
+static int scheduleMakeRegular
+(TScheduleEntry  *key,          /* (I) Terms of the schedule */
+ TDateInterval   *ivl,          /* (I) Interval between payments */
+ TStubMethod     *stub,         /* (I) Location and length of the stub */
+ THolidayList    *hl,           /* (I) Holidays, NULL if not adjusted */
+ TFeeLegSchedule *schedule)     /* (O) Schedule made */
+{
+    static char routine[] = "scheduleMakeRegular";
+    int         status    = FAILURE;
+
+    TDateList      *dl    = NULL;
+    TDate           prevDate;
+    TDate           prevDateAdj;
+    int             n;
+    int             i;
+
+    if (key->protectStart && key->endDate == key->startDate)
+    {
+        TDate dates[2];
+        dates[0] = key->startDate;
+        dates[1] = key->endDate;
+        dl = JpmcdsNewDateListFromDates (dates, 2);
+    }
+    else
+    {
+        dl = JpmcdsDateListMakeRegular (key->startDate, key->endDate, ivl, stub);
+    }
+    if (dl == NULL)
+        goto done;
+
+    /* the datelist includes both start date and end date */
+    n = dl->fNumItems - 1;
+    if (n < 1)
+    {
+        JpmcdsErrMsg ("%s: No fee payments.\n", routine);
+        goto done;
+    }
+
+    /* the three arrays share one allocation */
+    schedule->nbDates       = n;
+    schedule->accStartDates = NEW_ARRAY(TDate, 3 * n);
+    if (schedule->accStartDates == NULL)
+        goto done;
+    schedule->accEndDates   = schedule->accStartDates + n;
+    schedule->payDates      = schedule->accEndDates + n;
+
+    prevDate    = dl->fArray[0];
+    prevDateAdj = prevDate; /* first date is not bad day adjusted */
+
+    for (i = 0; i < n; ++i)
+    {
+        TDate nextDate = dl->fArray[i+1];
+        TDate nextDateAdj;
+
+        if (hl == NULL)
+            nextDateAdj = nextDate;
+        else if (JpmcdsHolidayListBusinessDay (nextDate, key->badDayConv, hl,
+                                               &nextDateAdj) != SUCCESS)
+            goto done;
+
+        schedule->accStartDates[i] = prevDateAdj;
+        schedule->accEndDates[i]   = nextDateAdj;
+        schedule->payDates[i]      = nextDateAdj;
+
+        prevDate    = nextDate;
+        prevDateAdj = nextDateAdj;
+    }
+
+    /* the last accrual date is not adjusted */
+    /* also we may have one extra day of accrued interest */
+    schedule->accEndDates[n-1] = key->protectStart ? prevDate + 1 : prevDate;
+
+    status = SUCCESS;
+
+ done:
+
+    if (status != SUCCESS)
+        JpmcdsErrMsgFailure (routine);
+
+    JpmcdsFreeDateList (dl);
+
+    return status;
+}
+
+
+/*
+***************************************************************************
+** Frees an entry which has no references.
+***************************************************************************
+*/
+static void entryFree
+(TScheduleEntry *entry)
+{
+    FREE (entry->schedule.accStartDates);
+    FREE (entry->calendar);
+    FREE (entry);
+}
+
+
+/*
+***************************************************************************
+** Returns TRUE if two entries are for the same terms.
+***************************************************************************
+*/
+static TBoolean entryMatch
+(TScheduleEntry *a,
+ TScheduleEntry *b)
+{
+    if (a->hash != b->hash ||
+        a->startDate != b->startDate ||
+        a->endDate != b->endDate ||
+        a->prd != b->prd ||
+        a->prdType != b->prdType ||
+        a->flag != b->flag ||
+        a->stubAtEnd != b->stubAtEnd ||
+        a->longStub != b->longStub ||
+        a->badDayConv != b->badDayConv ||
+        a->protectStart != b->protectStart)
+        return FALSE;
+
+    if (a->calendar == NULL || b->calendar == NULL)
+        return (TBoolean)(a->calendar == b->calendar);
+
+    return (TBoolean)(strcmp (a->calendar, b->calendar) == 0);
+}
+
+
+/*
+***************************************************************************
+** Returns the entry in the cache for the terms of the key, or NULL.
+** Called with the mutex held.
+***************************************************************************
+*/
+static TScheduleEntry* cacheFind
+(TScheduleEntry *key)
+{
+    TScheduleEntry *entry;
+
+    if (nbBuckets == 0)
+        return NULL;
+
+    for (entry = buckets[key->hash % (unsigned long)nbBuckets];
+         entry != NULL;
+         entry = entry->hashNext)
+    {
+        if (entryMatch (entry, key))
+            return entry;
+    }
+    return NULL;
+}
+
+
+/*
+***************************************************************************
+** Takes an entry out of the hash table and the LRU list, leaving its
+** reference count alone. Called with the mutex held.
+***************************************************************************
+*/
+static void cacheRemove
+(TScheduleEntry *entry)
+{
+    TScheduleEntry **link = &buckets[entry->hash % (unsigned long)nbBuckets];
+
+    while (*link != entry)
+        link = &(*link)->hashNext;
+    *link = entry->hashNext;
+    entry->hashNext = NULL;
+
+    lruRemove (entry);
+
+    --nbEntries;
+}
+
+
+/*
+***************************************************************************
+** Puts an entry into the hash table as the most recently used, growing
+** the table if it has become crowded. Returns FALSE if there is no table
+** and none can be allocated. Called with the mutex held.
+***************************************************************************
+*/
+static TBoolean cacheInsert
+(TScheduleEntry *entry)
+{
+    TScheduleEntry **link;
+
+    if (nbEntries >= 2 * nbBuckets)
+    {
+        long             newSize = nbBuckets == 0 ?
+                                   SCHEDULE_CACHE_MIN_BUCKETS : 2 * nbBuckets;
+        TScheduleEntry **newBuckets = NEW_ARRAY(TScheduleEntry*, newSize);
+        long             i;
+
+        /* when short of memory keep the crowded table */
+        if (newBuckets != NULL)
+        {
+            for (i = 0; i < newSize; ++i)
+                newBuckets[i] = NULL;
+            for (i = 0; i < nbBuckets; ++i)
+            {
+                TScheduleEntry *e = buckets[i];
+                while (e != NULL)
+                {
+                    TScheduleEntry *next = e->hashNext;
+                    TScheduleEntry **to  =
+                        &newBuckets[e->hash % (unsigned long)newSize];
+                    e->hashNext = *to;
+                    *to = e;
+                    e = next;
+                }
+            }
+            FREE (buckets);
+            buckets   = newBuckets;
+            nbBuckets = newSize;
+        }
+        else if (nbBuckets == 0)
+        {
+            return FALSE;
+        }
+    }
+
+    link = &buckets[entry->hash % (unsigned long)nbBuckets];
+    entry->hashNext = *link;
+    *link = entry;
+
+    lruPush (entry);
+
+    ++nbEntries;
+    return TRUE;
+}
+
+
+/*
+***************************************************************************
+** Takes an entry out of the LRU list. Called with the mutex held.
+***************************************************************************
+*/
+static void lruRemove
+(TScheduleEntry *entry)
+{
+    if (entry->lruPrev != NULL)
+        entry->lruPrev->lruNext = entry->lruNext;
+    else
+        lruFirst = entry->lruNext;
+    if (entry->lruNext != NULL)
+        entry->lruNext->lruPrev = entry->lruPrev;
+    else
+        lruLast = entry->lruPrev;
+    entry->lruPrev = NULL;
+    entry->lruNext = NULL;
+}
+
+
+/*
+***************************************************************************
+** Puts an entry at the front of the LRU list. Called with the mutex held.
+***************************************************************************
+*/
+static void lruPush
+(TScheduleEntry *entry)
+{
+    entry->lruPrev = NULL;
+    entry->lruNext = lruFirst;
+    if (lruFirst != NULL)
+        lruFirst->lruPrev = entry;
+    else
+        lruLast = entry;
+    lruFirst = entry;
+}
+
+
+/*
+***************************************************************************
+** Removes the least recently used entries until at most size are left.
+** Called with the mutex held.
+***************************************************************************
+*/
+static void cacheTrim
+(long            size)
+{
+    while (nbEntries > size)
+    {
+        TScheduleEntry *entry = lruLast;
+
+        cacheRemove (entry);
+        if (--entry->refCount == 0)
+            entryFree (entry);
+    }
+}
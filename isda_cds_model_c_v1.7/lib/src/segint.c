@@ -0,0 +1,395 @@
+/*
+ * ISDA CDS Standard Model
+ *
+ * Copyright (C) 2009 International Swaps and Derivatives Association, Inc.
+ * Developed and supported in collaboration with Markit
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the ISDA CDS Standard Model Public License.
+ */
+
+#include <math.h>
+#include "segint.h"
+
+#if !defined(JPMCDS_NO_SIMD) && (defined(__GNUC__) || defined(__clang__)) && \
+    (defined(__x86_64__) || defined(__i386__))
+#define SEGINT_AVX2
+#include <immintrin.h>
+#endif
+
+
+/*
+***************************************************************************
+** Scalar integrals. These are the loops of onePeriodIntegral and
+** AccrualOnDefaultPV.
+***************************************************************************
+*/
+static double protectionScalar
+(long          n,
+ double        loss,
+ const double *s,
+ const double *df,
+ const double *dt)
+{
+    double myPv = 0.0;
+    long   i;
+
+    for (i = 0; i < n; ++i)
+    {
+        double t       = dt[i];
+        double lambda  = log(s[i]/s[i+1])/t;
+        double fwdRate = log(df[i]/df[i+1])/t;
+
+        myPv += loss * lambda / (lambda + fwdRate) *
+            (1.0 - exp(-(lambda + fwdRate) * t)) * s[i] * df[i];
+    }
+    return myPv;
+}
+
+static double accrualScalar
+(long          n,
+ double        accRate,
+ const double *s,
+ const double *df,
+ const double *t)
+{
+    double myPv = 0.0;
+    long   i;
+
+    for (i = 0; i < n; ++i)
+    {
+        double t0 = t[i];
+        double t1 = t[i+1];
+        double dt = t1 - t0;
+        double lambda  = log(s[i]/s[i+1])/dt;
+        double fwdRate = log(df[i]/df[i+1])/dt;
+        double lambdafwdRate = lambda + fwdRate + 1.0e-50;
+
+        myPv += lambda * accRate * s[i] * df[i] * (
+            (t0 + 1.0/(lambdafwdRate))/(lambdafwdRate) -
+            (t1 + 1.0/(lambdafwdRate))/(lambdafwdRate) *
+            s[i+1]/s[i] * df[i+1]/df[i]);
+    }
+    return myPv;
+}
+
+
+#ifdef SEGINT_AVX2
+
+#define SEGINT_TARGET __attribute__((target("avx2,fma")))
+
+/*
+***************************************************************************
+** Logarithm of four positive normal numbers, with the reduction and the
+** polynomial of the fdlibm logarithm. Accurate to within one ulp.
+***************************************************************************
+*/
+SEGINT_TARGET static __m256d log4(__m256d x)
+{
+    const __m256d one    = _mm256_set1_pd(1.0);
+    const __m256d half   = _mm256_set1_pd(0.5);
+    const __m256d ln2Hi  = _mm256_set1_pd(6.93147180369123816490e-01);
+    const __m256d ln2Lo  = _mm256_set1_pd(1.90821492927058770002e-10);
+    const __m256d Lg1    = _mm256_set1_pd(6.666666666666735130e-01);
+    const __m256d Lg2    = _mm256_set1_pd(3.999999999940941908e-01);
+    const __m256d Lg3    = _mm256_set1_pd(2.857142874366239149e-01);
+    const __m256d Lg4    = _mm256_set1_pd(2.222219843214978396e-01);
+    const __m256d Lg5    = _mm256_set1_pd(1.818357216161805012e-01);
+    const __m256d Lg6    = _mm256_set1_pd(1.531383769920937332e-01);
+    const __m256d Lg7    = _mm256_set1_pd(1.479819860511658591e-01);
+    const __m256d two52  = _mm256_set1_pd(4503599627370496.0);
+
+    __m256i bits = _mm256_castpd_si256(x);
+    __m256d k;
+    __m256d m;
+    __m256d f, s, z, w, t1, t2, R, hfsq;
+    __m256d big;
+
+    /* x = m * 2^k with m in [1,2) - the exponent is converted to a
+       double by placing it in the mantissa of 2^52 */
+    k = _mm256_sub_pd(
+        _mm256_castsi256_pd(_mm256_or_si256(_mm256_srli_epi64(bits, 52),
+                                            _mm256_castpd_si256(two52))),
+        two52);
+    k = _mm256_sub_pd(k, _mm256_set1_pd(1023.0));
+    m = _mm256_castsi256_pd(_mm256_or_si256(
+        _mm256_and_si256(bits, _mm256_set1_epi64x(0x000FFFFFFFFFFFFFLL)),
+        _mm256_set1_epi64x(0x3FF0000000000000LL)));
+
+    /* then m in [sqrt(2)/2, sqrt(2)) */
+    big = _mm256_cmp_pd(m, _mm256_set1_pd(1.41421356237309504880), _CMP_GT_OQ);
+    m   = _mm256_blendv_pd(m, _mm256_mul_pd(m, half), big);
+    k   = _mm256_add_pd(k, _mm256_and_pd(big, one));
+
+    f    = _mm256_sub_pd(m, one);
+    s    = _mm256_div_pd(f, _mm256_add_pd(_mm256_set1_pd(2.0), f));
+    z    = _mm256_mul_pd(s, s);
+    w    = _mm256_mul_pd(z, z);
+    t1   = _mm256_mul_pd(w, _mm256_fmadd_pd(w, _mm256_fmadd_pd(w, Lg6, Lg4), Lg2));
+    t2   = _mm256_mul_pd(z, _mm256_fmadd_pd(w, _mm256_fmadd_pd(w,
+                         _mm256_fmadd_pd(w, Lg7, Lg5), Lg3), Lg1));
+    R    = _mm256_add_pd(t2, t1);
+    hfsq = _mm256_mul_pd(_mm256_mul_pd(half, f), f);
+
+    /* k*ln2Hi - ((hfsq - (s*(hfsq+R) + k*ln2Lo)) - f) */
+    return _mm256_sub_pd(
+        _mm256_mul_pd(k, ln2Hi),
+        _mm256_sub_pd(
+            _mm256_sub_pd(hfsq,
+                          _mm256_add_pd(_mm256_mul_pd(s, _mm256_add_pd(hfsq, R)),
+                                        _mm256_mul_pd(k, ln2Lo))),
+            f));
+}
+
+
+/*
+***************************************************************************
+** Exponential of four numbers in [-700,700], with the reduction and the
+** polynomial of the fdlibm exponential. Accurate to within one ulp.
+***************************************************************************
+*/
+SEGINT_TARGET static __m256d exp4(__m256d x)
+{
+    const __m256d one    = _mm256_set1_pd(1.0);
+    const __m256d two    = _mm256_set1_pd(2.0);
+    const __m256d invLn2 = _mm256_set1_pd(1.44269504088896338700e+00);
+    const __m256d ln2Hi  = _mm256_set1_pd(6.93147180369123816490e-01);
+    const __m256d ln2Lo  = _mm256_set1_pd(1.90821492927058770002e-10);
+    const __m256d P1     = _mm256_set1_pd( 1.66666666666666019037e-01);
+    const __m256d P2     = _mm256_set1_pd(-2.77777777770155933842e-03);
+    const __m256d P3     = _mm256_set1_pd( 6.61375632143793436117e-05);
+    const __m256d P4     = _mm256_set1_pd(-1.65339022054652515390e-06);
+    const __m256d P5     = _mm256_set1_pd( 4.13813679705723846039e-08);
+    const __m256d shift  = _mm256_set1_pd(6755399441055744.0); /* 1.5*2^52 */
+
+    __m256d k, hi, lo, r, r2, c, y;
+    __m256i ki;
+
+    k  = _mm256_round_pd(_mm256_mul_pd(x, invLn2),
+                         _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+    hi = _mm256_fnmadd_pd(k, ln2Hi, x);
+    lo = _mm256_mul_pd(k, ln2Lo);
+    r  = _mm256_sub_pd(hi, lo);
+    r2 = _mm256_mul_pd(r, r);
+    c  = _mm256_fnmadd_pd(r2,
+             _mm256_fmadd_pd(r2, _mm256_fmadd_pd(r2, _mm256_fmadd_pd(r2,
+                 _mm256_fmadd_pd(r2, P5, P4), P3), P2), P1), r);
+
+    /* 1 - ((lo - (r*c)/(2-c)) - hi) */
+    y = _mm256_sub_pd(one, _mm256_sub_pd(
+            _mm256_sub_pd(lo, _mm256_div_pd(_mm256_mul_pd(r, c),
+                                            _mm256_sub_pd(two, c))),
+            hi));
+
+    /* scale by 2^k - the low bits of k+1.5*2^52 hold k */
+    ki = _mm256_castpd_si256(_mm256_add_pd(k, shift));
+    return _mm256_castsi256_pd(_mm256_add_epi64(_mm256_castpd_si256(y),
+                                                _mm256_slli_epi64(ki, 52)));
+}
+
+
+/*
+***************************************************************************
+** Returns a mask of the lanes whose values are positive and normal, so
+** that they can be passed to log4.
+***************************************************************************
+*/
+SEGINT_TARGET static int logSafe4(__m256d x)
+{
+    __m256d ok = _mm256_and_pd(
+        _mm256_cmp_pd(x, _mm256_set1_pd(2.2250738585072014e-308), _CMP_GE_OQ),
+        _mm256_cmp_pd(x, _mm256_set1_pd(1.7976931348623157e+308), _CMP_LE_OQ));
+    return _mm256_movemask_pd(ok);
+}
+
+SEGINT_TARGET static int expSafe4(__m256d x)
+{
+    __m256d ok = _mm256_and_pd(
+        _mm256_cmp_pd(x, _mm256_set1_pd(-700.0), _CMP_GE_OQ),
+        _mm256_cmp_pd(x, _mm256_set1_pd(700.0), _CMP_LE_OQ));
+    return _mm256_movemask_pd(ok);
+}
+
+SEGINT_TARGET static double sum4(__m256d x)
+{
+    __m128d lo = _mm256_castpd256_pd128(x);
+    __m128d hi = _mm256_extractf128_pd(x, 1);
+    lo = _mm_add_pd(lo, hi);
+    return _mm_cvtsd_f64(_mm_add_sd(lo, _mm_unpackhi_pd(lo, lo)));
+}
+
+
+/*
+***************************************************************************
+** Protection integral four segments at a time. A group of segments whose
+** factors are outside the range of log4 or exp4 is integrated by the
+** scalar loop.
+***************************************************************************
+*/
+SEGINT_TARGET static double protectionAvx2
+(long          n,
+ double        loss,
+ const double *s,
+ const double *df,
+ const double *dt)
+{
+    const __m256d vLoss = _mm256_set1_pd(loss);
+    const __m256d one   = _mm256_set1_pd(1.0);
+    __m256d       vPv   = _mm256_setzero_pd();
+    double        myPv  = 0.0;
+    long          i;
+
+    for (i = 0; i + 4 <= n; i += 4)
+    {
+        __m256d s0  = _mm256_loadu_pd(s + i);
+        __m256d s1  = _mm256_loadu_pd(s + i + 1);
+        __m256d df0 = _mm256_loadu_pd(df + i);
+        __m256d df1 = _mm256_loadu_pd(df + i + 1);
+        __m256d t   = _mm256_loadu_pd(dt + i);
+        __m256d sRatio  = _mm256_div_pd(s0, s1);
+        __m256d dfRatio = _mm256_div_pd(df0, df1);
+        __m256d lambda, fwdRate, lambdaFwd, x;
+
+        if ((logSafe4(sRatio) & logSafe4(dfRatio)) != 0xF)
+        {
+            myPv += protectionScalar(4, loss, s + i, df + i, dt + i);
+            continue;
+        }
+
+        lambda    = _mm256_div_pd(log4(sRatio), t);
+        fwdRate   = _mm256_div_pd(log4(dfRatio), t);
+        lambdaFwd = _mm256_add_pd(lambda, fwdRate);
+        x         = _mm256_mul_pd(_mm256_sub_pd(_mm256_setzero_pd(), lambdaFwd), t);
+
+        if (expSafe4(x) != 0xF)
+        {
+            myPv += protectionScalar(4, loss, s + i, df + i, dt + i);
+            continue;
+        }
+
+        vPv = _mm256_add_pd(vPv,
+            _mm256_mul_pd(
+                _mm256_mul_pd(
+                    _mm256_div_pd(_mm256_mul_pd(vLoss, lambda), lambdaFwd),
+                    _mm256_sub_pd(one, exp4(x))),
+                _mm256_mul_pd(s0, df0)));
+    }
+
+    return myPv + sum4(vPv) + protectionScalar(n - i, loss, s + i, df + i, dt + i);
+}
+
+
+/*
+***************************************************************************
+** Accrual on default integral four segments at a time.
+***************************************************************************
+*/
+SEGINT_TARGET static double accrualAvx2
+(long          n,
+ double        accRate,
+ const double *s,
+ const double *df,
+ const double *t)
+{
+    const __m256d vAccRate = _mm256_set1_pd(accRate);
+    const __m256d one      = _mm256_set1_pd(1.0);
+    const __m256d tiny     = _mm256_set1_pd(1.0e-50);
+    __m256d       vPv      = _mm256_setzero_pd();
+    double        myPv     = 0.0;
+    long          i;
+
+    for (i = 0; i + 4 <= n; i += 4)
+    {
+        __m256d s0  = _mm256_loadu_pd(s + i);
+        __m256d s1  = _mm256_loadu_pd(s + i + 1);
+        __m256d df0 = _mm256_loadu_pd(df + i);
+        __m256d df1 = _mm256_loadu_pd(df + i + 1);
+        __m256d t0  = _mm256_loadu_pd(t + i);
+        __m256d t1  = _mm256_loadu_pd(t + i + 1);
+        __m256d dt  = _mm256_sub_pd(t1, t0);
+        __m256d sRatio  = _mm256_div_pd(s0, s1);
+        __m256d dfRatio = _mm256_div_pd(df0, df1);
+        __m256d lambda, fwdRate, lf, invLf, h0, h1;
+
+        if ((logSafe4(sRatio) & logSafe4(dfRatio)) != 0xF)
+        {
+            myPv += accrualScalar(4, accRate, s + i, df + i, t + i);
+            continue;
+        }
+
+        lambda  = _mm256_div_pd(log4(sRatio), dt);
+        fwdRate = _mm256_div_pd(log4(dfRatio), dt);
+        lf      = _mm256_add_pd(_mm256_add_pd(lambda, fwdRate), tiny);
+        invLf   = _mm256_div_pd(one, lf);
+        h0      = _mm256_div_pd(_mm256_add_pd(t0, invLf), lf);
+        h1      = _mm256_div_pd(_mm256_add_pd(t1, invLf), lf);
+
+        /* lambda*accRate*s0*df0*(h0 - h1*s1/s0*df1/df0) */
+        vPv = _mm256_add_pd(vPv,
+            _mm256_mul_pd(
+                _mm256_mul_pd(_mm256_mul_pd(lambda, vAccRate),
+                              _mm256_mul_pd(s0, df0)),
+                _mm256_sub_pd(h0,
+                    _mm256_mul_pd(h1, _mm256_div_pd(_mm256_mul_pd(s1, df1),
+                                                    _mm256_mul_pd(s0, df0))))));
+    }
+
+    return myPv + sum4(vPv) + accrualScalar(n - i, accRate, s + i, df + i, t + i);
+}
+
+#endif /* SEGINT_AVX2 */
+
+
+/*
+***************************************************************************
+** Returns TRUE if the segment integrals process four segments at a time.
+***************************************************************************
+*/
+TBoolean JpmcdsSegmentsVectorized(void)
+{
+#ifdef SEGINT_AVX2
+    return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+#else
+    return FALSE;
+#endif
+}
+
+
+/*
+***************************************************************************
+** Returns the protection integral over n segments of a timeline.
+***************************************************************************
+*/
+double JpmcdsProtectionSegmentsPV
+(long          n,
+ double        loss,
+ const double *s,
+ const double *df,
+ const double *dt)
+{
+#ifdef SEGINT_AVX2
+    if (n >= 4 && JpmcdsSegmentsVectorized())
+        return protectionAvx2 (n, loss, s, df, dt);
+#endif
+    return protectionScalar (n, loss, s, df, dt);
+}
+
+
+/*
+***************************************************************************
+** Returns the accrual on default integral over n segments of a timeline.
+***************************************************************************
+*/
+double JpmcdsAccrualSegmentsPV
+(long          n,
+ double        accRate,
+ const double *s,
+ const double *df,
+ const double *t)
+{
+#ifdef SEGINT_AVX2
+    if (n >= 4 && JpmcdsSegmentsVectorized())
+        return accrualAvx2 (n, accRate, s, df, t);
+#endif
+    return accrualScalar (n, accRate, s, df, t);
+}
@@ -16,6 +16,11 @@
 #include "tcurve.h"
 
 
+#define TIMELINE_DATE(base, skip, i) (*(TDate*)((char*)(base) + (i)*(skip)))
+
+static long timeLineFirstAfter (TDate, TDate*, size_t, long);
+
+
 /*
 ***************************************************************************
 ** Returns a timeline for use with risky integrations assuming flat
@@ -118,3 +123,234 @@ TDateList* JpmcdsTruncateTimeLine
     
     return tl;
 }
+
+
+/*
+***************************************************************************
+** Returns the critical dates for risky integrations assuming flat
+** forward curves, i.e. all the points in the discount curve and all the
+** points in the risky curve.
+**
+** Truncating this with JpmcdsTruncateTimeLine gives the same timeline as
+** JpmcdsRiskyTimeLine, so it can be computed once and shared between
+** integrations over different periods.
+***************************************************************************
+*/
+TDateList* JpmcdsRiskyCriticalDates
+(TCurve           *discCurve,
+ TCurve           *spreadCurve)
+{
+    static char routine[] = "JpmcdsRiskyCriticalDates";
+
+    TDateList *tl  = NULL;
+    TDate     *dates = NULL;
+
+    REQUIRE (discCurve != NULL);
+    REQUIRE (spreadCurve != NULL);
+
+    tl = JpmcdsNewDateListFromTCurve(discCurve);
+    if (tl == NULL) goto done;
+
+    dates = JpmcdsDatesFromCurve(spreadCurve);
+    tl = JpmcdsDateListAddDatesFreeOld(tl, spreadCurve->fNumItems, dates);
+
+ done:
+
+    if (tl == NULL)
+        JpmcdsErrMsgFailure(routine);
+
+    FREE (dates);
+
+    return tl;
+}
+
+
+/*
+***************************************************************************
+** Writes a timeline for risky integrations into a buffer supplied by the
+** caller without allocating any memory.
+**
+** Each source of dates is sorted, so a binary search finds the first
+** date after startDate in each and the rest is a single merge.
+***************************************************************************
+*/
+int JpmcdsRiskyTimeLineToBuffer
+(TDate             startDate,
+ TDate             endDate,
+ TCurve           *discCurve,
+ TCurve           *spreadCurve,
+ TDateList        *criticalDates,
+ long              maxDates,
+ TDate            *dates,
+ long             *numDates)
+{
+    static char routine[] = "JpmcdsRiskyTimeLineToBuffer";
+    int         status    = FAILURE;
+
+    TDate      *base1;
+    TDate      *base2 = NULL;
+    size_t      skip1;
+    size_t      skip2 = 0;
+    long        n1;
+    long        n2 = 0;
+    long        i;
+    long        j;
+    long        k;
+
+    REQUIRE (endDate > startDate);
+    REQUIRE (maxDates >= 0);
+    REQUIRE (dates != NULL || maxDates == 0);
+    REQUIRE (numDates != NULL);
+
+    if (criticalDates != NULL)
+    {
+        base1 = criticalDates->fArray;
+        skip1 = sizeof(TDate);
+        n1    = criticalDates->fNumItems;
+    }
+    else
+    {
+        REQUIRE (discCurve != NULL);
+        REQUIRE (spreadCurve != NULL);
+
+        base1 = &discCurve->fArray[0].fDate;
+        skip1 = sizeof(TRatePt);
+        n1    = discCurve->fNumItems;
+        base2 = &spreadCurve->fArray[0].fDate;
+        skip2 = sizeof(TRatePt);
+        n2    = spreadCurve->fNumItems;
+    }
+
+    i = timeLineFirstAfter (startDate, base1, skip1, n1);
+    j = timeLineFirstAfter (startDate, base2, skip2, n2);
+
+    k = 0;
+    if (k < maxDates)
+        dates[k] = startDate;
+    ++k;
+
+    while (TRUE)
+    {
+        TDate d1 = i < n1 ? TIMELINE_DATE(base1, skip1, i) : endDate;
+        TDate d2 = j < n2 ? TIMELINE_DATE(base2, skip2, j) : endDate;
+        TDate d  = MIN(d1, d2);
+
+        if (d >= endDate)
+            break;
+
+        /* a date in both sources, or repeated in a curve, appears once */
+        while (i < n1 && TIMELINE_DATE(base1, skip1, i) == d)
+            ++i;
+        while (j < n2 && TIMELINE_DATE(base2, skip2, j) == d)
+            ++j;
+
+        if (k < maxDates)
+            dates[k] = d;
+        ++k;
+    }
+
+    if (k < maxDates)
+        dates[k] = endDate;
+    ++k;
+
+    *numDates = k;
+    status    = SUCCESS;
+
+ done:
+
+    if (status != SUCCESS)
+        JpmcdsErrMsgFailure (routine);
+
+    return status;
+}
+
+
+/*
+***************************************************************************
+** Makes a view of the timeline for risky integrations over a period.
+**
+** The critical dates are sorted, so two binary searches find the dates
+** strictly inside the period and nothing is copied.
+***************************************************************************
+*/
+int JpmcdsRiskyTimeLineView
+(TDate             startDate,
+ TDate             endDate,
+ TCurve           *discCurve,
+ TCurve           *spreadCurve,
+ TDateList        *criticalDates,
+ long              maxDates,
+ TDate            *dates,
+ TTimeLineView    *view)
+{
+    static char routine[] = "JpmcdsRiskyTimeLineView";
+    int         status    = FAILURE;
+
+    long        numDates;
+
+    REQUIRE (endDate > startDate);
+    REQUIRE (view != NULL);
+
+    view->startDate = startDate;
+    view->endDate   = endDate;
+
+    if (criticalDates != NULL)
+    {
+        view->dates = criticalDates->fArray;
+        view->begin = timeLineFirstAfter (startDate, criticalDates->fArray,
+                                          sizeof(TDate),
+                                          criticalDates->fNumItems);
+        view->end   = timeLineFirstAfter (endDate - 1, criticalDates->fArray,
+                                          sizeof(TDate),
+                                          criticalDates->fNumItems);
+    }
+    else
+    {
+        /* the buffer holds startDate and endDate as well */
+        if (JpmcdsRiskyTimeLineToBuffer (startDate, endDate,
+                                         discCurve, spreadCurve, NULL,
+                                         maxDates, dates,
+                                         &numDates) != SUCCESS)
+            goto done;
+
+        view->dates = numDates > maxDates ? NULL : dates;
+        view->begin = 1;
+        view->end   = numDates - 1;
+    }
+
+    status = SUCCESS;
+
+ done:
+
+    if (status != SUCCESS)
+        JpmcdsErrMsgFailure (routine);
+
+    return status;
+}
+
+
+/*
+***************************************************************************
+** Returns the index of the first of n sorted dates strictly after date,
+** or n if there is none. The dates are skip bytes apart.
+***************************************************************************
+*/
+static long timeLineFirstAfter
+(TDate      date,
+ TDate     *base,
+ size_t     skip,
+ long       n)
+{
+    long lo = 0;
+    long hi = n;
+
+    while (lo < hi)
+    {
+        long mid = (lo + hi) / 2;
+        if (TIMELINE_DATE(base, skip, mid) <= date)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    return lo;
+}
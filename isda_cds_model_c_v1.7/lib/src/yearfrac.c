@@ -169,7 +169,7 @@ int JpmcdsStringToDayCountConv(char *dayCountString, long *type)
 {
     static char  routine[]="JpmcdsStringToDayCountConv";
 #define MAX_DCC_CHARS 32
-    static char  privDccString[MAX_DCC_CHARS + 1];
+    char         privDccString[MAX_DCC_CHARS + 1];
     char *str = NULL;
 
     /* Remove white space, convert to capitals.
@@ -16,6 +16,7 @@
 #include "cerror.h"
 #include "cmemory.h"
 #include "rtbrent.h"
+#include "rtnewton.h"
 #include "convert.h"
 #include "datelist.h"
 #include "date_sup.h"
@@ -43,6 +44,14 @@
 #define LOWER_BOUND             (-DBL_MAX/1000)
 #define UPPER_BOUND             (DBL_MAX/1000)
 
+/* Define constants for JpmcdsRootFindNewton, which gives up to Brent
+ * outside these rates */
+#define NEWTON_MIN_RATE         (-0.99)
+#define NEWTON_MAX_RATE         (MAX_ZERO_RATE)
+#define NEWTON_X_TOLERANCE      (1E-15)
+#define NEWTON_F_TOLERANCE      (1E-14)
+#define NEWTON_ITERATIONS       (20)
+
 typedef struct {                           /* data of objective-functions */
    ZCurve         *zc;                     /* ZCurve being fit */
    TCashFlowList  *cfl;                    /* cash flows specifying fit */
@@ -55,6 +64,8 @@ typedef struct {                           /* data of objective-functions */
    double          offset;                 /*  ""   "" : const for linear eqn*/
    double          startingDiscount;       /*  ""   "" : discount to 1st fwd */
    TDateList      *fwdDL;                  /*  ""   "" : list of forward dts*/
+   double         *weight;                 /* flat fwds only: weight of rate */
+   double          discountLo;             /*  ""   "" : discount before it */
 } TObjectiveData;
 
 
@@ -74,6 +85,30 @@ static int JpmcdsObjFunctionRate(            /* objective func for root finder *
    double             *result);            /* (O) objective function value */
 
 
+/*
+***************************************************************************
+** Sets up the flat forward objective function ObjFunctionRateFlatFwd.
+** Returns FALSE if the zero curve does not allow it.
+***************************************************************************
+*/
+static TBoolean SetupFlatFwdObjective(
+   TObjectiveData     *data,               /* (M) representing problem solved*/
+   double             *weight);            /* (O) for each uncovered c.f. */
+
+
+/*
+***************************************************************************
+** Objective function for use with JpmcdsRootFindNewton when the zero
+** curve is interpolated with flat forwards, with its derivative.
+***************************************************************************
+*/
+static int ObjFunctionRateFlatFwd(
+   double              rate,               /* (I) newest rate guess */
+   TObjectiveData     *data,               /* (I) representing problem solved*/
+   double             *result,             /* (O) objective function value */
+   double             *deriv);             /* (O) derivative wrt rate */
+
+
 /*
 ***************************************************************************
 ** Constructs a TCurve from a ZCurve.
@@ -188,6 +223,7 @@ ZCurve* JpmcdsZCMake(              /* constructor for ZCurve */
    zc->numAlloc     = n;
    zc->basis        = basis;
    zc->dayCountConv = dayCountConv;
+   zc->newtonSolve  = FALSE;
 
    return zc;
 }
@@ -362,6 +398,9 @@ int JpmcdsZCAddMoneyMarket(        /* adds simple-interest MMKT to ZC */
 ** Notes: date may be set for non-linear-forward interpolation methods to a 
 ** date to be added to the zero curve.  This allows production of a curve 
 ** with "nice" dates.
+**
+** With zc->newtonSolve set, flat forward points are solved for by Newton
+** before falling back to Brent.
 ***************************************************************************
 */
 int JpmcdsZCAddCashFlowList(       /* adds cashFlowList info to a ZCurve */
@@ -376,6 +415,7 @@ int JpmcdsZCAddCashFlowList(       /* adds cashFlowList info to a ZCurve */
     int         status = FAILURE;       /* Until proven successful */
     double      sumNPV = 0.0;           /* sum of n.p.vs of uncovered c.f.s */
     int         firstUncovered;         /* index in cfl of 1st uncovered c.f.*/
+    double     *weight = NULL;          /* flat fwds: see TObjectiveData */
 
     if (date==0L)                       /* add at last c.f. if not set up */
     {
@@ -442,6 +482,7 @@ int JpmcdsZCAddCashFlowList(       /* adds cashFlowList info to a ZCurve */
     {                                  
         double          rate;       /* rate to use for guess (and result)*/
         TObjectiveData  objData;    /* data for objective function */
+        TBoolean        foundIt = FALSE; /* if Newton found the rate */
        
         if (zc->numItems<=0)        /* make a guess based on zc */
         {
@@ -467,8 +508,47 @@ int JpmcdsZCAddCashFlowList(       /* adds cashFlowList info to a ZCurve */
         objData.offset           = 0.0; /* ditto */
         objData.startingDiscount = 0.0; /* ditto */
         objData.fwdDL            = NULL; /* ditto */
-       
-        if (JpmcdsRootFindBrent((TObjectFunc) JpmcdsObjFunctionRate,
+        objData.weight           = NULL; /* set up below */
+        objData.discountLo       = 0.0; /* ditto */
+
+        /* With flat forwards, the p.v. of the uncovered c.f.s is a sum
+         * of powers of the discount at the new rate, so Newton's method
+         * can solve for it without interpolating on the zero curve.
+         * Brent is always used when Newton gives up, and unless asked
+         * for, since Newton does not stop where Brent does.
+         */
+        if (interpType == JPMCDS_FLAT_FORWARDS && zc->newtonSolve)
+        {
+            weight = NEW_ARRAY(double, cfl->fNumItems - firstUncovered);
+            if (weight == NULL)
+                goto done;
+
+            if (SetupFlatFwdObjective(&objData, weight))
+            {
+                if (JpmcdsRootFindNewton((TObjectDerivFunc) ObjFunctionRateFlatFwd,
+                                      &objData,
+                                      NEWTON_MIN_RATE, NEWTON_MAX_RATE,
+                                      NEWTON_ITERATIONS, rate,
+                                      NEWTON_X_TOLERANCE, NEWTON_F_TOLERANCE,
+                                      &foundIt,
+                                      &rate) == FAILURE)
+                {
+                    goto done;
+                }
+            }
+        }
+
+        if (foundIt)
+        {
+            if (JpmcdsZCComputeDiscount(zc,
+                                     date,
+                                     rate,
+                                    &zc->discount[ objData.zcIndex ]) == FAILURE)
+            {
+                goto done;
+            }
+        }
+        else if (JpmcdsRootFindBrent((TObjectFunc) JpmcdsObjFunctionRate,
                              &objData,
                              MIN_ZERO_RATE, MAX_ZERO_RATE,
                              MAX_ITERATIONS, rate,
@@ -502,6 +582,7 @@ int JpmcdsZCAddCashFlowList(       /* adds cashFlowList info to a ZCurve */
     status = SUCCESS;
 
   done:
+    FREE_ARRAY(weight);
     if (status == FAILURE)
         JpmcdsErrMsg("%s: Failed for CFL maturing %s.\n", routine, JpmcdsFormatDate(cfl->fArray[cfl->fNumItems-1].fDate));
 
@@ -637,6 +718,109 @@ static int JpmcdsObjFunctionRate( /* objective function for root finder */
 }
 
 
+/*
+***************************************************************************
+** Sets up the flat forward objective function ObjFunctionRateFlatFwd.
+**
+** Every uncovered c.f. is beyond the previous point lo of the zero curve,
+** so JpmcdsZCInterpolate finds its discount as
+**     discount[lo] * (discount/discount[lo])^weight
+** from the discount at the rate being fit, with a weight which does not
+** depend on the rate. The derivative of the discount with respect to the
+** rate is only known for the annual rates hard coded in
+** JpmcdsZCComputeDiscount.
+***************************************************************************
+*/
+static TBoolean SetupFlatFwdObjective(
+   TObjectiveData     *data,               /* (M) representing problem solved*/
+   double             *weight)             /* (O) for each uncovered c.f. */
+{
+   ZCurve     *zc = data->zc;
+   int         hi = data->zcIndex;
+   int         lo = hi - 1;
+   int         i;
+
+   if (lo < 0 || hi != zc->numItems - 1 ||
+       zc->basis != 1 ||
+       (zc->dayCountConv != JPMCDS_ACT_365F && zc->dayCountConv != JPMCDS_ACT_360))
+       return FALSE;
+
+   if (JpmcdsZCComputeDiscount(zc, zc->date[lo], zc->rate[lo],
+                            &data->discountLo) == FAILURE ||
+       !(data->discountLo > 0.0))
+       return FALSE;
+
+   for (i = data->firstUncovered; i < data->cfl->fNumItems; i++)
+   {
+       long hi_lo = zc->date[hi] - zc->date[lo];
+       long dt_lo = data->cfl->fArray[i].fDate - zc->date[lo];
+
+       weight[i - data->firstUncovered] = dt_lo / (double) hi_lo;
+   }
+
+   data->weight = weight;
+   return TRUE;
+}
+
+
+/*
+***************************************************************************
+** Objective function for use with JpmcdsRootFindNewton when the zero
+** curve is interpolated with flat forwards, with its derivative.
+**
+** This is JpmcdsObjFunctionRate without the interpolation, which is done
+** with the weights of SetupFlatFwdObjective instead.
+***************************************************************************
+*/
+static int ObjFunctionRateFlatFwd(
+   double              rate,               /* (I) newest rate guess */
+   TObjectiveData     *data,               /* (I) representing problem solved*/
+   double             *result,             /* (O) objective function value */
+   double             *deriv)              /* (O) derivative wrt rate */
+{
+   static char routine[]="ObjFunctionRateFlatFwd";
+
+   ZCurve     *zc   = data->zc;
+   TDate       date = zc->date[data->zcIndex];
+   double      yearDays = zc->dayCountConv == JPMCDS_ACT_360 ? 360.0 : 365.0;
+   double      discount;               /* discount at the rate */
+   double      dDiscount;              /* its derivative wrt rate */
+   double      sumPV = 0.0;            /* p.v. of uncovered c.fs */
+   double      sumDeriv = 0.0;         /* its derivative wrt rate */
+   int         i;
+
+   if (JpmcdsZCComputeDiscount(zc, date, rate, &discount) == FAILURE)
+   {
+       JpmcdsErrMsg("%s: Failed.\n", routine);
+       return FAILURE;
+   }
+   dDiscount = discount * ((zc->valueDate - date) / yearDays) / (1 + rate);
+
+   for (i = data->firstUncovered; i < data->cfl->fNumItems; i++)
+   {
+       double amt = data->cfl->fArray[i].fAmount;
+       double w   = data->weight[i - data->firstUncovered];
+       double disc;
+
+       if (data->cfl->fArray[i].fDate == date)
+       {
+           disc = discount;
+       }
+       else
+       {
+           disc = data->discountLo * pow(discount / data->discountLo, w);
+       }
+
+       sumPV    += amt * disc;
+       sumDeriv += amt * w * disc / discount * dDiscount;
+   }
+
+   *result = data->pvUnCovered - sumPV;
+   *deriv  = -sumDeriv;
+   return SUCCESS;
+}
+
+
 /*
 ***************************************************************************
 ** Adds a general zero rate to a ZCurve.
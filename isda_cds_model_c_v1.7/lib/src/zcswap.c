@@ -83,6 +83,35 @@ static int AddSwapFromPrevious(           /* adds swap based on one just added *
    long                         dayCount); /* (I) day counting convention */
 
 
+/*
+***************************************************************************
+** Returns TRUE if swap i of a strip can be added with AddSwapFromPrevious.
+***************************************************************************
+*/
+static TBoolean CanAddSwapFromPrevious(
+   ZCurve                      *zc,        /* (I) ZCurve to add to */
+   TCurve                      *discZC,    /* (I) Discount zero curve */
+   TSwapDates                  *swapDates, /* (I) Dates of the strip */
+   double                      *swapRates, /* (I) Rates of the strip */
+   int                          i,         /* (I) Swap to add */
+   TBoolean                     oneAlreadyAdded, /* (I) Swap added before */
+   long                         interpType); /* (I) Interpolation method */
+
+
+/*
+***************************************************************************
+** Adds a swap with the floating side at par, given its cash flow list.
+***************************************************************************
+*/
+static int AddSwapCFL(
+   ZCurve              *zc,                /* (M) ZCurve to add to          */
+   TCashFlowList       *cfl,               /* (I) Flows of the fixed side   */
+   double               price,             /* (I) Par price: usually 1.0    */
+   TDate                adjMatDate,        /* (I) Adjusted maturity date    */
+   long                 interpType,        /* (I) Interpolation method type */
+   TInterpData         *interpData);       /* (I) Interpolation data        */
+
+
 /*
 ***************************************************************************
 ** Objective function for root-finder to use.
@@ -238,13 +267,9 @@ int  JpmcdsZCAddSwaps(            /* adds a strip of swaps to ZCurve */
            /* Check if optimization okay. Note linear forwards
             * not OK because they must include intermed. fwds.
             */
-           if (oneAlreadyAdded                                      && 
-               discZC ==  NULL                                      &&
-               swapRates[i-1] != 0.0                              &&
-               swapDates->adjusted[i-1] == zc->date[zc->numItems-1] &&
-               swapDates->previous[i] == swapDates->original[i-1]   &&
-               swapDates->onCycle[i]                                &&
-               interpType != JPMCDS_LINEAR_FORWARDS)
+           if (CanAddSwapFromPrevious
+               (zc, discZC, swapDates, swapRates, i,
+                oneAlreadyAdded, interpType))
            {
                /* Optimization: compute from last
                 */
@@ -292,6 +317,234 @@ int  JpmcdsZCAddSwaps(            /* adds a strip of swaps to ZCurve */
 }
 
 
+/*
+***************************************************************************
+** Makes a strip of swaps with the floating side at par, whose dates and
+** fixed coupon schedules are kept for JpmcdsZCSwapStripAdd.
+***************************************************************************
+*/
+TZCSwapStrip* JpmcdsZCSwapStripNew(
+ TDate            valueDate,        /* (I) Value date of zero curves */
+ TDate           *inDates,          /* (I) Unadjusted maturity dates */
+ int              numSwaps,         /* (I) # instruments in strip  */
+ int              fixedSwapFreq,    /* (I) Fixed leg freq          */
+ long             fixDayCountConv,  /* (I) Convention for fixed leg*/
+ TBadDayAndStubPos badDayAndStubPos,/* (I) See JpmcdsBusinessDay      */
+ char            *holidayFile)      /* (I) See JpmcdsBusinessDay      */
+{
+   static char    routine[] = "JpmcdsZCSwapStripNew";
+   int            status = FAILURE;       /* Until proven successful */
+
+   TZCSwapStrip  *strip = NULL;
+   TDateInterval  ivl;
+   long           badDayConv;
+   TStubPos       stubPos;
+   int            i;
+
+   if (JpmcdsBadDayAndStubPosSplit(badDayAndStubPos, &badDayConv, &stubPos) != SUCCESS)
+       goto done;
+
+   if (JpmcdsFreq2TDateInterval (fixedSwapFreq, &ivl) != SUCCESS)
+       goto done;
+
+   strip = NEW(TZCSwapStrip);
+   if (strip == NULL)
+       goto done;
+
+   strip->numSwaps = numSwaps;
+   strip->fixDayCountConv = fixDayCountConv;
+   strip->fractions = NEW_ARRAY(TCashFlowList*, numSwaps);
+   strip->cfls = NEW_ARRAY(TCashFlowList*, numSwaps);
+   strip->zeroRateCfl = JpmcdsNewEmptyCFL(1);
+   strip->swapDates = JpmcdsSwapDatesNewFromOriginal
+       (valueDate, fixedSwapFreq, inDates, numSwaps, 
+        NULL, badDayConv, holidayFile);
+   if (strip->fractions == NULL || strip->cfls == NULL ||
+       strip->zeroRateCfl == NULL || strip->swapDates == NULL)
+       goto done;
+
+   /* Same schedules as JpmcdsZCAddSwap makes for each swap */
+   for (i=0; i < numSwaps; i++)
+   {
+       TBoolean isEndStub;
+
+       if (strip->swapDates->onCycle[i])
+       {
+           isEndStub = TRUE;
+       }
+       else
+       {
+           if (JpmcdsIsEndStub(valueDate,
+                            inDates[i],
+                            &ivl,
+                            stubPos,
+                            &isEndStub) != SUCCESS)
+           {
+               goto done;
+           }
+       }
+
+       strip->fractions[i] = JpmcdsZCGetSwapFractions
+           (valueDate, inDates[i], isEndStub, &ivl,
+            fixDayCountConv, NULL, badDayConv, holidayFile);
+       if (strip->fractions[i] == NULL)
+           goto done;
+
+       strip->cfls[i] = JpmcdsNewEmptyCFL(strip->fractions[i]->fNumItems);
+       if (strip->cfls[i] == NULL)
+           goto done;
+   }
+
+   status = SUCCESS;
+
+ done:
+   if (status == FAILURE)
+   {
+       JpmcdsZCSwapStripFree(strip);
+       strip = NULL;
+       JpmcdsErrMsg("%s: Failed.\n", routine);
+   }
+
+   return strip;
+}
+
+
+/*
+***************************************************************************
+** Adds swap i of a strip to a ZCurve, in the same way as JpmcdsZCAddSwaps
+** with flat forward interpolation adds the swaps of the strip in turn.
+***************************************************************************
+*/
+int JpmcdsZCSwapStripAdd(
+ ZCurve          *zc,               /* (M) ZCurve to add to        */
+ TZCSwapStrip    *strip,            /* (I) Strip of swaps          */
+ double          *rates,            /* (I) Fixed rates of the strip*/
+ int              i,                /* (I) Swap to add             */
+ TBoolean        *oneAlreadyAdded,  /* (M) If a swap was already added */
+ long             interpType,       /* (I) Zero interpolation method */
+ TInterpData     *interpData)       /* (I) Zero interpolation data */
+{
+   static char    routine[] = "JpmcdsZCSwapStripAdd";
+   int            status = FAILURE;       /* Until proven successful */
+
+   TSwapDates    *swapDates = strip->swapDates;
+   TCashFlowList *cfl;
+
+   if (zc == NULL || zc->numItems<1)     /* need a ZCurve to start with */
+   {
+       JpmcdsErrMsg("%s: input zero curve must contain data.\n",routine);
+       goto done;
+   }
+
+   /* Add those beyond stub zero curve
+    */
+   if (swapDates->adjusted[i] > zc->date[zc->numItems-1])
+   {
+       if (CanAddSwapFromPrevious
+           (zc, NULL, swapDates, rates, i,
+            *oneAlreadyAdded, interpType))
+       {
+           if (AddSwapFromPrevious
+               (zc,
+                swapDates->adjusted[i], rates[i],
+                1.0,
+                swapDates->adjusted[i-1], rates[i-1],
+                1.0,
+                strip->fixDayCountConv) == FAILURE)
+           {
+               goto done;
+           }
+       }
+       else
+       {
+           if (rates[i] == 0.0)
+           {
+               cfl = strip->zeroRateCfl;
+               cfl->fArray[0].fAmount = 1;
+               cfl->fArray[0].fDate = swapDates->adjusted[i];
+           }
+           else
+           {
+               cfl = strip->cfls[i];
+               JpmcdsZCSwapCFLFromFractions(strip->fractions[i], rates[i], cfl);
+           }
+
+           if (AddSwapCFL(zc, cfl, 1.0, swapDates->adjusted[i],
+                          interpType, interpData) == FAILURE)
+           {
+               JpmcdsErrMsg("%s: Failed for swap at %s(unadj), rate=%f.\n",
+                         routine, JpmcdsFormatDate(swapDates->original[i]),
+                         rates[i]);
+               goto done;
+           }
+           *oneAlreadyAdded = TRUE;
+       }
+   }
+
+   status = SUCCESS;
+
+ done:
+   if (status == FAILURE)
+       JpmcdsErrMsg("%s: Failed.\n", routine);
+
+   return status;
+}
+
+
+/*
+***************************************************************************
+** Frees a strip of swaps.
+***************************************************************************
+*/
+void JpmcdsZCSwapStripFree(TZCSwapStrip *strip)
+{
+   int i;
+
+   if (strip == NULL)
+       return;
+
+   for (i=0; i < strip->numSwaps; i++)
+   {
+       if (strip->fractions != NULL)
+           JpmcdsFreeCFL(strip->fractions[i]);
+       if (strip->cfls != NULL)
+           JpmcdsFreeCFL(strip->cfls[i]);
+   }
+   FREE_ARRAY(strip->fractions);
+   FREE_ARRAY(strip->cfls);
+   JpmcdsFreeCFL(strip->zeroRateCfl);
+   JpmcdsSwapDatesFree(strip->swapDates);
+   FREE(strip);
+}
+
+
+/*
+***************************************************************************
+** Returns TRUE if swap i of a strip can be added with AddSwapFromPrevious.
+**
+** Linear forwards are not OK because they must include intermediate
+** forwards.
+***************************************************************************
+*/
+static TBoolean CanAddSwapFromPrevious(
+   ZCurve                      *zc,        /* (I) ZCurve to add to */
+   TCurve                      *discZC,    /* (I) Discount zero curve */
+   TSwapDates                  *swapDates, /* (I) Dates of the strip */
+   double                      *swapRates, /* (I) Rates of the strip */
+   int                          i,         /* (I) Swap to add */
+   TBoolean                     oneAlreadyAdded, /* (I) Swap added before */
+   long                         interpType) /* (I) Interpolation method */
+{
+   return oneAlreadyAdded                                      && 
+          discZC ==  NULL                                      &&
+          swapRates[i-1] != 0.0                              &&
+          swapDates->adjusted[i-1] == zc->date[zc->numItems-1] &&
+          swapDates->previous[i] == swapDates->original[i-1]   &&
+          swapDates->onCycle[i]                                &&
+          interpType != JPMCDS_LINEAR_FORWARDS;
+}
+
+
 /*
 ***************************************************************************
 ** Optimization, adds a swap to a zero curve assuming the one added just 
@@ -471,25 +724,8 @@ int JpmcdsZCAddSwap(                             /* adds a swap to ZCurve */
                            &adjMatDate) == FAILURE)
            goto done;
 
-
-       /* Add rate implied by cashflow list to the zeroCurve.
-        */
-       if (JpmcdsZCAddCashFlowList(zc, cfl, price, adjMatDate,
-                             interpType,interpData) == FAILURE)
-           goto done;
-
-
-       /* Add zero rates at all dates in cfl.
-        * This guarantees that regardless of the interpolation used when
-        * pricing one of the original benchmark swaps with the zero curve
-        * created by this routine, the swap will be priced to par.
-        * Since JpmcdsZCInterpolate does not support linear forwards,
-        * we switch to linear interp here if linear fwds was specified.
-        */
-       if (JpmcdsZCAddCFLPoints
-           (zc, cfl, 0, 
-            interpType == JPMCDS_LINEAR_FORWARDS ? JPMCDS_LINEAR_INTERP:interpType, 
-            interpData) == FAILURE)
+       if (AddSwapCFL(zc, cfl, price, adjMatDate,
+                      interpType, interpData) == FAILURE)
            goto done;
    }
    else         /* Need to value floating side */
@@ -520,6 +756,40 @@ int JpmcdsZCAddSwap(                             /* adds a swap to ZCurve */
 }
 
 
+/*
+***************************************************************************
+** Adds a swap with the floating side at par, given its cash flow list.
+***************************************************************************
+*/
+static int AddSwapCFL(
+   ZCurve              *zc,                /* (M) ZCurve to add to          */
+   TCashFlowList       *cfl,               /* (I) Flows of the fixed side   */
+   double               price,             /* (I) Par price: usually 1.0    */
+   TDate                adjMatDate,        /* (I) Adjusted maturity date    */
+   long                 interpType,        /* (I) Interpolation method type */
+   TInterpData         *interpData)        /* (I) Interpolation data        */
+{
+   /* Add rate implied by cashflow list to the zeroCurve.
+    */
+   if (JpmcdsZCAddCashFlowList(zc, cfl, price, adjMatDate,
+                         interpType,interpData) == FAILURE)
+       return FAILURE;
+
+
+   /* Add zero rates at all dates in cfl.
+    * This guarantees that regardless of the interpolation used when
+    * pricing one of the original benchmark swaps with the zero curve
+    * created by this routine, the swap will be priced to par.
+    * Since JpmcdsZCInterpolate does not support linear forwards,
+    * we switch to linear interp here if linear fwds was specified.
+    */
+   return JpmcdsZCAddCFLPoints
+       (zc, cfl, 0, 
+        interpType == JPMCDS_LINEAR_FORWARDS ? JPMCDS_LINEAR_INTERP:interpType, 
+        interpData);
+}
+
+
 /*
 ***************************************************************************
 ** Models the swap points which are to be added to the zero curve using the 
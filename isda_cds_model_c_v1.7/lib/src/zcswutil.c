@@ -47,9 +47,6 @@ TCashFlowList* JpmcdsZCGetSwapCFL
     int status = FAILURE;               /* Until proven successful */
 
     TCashFlowList  *cfl = NULL;         /* cash-flow-list to return */
-    TDateList      *dl = NULL;          /* list of coupon dates */
-    TDate           prevDate;           /* prev date added to cash-flow list */
-    int             i;                  /* loops over coupon dates */
 
     /* Bizarre rate==0.0 case 
      */
@@ -66,6 +63,54 @@ TCashFlowList* JpmcdsZCGetSwapCFL
         return cfl;
     }
     
+    cfl = JpmcdsZCGetSwapFractions(valueDate,
+                                   matDate, stubAtEnd, interval, dayCountConv,
+                                   badDayList, badDayConv, holidayFile);
+    if (cfl == NULL)
+        goto done;
+
+    JpmcdsZCSwapCFLFromFractions(cfl, rate, cfl);
+
+    status = SUCCESS;
+
+
+ done:
+   if (status == FAILURE)
+   {
+       JpmcdsErrMsg("%s: Failed.\n", routine);
+       JpmcdsFreeCFL(cfl);
+       cfl = NULL;
+   }
+   return cfl;
+}
+
+
+/*
+***************************************************************************
+** Makes a cash flow list with the coupon dates of a swap instrument, and
+** the year fraction of each coupon as its amount.
+**
+** Returns the list, NULL if an error found.
+***************************************************************************
+*/
+TCashFlowList* JpmcdsZCGetSwapFractions
+  (TDate           valueDate,           /* (I) Value date                  */
+   TDate           matDate,             /* (I) Unadjusted maturity date    */
+   TBoolean        stubAtEnd,           /* (I) If matDate on-cycle         */
+   TDateInterval  *interval,            /* (I) Coupon payment interval     */
+   long            dayCountConv,        /* (I) Day count convention        */
+   TBadDayList    *badDayList,          /* (I) Bad day adjustment list     */
+   long            badDayConv,          /* (I) Bad day convention for rate */
+   char           *holidayFile)         /* (I) Name of holiday file        */
+{
+    static char routine[]="JpmcdsZCGetSwapFractions";
+    int status = FAILURE;               /* Until proven successful */
+
+    TCashFlowList  *cfl = NULL;         /* cash-flow-list to return */
+    TDateList      *dl = NULL;          /* list of coupon dates */
+    TDate           prevDate;           /* prev date added to cash-flow list */
+    int             i;                  /* loops over coupon dates */
+
      /* Get dateList with adjusted coupon dates & mat date 
       */
     dl = JpmcdsZCGetSwapCouponDL(valueDate,   
@@ -88,13 +133,11 @@ TCashFlowList* JpmcdsZCGetSwapCFL
            (prevDate, cDate, dayCountConv, &yearFraction) == FAILURE)
            goto done;
 
-       cfl->fArray[i].fAmount = rate * yearFraction;
+       cfl->fArray[i].fAmount = yearFraction;
        cfl->fArray[i].fDate = cDate;      /* store date */
        prevDate = cDate;
    }
 
-   cfl->fArray[cfl->fNumItems-1].fAmount += 1.0;   /* add principal */
-
    status = SUCCESS;
 
 
@@ -110,6 +153,30 @@ TCashFlowList* JpmcdsZCGetSwapCFL
 }
 
 
+/*
+***************************************************************************
+** Sets the cash flows of a swap instrument with a non-zero coupon rate
+** from the year fractions made by JpmcdsZCGetSwapFractions. The two lists
+** can be the same.
+***************************************************************************
+*/
+void JpmcdsZCSwapCFLFromFractions
+  (TCashFlowList  *fractions,           /* (I) Coupon dates and fractions  */
+   double          rate,                /* (I) Coupon rate                 */
+   TCashFlowList  *cfl)                 /* (O) Cash flows, same length     */
+{
+   int             i;                  /* loops over coupon dates */
+
+   for (i=0; i<fractions->fNumItems; i++)
+   {
+       cfl->fArray[i].fAmount = rate * fractions->fArray[i].fAmount;
+       cfl->fArray[i].fDate = fractions->fArray[i].fDate;
+   }
+
+   cfl->fArray[cfl->fNumItems-1].fAmount += 1.0;   /* add principal */
+}
+
+
 /*
 ***************************************************************************
 ** Makes a date list for all coupons associated w/ a swap instrument.
@@ -13,12 +13,53 @@
 #include "macros.h"
 #include "cerror.h"
 #include "gtozc.h"
+#include "zcprvt.h"
+#include "cmemory.h"
+#include "strutil.h"
 #include <ctype.h>
+#include <string.h>
 
 #define JpmcdsSWAPNAME   'S'
 #define JpmcdsMONEYNAME  'M'
 
 
+/*
+** Builder of zero curves - see zerocurve.h.
+*/
+struct _TIRCurveBuilder
+{
+    TDate          valueDate;      /* Value date                           */
+    long           nInstr;         /* Number of benchmark instruments      */
+    char          *instrNames;     /* [nInstr] 'M' or 'S'                  */
+    long           nCash;          /* Number of money market instruments   */
+    TDate         *cashDates;      /* [nCash] money market dates           */
+    double        *cashRates;      /* [nCash] rates of cashCurve           */
+    long           nSwap;          /* Number of swaps                      */
+    TDate         *swapDates;      /* [nSwap] swap dates                   */
+    double        *swapRates;      /* [nSwap] rates of solved curves       */
+    long           mmDCC;          /* DCC of MM instruments                */
+    long           fixedSwapFreq;  /* Fixed leg freqency                   */
+    long           floatSwapFreq;  /* Floating leg freqency                */
+    long           fixedSwapDCC;   /* DCC of fixed leg                     */
+    long           floatSwapDCC;   /* DCC of floating leg                  */
+    long           badDayConv;     /* Bad day convention                   */
+    char          *holidayFile;    /* Holiday file                         */
+    TCurve        *zcurveIni;      /* Empty curve at the value date        */
+    TCurve        *cashCurve;      /* Money market curve - NULL if unknown */
+    long           swapOffset;     /* First swap beyond cashCurve          */
+    TZCSwapStrip  *swapStrip;      /* Swaps from swapOffset - can be NULL  */
+    ZCurve       **solved;         /* [nSwap+1] curve before swapOffset+k  */
+    TBoolean      *oneAdded;       /* [nSwap+1] a swap added before it     */
+    long           numSolved;      /* Number of valid curves in solved     */
+    TBoolean       newtonSolve;    /* Solve swaps by Newton - see zcprvt.h */
+};
+
+
+static int zcAssign
+(ZCurve **dst,
+ ZCurve  *src);
+
+
 /*
 ***************************************************************************
 ** Build zero curve from money market, and swap instruments.
@@ -133,3 +174,369 @@ EXPORT TCurve* JpmcdsBuildIRZeroCurve(
     }
     return (zcurveSwap);
 }
+
+
+/*
+***************************************************************************
+** Makes a builder of zero curves from money market and swap instruments.
+***************************************************************************
+*/
+EXPORT TIRCurveBuilder* JpmcdsIRCurveBuilderNew(
+    TDate      valueDate,       /* (I) Value date                       */
+    char      *instrNames,      /* (I) Array of 'M' or 'S'              */
+    TDate     *dates,           /* (I) Array of swaps dates             */
+    long       nInstr,          /* (I) Number of benchmark instruments  */
+    long       mmDCC,           /* (I) DCC of MM instruments            */
+    long       fixedSwapFreq,   /* (I) Fixed leg freqency               */
+    long       floatSwapFreq,   /* (I) Floating leg freqency            */
+    long       fixedSwapDCC,    /* (I) DCC of fixed leg                 */
+    long       floatSwapDCC,    /* (I) DCC of floating leg              */
+    long       badDayConv,      /* (I) Bad day convention               */
+    char      *holidayFile)     /* (I) Holiday file                     */
+{
+    static char routine[] = "JpmcdsIRCurveBuilderNew";
+    int         status    = FAILURE;
+
+    TIRCurveBuilder *builder = NULL;
+    long             i;
+    char             instr;
+
+    builder = NEW(TIRCurveBuilder);
+    if (builder == NULL)
+        goto done;
+
+    builder->valueDate     = valueDate;
+    builder->nInstr        = nInstr;
+    builder->mmDCC         = mmDCC;
+    builder->fixedSwapFreq = fixedSwapFreq;
+    builder->floatSwapFreq = floatSwapFreq;
+    builder->fixedSwapDCC  = fixedSwapDCC;
+    builder->floatSwapDCC  = floatSwapDCC;
+    builder->badDayConv    = badDayConv;
+    builder->newtonSolve   = FALSE;
+
+    /* Allocate enough spaces for cash and swap dates/rates */
+    builder->instrNames = NEW_ARRAY(char,   nInstr);
+    builder->cashDates  = NEW_ARRAY(TDate,  nInstr);
+    builder->swapDates  = NEW_ARRAY(TDate,  nInstr);
+    builder->cashRates  = NEW_ARRAY(double, nInstr);
+    builder->swapRates  = NEW_ARRAY(double, nInstr);
+    builder->solved     = NEW_ARRAY(ZCurve*,  nInstr + 1);
+    builder->oneAdded   = NEW_ARRAY(TBoolean, nInstr + 1);
+    builder->holidayFile = JpmcdsStringDuplicate(holidayFile);
+
+    if (builder->instrNames == NULL || builder->cashDates == NULL ||
+        builder->swapDates == NULL || builder->cashRates == NULL ||
+        builder->swapRates == NULL || builder->solved == NULL ||
+        builder->oneAdded == NULL || builder->holidayFile == NULL)
+        goto done;
+
+    /* Sort out cash and swap separately */
+    for(i = 0; i < nInstr; i++)
+    {
+        instr = toupper(instrNames[i]);
+        if (instr != JpmcdsMONEYNAME && instr != JpmcdsSWAPNAME)
+        {
+            JpmcdsErrMsg("%s: unknown instrument type (%c)."
+                      " Only (M)oney market or (S)wap is allowed.\n",
+                      routine, instrNames[i]);
+            goto done;
+        }
+
+        builder->instrNames[i] = instr;
+        if (instr == JpmcdsMONEYNAME)
+            builder->cashDates[builder->nCash++] = dates[i];
+        else
+            builder->swapDates[builder->nSwap++] = dates[i];
+    }
+
+    /* Initialize the zero curve */
+    builder->zcurveIni = JpmcdsNewTCurve(valueDate, 0, (double) 1L, JPMCDS_ACT_365F);
+    if (builder->zcurveIni == NULL)
+        goto done;
+
+    status = SUCCESS;
+
+ done:
+    if (status != SUCCESS)
+    {
+        JpmcdsIRCurveBuilderFree(builder);
+        builder = NULL;
+        JpmcdsErrMsgFailure(routine);
+    }
+    return builder;
+}
+
+
+/*
+***************************************************************************
+** Builds the zero curve for new rates of the instruments of a builder.
+**
+** The curves are made in the same steps as in JpmcdsBuildIRZeroCurve: the
+** swaps beyond the money market curve are added in turn to a copy of it
+** by JpmcdsZCSwapStripAdd, as they are by JpmcdsZCSwaps.
+***************************************************************************
+*/
+EXPORT TCurve* JpmcdsIRCurveBuilderUpdate(
+    TIRCurveBuilder *builder,   /* (I/O) Builder                        */
+    double    *rates)           /* (I) Array of rates of instruments    */
+{
+    static char routine[] = "JpmcdsIRCurveBuilderUpdate";
+    int         status    = FAILURE;
+
+    TCurve     *zcurveSwap = NULL;
+    TBoolean    cashChanged;
+    long        firstChanged;   /* first changed swap beyond the cash */
+    long        nCash = 0;
+    long        nSwap = 0;
+    long        numStrip;
+    long        badDayConv;
+    TStubPos    stubPos;
+    long        i;
+    long        k;
+
+    if (builder == NULL || rates == NULL)
+    {
+        JpmcdsErrMsg("%s: NULL inputs.\n", routine);
+        goto done;
+    }
+
+    /* Sort out cash and swap rates, and find the first which changed */
+    cashChanged  = builder->cashCurve == NULL;
+    firstChanged = builder->nSwap;
+    for(i = 0; i < builder->nInstr; i++)
+    {
+        if (builder->instrNames[i] == JpmcdsMONEYNAME)
+        {
+            if (builder->cashRates[nCash] != rates[i])
+                cashChanged = TRUE;
+            builder->cashRates[nCash++] = rates[i];
+        }
+        else
+        {
+            if (builder->swapRates[nSwap] != rates[i] &&
+                nSwap >= builder->swapOffset && nSwap < firstChanged)
+                firstChanged = nSwap;
+            builder->swapRates[nSwap++] = rates[i];
+        }
+    }
+
+    /* From here on, solved[0..numSolved-1] hold for the new rates */
+    if (cashChanged)
+        builder->numSolved = 0;
+    else
+        builder->numSolved = MIN(builder->numSolved,
+                                 firstChanged - builder->swapOffset + 1);
+
+    /* Cash instruments */
+    if (cashChanged)
+    {
+        JpmcdsFreeTCurve(builder->cashCurve);
+        builder->cashCurve = JpmcdsZCCash(builder->zcurveIni,
+                                          builder->cashDates,
+                                          builder->cashRates,
+                                          builder->nCash,
+                                          builder->mmDCC);
+        if (builder->cashCurve == NULL)
+            goto done;
+    }
+
+    /* Swap instruments */
+    if (builder->nSwap == 0)      /* nothing to add */
+    {
+        zcurveSwap = JpmcdsCopyCurve(builder->cashCurve);
+        if (zcurveSwap == NULL)
+            goto done;
+        status = SUCCESS;
+        goto done;
+    }
+
+    if (JpmcdsBadDayAndStubPosSplit(builder->badDayConv, &badDayConv, &stubPos) != SUCCESS)
+        goto done;
+
+    if (JpmcdsZCSwapsCheckInputs(builder->cashCurve,
+                                 NULL,
+                                 builder->swapDates,
+                                 builder->swapRates,
+                                 builder->nSwap,
+                                 builder->fixedSwapFreq,
+                                 builder->floatSwapFreq,
+                                 builder->fixedSwapDCC,
+                                 builder->floatSwapDCC,
+                                 '3',   /* not used */
+                                 badDayConv,
+                                 builder->holidayFile) == FAILURE)
+        goto done;
+
+    if (builder->numSolved == 0)
+    {
+        TCurve *cashCurve = builder->cashCurve;
+        TDate   lastStubDate;
+        ZCurve *zc;
+        long    offset = 0;
+
+        /* only want to add swap points not already covered by the cash
+           curve, and the swaps to add depend on its last date only */
+        if (cashCurve->fNumItems < 1)
+            lastStubDate = cashCurve->fBaseDate;
+        else
+            lastStubDate = cashCurve->fArray[cashCurve->fNumItems-1].fDate;
+
+        while (offset < builder->nSwap &&
+               builder->swapDates[offset] < lastStubDate)
+            offset++;
+
+        if (builder->swapStrip == NULL || offset != builder->swapOffset)
+        {
+            JpmcdsZCSwapStripFree(builder->swapStrip);
+            builder->swapStrip = NULL;
+            builder->swapOffset = offset;
+
+            if (offset < builder->nSwap)
+            {
+                builder->swapStrip = JpmcdsZCSwapStripNew(builder->valueDate,
+                                                      &builder->swapDates[offset],
+                                                      builder->nSwap - offset,
+                                                      builder->fixedSwapFreq,
+                                                      builder->fixedSwapDCC,
+                                                      builder->badDayConv,
+                                                      builder->holidayFile);
+                if (builder->swapStrip == NULL)
+                    goto done;
+            }
+        }
+
+        zc = JpmcdsZCFromTCurve(cashCurve);
+        if (zc == NULL)
+            goto done;
+        zc->newtonSolve = builder->newtonSolve;
+        JpmcdsZCFree(builder->solved[0]);
+        builder->solved[0]   = zc;
+        builder->oneAdded[0] = FALSE;
+        builder->numSolved   = 1;
+    }
+
+    /* Re-solve from the first swap which changed, each one starting from
+       a copy of the curve before it */
+    numStrip = builder->nSwap - builder->swapOffset;
+    for (k = builder->numSolved - 1; k < numStrip; k++)
+    {
+        TBoolean oneAdded = builder->oneAdded[k];
+
+        if (zcAssign(&builder->solved[k+1], builder->solved[k]) != SUCCESS)
+            goto done;
+
+        if (JpmcdsZCSwapStripAdd(builder->solved[k+1],
+                                 builder->swapStrip,
+                                 &builder->swapRates[builder->swapOffset],
+                                 (int)k,
+                                 &oneAdded,
+                                 JPMCDS_FLAT_FORWARDS,
+                                 NULL) != SUCCESS)
+            goto done;
+
+        builder->oneAdded[k+1] = oneAdded;
+        builder->numSolved = k + 2;
+    }
+
+    zcurveSwap = JpmcdsZCToTCurve(builder->solved[numStrip]);
+    if (zcurveSwap == NULL)
+        goto done;
+
+    status = SUCCESS;
+
+ done:
+    if (status != SUCCESS)
+    {
+        JpmcdsFreeTCurve(zcurveSwap);
+        zcurveSwap = NULL;
+        JpmcdsErrMsgFailure(routine);
+    }
+    return (zcurveSwap);
+}
+
+
+/*
+***************************************************************************
+** Chooses whether a builder solves for the swap points by Newton's method.
+***************************************************************************
+*/
+EXPORT void JpmcdsIRCurveBuilderSetNewton(
+    TIRCurveBuilder *builder,   /* (I/O) Builder                        */
+    TBoolean   newtonSolve)     /* (I) Solve by Newton's method         */
+{
+    if (builder->newtonSolve != newtonSolve)
+    {
+        /* the curves solved so far are only valid for the old method */
+        builder->newtonSolve = newtonSolve;
+        builder->numSolved   = 0;
+    }
+}
+
+
+/*
+***************************************************************************
+** Frees a builder made by JpmcdsIRCurveBuilderNew.
+***************************************************************************
+*/
+EXPORT void JpmcdsIRCurveBuilderFree(
+    TIRCurveBuilder *builder)   /* (I) Builder                          */
+{
+    long i;
+
+    if (builder == NULL)
+        return;
+
+    if (builder->solved != NULL)
+    {
+        for (i = 0; i <= builder->nInstr; i++)
+            JpmcdsZCFree(builder->solved[i]);
+    }
+
+    FREE(builder->instrNames);
+    FREE(builder->cashDates);
+    FREE(builder->cashRates);
+    FREE(builder->swapDates);
+    FREE(builder->swapRates);
+    FREE(builder->solved);
+    FREE(builder->oneAdded);
+    FREE(builder->holidayFile);
+    JpmcdsFreeTCurve(builder->zcurveIni);
+    JpmcdsFreeTCurve(builder->cashCurve);
+    JpmcdsZCSwapStripFree(builder->swapStrip);
+    FREE(builder);
+}
+
+
+/*
+***************************************************************************
+** Copies the points of a ZCurve into another, which is made or grown if
+** it does not have room for them. Only the arrays made here are known to
+** have numAlloc items, since JpmcdsZCAddRateAndDiscount grows the arrays
+** without updating it.
+***************************************************************************
+*/
+static int zcAssign
+(ZCurve **dst,
+ ZCurve  *src)
+{
+    ZCurve *zc = *dst;
+
+    if (zc == NULL || zc->numAlloc < src->numItems)
+    {
+        zc = JpmcdsZCMake(src->valueDate, src->numItems + 32,
+                          src->basis, src->dayCountConv);
+        if (zc == NULL)
+            return FAILURE;
+        JpmcdsZCFree(*dst);
+        *dst = zc;
+    }
+
+    memcpy(zc->rate,     src->rate,     src->numItems * sizeof(double));
+    memcpy(zc->date,     src->date,     src->numItems * sizeof(TDate));
+    memcpy(zc->discount, src->discount, src->numItems * sizeof(double));
+    zc->numItems    = src->numItems;
+    zc->newtonSolve = src->newtonSolve;
+
+    return SUCCESS;
+}
@@ -41,7 +41,7 @@ CLEAN   =
 ############################################################################
 # Standard system libraries
 ############################################################################
-SYS_LIBS = -lc
+SYS_LIBS = -lc -lpthread
 
 ############################################################################
 # Compiler flags
@@ -0,0 +1,196 @@
+/*
+ * ISDA CDS Standard Model
+ *
+ * Copyright (C) 2009 International Swaps and Derivatives Association, Inc.
+ * Developed and supported in collaboration with Markit
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the ISDA CDS Standard Model Public License.
+ */
+
+/*
+***************************************************************************
+** Checks that the business day functions give the same results for a
+** holiday list with a business day index as for the same list without
+** one. The lists have several weekends and holidays inside and outside
+** the years of the index, and the dates are drawn from the whole index
+** and around its ends.
+**
+** Usage: bustest
+***************************************************************************
+*/
+
+#include <stdio.h>
+#include "macros.h"
+#include "cerror.h"
+#include "convert.h"
+#include "busday.h"
+#include "buscache.h"
+#include "dtlist.h"
+#include "ldate.h"
+
+#define NB_LISTS     5
+#define NB_CHECKS    100000
+#define MAX_HOLIDAYS 4000
+
+static long weekends[NB_LISTS] = {
+    JPMCDS_WEEKEND_STANDARD,
+    JPMCDS_WEEKEND_FRIDAY | JPMCDS_WEEKEND_SATURDAY,
+    JPMCDS_WEEKEND_NO_WEEKENDS,
+    JPMCDS_WEEKEND_SUNDAY,
+    JPMCDS_WEEKEND_STANDARD
+};
+
+
+/*
+***************************************************************************
+** Returns a pseudo-random number in [0, n).
+***************************************************************************
+*/
+static long NextRandom(unsigned long *seed, long n)
+{
+    *seed = (*seed * 1103515245UL + 12345UL) & 0xffffffffUL;
+    return (long)((*seed >> 8) % (unsigned long)n);
+}
+
+
+/*
+***************************************************************************
+** Returns the number of dates for which the business day functions give
+** other results with the two holiday lists.
+***************************************************************************
+*/
+static int CompareLists
+(THolidayList  *indexed,
+ THolidayList  *plain,
+ unsigned long *seed)
+{
+    static long convs[3] = {JPMCDS_BAD_DAY_FOLLOW, JPMCDS_BAD_DAY_PREVIOUS,
+                            JPMCDS_BAD_DAY_MODIFIED};
+    TDate       lowDate = JpmcdsDate(1895, 1, 1);
+    long        span = JpmcdsDate(2206, 1, 1) - lowDate;
+    int         bad = 0;
+    long        i;
+
+    for (i = 0; i < NB_CHECKS; i++)
+    {
+        TDate    date = lowDate + NextRandom(seed, span);
+        TDate    toDate;
+        TDate    outA;
+        TDate    outB;
+        long     diffA;
+        long     diffB;
+        TBoolean isA;
+        TBoolean isB;
+        long     offset = NextRandom(seed, 600) - 300;
+        int      statusA;
+        int      statusB;
+        int      failed = 0;
+
+        /* the ends of the index */
+        if (i % 5 == 0)
+            date = indexed->index->startDate - 3 + NextRandom(seed, 6);
+        else if (i % 7 == 0)
+            date = indexed->index->endDate - 3 + NextRandom(seed, 6);
+        toDate = date + NextRandom(seed, 2000) - 1000;
+
+        statusA = JpmcdsHolidayListIsBusinessDay(date, indexed, &isA);
+        statusB = JpmcdsHolidayListIsBusinessDay(date, plain, &isB);
+        if (statusA != statusB || isA != isB)
+            failed = 1;
+
+        statusA = JpmcdsHolidayListBusinessDay(date, convs[i % 3], indexed, &outA);
+        statusB = JpmcdsHolidayListBusinessDay(date, convs[i % 3], plain, &outB);
+        if (statusA != statusB || outA != outB)
+            failed = 1;
+
+        statusA = JpmcdsHolidayListAddBusinessDays(date, offset, indexed, &outA);
+        statusB = JpmcdsHolidayListAddBusinessDays(date, offset, plain, &outB);
+        if (statusA != statusB || (statusA == SUCCESS && outA != outB))
+            failed = 1;
+
+        statusA = JpmcdsHolidayListBusinessDaysDiff(date, toDate, indexed, &diffA);
+        statusB = JpmcdsHolidayListBusinessDaysDiff(date, toDate, plain, &diffB);
+        if (statusA != statusB || (statusA == SUCCESS && diffA != diffB))
+            failed = 1;
+
+        if (failed)
+        {
+            if (bad == 0)
+                printf("Weekends %ld: differs on %s.\n", plain->weekends,
+                       JpmcdsFormatDate(date));
+            bad++;
+        }
+    }
+
+    return bad;
+}
+
+
+/*
+***************************************************************************
+** Main function.
+***************************************************************************
+*/
+int main(void)
+{
+    static TDate  holidays[MAX_HOLIDAYS];
+    unsigned long seed = 18;
+    int           bad = 0;
+    int           c;
+
+    JpmcdsErrMsgFileName("bustest.log", FALSE);
+    JpmcdsErrMsgOn();
+
+    for (c = 0; c < NB_LISTS; c++)
+    {
+        TDateList    *dl;
+        THolidayList *indexed;
+        THolidayList *plain;
+        TDate         date    = JpmcdsDate(1950, 1, 1);
+        TDate         endDate = JpmcdsDate(2150, 1, 1);
+        long          gap     = 40;
+        long          nbHolidays = 0;
+
+        /* the last list has holidays beyond the years of the index */
+        if (c == NB_LISTS - 1)
+        {
+            date    = JpmcdsDate(1880, 1, 1);
+            endDate = JpmcdsDate(2230, 1, 1);
+            gap     = 60;
+        }
+        for ( ; date < endDate && nbHolidays < MAX_HOLIDAYS;
+              date += 1 + NextRandom(&seed, gap))
+            holidays[nbHolidays++] = date;
+
+        dl      = JpmcdsNewDateListFromDates(holidays, nbHolidays);
+        indexed = JpmcdsHolidayListNewGeneral(dl, weekends[c]);
+        plain   = JpmcdsHolidayListNewGeneral(dl, weekends[c]);
+        JpmcdsFreeDateList(dl);
+        if (indexed == NULL || plain == NULL ||
+            JpmcdsHolidayListBuildIndex(indexed) != SUCCESS ||
+            JPMCDS_HOLIDAY_LIST_INDEX(indexed) == NULL ||
+            JPMCDS_HOLIDAY_LIST_INDEX(plain) != NULL)
+        {
+            printf("Weekends %ld: the index was not built.\n", weekends[c]);
+            return 1;
+        }
+
+        bad += CompareLists(indexed, plain, &seed);
+
+        /* the index is not used once the weekends are changed in place */
+        indexed->weekends = plain->weekends = JPMCDS_WEEKEND_MONDAY;
+        if (JPMCDS_HOLIDAY_LIST_INDEX(indexed) != NULL)
+        {
+            printf("Weekends %ld: a stale index is used.\n", weekends[c]);
+            bad++;
+        }
+        bad += CompareLists(indexed, plain, &seed);
+
+        JpmcdsHolidayListDelete(indexed);
+        JpmcdsHolidayListDelete(plain);
+    }
+
+    printf("%d holiday lists: %d differences\n", NB_LISTS, bad);
+    return bad == 0 ? 0 : 1;
+}
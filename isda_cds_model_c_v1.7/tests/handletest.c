@@ -0,0 +1,198 @@
+/*
+ * ISDA CDS Standard Model
+ *
+ * Copyright (C) 2009 International Swaps and Derivatives Association, Inc.
+ * Developed and supported in collaboration with Markit
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the ISDA CDS Standard Model Public License.
+ */
+
+/*
+***************************************************************************
+** Checks the calendar handles of the holiday cache: that a handle gives
+** the dates of its calendar name, follows the calendar when it is
+** replaced, stays valid when the cache is emptied and finds the calendar
+** again by its name, and that a calendar keeps the same handle. Handles
+** are then used from many threads while the calendar is replaced.
+**
+** Usage: handletest <holiday file> [nbThreads]
+***************************************************************************
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "macros.h"
+#include "cerror.h"
+#include "busday.h"
+#include "buscache.h"
+#include "dtlist.h"
+#include "ldate.h"
+#include "cthread.h"
+
+#define NB_TASKS   100000
+#define NB_REPLACE 1000
+
+#define CALENDAR   "HANDLETEST"
+
+/* a Monday, which is a holiday of CALENDAR */
+#define HOLIDAY    JpmcdsDate(2010, 5, 31)
+
+typedef struct
+{
+    char *handle;                  /* Handle of CALENDAR */
+    char  failures[NB_TASKS];      /* Failed or wrong dates by task */
+} THandleTest;
+
+
+/*
+***************************************************************************
+** Adds CALENDAR to the holiday cache, with HOLIDAY or without holidays.
+***************************************************************************
+*/
+static int AddCalendar(TBoolean withHoliday)
+{
+    TDate         holiday = HOLIDAY;
+    TDateList    *dl = NULL;
+    THolidayList *hl;
+
+    if (withHoliday)
+    {
+        dl = JpmcdsNewDateListFromDates(&holiday, 1);
+        if (dl == NULL)
+            return FAILURE;
+    }
+    hl = JpmcdsHolidayListNewGeneral(dl, JPMCDS_WEEKEND_STANDARD);
+    JpmcdsFreeDateList(dl);
+    if (hl == NULL)
+        return FAILURE;
+    return JpmcdsHolidayListAddToCache(CALENDAR, hl);
+}
+
+
+/*
+***************************************************************************
+** Returns the date after HOLIDAY if it is a holiday of a calendar, and
+** HOLIDAY if it is not. Returns zero on failure.
+***************************************************************************
+*/
+static TDate AdjustHoliday(char *calendar)
+{
+    TDate date;
+
+    if (JpmcdsBusinessDay(HOLIDAY, JPMCDS_BAD_DAY_FOLLOW, calendar,
+                          &date) != SUCCESS)
+        return 0;
+    return date;
+}
+
+
+/*
+***************************************************************************
+** Task of JpmcdsParallelFor: adjusts HOLIDAY with the handle of CALENDAR,
+** or replaces CALENDAR with the same holidays.
+***************************************************************************
+*/
+static void HandleTask(void *data, long i)
+{
+    THandleTest *test = (THandleTest*)data;
+
+    if (i % NB_REPLACE == 0)
+        test->failures[i] = AddCalendar(TRUE) != SUCCESS;
+    else
+        test->failures[i] = AdjustHoliday(test->handle) != HOLIDAY + 1;
+}
+
+
+/*
+***************************************************************************
+** Main function.
+***************************************************************************
+*/
+int main(int argc, char **argv)
+{
+    static THandleTest test;
+    char              *handle;
+    char              *fileHandle;
+    TDate              fileDate;
+    int                nbThreads;
+    long               i;
+    int                bad = 0;
+
+    if (argc < 2)
+    {
+        printf("Usage: %s <holiday file> [nbThreads]\n", argv[0]);
+        return 1;
+    }
+    nbThreads = argc > 2 ? atoi(argv[2]) : 8;
+
+    JpmcdsErrMsgFileName("handletest.log", FALSE);
+    JpmcdsErrMsgOn();
+
+    if (AddCalendar(TRUE) != SUCCESS)
+        return 1;
+
+    /* the handle gives the dates of the name, whatever its case */
+    handle = JpmcdsHolidayCalendarHandle(CALENDAR);
+    if (handle == NULL ||
+        JpmcdsHolidayCalendarHandle("handleTest") != handle ||
+        AdjustHoliday(handle) != HOLIDAY + 1 ||
+        AdjustHoliday(handle) != AdjustHoliday(CALENDAR))
+    {
+        printf("The handle does not give the dates of the calendar.\n");
+        bad++;
+    }
+
+    /* a calendar read from file */
+    fileHandle = JpmcdsHolidayCalendarHandle(argv[1]);
+    fileDate   = AdjustHoliday(argv[1]);
+    if (fileHandle == NULL || fileDate == 0 ||
+        AdjustHoliday(fileHandle) != fileDate)
+    {
+        printf("The handle of %s does not give its dates.\n", argv[1]);
+        bad++;
+    }
+
+    /* the handle follows the calendar when it is replaced */
+    if (AddCalendar(FALSE) != SUCCESS)
+        return 1;
+    if (AdjustHoliday(handle) != HOLIDAY ||
+        JpmcdsHolidayCalendarHandle(CALENDAR) != handle)
+    {
+        printf("The handle does not follow the replaced calendar.\n");
+        bad++;
+    }
+
+    /* after the cache is emptied the calendar is found again by name */
+    JpmcdsHolidayEmptyCache();
+    if (AdjustHoliday(handle) != 0)
+    {
+        printf("The handle of a calendar no longer in the cache works.\n");
+        bad++;
+    }
+    if (AddCalendar(TRUE) != SUCCESS)
+        return 1;
+    if (AdjustHoliday(handle) != HOLIDAY + 1 ||
+        AdjustHoliday(fileHandle) != fileDate ||
+        JpmcdsHolidayCalendarHandle(CALENDAR) != handle ||
+        JpmcdsHolidayCalendarHandle(argv[1]) != fileHandle)
+    {
+        printf("The handles do not find the calendars again.\n");
+        bad++;
+    }
+
+    /* many threads use the handle while the calendar is replaced */
+    test.handle = handle;
+    if (JpmcdsParallelFor(NB_TASKS, nbThreads, HandleTask, &test) != SUCCESS)
+    {
+        printf("JpmcdsParallelFor failed.\n");
+        return 1;
+    }
+    for (i = 0; i < NB_TASKS; i++)
+        bad += test.failures[i];
+
+    JpmcdsHolidayEmptyCache();
+
+    printf("Handles: %d failures\n", bad);
+    return bad == 0 ? 0 : 1;
+}
@@ -0,0 +1,269 @@
+/*
+ * ISDA CDS Standard Model
+ *
+ * Copyright (C) 2009 International Swaps and Derivatives Association, Inc.
+ * Developed and supported in collaboration with Markit
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the ISDA CDS Standard Model Public License.
+ */
+
+/*
+***************************************************************************
+** Converts a text holiday file to binary holiday files, with and without
+** the business day index, and checks that they give the business days of
+** the text file. A file whose index has been corrupted must still give
+** them, and truncated or foreign files must be refused. The binary files
+** are then loaded as a directory.
+**
+** Usage: holfiletest <holiday file> <empty directory>
+***************************************************************************
+*/
+
+#include <stdio.h>
+#include <string.h>
+#include "macros.h"
+#include "cerror.h"
+#include "convert.h"
+#include "busday.h"
+#include "buscache.h"
+#include "holfile.h"
+#include "ldate.h"
+
+#define MAX_PATH_LEN 1024
+
+/* ints in the header of a binary holiday file, as described in holfile.h */
+#define HEADER_INTS  8
+
+
+/*
+***************************************************************************
+** Returns the number of dates for which the business day functions give
+** other results with the two holiday lists.
+***************************************************************************
+*/
+static int CompareLists(char *name, THolidayList *hl, THolidayList *ref)
+{
+    TDate firstDate = JpmcdsDate(1950, 1, 1);
+    TDate lastDate  = JpmcdsDate(2100, 1, 1);
+    TDate date;
+    int   bad = 0;
+
+    if (hl == NULL)
+    {
+        printf("%s: not read.\n", name);
+        return 1;
+    }
+
+    if (hl->weekends != ref->weekends ||
+        hl->dateList->fNumItems != ref->dateList->fNumItems ||
+        memcmp(hl->dateList->fArray, ref->dateList->fArray,
+               ref->dateList->fNumItems * sizeof(TDate)) != 0)
+    {
+        printf("%s: other holidays.\n", name);
+        bad++;
+    }
+
+    for (date = firstDate; date < lastDate; date++)
+    {
+        TBoolean isA;
+        TBoolean isB;
+        TDate    outA;
+        TDate    outB;
+        long     offset = date % 21 - 10;
+        int      failed = 0;
+
+        if (JpmcdsHolidayListIsBusinessDay(date, hl, &isA) != SUCCESS ||
+            JpmcdsHolidayListIsBusinessDay(date, ref, &isB) != SUCCESS ||
+            isA != isB)
+            failed = 1;
+
+        if (JpmcdsHolidayListBusinessDay(date, JPMCDS_BAD_DAY_MODIFIED, hl, &outA) != SUCCESS ||
+            JpmcdsHolidayListBusinessDay(date, JPMCDS_BAD_DAY_MODIFIED, ref, &outB) != SUCCESS ||
+            outA != outB)
+            failed = 1;
+
+        if (JpmcdsHolidayListAddBusinessDays(date, offset, hl, &outA) != SUCCESS ||
+            JpmcdsHolidayListAddBusinessDays(date, offset, ref, &outB) != SUCCESS ||
+            outA != outB)
+            failed = 1;
+
+        if (failed)
+        {
+            if (bad == 0)
+                printf("%s: differs on %s.\n", name, JpmcdsFormatDate(date));
+            bad++;
+        }
+    }
+
+    return bad;
+}
+
+
+/*
+***************************************************************************
+** Replaces a file with the first size bytes of another, with the int at
+** position flip changed unless flip is negative.
+***************************************************************************
+*/
+static int CopyFile(char *from, char *to, long size, long flip)
+{
+    static char buffer[1 << 20];
+    FILE       *fp;
+    size_t      n;
+
+    fp = fopen(from, "rb");
+    if (fp == NULL)
+        return FAILURE;
+    n = fread(buffer, 1, sizeof(buffer), fp);
+    fclose(fp);
+
+    if (size >= 0 && (size_t)size < n)
+        n = (size_t)size;
+    if (flip >= 0 && (size_t)(flip + 1) * sizeof(int) <= n)
+        ((int*)buffer)[flip] ^= 0x10;
+
+    fp = fopen(to, "wb");
+    if (fp == NULL)
+        return FAILURE;
+    if (fwrite(buffer, 1, n, fp) != n)
+    {
+        fclose(fp);
+        return FAILURE;
+    }
+    return fclose(fp) == 0 ? SUCCESS : FAILURE;
+}
+
+
+/*
+***************************************************************************
+** Main function.
+***************************************************************************
+*/
+int main(int argc, char **argv)
+{
+    char          indexed[MAX_PATH_LEN];
+    char          plain[MAX_PATH_LEN];
+    char          other[MAX_PATH_LEN];
+    char         *directory;
+    THolidayList *ref;
+    THolidayList *hl;
+    long          numLoaded;
+    long          bitsStart;
+    long          nbWords = 0;
+    int           bad = 0;
+
+    if (argc < 3 || strlen(argv[2]) + 32 > MAX_PATH_LEN)
+    {
+        printf("Usage: %s <holiday file> <empty directory>\n", argv[0]);
+        return 1;
+    }
+    directory = argv[2];
+    sprintf(indexed, "%s/INDEXED.hol", directory);
+    sprintf(plain,   "%s/PLAIN.hol", directory);
+    sprintf(other,   "%s/other.bin", directory);
+
+    JpmcdsErrMsgFileName("holfiletest.log", FALSE);
+    JpmcdsErrMsgOn();
+
+    ref = JpmcdsHolidayListRead(argv[1]);
+    if (ref == NULL ||
+        JpmcdsHolidayFileIsBinary(argv[1]) ||
+        JpmcdsHolidayFileConvert(argv[1], indexed, TRUE) != SUCCESS ||
+        JpmcdsHolidayFileConvert(argv[1], plain, FALSE) != SUCCESS)
+    {
+        printf("%s was not converted.\n", argv[1]);
+        return 1;
+    }
+
+    /* with the index, which is the one made from the text file */
+    hl = JpmcdsHolidayListReadBinary(indexed);
+    bad += CompareLists("With index", hl, ref);
+    if (hl != NULL)
+    {
+        THolidayList *built = JpmcdsHolidayListRead(argv[1]);
+
+        if (!JpmcdsHolidayFileIsBinary(indexed) ||
+            JPMCDS_HOLIDAY_LIST_INDEX(hl) == NULL || built == NULL ||
+            JpmcdsHolidayListBuildIndex(built) != SUCCESS ||
+            hl->index->startDate != built->index->startDate ||
+            hl->index->nbWords != built->index->nbWords ||
+            memcmp(hl->index->bits, built->index->bits,
+                   (built->index->nbWords + 1) * sizeof(unsigned long)) != 0 ||
+            memcmp(hl->index->ranks, built->index->ranks,
+                   (built->index->nbWords + 1) * sizeof(long)) != 0)
+        {
+            printf("With index: not the index of the text file.\n");
+            bad++;
+        }
+        else
+            nbWords = built->index->nbWords;
+        JpmcdsHolidayListDelete(built);
+    }
+    JpmcdsHolidayListDelete(hl);
+
+    /* read through JpmcdsHolidayListRead */
+    hl = JpmcdsHolidayListRead(indexed);
+    bad += CompareLists("Read", hl, ref);
+    JpmcdsHolidayListDelete(hl);
+
+    /* without the index */
+    hl = JpmcdsHolidayListReadBinary(plain);
+    bad += CompareLists("Without index", hl, ref);
+    if (hl != NULL && hl->index != NULL)
+    {
+        printf("Without index: has an index.\n");
+        bad++;
+    }
+    JpmcdsHolidayListDelete(hl);
+
+    /* a corrupted bitmap word and a corrupted count, in the middle */
+    bitsStart = HEADER_INTS + ref->dateList->fNumItems;
+    if (CopyFile(indexed, other, -1, bitsStart + nbWords / 2) != SUCCESS)
+        return 1;
+    hl = JpmcdsHolidayListReadBinary(other);
+    bad += CompareLists("Corrupt bitmap", hl, ref);
+    JpmcdsHolidayListDelete(hl);
+
+    if (CopyFile(indexed, other, -1, bitsStart + nbWords + 1 + nbWords / 2) != SUCCESS)
+        return 1;
+    hl = JpmcdsHolidayListReadBinary(other);
+    bad += CompareLists("Corrupt count", hl, ref);
+    JpmcdsHolidayListDelete(hl);
+
+    /* truncated and foreign files */
+    if (CopyFile(indexed, other, 100, -1) != SUCCESS)
+        return 1;
+    hl = JpmcdsHolidayListReadBinary(other);
+    if (hl != NULL)
+    {
+        printf("A truncated file was read.\n");
+        JpmcdsHolidayListDelete(hl);
+        bad++;
+    }
+    if (JpmcdsHolidayListReadBinary(argv[1]) != NULL)
+    {
+        printf("A text file was read as a binary file.\n");
+        bad++;
+    }
+
+    /* the directory has INDEXED and PLAIN, and other.bin which is skipped */
+    JpmcdsHolidayEmptyCache();
+    if (JpmcdsHolidayLoadDirectory(directory, NULL, &numLoaded) != SUCCESS ||
+        numLoaded != 2)
+    {
+        printf("The directory was not loaded.\n");
+        bad++;
+    }
+    else
+    {
+        bad += CompareLists("INDEXED", JpmcdsHolidayListFromCache("INDEXED"), ref);
+        bad += CompareLists("PLAIN", JpmcdsHolidayListFromCache("plain"), ref);
+    }
+
+    JpmcdsHolidayEmptyCache();
+    JpmcdsHolidayListDelete(ref);
+
+    printf("Binary holiday files: %d differences\n", bad);
+    return bad == 0 ? 0 : 1;
+}
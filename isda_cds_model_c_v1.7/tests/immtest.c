@@ -0,0 +1,287 @@
+/*
+ * ISDA CDS Standard Model
+ *
+ * Copyright (C) 2009 International Swaps and Derivatives Association, Inc.
+ * Developed and supported in collaboration with Markit
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the ISDA CDS Standard Model Public License.
+ */
+
+/*
+***************************************************************************
+** Checks the table of CDS IMM dates against the calendar for every date
+** of its years, and checks that JpmcdsCdsImmScheduleMake gives the
+** schedules made by rolling and adjusting the dates one by one, for
+** NB_SCHEDULES standard terms with and without holidays.
+**
+** Usage: immtest <holiday file>
+***************************************************************************
+*/
+
+#include <stdio.h>
+#include "macros.h"
+#include "cerror.h"
+#include "convert.h"
+#include "cdsimm.h"
+#include "busday.h"
+#include "buscache.h"
+#include "cxdatelist.h"
+#include "dateconv.h"
+#include "ldate.h"
+
+#define NB_SCHEDULES 20000
+
+#define CALENDAR     "IMMTEST"
+
+
+/*
+***************************************************************************
+** Returns a pseudo-random number in [0, n).
+***************************************************************************
+*/
+static long NextRandom(unsigned long *seed, long n)
+{
+    *seed = (*seed * 1103515245UL + 12345UL) & 0xffffffffUL;
+    return (long)((*seed >> 8) % (unsigned long)n);
+}
+
+
+/*
+***************************************************************************
+** Returns TRUE if a date is the 20th of March, June, September or
+** December.
+***************************************************************************
+*/
+static TBoolean IsImmDay(TDate date)
+{
+    TMonthDayYear mdy;
+
+    if (JpmcdsDateToMDY(date, &mdy) != SUCCESS)
+        return FALSE;
+    return mdy.day == 20 && mdy.month % 3 == 0;
+}
+
+
+/*
+***************************************************************************
+** Makes a schedule from the dates of JpmcdsDateListMakeRegular, adjusting
+** them one by one with JpmcdsBusinessDay.
+***************************************************************************
+*/
+static int RegularSchedule
+(TDate            startDate,
+ TDate            endDate,
+ TDateInterval   *ivl,
+ TStubMethod     *stub,
+ long             badDayConv,
+ char            *calendar,
+ TBoolean         protectStart,
+ TFeeLegSchedule *schedule)
+{
+    TDateList *dl = JpmcdsDateListMakeRegular(startDate, endDate, ivl, stub);
+    TDate      prevDate;
+    TDate      prevDateAdj;
+    int        n;
+    int        i;
+
+    if (dl == NULL)
+        return FAILURE;
+
+    n = dl->fNumItems - 1;
+    schedule->nbDates       = n;
+    schedule->accStartDates = NEW_ARRAY(TDate, 3 * n);
+    if (schedule->accStartDates == NULL)
+    {
+        JpmcdsFreeDateList(dl);
+        return FAILURE;
+    }
+    schedule->accEndDates = schedule->accStartDates + n;
+    schedule->payDates    = schedule->accEndDates + n;
+
+    prevDate    = dl->fArray[0];
+    prevDateAdj = prevDate;
+    for (i = 0; i < n; i++)
+    {
+        TDate nextDate = dl->fArray[i+1];
+        TDate nextDateAdj;
+
+        if (JpmcdsBusinessDay(nextDate, badDayConv, calendar,
+                              &nextDateAdj) != SUCCESS)
+        {
+            JpmcdsFreeDateList(dl);
+            return FAILURE;
+        }
+        schedule->accStartDates[i] = prevDateAdj;
+        schedule->accEndDates[i]   = nextDateAdj;
+        schedule->payDates[i]      = nextDateAdj;
+        prevDate    = nextDate;
+        prevDateAdj = nextDateAdj;
+    }
+    schedule->accEndDates[n-1] = protectStart ? prevDate + 1 : prevDate;
+
+    JpmcdsFreeDateList(dl);
+    return SUCCESS;
+}
+
+
+/*
+***************************************************************************
+** Returns the number of dates of the years of the table for which
+** JpmcdsIsImmDate or JpmcdsImmDateNext is wrong.
+***************************************************************************
+*/
+static int CheckImmDates(void)
+{
+    TDate firstDate = JpmcdsDate(JPMCDS_IMM_FIRST_YEAR, 1, 1);
+    TDate lastDate  = JpmcdsDate(JPMCDS_IMM_LAST_YEAR, 12, 20);
+    TDate nextImm   = JpmcdsDate(JPMCDS_IMM_FIRST_YEAR, 3, 20);
+    TDate date;
+    TDate immDate;
+    int   bad = 0;
+
+    for (date = firstDate; date < lastDate; date++)
+    {
+        if (date == nextImm)
+        {
+            for (nextImm = date + 1; !IsImmDay(nextImm); nextImm++)
+                ;
+        }
+
+        if (JpmcdsIsImmDate(date) != IsImmDay(date) ||
+            JpmcdsImmDateNext(date, &immDate) != SUCCESS ||
+            immDate != nextImm)
+        {
+            if (bad == 0)
+                printf("IMM dates: wrong on %s.\n", JpmcdsFormatDate(date));
+            bad++;
+        }
+    }
+
+    /* outside the years of the table */
+    if (JpmcdsIsImmDate(JpmcdsDate(JPMCDS_IMM_FIRST_YEAR - 1, 12, 20)) ||
+        JpmcdsIsImmDate(JpmcdsDate(JPMCDS_IMM_LAST_YEAR + 1, 3, 20)) ||
+        JpmcdsImmDateNext(lastDate, &immDate) == SUCCESS)
+    {
+        printf("IMM dates: accepted outside the table.\n");
+        bad++;
+    }
+
+    return bad;
+}
+
+
+/*
+***************************************************************************
+** Returns the number of standard terms for which JpmcdsCdsImmScheduleMake
+** does not give the schedule of RegularSchedule.
+***************************************************************************
+*/
+static int CheckSchedules(void)
+{
+    static long   convs[4] = {JPMCDS_BAD_DAY_FOLLOW, JPMCDS_BAD_DAY_MODIFIED,
+                              JPMCDS_BAD_DAY_PREVIOUS, JPMCDS_BAD_DAY_NONE};
+    static char  *calendars[2] = {"None", CALENDAR};
+    unsigned long seed = 21;
+    int           bad = 0;
+    long          i;
+
+    for (i = 0; i < NB_SCHEDULES; i++)
+    {
+        TDate           startDate = JpmcdsDate(1990, 1, 1) + NextRandom(&seed, 40000);
+        TDate           endDate;
+        TDateInterval   ivl;
+        TStubMethod     stub;
+        TFeeLegSchedule ref;
+        TFeeLegSchedule schedule;
+        long            conv = convs[NextRandom(&seed, 4)];
+        char           *calendar = calendars[NextRandom(&seed, 2)];
+        TBoolean        protectStart = (TBoolean)NextRandom(&seed, 2);
+        long            q;
+
+        /* some trades start on or just before an IMM date */
+        if (i % 4 == 0)
+            JpmcdsImmDateNext(startDate - 1 - NextRandom(&seed, 3), &startDate);
+        JpmcdsImmDateNext(startDate, &endDate);
+        for (q = NextRandom(&seed, 45); q > 0; q--)
+            JpmcdsImmDateNext(endDate, &endDate);
+
+        if (NextRandom(&seed, 2))
+            SET_TDATE_INTERVAL(ivl, 3, 'M');
+        else
+            SET_TDATE_INTERVAL(ivl, 1, 'Q');
+        stub.stubAtEnd = FALSE;
+        stub.longStub  = (TBoolean)NextRandom(&seed, 2);
+
+        if (!JpmcdsCdsImmScheduleValid(startDate, endDate, &ivl, &stub) ||
+            RegularSchedule(startDate, endDate, &ivl, &stub, conv, calendar,
+                            protectStart, &ref) != SUCCESS)
+        {
+            printf("Schedule %ld: not accepted.\n", i);
+            bad++;
+            continue;
+        }
+
+        if (JpmcdsCdsImmScheduleMake(startDate, endDate, &ivl, &stub, conv,
+                                     JpmcdsHolidayListFromCache(calendar),
+                                     protectStart, &schedule) != SUCCESS)
+        {
+            printf("Schedule %ld: not made.\n", i);
+            bad++;
+        }
+        else
+        {
+            int k = schedule.nbDates == ref.nbDates ? 0 : -1;
+
+            while (k >= 0 && k < 3 * ref.nbDates &&
+                   schedule.accStartDates[k] == ref.accStartDates[k])
+                k++;
+            if (k != 3 * ref.nbDates)
+            {
+                if (bad == 0)
+                    printf("Schedule %ld: from %s to %s differs.\n", i,
+                           JpmcdsFormatDate(startDate),
+                           JpmcdsFormatDate(endDate));
+                bad++;
+            }
+            FREE(schedule.accStartDates);
+        }
+        FREE(ref.accStartDates);
+    }
+
+    return bad;
+}
+
+
+/*
+***************************************************************************
+** Main function.
+***************************************************************************
+*/
+int main(int argc, char **argv)
+{
+    THolidayList *hl;
+    int           bad = 0;
+
+    if (argc < 2)
+    {
+        printf("Usage: %s <holiday file>\n", argv[0]);
+        return 1;
+    }
+
+    JpmcdsErrMsgFileName("immtest.log", FALSE);
+    JpmcdsErrMsgOn();
+
+    hl = JpmcdsHolidayListRead(argv[1]);
+    if (hl == NULL || JpmcdsHolidayListAddToCache(CALENDAR, hl) != SUCCESS)
+    {
+        printf("The holidays were not read.\n");
+        return 1;
+    }
+
+    bad += CheckImmDates();
+    bad += CheckSchedules();
+
+    printf("%d schedules: %d differences\n", NB_SCHEDULES, bad);
+    return bad == 0 ? 0 : 1;
+}
@@ -0,0 +1,241 @@
+/*
+ * ISDA CDS Standard Model
+ *
+ * Copyright (C) 2009 International Swaps and Derivatives Association, Inc.
+ * Developed and supported in collaboration with Markit
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the ISDA CDS Standard Model Public License.
+ */
+
+/*
+***************************************************************************
+** Checks that the fee legs made with the schedule cache have the dates of
+** the fee legs made without it: on the first and second time the terms
+** are seen, with calendar names in another case or longer than the key
+** buffer of the cache, after the holidays of a calendar are replaced and
+** when the cache is smaller than the number of terms.
+**
+** Usage: schedtest
+***************************************************************************
+*/
+
+#include <stdio.h>
+#include <string.h>
+#include "macros.h"
+#include "cerror.h"
+#include "cds.h"
+#include "feeleg.h"
+#include "schedcache.h"
+#include "buscache.h"
+#include "busday.h"
+#include "dtlist.h"
+#include "ldate.h"
+
+#define NB_TERMS     500
+#define LONG_NAME    300
+
+#define CALENDAR     "SCHEDTEST"
+
+
+/*
+***************************************************************************
+** Makes the fee leg of terms i with a calendar.
+***************************************************************************
+*/
+static TFeeLeg* MakeFeeLeg(long i, char *calendar)
+{
+    TDate         base = JpmcdsDate(2025, 6, 16);
+    TDateInterval ivl;
+    TStubMethod   stub;
+
+    SET_TDATE_INTERVAL(ivl, 3, 'M');
+    stub.stubAtEnd = FALSE;
+    stub.longStub  = (TBoolean)(i % 5 == 0);
+
+    return JpmcdsCdsFeeLegMake(base + i % 37, base + 365 * (1 + i % 10) + i % 53,
+                               TRUE, &ivl, &stub, 1e7, 0.01, JPMCDS_ACT_360,
+                               i % 2 ? 'M' : 'F', calendar,
+                               (TBoolean)(i % 3 != 0));
+}
+
+
+/*
+***************************************************************************
+** Returns TRUE if two fee legs have the same dates.
+***************************************************************************
+*/
+static TBoolean SameDates(TFeeLeg *a, TFeeLeg *b)
+{
+    return a != NULL && b != NULL &&
+        a->nbDates == b->nbDates &&
+        a->obsStartOfDay == b->obsStartOfDay &&
+        memcmp(a->accStartDates, b->accStartDates, a->nbDates * sizeof(TDate)) == 0 &&
+        memcmp(a->accEndDates, b->accEndDates, a->nbDates * sizeof(TDate)) == 0 &&
+        memcmp(a->payDates, b->payDates, a->nbDates * sizeof(TDate)) == 0;
+}
+
+
+/*
+***************************************************************************
+** Returns the number of terms whose fee leg made with a calendar does not
+** have the dates of the reference leg.
+***************************************************************************
+*/
+static int CompareFeeLegs(char *name, TFeeLeg **refs, char *calendar)
+{
+    int  bad = 0;
+    long i;
+
+    for (i = 0; i < NB_TERMS; i++)
+    {
+        TFeeLeg *feeLeg = MakeFeeLeg(i, calendar);
+
+        if (!SameDates(feeLeg, refs[i]))
+        {
+            if (bad == 0)
+                printf("%s: fee leg %ld has other dates.\n", name, i);
+            bad++;
+        }
+        JpmcdsFeeLegFree(feeLeg);
+    }
+
+    return bad;
+}
+
+
+/*
+***************************************************************************
+** Makes the reference fee legs of a calendar without the cache.
+***************************************************************************
+*/
+static int MakeReferences(TFeeLeg **refs, char *calendar)
+{
+    long i;
+
+    JpmcdsFeeLegScheduleCacheSetMaxSize(0);
+    for (i = 0; i < NB_TERMS; i++)
+    {
+        JpmcdsFeeLegFree(refs[i]);
+        refs[i] = MakeFeeLeg(i, calendar);
+        if (refs[i] == NULL)
+        {
+            printf("Fee leg %ld was not made.\n", i);
+            return FAILURE;
+        }
+    }
+    JpmcdsFeeLegScheduleCacheSetMaxSize(JPMCDS_FEE_SCHEDULE_CACHE_SIZE);
+
+    return SUCCESS;
+}
+
+
+/*
+***************************************************************************
+** Adds a calendar with the weekends and one holiday to the holiday cache.
+***************************************************************************
+*/
+static int AddCalendar(char *calendar, TDate holiday)
+{
+    TDateList    *dl = JpmcdsNewDateListFromDates(&holiday, 1);
+    THolidayList *hl = NULL;
+
+    if (dl == NULL)
+        return FAILURE;
+    hl = JpmcdsHolidayListNewGeneral(dl, JPMCDS_WEEKEND_STANDARD);
+    JpmcdsFreeDateList(dl);
+    if (hl == NULL)
+        return FAILURE;
+    return JpmcdsHolidayListAddToCache(calendar, hl);
+}
+
+
+/*
+***************************************************************************
+** Main function.
+***************************************************************************
+*/
+int main(void)
+{
+    static TFeeLeg *refs[NB_TERMS];
+    static TFeeLeg *newRefs[NB_TERMS];
+    char            longName[LONG_NAME + 1];
+    TDate           holiday = JpmcdsDate(2026, 6, 22);
+    long            hits;
+    long            misses;
+    long            numEntries;
+    long            i;
+    int             bad = 0;
+
+    JpmcdsErrMsgFileName("schedtest.log", FALSE);
+    JpmcdsErrMsgOn();
+
+    for (i = 0; i < LONG_NAME; i++)
+        longName[i] = (char)('a' + i % 26);
+    longName[LONG_NAME] = '\0';
+
+    if (AddCalendar(CALENDAR, holiday) != SUCCESS ||
+        AddCalendar(longName, holiday) != SUCCESS)
+    {
+        printf("The calendars were not added.\n");
+        return 1;
+    }
+
+    if (MakeReferences(refs, CALENDAR) != SUCCESS)
+        return 1;
+    JpmcdsFeeLegScheduleCacheEmpty();
+
+    bad += CompareFeeLegs("First time", refs, CALENDAR);
+    bad += CompareFeeLegs("Second time", refs, "schedTest");
+    JpmcdsFeeLegScheduleCacheStats(&hits, &misses, &numEntries);
+    if (hits != NB_TERMS || misses != NB_TERMS)
+    {
+        printf("%ld hits and %ld misses, not %d of each.\n",
+               hits, misses, NB_TERMS);
+        bad++;
+    }
+
+    /* long names which differ only at the end have their own schedules */
+    bad += CompareFeeLegs("Long name", refs, longName);
+    bad += CompareFeeLegs("Long name again", refs, longName);
+    longName[LONG_NAME - 1] = '_';
+    if (AddCalendar(longName, JpmcdsDate(2026, 9, 21)) != SUCCESS ||
+        MakeReferences(newRefs, longName) != SUCCESS)
+        return 1;
+    bad += CompareFeeLegs("Other long name", newRefs, longName);
+
+    /* replacing the holidays of a calendar makes its schedules again */
+    if (AddCalendar(CALENDAR, JpmcdsDate(2026, 9, 21)) != SUCCESS ||
+        MakeReferences(newRefs, CALENDAR) != SUCCESS)
+        return 1;
+    bad += CompareFeeLegs("Replaced holidays", newRefs, CALENDAR);
+
+    /* a cache smaller than the number of terms */
+    JpmcdsFeeLegScheduleCacheSetMaxSize(NB_TERMS / 10);
+    JpmcdsFeeLegScheduleCacheStats(NULL, NULL, &numEntries);
+    if (numEntries > NB_TERMS / 10)
+    {
+        printf("%ld schedules in a cache of %d.\n", numEntries, NB_TERMS / 10);
+        bad++;
+    }
+    bad += CompareFeeLegs("Small cache", newRefs, CALENDAR);
+    bad += CompareFeeLegs("Small cache again", newRefs, CALENDAR);
+
+    JpmcdsFeeLegScheduleCacheEmpty();
+    JpmcdsFeeLegScheduleCacheStats(&hits, &misses, &numEntries);
+    if (hits != 0 || misses != 0 || numEntries != 0)
+    {
+        printf("The emptied cache has %ld hits, %ld misses and %ld "
+               "schedules.\n", hits, misses, numEntries);
+        bad++;
+    }
+
+    for (i = 0; i < NB_TERMS; i++)
+    {
+        JpmcdsFeeLegFree(refs[i]);
+        JpmcdsFeeLegFree(newRefs[i]);
+    }
+
+    printf("%d terms: %d differences\n", NB_TERMS, bad);
+    return bad == 0 ? 0 : 1;
+}
@@ -0,0 +1,152 @@
+/*
+ * ISDA CDS Standard Model
+ *
+ * Copyright (C) 2009 International Swaps and Derivatives Association, Inc.
+ * Developed and supported in collaboration with Markit
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the ISDA CDS Standard Model Public License.
+ */
+
+/*
+***************************************************************************
+** Prices a table of trades with JpmcdsCdsPriceBatch, and again with the
+** segment integrals of segint.h by JpmcdsCdsPriceBatchVectorIntegrals, and
+** checks that the first prices are those of JpmcdsCdsPrice bit for bit and
+** that the second differ from them only by rounding.
+**
+** Usage: segtest
+***************************************************************************
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "macros.h"
+#include "cerror.h"
+#include "tcurve.h"
+#include "convert.h"
+#include "cds.h"
+#include "ldate.h"
+#include "segint.h"
+#include "testutil.h"
+
+#define NB_TRADES 400
+#define TOLERANCE 1e-12
+
+
+/*
+***************************************************************************
+** Main function.
+***************************************************************************
+*/
+int main(void)
+{
+    TDate          today = JpmcdsDate(2025, 6, 16);
+    TCurve        *zc = NULL;
+    TCurve        *sc[2] = {NULL, NULL};
+    TDateInterval  ivl;
+    TStubMethod    stub;
+    long           dcc;
+    TDate          startDates[NB_TRADES];
+    TDate          tradeEndDates[NB_TRADES];
+    double         couponRates[NB_TRADES];
+    double         recoveryRates[NB_TRADES];
+    TCurve        *discCurves[NB_TRADES];
+    TCurve        *spreadCurves[NB_TRADES];
+    TCdsTradeTable trades;
+    double         prices[NB_TRADES];
+    double         scalarPrices[NB_TRADES];
+    double         vectorPrices[NB_TRADES];
+    double         maxDiff = 0.0;
+    int            bad = 0;
+    int            i;
+
+    JpmcdsErrMsgFileName("segtest.log", FALSE);
+    JpmcdsErrMsgOn();
+
+    if (JpmcdsStringToDayCountConv("Act/360", &dcc) != SUCCESS ||
+        JpmcdsStringToDateInterval("3M", "segtest", &ivl) != SUCCESS ||
+        JpmcdsStringToStubMethod("f/s", &stub) != SUCCESS)
+        return 1;
+
+    zc = TestBuildZeroCurve(today);
+    if (zc == NULL)
+    {
+        printf("Zero curve failed.\n");
+        return 1;
+    }
+
+    for (i = 0; i < 2; i++)
+    {
+        sc[i] = TestBuildSpreadCurve(today, zc, 0.01 * (1 + 2 * i), "None");
+        if (sc[i] == NULL)
+        {
+            printf("Spread curve failed.\n");
+            return 1;
+        }
+    }
+
+    for (i = 0; i < NB_TRADES; i++)
+    {
+        startDates[i]    = today - 30 + i % 60;
+        tradeEndDates[i] = TestImmDate(today, 3 + i % 120);
+        couponRates[i]   = i % 3 ? 0.01 : 0.05;
+        recoveryRates[i] = i % 4 ? 0.4 : 0.25;
+        discCurves[i]    = zc;
+        spreadCurves[i]  = sc[i % 2];
+    }
+
+    trades.nbTrades      = NB_TRADES;
+    trades.startDates    = startDates;
+    trades.endDates      = tradeEndDates;
+    trades.couponRates   = couponRates;
+    trades.recoveryRates = recoveryRates;
+    trades.discCurves    = discCurves;
+    trades.spreadCurves  = spreadCurves;
+
+    if (JpmcdsCdsPriceBatch(today, today+3, today+1, &trades, TRUE, &ivl,
+                            &stub, dcc, 'F', "None", TRUE,
+                            scalarPrices) != SUCCESS ||
+        JpmcdsCdsPriceBatchVectorIntegrals(today, today+3, today+1, &trades,
+                                           TRUE, &ivl, &stub, dcc, 'F',
+                                           "None", TRUE,
+                                           vectorPrices) != SUCCESS)
+    {
+        printf("JpmcdsCdsPriceBatch failed.\n");
+        return 1;
+    }
+
+    for (i = 0; i < NB_TRADES; i++)
+    {
+        double diff;
+
+        if (JpmcdsCdsPrice(today, today+3, today+1, startDates[i],
+                           tradeEndDates[i], couponRates[i], TRUE, &ivl,
+                           &stub, dcc, 'F', "None", zc, spreadCurves[i],
+                           recoveryRates[i], TRUE, &prices[i]) != SUCCESS)
+        {
+            printf("JpmcdsCdsPrice failed for trade %d.\n", i);
+            return 1;
+        }
+
+        if (memcmp(&scalarPrices[i], &prices[i], sizeof(double)) != 0)
+            bad++;
+
+        diff = fabs(vectorPrices[i] - prices[i]);
+        if (diff > maxDiff)
+            maxDiff = diff;
+        if (!(diff <= TOLERANCE))
+            bad++;
+    }
+
+    printf("%d trades, %s integrals: max difference %g, %d failures\n",
+           NB_TRADES, JpmcdsSegmentsVectorized() ? "AVX2" : "scalar",
+           maxDiff, bad);
+
+    JpmcdsFreeTCurve(zc);
+    JpmcdsFreeTCurve(sc[0]);
+    JpmcdsFreeTCurve(sc[1]);
+    return bad == 0 ? 0 : 1;
+}
@@ -0,0 +1,130 @@
+/*
+ * ISDA CDS Standard Model
+ *
+ * Copyright (C) 2009 International Swaps and Derivatives Association, Inc.
+ * Developed and supported in collaboration with Markit
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the ISDA CDS Standard Model Public License.
+ */
+
+#include "testutil.h"
+#include "macros.h"
+#include "tcurve.h"
+#include "convert.h"
+#include "zerocurve.h"
+#include "cds.h"
+#include "ldate.h"
+#include "date_sup.h"
+
+
+/*
+***************************************************************************
+** Returns the dates and rates of the instruments of the IR zero curve.
+***************************************************************************
+*/
+int TestIRInstruments
+(TDate   today,
+ double  shift,
+ TDate  *dates,
+ double *rates)
+{
+    char *expiries[TEST_IR_NB_INSTR] = {"1M", "2M", "3M", "6M", "9M", "1Y",
+                                        "2Y", "3Y", "4Y", "5Y", "6Y", "7Y",
+                                        "8Y", "9Y", "10Y", "15Y", "30Y"};
+    int   i;
+
+    for (i = 0; i < TEST_IR_NB_INSTR; i++)
+    {
+        TDateInterval tmp;
+
+        if (JpmcdsStringToDateInterval(expiries[i], "TestIRInstruments", &tmp) != SUCCESS ||
+            JpmcdsDateFwdThenAdjust(today, &tmp, JPMCDS_BAD_DAY_NONE, "None",
+                                    dates+i) != SUCCESS)
+            return FAILURE;
+        rates[i] = 0.02 + 0.002 * i - 0.0001 * i * i + shift;
+    }
+
+    return SUCCESS;
+}
+
+
+/*
+***************************************************************************
+** Builds the IR zero curve.
+***************************************************************************
+*/
+TCurve* TestBuildZeroCurve
+(TDate   today)
+{
+    TDate         dates[TEST_IR_NB_INSTR];
+    double        rates[TEST_IR_NB_INSTR];
+    long          mmDCC;
+    long          dcc;
+    TDateInterval ivl;
+    double        freq;
+
+    if (JpmcdsStringToDayCountConv("Act/360", &mmDCC) != SUCCESS ||
+        JpmcdsStringToDayCountConv("30/360", &dcc) != SUCCESS ||
+        JpmcdsStringToDateInterval("6M", "TestBuildZeroCurve", &ivl) != SUCCESS ||
+        JpmcdsDateIntervalToFreq(&ivl, &freq) != SUCCESS ||
+        TestIRInstruments(today, 0.0, dates, rates) != SUCCESS)
+        return NULL;
+
+    return JpmcdsBuildIRZeroCurve(today, TEST_IR_TYPES, dates, rates,
+                                  TEST_IR_NB_INSTR, mmDCC, (long)freq,
+                                  (long)freq, dcc, dcc, 'M', "None");
+}
+
+
+/*
+***************************************************************************
+** Returns the IMM date on or after a number of months from a date.
+***************************************************************************
+*/
+TDate TestImmDate
+(TDate   date,
+ long    months)
+{
+    TMonthDayYear mdy;
+    long          m;
+
+    JpmcdsDateToMDY(date, &mdy);
+    m = mdy.month - 1 + months;
+    return JpmcdsDate(mdy.year + m / 12, (m % 12) / 3 * 3 + 3, 20);
+}
+
+
+/*
+***************************************************************************
+** Builds a clean spread curve from four quarterly CDS.
+***************************************************************************
+*/
+TCurve* TestBuildSpreadCurve
+(TDate   today,
+ TCurve *discCurve,
+ double  level,
+ char   *calendar)
+{
+    TDate         endDates[4];
+    double        coupons[4];
+    TDateInterval ivl;
+    TStubMethod   stub;
+    long          dcc;
+    int           i;
+
+    if (JpmcdsStringToDayCountConv("Act/360", &dcc) != SUCCESS ||
+        JpmcdsStringToDateInterval("3M", "TestBuildSpreadCurve", &ivl) != SUCCESS ||
+        JpmcdsStringToStubMethod("f/s", &stub) != SUCCESS)
+        return NULL;
+
+    for (i = 0; i < 4; i++)
+    {
+        endDates[i] = TestImmDate(today, 24 * (i + 1));
+        coupons[i]  = level * (1 + 0.2 * i);
+    }
+
+    return JpmcdsCleanSpreadCurve(today, discCurve, today-30, today+1, today+3,
+                                  4, endDates, coupons, NULL, 0.4, TRUE, &ivl,
+                                  dcc, &stub, 'F', calendar);
+}
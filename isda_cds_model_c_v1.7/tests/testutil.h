@@ -0,0 +1,74 @@
+/*
+ * ISDA CDS Standard Model
+ *
+ * Copyright (C) 2009 International Swaps and Derivatives Association, Inc.
+ * Developed and supported in collaboration with Markit
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the ISDA CDS Standard Model Public License.
+ */
+
+#ifndef TESTUTIL_H
+#define TESTUTIL_H
+
+#include "cdate.h"
+#include "bastypes.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/* instruments of the IR zero curve of the tests */
+#define TEST_IR_NB_INSTR 17
+#define TEST_IR_TYPES    "MMMMMSSSSSSSSSSSS"
+
+/*f
+***************************************************************************
+** Returns the dates and rates of the instruments of the IR zero curve of
+** the tests. The rates are shifted by shift.
+***************************************************************************
+*/
+int TestIRInstruments
+(TDate   today,        /* (I) Value date                              */
+ double  shift,        /* (I) Added to every rate                     */
+ TDate  *dates,        /* (O) [TEST_IR_NB_INSTR] Instrument dates     */
+ double *rates);       /* (O) [TEST_IR_NB_INSTR] Instrument rates     */
+
+
+/*f
+***************************************************************************
+** Builds the IR zero curve of the tests with JpmcdsBuildIRZeroCurve.
+***************************************************************************
+*/
+TCurve* TestBuildZeroCurve
+(TDate   today);       /* (I) Value date                              */
+
+
+/*f
+***************************************************************************
+** Returns the IMM date on or after a number of months from a date.
+***************************************************************************
+*/
+TDate TestImmDate
+(TDate   date,         /* (I) Date                                    */
+ long    months);      /* (I) Number of months                        */
+
+
+/*f
+***************************************************************************
+** Builds a clean spread curve from four quarterly CDS of 2, 4, 6 and 8
+** years with coupons from level to 1.6 * level.
+***************************************************************************
+*/
+TCurve* TestBuildSpreadCurve
+(TDate   today,        /* (I) Value date                              */
+ TCurve *discCurve,    /* (I) IR zero curve                           */
+ double  level,        /* (I) Coupon of the shortest CDS              */
+ char   *calendar);    /* (I) Calendar of the CDS                     */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,211 @@
+/*
+ * ISDA CDS Standard Model
+ *
+ * Copyright (C) 2009 International Swaps and Derivatives Association, Inc.
+ * Developed and supported in collaboration with Markit
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the ISDA CDS Standard Model Public License.
+ */
+
+/*
+***************************************************************************
+** Prices the same trades on many threads at once, each thread building
+** its own curves, and checks that every thread gets the single-threaded
+** prices bit for bit. The holidays are looked up in the shared cache
+** while some of the threads read the holiday file again and replace them.
+**
+** Usage: threadtest <holiday file> [nbThreads]
+***************************************************************************
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "macros.h"
+#include "cerror.h"
+#include "tcurve.h"
+#include "convert.h"
+#include "cds.h"
+#include "ldate.h"
+#include "busday.h"
+#include "buscache.h"
+#include "cthread.h"
+#include "testutil.h"
+
+#define NB_TRADES 200
+#define NB_ROUNDS 4
+
+#define CALENDAR "THREADTEST"
+
+typedef struct
+{
+    char   *holidayFile;           /* Holiday file of the trades */
+    double  prices[NB_TRADES];     /* Single-threaded prices */
+    char    dates[NB_TRADES][JPMCDS_FORMAT_DATE_LEN];
+    double *results;               /* NB_TRADES prices for each task */
+    int    *failures;              /* Failed or mismatched dates by task */
+} TThreadTest;
+
+
+/*
+***************************************************************************
+** Builds the curves and prices the trades with the holidays of CALENDAR,
+** writing the prices. The
+** formatted trade dates are written if setDates is TRUE, and otherwise
+** compared with the dates given. Returns the number of failures.
+***************************************************************************
+*/
+static int PriceTrades
+(double   *prices,
+ char      dates[][JPMCDS_FORMAT_DATE_LEN],
+ TBoolean  setDates)
+{
+    TDate          today = JpmcdsDate(2025, 6, 16);
+    TCurve        *zc = NULL;
+    TCurve        *sc = NULL;
+    TDateInterval  ivl;
+    TStubMethod    stub;
+    long           dcc;
+    int            failures = 0;
+    int            i;
+
+    if (JpmcdsStringToDayCountConv("Act/360", &dcc) != SUCCESS ||
+        JpmcdsStringToDateInterval("3M", "PriceTrades", &ivl) != SUCCESS ||
+        JpmcdsStringToStubMethod("f/s", &stub) != SUCCESS)
+        return NB_TRADES;
+
+    zc = TestBuildZeroCurve(today);
+    if (zc == NULL)
+        return NB_TRADES;
+
+    sc = TestBuildSpreadCurve(today, zc, 0.01, CALENDAR);
+    if (sc == NULL)
+    {
+        JpmcdsFreeTCurve(zc);
+        return NB_TRADES;
+    }
+
+    for (i = 0; i < NB_TRADES; i++)
+    {
+        char buffer[JPMCDS_FORMAT_DATE_LEN];
+
+        if (JpmcdsCdsPrice(today, today+3, today+1, today-30+i%60,
+                           TestImmDate(today, 3+i%100), 0.01, TRUE, &ivl, &stub,
+                           dcc, 'F', i % 2 ? CALENDAR : "None", zc, sc, 0.4,
+                           TRUE, &prices[i]) != SUCCESS)
+            failures++;
+
+        /* date formatting uses a buffer for each thread */
+        strcpy(buffer, JpmcdsFormatDate(today + 7 * i));
+        if (setDates)
+            strcpy(dates[i], buffer);
+        else if (strcmp(dates[i], buffer) != 0)
+            failures++;
+    }
+
+    JpmcdsFreeTCurve(zc);
+    JpmcdsFreeTCurve(sc);
+    return failures;
+}
+
+
+/*
+***************************************************************************
+** Reads the holiday file into the holiday cache as CALENDAR.
+***************************************************************************
+*/
+static int LoadCalendar(char *holidayFile)
+{
+    THolidayList *hl = JpmcdsHolidayListRead(holidayFile);
+
+    if (hl == NULL)
+        return FAILURE;
+    return JpmcdsHolidayListAddToCache(CALENDAR, hl);
+}
+
+
+/*
+***************************************************************************
+** Task of JpmcdsParallelFor: prices the trades for task i. The first task
+** of each round replaces the holidays in the cache beforehand.
+***************************************************************************
+*/
+static void PriceTask(void *data, long i)
+{
+    TThreadTest *test = (TThreadTest*)data;
+
+    if (i % NB_ROUNDS == 0 && LoadCalendar(test->holidayFile) != SUCCESS)
+    {
+        test->failures[i] = NB_TRADES;
+        return;
+    }
+
+    test->failures[i] = PriceTrades(test->results + i * NB_TRADES,
+                                    test->dates, FALSE);
+}
+
+
+/*
+***************************************************************************
+** Main function.
+***************************************************************************
+*/
+int main(int argc, char **argv)
+{
+    TThreadTest test;
+    int         nbThreads;
+    long        nbTasks;
+    long        i;
+    int         j;
+    int         bad = 0;
+
+    if (argc < 2)
+    {
+        printf("Usage: %s <holiday file> [nbThreads]\n", argv[0]);
+        return 1;
+    }
+
+    nbThreads = argc > 2 ? atoi(argv[2]) : 8;
+    nbTasks   = (long)nbThreads * NB_ROUNDS;
+
+    memset(&test, 0, sizeof(test));
+    test.holidayFile = argv[1];
+    test.results  = malloc(nbTasks * NB_TRADES * sizeof(double));
+    test.failures = malloc(nbTasks * sizeof(int));
+    if (test.results == NULL || test.failures == NULL)
+        return 1;
+
+    JpmcdsErrMsgFileName("threadtest.log", FALSE);
+    JpmcdsErrMsgOn();
+
+    if (LoadCalendar(test.holidayFile) != SUCCESS ||
+        PriceTrades(test.prices, test.dates, TRUE) != 0)
+    {
+        printf("Single-threaded pricing failed.\n");
+        return 1;
+    }
+
+    if (JpmcdsParallelFor(nbTasks, nbThreads, PriceTask, &test) != SUCCESS)
+    {
+        printf("JpmcdsParallelFor failed.\n");
+        return 1;
+    }
+
+    for (i = 0; i < nbTasks; i++)
+    {
+        bad += test.failures[i];
+        for (j = 0; j < NB_TRADES; j++)
+        {
+            if (memcmp(&test.results[i * NB_TRADES + j], &test.prices[j],
+                       sizeof(double)) != 0)
+                bad++;
+        }
+    }
+
+    printf("%ld tasks on %d threads: %d differences\n", nbTasks, nbThreads, bad);
+
+    free(test.results);
+    free(test.failures);
+    return bad == 0 ? 0 : 1;
+}
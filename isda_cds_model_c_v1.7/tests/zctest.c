@@ -0,0 +1,299 @@
+/*
+ * ISDA CDS Standard Model
+ *
+ * Copyright (C) 2009 International Swaps and Derivatives Association, Inc.
+ * Developed and supported in collaboration with Markit
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the ISDA CDS Standard Model Public License.
+ */
+
+/*
+***************************************************************************
+** Checks that JpmcdsBuildIRZeroCurve gives the rates of the reference
+** implementation bit for bit, and that a curve builder gives the same
+** curves. With Newton's method the builder must stay within NEWTON_TOL of
+** them. The builder is then updated NB_UPDATES times with rates moved one
+** at a time or all together, and must give the curves of
+** JpmcdsBuildIRZeroCurve bit for bit after each update.
+**
+** The reference rates were printed with %.17g from the Brent search of
+** version 1.7 for the instruments of TestIRInstruments.
+**
+** Usage: zctest
+***************************************************************************
+*/
+
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include "macros.h"
+#include "cerror.h"
+#include "tcurve.h"
+#include "convert.h"
+#include "zerocurve.h"
+#include "ldate.h"
+#include "date_sup.h"
+#include "testutil.h"
+
+#define NB_CURVES  2
+#define NB_POINTS  64
+#define NEWTON_TOL 1e-8
+#define NB_UPDATES 200
+
+static double shifts[NB_CURVES] = {0.0, -0.019};
+
+static double refRates[NB_CURVES][NB_POINTS] = {
+  {
+    0.020467543630127372, 0.022410495686170817, 0.024142739603908003,
+    0.025610071738974893, 0.026856563349794804, 0.027702887486017236,
+    0.02831636564689699, 0.028621564873544284, 0.029040250976545501,
+    0.029319214922751944, 0.029623637515683532, 0.029848053767165067,
+    0.030024455306523423, 0.030165733496714864, 0.030221584302825732,
+    0.030268158695941731, 0.030198453385764656, 0.03013872920072801,
+    0.029956743365864291, 0.029798386591879979, 0.029496685430818959,
+    0.029230025411010285, 0.028806641834662194, 0.028432103378515948,
+    0.028289580995590535, 0.028159987196294756, 0.028041017228356946,
+    0.02793256260582444, 0.02783223962215331, 0.027740143605422318,
+    0.027654403526490512, 0.027575225577609386, 0.027501105036709106,
+    0.027431210251628216, 0.027350724953149053, 0.027275257640981598,
+    0.027204353220399158, 0.027137610013506563, 0.027074336243735564,
+    0.027014905655918797, 0.026958379681498723, 0.026904837629264433,
+    0.026854049299995797, 0.026806064621688108, 0.026759681059596252,
+    0.026716234400570693, 0.0266748030247832, 0.026635249891535651,
+    0.026597450109883347, 0.026561095268762713, 0.026526291712173578,
+    0.026493120673968029, 0.026461128763008102, 0.026430584449077532,
+    0.026401076729565709, 0.026372859045335595, 0.026345264330209783,
+    0.026319127923515984, 0.02629393924989798, 0.026269647678654584,
+    0.026246079588337912, 0.026223448512475489, 0.026201464401263808,
+    0.026180329199558813
+  },
+  {
+    0.0010143607621071471, 0.002943880334564275, 0.004672029761382257,
+    0.0061942586664716082, 0.0075098632932157905, 0.0085229728579760966,
+    0.0091280293636479826, 0.0094290395774300137, 0.0098487198180039481,
+    0.010128348173644322, 0.010422043756692867, 0.010638551260382424,
+    0.010808677856088078, 0.010944930145805273, 0.010999943615068508,
+    0.011045819755420053, 0.010986275930517708, 0.010935257789349577,
+    0.010767401250131758, 0.010621337771550967, 0.010344060008641076,
+    0.010098982429354817, 0.0097119674075420992, 0.0093695926132948606,
+    0.0092378049511505633, 0.0091179711802098495, 0.0090079603642962969,
+    0.0089076723833865223, 0.0088149031831978863, 0.0087297410421580679,
+    0.0086504559057707375, 0.0085772385294942133, 0.0085086975400929798,
+    0.0084440639433770136, 0.0083714814809929816, 0.0083034238702894836,
+    0.0082394807771175582, 0.0081792900261823398, 0.0081222278101114043,
+    0.0080686312327724607, 0.0080176539034049199, 0.0079693673813463484,
+    0.0079235640959551823, 0.0078802891048044277, 0.007838457924502551,
+    0.0077992752614666205, 0.0077619099698047478, 0.0077262384752982971,
+    0.0076921481588487772, 0.0076593608881476705, 0.0076279725830958878,
+    0.0075980565179651904, 0.0075692038015349183, 0.0075416565690569204,
+    0.0075150441546398827, 0.0074895951387889959, 0.0074647079124812166,
+    0.0074411358608017508, 0.0074184185099068767, 0.0073965102015753903,
+    0.0073752543527032532, 0.0073548435514361188, 0.0073350162078373859,
+    0.0073159544583224143
+  }
+};
+
+
+/*
+***************************************************************************
+** Returns the number of rates of a curve which are not the reference
+** rates, or further than tol from them if tol is not zero.
+***************************************************************************
+*/
+static int CompareRates(char *name, TCurve *curve, double *rates, double tol)
+{
+    int bad = 0;
+    int i;
+
+    if (curve == NULL || curve->fNumItems != NB_POINTS)
+    {
+        printf("%s: no curve of %d points.\n", name, NB_POINTS);
+        return NB_POINTS;
+    }
+
+    for (i = 0; i < NB_POINTS; i++)
+    {
+        if (tol == 0.0 ?
+            memcmp(&curve->fArray[i].fRate, &rates[i], sizeof(double)) != 0 :
+            !(fabs(curve->fArray[i].fRate - rates[i]) <= tol))
+        {
+            if (bad == 0)
+                printf("%s: point %d is %.17g, not %.17g.\n",
+                       name, i, curve->fArray[i].fRate, rates[i]);
+            bad++;
+        }
+    }
+
+    return bad;
+}
+
+
+/*
+***************************************************************************
+** Returns a pseudo-random number in [0, 1). The tests must give the same
+** sequence on every platform, hence not rand().
+***************************************************************************
+*/
+static double NextRandom(unsigned long *seed)
+{
+    *seed = (*seed * 1103515245UL + 12345UL) & 0xffffffffUL;
+    return (double)(*seed >> 8) / (double)(1UL << 24);
+}
+
+
+/*
+***************************************************************************
+** Returns the number of updates of a builder whose curve is not the curve
+** of JpmcdsBuildIRZeroCurve for the same rates.
+***************************************************************************
+*/
+static int CompareUpdates
+(TIRCurveBuilder *builder,
+ TDate            today,
+ TDate           *dates,
+ double          *rates,
+ long             mmDCC,
+ long             freq,
+ long             dcc)
+{
+    unsigned long seed = 24;
+    int           bad = 0;
+    int           u;
+    int           i;
+
+    JpmcdsIRCurveBuilderSetNewton(builder, FALSE);
+
+    for (u = 0; u < NB_UPDATES; u++)
+    {
+        TCurve *ref;
+        TCurve *curve;
+        double  kind = NextRandom(&seed);
+
+        if (kind < 0.1)
+        {
+            /* no change */
+        }
+        else if (kind < 0.7)
+        {
+            i = (int)(NextRandom(&seed) * TEST_IR_NB_INSTR);
+            rates[i] += 0.001 * (NextRandom(&seed) - 0.5);
+        }
+        else
+        {
+            double shift = 0.002 * (NextRandom(&seed) - 0.5);
+
+            for (i = 0; i < TEST_IR_NB_INSTR; i++)
+                rates[i] += shift;
+        }
+
+        ref = JpmcdsBuildIRZeroCurve(today, TEST_IR_TYPES, dates, rates,
+                                     TEST_IR_NB_INSTR, mmDCC, freq, freq,
+                                     dcc, dcc, 'M', "None");
+        curve = JpmcdsIRCurveBuilderUpdate(builder, rates);
+
+        if (ref == NULL || curve == NULL)
+        {
+            printf("Update %d: no curve.\n", u);
+            bad++;
+        }
+        else
+        {
+            int n = curve->fNumItems == ref->fNumItems ? ref->fNumItems : -1;
+
+            for (i = 0; i < n; i++)
+            {
+                if (curve->fArray[i].fDate != ref->fArray[i].fDate ||
+                    memcmp(&curve->fArray[i].fRate, &ref->fArray[i].fRate,
+                           sizeof(double)) != 0)
+                    break;
+            }
+            if (i != n)
+            {
+                if (bad == 0)
+                    printf("Update %d: point %d is not the point of "
+                           "JpmcdsBuildIRZeroCurve.\n", u, i);
+                bad++;
+            }
+        }
+        JpmcdsFreeTCurve(ref);
+        JpmcdsFreeTCurve(curve);
+    }
+
+    return bad;
+}
+
+
+/*
+***************************************************************************
+** Main function.
+***************************************************************************
+*/
+int main(void)
+{
+    TDate            today = JpmcdsDate(2025, 6, 16);
+    TDate            dates[TEST_IR_NB_INSTR];
+    double           rates[TEST_IR_NB_INSTR];
+    long             mmDCC;
+    long             dcc;
+    long             freq;
+    TDateInterval    ivl;
+    double           dfreq;
+    TIRCurveBuilder *builder = NULL;
+    int              bad = 0;
+    int              k;
+
+    JpmcdsErrMsgFileName("zctest.log", FALSE);
+    JpmcdsErrMsgOn();
+
+    if (JpmcdsStringToDayCountConv("Act/360", &mmDCC) != SUCCESS ||
+        JpmcdsStringToDayCountConv("30/360", &dcc) != SUCCESS ||
+        JpmcdsStringToDateInterval("6M", "zctest", &ivl) != SUCCESS ||
+        JpmcdsDateIntervalToFreq(&ivl, &dfreq) != SUCCESS ||
+        TestIRInstruments(today, 0.0, dates, rates) != SUCCESS)
+        return 1;
+    freq = (long)dfreq;
+
+    builder = JpmcdsIRCurveBuilderNew(today, TEST_IR_TYPES, dates,
+                                      TEST_IR_NB_INSTR, mmDCC, freq, freq,
+                                      dcc, dcc, 'M', "None");
+    if (builder == NULL)
+    {
+        printf("JpmcdsIRCurveBuilderNew failed.\n");
+        return 1;
+    }
+
+    for (k = 0; k < NB_CURVES; k++)
+    {
+        TCurve *curve;
+
+        if (TestIRInstruments(today, shifts[k], dates, rates) != SUCCESS)
+            return 1;
+
+        curve = JpmcdsBuildIRZeroCurve(today, TEST_IR_TYPES, dates, rates,
+                                       TEST_IR_NB_INSTR, mmDCC, freq, freq,
+                                       dcc, dcc, 'M', "None");
+        bad += CompareRates("JpmcdsBuildIRZeroCurve", curve, refRates[k], 0.0);
+        JpmcdsFreeTCurve(curve);
+
+        JpmcdsIRCurveBuilderSetNewton(builder, FALSE);
+        curve = JpmcdsIRCurveBuilderUpdate(builder, rates);
+        bad += CompareRates("Builder", curve, refRates[k], 0.0);
+        JpmcdsFreeTCurve(curve);
+
+        JpmcdsIRCurveBuilderSetNewton(builder, TRUE);
+        curve = JpmcdsIRCurveBuilderUpdate(builder, rates);
+        bad += CompareRates("Newton builder", curve, refRates[k], NEWTON_TOL);
+        JpmcdsFreeTCurve(curve);
+    }
+
+    if (TestIRInstruments(today, 0.0, dates, rates) != SUCCESS)
+        return 1;
+    bad += CompareUpdates(builder, today, dates, rates, mmDCC, freq, dcc);
+
+    JpmcdsIRCurveBuilderFree(builder);
+
+    printf("%d curves, %d updates: %d differences\n", NB_CURVES, NB_UPDATES,
+           bad);
+    return bad == 0 ? 0 : 1;
+}